@@ -0,0 +1,69 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+// Microbenchmark measuring the overhead of calls into interpreted methods.
+// 'small' has a tiny frame while 'large' has a large 'max_locals' and 'max_stack', making it sensitive to any per-call
+// work proportional to the frame size.
+//
+// Usage:
+//   javac CallOverhead.java -d out
+//   jllvm -Xint out/CallOverhead.class [iterations]
+//   jllvm -Xint -Xzero-interpreter-frames out/CallOverhead.class [iterations]
+
+class CallOverhead
+{
+    private static int small(int a)
+    {
+        return a + 1;
+    }
+
+    private static int large(int a)
+    {
+        long l0 = a, l1 = a, l2 = a, l3 = a, l4 = a, l5 = a, l6 = a, l7 = a;
+        long l8 = a, l9 = a, l10 = a, l11 = a, l12 = a, l13 = a, l14 = a, l15 = a;
+        if (a < 0)
+        {
+            // Never executed, only present to increase 'max_stack' and 'max_locals'.
+            return (int)(l0 + (l1 * (l2 + (l3 * (l4 + (l5 * (l6 + (l7
+                * (l8 + (l9 * (l10 + (l11 * (l12 + (l13 * (l14 + l15)))))))))))))));
+        }
+        return a + 1;
+    }
+
+    private static void report(String name, int iterations, long start, int result)
+    {
+        long nanos = System.nanoTime() - start;
+        System.out.println(name + ": " + (nanos / iterations) + " ns/call (" + result + ")");
+    }
+
+    public static void main(String[] args)
+    {
+        int iterations = args.length > 0 ? Integer.parseInt(args[0]) : 1000000;
+
+        long start = System.nanoTime();
+        int result = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            result = small(result);
+        }
+        report("small frame", iterations, start, result);
+
+        start = System.nanoTime();
+        result = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            result = large(result);
+        }
+        report("large frame", iterations, start, result);
+    }
+}
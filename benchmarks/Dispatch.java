@@ -0,0 +1,87 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+// Microbenchmark measuring the instruction dispatch overhead of the interpreter.
+// The loops consist of many cheap instructions of different kinds, making the time spent selecting and jumping to
+// the handler of the next instruction dominate.
+// Compare a build with threaded dispatch against one configured with '-DJLLVM_INTERPRETER_THREADED_DISPATCH=OFF'.
+//
+// Usage:
+//   javac Dispatch.java -d out
+//   jllvm -Xint out/Dispatch.class [iterations]
+
+class Dispatch
+{
+    private static int arithmetic(int iterations)
+    {
+        int a = 1, b = 2, c = 3;
+        for (int i = 0; i < iterations; i++)
+        {
+            a = (a ^ b) + c;
+            b = (b << 1) - a;
+            c = (c | a) & ~b;
+        }
+        return a + b + c;
+    }
+
+    private static int branches(int iterations)
+    {
+        int result = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            switch (i & 3)
+            {
+                case 0: result += 1; break;
+                case 1: result -= 2; break;
+                case 2: result ^= i; break;
+                default: result = result > 0 ? result - i : result + i; break;
+            }
+        }
+        return result;
+    }
+
+    private static long arrays(int iterations)
+    {
+        int[] array = new int[64];
+        long sum = 0;
+        for (int i = 0; i < iterations; i++)
+        {
+            array[i & 63] += i;
+            sum += array[(i * 7) & 63];
+        }
+        return sum;
+    }
+
+    private static void report(String name, int iterations, long start, long result)
+    {
+        long nanos = System.nanoTime() - start;
+        System.out.println(name + ": " + (nanos * 1000 / iterations) + " ps/iteration (" + result + ")");
+    }
+
+    public static void main(String[] args)
+    {
+        int iterations = args.length > 0 ? Integer.parseInt(args[0]) : 10000000;
+
+        long start = System.nanoTime();
+        long result = arithmetic(iterations);
+        report("arithmetic", iterations, start, result);
+
+        start = System.nanoTime();
+        result = branches(iterations);
+        report("branches", iterations, start, result);
+
+        start = System.nanoTime();
+        result = arrays(iterations);
+        report("arrays", iterations, start, result);
+    }
+}
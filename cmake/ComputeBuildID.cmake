@@ -0,0 +1,38 @@
+# Copyright (C) 2023 The JLLVM Contributors.
+#
+# This file is part of JLLVM.
+#
+# JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+#
+# JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+# of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+# see <http://www.gnu.org/licenses/>.
+
+# Writes a header to 'OUTPUT' defining 'JLLVM_BUILD_ID' as a hash of all sources within 'SOURCE_DIR'.
+# Used as script via 'cmake -DSOURCE_DIR=<dir> -DOUTPUT=<file> -P ComputeBuildID.cmake'.
+#
+# Contrary to a hash of an executable, the ID is identical in all executables built from the same sources. It therefore
+# identifies the layouts of class objects, frames and symbols that compiled code relies on across tools.
+
+file(GLOB_RECURSE sources RELATIVE ${SOURCE_DIR} ${SOURCE_DIR}/*.cpp ${SOURCE_DIR}/*.hpp ${SOURCE_DIR}/*.def
+        ${SOURCE_DIR}/*.td)
+list(SORT sources)
+
+set(hashes "")
+foreach (source IN LISTS sources)
+    file(SHA256 ${SOURCE_DIR}/${source} hash)
+    string(APPEND hashes "${source} ${hash}\n")
+endforeach ()
+string(SHA256 buildID "${hashes}")
+
+set(content "#define JLLVM_BUILD_ID \"${buildID}\"\n")
+# Avoid recompiling users of the header if the sources only changed in a way that does not change the ID.
+if (EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} oldContent)
+endif ()
+if (NOT content STREQUAL oldContent)
+    file(WRITE ${OUTPUT} "${content}")
+endif ()
@@ -13,7 +13,9 @@
 
 #include "ClassFile.hpp"
 
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/SHA1.h>
 
 using namespace jllvm;
 
@@ -186,6 +188,7 @@ T parseFieldOrMethodInfo(llvm::ArrayRef<char>& bytes, const ClassFile& classFile
 jllvm::ClassFile jllvm::ClassFile::parseFromFile(llvm::ArrayRef<char> bytes, llvm::StringSaver& stringSaver)
 {
     jllvm::ClassFile result;
+    result.m_bytes = bytes;
 
     auto magic = consume<std::uint32_t>(bytes);
     if (magic != 0xCAFEBABE)
@@ -283,3 +286,14 @@ MethodType MethodInfo::getDescriptor(const jllvm::ClassFile& classFile) const
 {
     return MethodType(m_descriptorIndex.resolve(classFile)->text);
 }
+
+llvm::StringRef jllvm::ClassFile::getContentHash() const
+{
+    if (m_contentHash.empty())
+    {
+        m_contentHash = llvm::toHex(
+            llvm::SHA1::hash({reinterpret_cast<const std::uint8_t*>(m_bytes.data()), m_bytes.size()}),
+            /*LowerCase=*/true);
+    }
+    return m_contentHash;
+}
@@ -335,6 +335,12 @@ public:
         return m_code;
     }
 
+    /// Returns all exception handlers in order of appearance in the class file.
+    llvm::ArrayRef<ExceptionTable> getExceptionTable() const
+    {
+        return m_exceptionTable;
+    }
+
     /// Get exception handlers in an unspecified order that are active at the given bytecode offset.
     auto getHandlersAtUnordered(std::uint16_t offset) const
     {
@@ -492,6 +498,8 @@ public:
 /// Top level struct representing a class file.
 class ClassFile
 {
+    llvm::ArrayRef<char> m_bytes;
+    mutable std::string m_contentHash;
     std::vector<ConstantPoolInfo> m_constantPool;
     AccessFlag m_accessFlags;
     llvm::StringRef m_thisClass;
@@ -511,6 +519,16 @@ public:
     /// its backing storage.
     static ClassFile parseFromFile(llvm::ArrayRef<char> bytes, llvm::StringSaver& stringSaver);
 
+    /// Returns the raw bytes this class file was parsed from.
+    llvm::ArrayRef<char> getBytes() const
+    {
+        return m_bytes;
+    }
+
+    /// Returns the SHA1 hash of the raw bytes of this class file as lower-case hex string. Computed on first use.
+    /// Used to identify code compiled from this class file across processes.
+    llvm::StringRef getContentHash() const;
+
     /// Returns the name of the class defined by this class file.
     llvm::StringRef getThisClass() const
     {
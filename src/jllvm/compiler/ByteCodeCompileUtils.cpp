@@ -17,7 +17,9 @@
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/IR/Module.h>
+#include <llvm/Support/raw_ostream.h>
 
 #include <jllvm/support/Variant.hpp>
 
@@ -42,6 +44,12 @@ llvm::Type* jllvm::iTableType(llvm::LLVMContext& context)
                                            llvm::ArrayType::get(llvm::PointerType::get(context, 0), 0)});
 }
 
+llvm::Type* jllvm::imtEntryType(llvm::LLVMContext& context)
+{
+    return llvm::StructType::get(context, {llvm::Type::getIntNTy(context, std::numeric_limits<std::size_t>::digits),
+                                           llvm::PointerType::get(context, 0), llvm::PointerType::get(context, 0)});
+}
+
 llvm::Type* jllvm::objectHeaderType(llvm::LLVMContext& context)
 {
     return llvm::StructType::get(/*classObject*/ jllvm::referenceType(context),
@@ -55,6 +63,9 @@ llvm::PointerType* jllvm::referenceType(llvm::LLVMContext& context)
 
 namespace
 {
+/// Name of the module flag containing the 'CompilationTier' of a module.
+constexpr llvm::StringLiteral compilationTierFlag = "jllvm.compilation-tier";
+
 /// Get or insert a global of the given 'name' in 'module' which has external linkage and simply imports the symbol
 /// 'name'.
 llvm::GlobalVariable* getOrInsertImportingGlobal(llvm::Module& module, llvm::StringRef name, unsigned addressSpace)
@@ -89,6 +100,11 @@ llvm::GlobalVariable* jllvm::stringGlobal(llvm::Module& module, llvm::StringRef
     return getOrInsertImportingGlobal(module, mangleStringGlobal(contents), /*addressSpace=*/1);
 }
 
+llvm::GlobalVariable* jllvm::pendingExceptionGlobal(llvm::Module& module)
+{
+    return getOrInsertImportingGlobal(module, "jllvm_pending_exception", /*addressSpace=*/0);
+}
+
 llvm::Type* jllvm::descriptorToType(FieldType type, llvm::LLVMContext& context)
 {
     return jllvm::match(
@@ -148,6 +164,64 @@ llvm::Value* jllvm::extendToStackType(llvm::IRBuilder<>& builder, FieldType type
         [&](const auto&) { return value; });
 }
 
+namespace
+{
+
+/// Attaches a TBAA access tag of a scalar type named 'name' within the kind of memory 'kind' to 'access'.
+void annotateTBAA(llvm::Instruction* access, llvm::StringRef kind, const llvm::Twine& name)
+{
+    llvm::MDBuilder builder(access->getContext());
+    llvm::MDNode* root = builder.createTBAARoot("Java TBAA");
+    llvm::MDNode* kindNode = builder.createTBAAScalarTypeNode(kind, root);
+    llvm::MDNode* type = builder.createTBAAScalarTypeNode(name.str(), kindNode);
+    access->setMetadata(llvm::LLVMContext::MD_tbaa, builder.createTBAAStructTagNode(type, type, /*Offset=*/0));
+}
+
+void markInvariantLoad(llvm::Instruction* access)
+{
+    if (llvm::isa<llvm::LoadInst>(access))
+    {
+        access->setMetadata(llvm::LLVMContext::MD_invariant_load, llvm::MDNode::get(access->getContext(), {}));
+    }
+}
+
+} // namespace
+
+void jllvm::annotateClassObjectAccess(llvm::Instruction* access)
+{
+    annotateTBAA(access, "object header", "class object");
+    markInvariantLoad(access);
+}
+
+void jllvm::annotateArrayLengthAccess(llvm::Instruction* access)
+{
+    annotateTBAA(access, "array length", "length");
+    markInvariantLoad(access);
+    if (llvm::isa<llvm::LoadInst>(access))
+    {
+        // Array lengths are never negative. Knowing so allows LLVM to prove more array accesses to be within bounds.
+        access->setMetadata(llvm::LLVMContext::MD_range,
+                            llvm::MDBuilder(access->getContext())
+                                .createRange(llvm::APInt(32, 0), llvm::APInt::getSignedMinValue(32)));
+    }
+}
+
+void jllvm::annotateArrayElementAccess(llvm::Instruction* access, llvm::Type* elementType)
+{
+    // Element types are distinguished by their LLVM type. 'boolean' and 'byte' arrays or 'char' and 'short' arrays
+    // therefore share a type, which is conservatively correct.
+    std::string name;
+    llvm::raw_string_ostream ss(name);
+    ss << *elementType;
+    annotateTBAA(access, "array element", name);
+}
+
+void jllvm::annotateFieldAccess(llvm::Instruction* access, llvm::StringRef fieldName, FieldType descriptor,
+                                bool isStatic)
+{
+    annotateTBAA(access, isStatic ? "static field" : "field", fieldName + ":" + descriptor.textual());
+}
+
 namespace
 {
 void placeInJavaSection(llvm::Function* function)
@@ -402,3 +476,18 @@ void jllvm::emitReturn(llvm::IRBuilder<>& builder, llvm::Value* value, CallingCo
             break;
     }
 }
+
+void jllvm::setCompilationTier(llvm::Module& module, CompilationTier tier)
+{
+    module.addModuleFlag(llvm::Module::Max, compilationTierFlag, static_cast<std::uint32_t>(tier));
+}
+
+jllvm::CompilationTier jllvm::getCompilationTier(const llvm::Module& module)
+{
+    auto* flag = llvm::mdconst::extract_or_null<llvm::ConstantInt>(module.getModuleFlag(compilationTierFlag));
+    if (!flag)
+    {
+        return CompilationTier::Optimized;
+    }
+    return static_cast<CompilationTier>(flag->getZExtValue());
+}
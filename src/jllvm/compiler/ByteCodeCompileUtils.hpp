@@ -33,6 +33,9 @@ llvm::Type* arrayStructType(llvm::Type* elementType);
 /// Returns the pointer type used by the JVM for interface tables.
 llvm::Type* iTableType(llvm::LLVMContext& context);
 
+/// Returns the type used by the JVM for entries of interface method tables.
+llvm::Type* imtEntryType(llvm::LLVMContext& context);
+
 /// Returns the pointer type used by the JVM for object headers.
 llvm::Type* objectHeaderType(llvm::LLVMContext& context);
 
@@ -49,6 +52,18 @@ llvm::GlobalVariable* methodGlobal(llvm::Module& module, const Method* method);
 /// Returns the global variable importing the given interned string.
 llvm::GlobalVariable* stringGlobal(llvm::Module& module, llvm::StringRef contents);
 
+/// Exception waiting to be dispatched to an exception handler of a JITted method.
+/// The runtime sets it prior to resuming execution of a JITted frame after the call that threw 'exception'. The code
+/// following the call then clears it and branches to the exception handler at 'handlerOffset'.
+struct PendingException
+{
+    ObjectInterface* exception;
+    std::uint16_t handlerOffset;
+};
+
+/// Returns the global variable importing the 'PendingException' of the JIT.
+llvm::GlobalVariable* pendingExceptionGlobal(llvm::Module& module);
+
 /// Returns the corresponding LLVM type for a given Java field descriptor.
 llvm::Type* descriptorToType(FieldType type, llvm::LLVMContext& context);
 
@@ -65,6 +80,15 @@ enum class CallingConvention : std::uint8_t
     JIT,
 };
 
+/// Reason for JIT compiled code to deoptimize its frame by calling 'jllvm_deoptimize'.
+enum class DeoptimizationReason : std::uint8_t
+{
+    /// The class of the receiver of a virtual call did not match any of the classes speculated on too often.
+    ClassCheck = 0,
+    /// A branch target that the profile has never seen being branched to was reached.
+    UnstableIf = 1,
+};
+
 /// Returns the LLVM function type for an OSR method for a given return type.
 /// The calling convention used is suitable to replace a frame with the given 'callingConvention' by using the same
 /// return type. The parameter list contains of a single pointer to an internal array built by 'OSRState' used to
@@ -77,6 +101,43 @@ llvm::FunctionType* osrMethodSignature(FieldType returnType, CallingConvention c
 /// This is essentially just signed-extending or zero-extending integers less than 'int' to 'int'.
 llvm::Value* extendToStackType(llvm::IRBuilder<>& builder, FieldType type, llvm::Value* value);
 
+/// Functions attaching type-based alias analysis (TBAA) metadata to loads and stores of Java heap memory.
+/// The class object pointer of objects, the length of arrays, the elements of every type of array and every field are
+/// all distinct kinds of memory which never alias each other.
+
+/// Annotates 'access', a load or store of the class object pointer of an object. Loads are additionally marked as
+/// invariant as the class object of an object never changes after allocation.
+void annotateClassObjectAccess(llvm::Instruction* access);
+
+/// Annotates 'access', a load or store of the length of an array. Loads are additionally marked as invariant as the
+/// length of an array never changes after allocation and as never being negative.
+void annotateArrayLengthAccess(llvm::Instruction* access);
+
+/// Annotates 'access', a load or store of an element of an array with elements of type 'elementType'.
+void annotateArrayElementAccess(llvm::Instruction* access, llvm::Type* elementType);
+
+/// Annotates 'access', a load or store of the field with the given name and descriptor.
+/// The class containing the field is intentionally not part of the metadata as it is not known prior to field
+/// resolution.
+void annotateFieldAccess(llvm::Instruction* access, llvm::StringRef fieldName, FieldType descriptor, bool isStatic);
+
+/// State of an interpreter frame executed within the native frame of the interpreter frame that called it rather than
+/// a native frame of its own. These are created by the interpreter for interpreter-to-interpreter calls when stackless
+/// calls are enabled. All such frames executed within a native frame form a chain from the innermost frame to the
+/// frame called by the native frame's own method.
+struct StacklessFrame
+{
+    const Method* method;
+    std::uint16_t byteCodeOffset;
+    std::uint16_t topOfStack;
+    std::uint64_t* operandStack;
+    std::uint64_t* operandGCMask;
+    std::uint64_t* localVariables;
+    std::uint64_t* localVariablesGCMask;
+    /// Next frame in the chain or null if this frame was called by the method of the native frame.
+    StacklessFrame* caller;
+};
+
 /// Metadata attached to Java methods produced by any 'ByteCodeLayer' implementation.
 class JavaMethodMetadata
 {
@@ -91,20 +152,37 @@ public:
         FrameValue<std::uint64_t*> operandGCMask;
         FrameValue<std::uint64_t*> localVariables;
         FrameValue<std::uint64_t*> localVariablesGCMask;
+        /// Pointer to the innermost stackless frame executed within the frame or null if there is none.
+        FrameValue<StacklessFrame**> stacklessFrames;
     };
 
     /// Metadata contained within any JITted Java frame.
     class JITData
     {
-        const Method* m_method{};
-
-        struct PerPCData
+    public:
+        /// State of a Java frame at a call within the JITted method.
+        struct FrameState
         {
+            const Method* method{};
             std::uint16_t byteCodeOffset{};
             std::vector<FrameValue<std::uint64_t>> locals;
             std::vector<std::uint64_t> localsGCMask;
+            /// Operand stack in the layout used by the interpreter. Only recorded for calls to 'jllvm_deoptimize' and,
+            /// within fully optimized code, for calls to Java methods. The arguments of the call are not part of it.
+            std::vector<FrameValue<std::uint64_t>> operandStack;
+            std::vector<std::uint64_t> operandStackGCMask;
+        };
+
+        struct PerPCData
+        {
+            /// State of the frame of the JITted method followed by the states of the frames of any methods inlined at
+            /// the call, from the outermost to the innermost frame.
+            std::vector<FrameState> frames;
         };
 
+    private:
+        const Method* m_method{};
+
         /// Pointer to a dynamically allocated instance. This is not just a 'llvm::DenseMap' as that is 1) not a
         /// standard layout type and 2) requires being able to write to the object despite 'JavaMethodMetadata' being
         /// in read-only memory after linking.
@@ -270,6 +348,22 @@ void applyABIAttributes(llvm::CallBase* call, MethodType methodType, bool isStat
 /// Returns a pointer to the call instruction of the initializer.
 llvm::CallBase* initializeClassObject(llvm::IRBuilder<>& builder, llvm::Value* classObject, bool addDeopt = true);
 
+/// Tier of JIT compiled code determining how much time is spent optimizing it.
+enum class CompilationTier : std::uint8_t
+{
+    /// Cheaply optimized code used to quickly get out of the interpreter. Code of this tier usually counts its
+    /// executions to be recompiled in the optimized tier once hot.
+    Baseline = 1,
+    /// Fully optimized code for hot methods.
+    Optimized = 2,
+};
+
+/// Marks 'module' as containing code of the given compilation tier.
+void setCompilationTier(llvm::Module& module, CompilationTier tier);
+
+/// Returns the compilation tier 'module' was marked with, or 'CompilationTier::Optimized' if it was never marked.
+CompilationTier getCompilationTier(const llvm::Module& module);
+
 /// Emits a suitable sequence of instructions for returning from a method with the given calling convention.
 /// 'builder' is used to create any new instructions. 'value' is expected to be null if the method has a void return
 /// type.
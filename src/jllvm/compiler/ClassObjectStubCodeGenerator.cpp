@@ -14,6 +14,7 @@
 #include "ClassObjectStubCodeGenerator.hpp"
 
 #include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/MDBuilder.h>
 
 #include <jllvm/debuginfo/TrivialDebugInfoBuilder.hpp>
 
@@ -156,7 +157,9 @@ llvm::Function* jllvm::generateFieldAccessStub(llvm::Module& module, const Class
 
 llvm::Function* jllvm::generateMethodResolutionCallStub(llvm::Module& module, jllvm::MethodResolution resolution,
                                                         const ClassObject& classObject, llvm::StringRef methodName,
-                                                        jllvm::MethodType descriptor, const ClassObject& objectClass)
+                                                        jllvm::MethodType descriptor, const ClassObject& objectClass,
+                                                        ClassHierarchyAnalysis* classHierarchyAnalysis,
+                                                        const Method* dependent)
 {
     auto* functionType = descriptorToType(descriptor, /*isStatic=*/false, module.getContext());
 
@@ -188,8 +191,33 @@ llvm::Function* jllvm::generateMethodResolutionCallStub(llvm::Module& module, jl
 
     if (!resolvedMethod->getClassObject()->isInterface())
     {
+        const ClassHierarchyAnalysis::Assumption* assumption = nullptr;
+        if (classHierarchyAnalysis && resolution == MethodResolution::Virtual && classObject.isClass())
+        {
+            assumption = classHierarchyAnalysis->devirtualize(classObject, *resolvedMethod, dependent);
+        }
+        if (assumption)
+        {
+            // Call the single implementation directly, allowing LLVM to inline it. Code that is already executing
+            // when loading a class invalidates the assumption falls back to the v-table below.
+            llvm::Value* validFlag = builder.CreateIntToPtr(
+                builder.getInt64(reinterpret_cast<std::uint64_t>(assumption->getValidFlag())), builder.getPtrTy());
+            llvm::Value* isValid = builder.CreateICmpNE(builder.CreateLoad(builder.getInt8Ty(), validFlag),
+                                                        builder.getInt8(0));
+            auto* directCall = llvm::BasicBlock::Create(builder.getContext(), "", function);
+            auto* virtualCall = llvm::BasicBlock::Create(builder.getContext(), "", function);
+            builder.CreateCondBr(isValid, directCall, virtualCall,
+                                 llvm::MDBuilder(builder.getContext()).createLikelyBranchWeights());
+
+            builder.SetInsertPoint(directCall);
+            buildRetCall(builder, buildDirectMethodCall(builder, &assumption->getTarget(), args));
+
+            builder.SetInsertPoint(virtualCall);
+        }
+
         llvm::Value* methodOffset = builder.getInt32(sizeof(VTableSlot) * *resolvedMethod->getTableSlot());
-        llvm::Value* thisClassObject = builder.CreateLoad(referenceType(builder.getContext()), args.front());
+        llvm::LoadInst* thisClassObject = builder.CreateLoad(referenceType(builder.getContext()), args.front());
+        annotateClassObjectAccess(thisClassObject);
         llvm::Value* vtblPositionInClassObject = builder.getInt32(ClassObject::getVTableOffset());
 
         llvm::Value* totalOffset = builder.CreateAdd(vtblPositionInClassObject, methodOffset);
@@ -206,7 +234,41 @@ llvm::Function* jllvm::generateMethodResolutionCallStub(llvm::Module& module, jl
     llvm::Value* slot = builder.getIntN(sizeTBits, *resolvedMethod->getTableSlot());
     llvm::Value* id = builder.getIntN(sizeTBits, resolvedMethod->getClassObject()->getInterfaceId());
 
-    llvm::Value* thisClassObject = builder.CreateLoad(referenceType(builder.getContext()), args.front());
+    llvm::LoadInst* thisClassObject = builder.CreateLoad(referenceType(builder.getContext()), args.front());
+    annotateClassObjectAccess(thisClassObject);
+
+    // Constant time lookup in the IMT of the class object first. The hash of the key is known at compile time, leaving
+    // only the masking with the size of the IMT to be done at runtime.
+    std::size_t key = IMTEntry::getKey(resolvedMethod->getClassObject()->getInterfaceId(),
+                                       *resolvedMethod->getTableSlot());
+    llvm::Type* entryType = imtEntryType(builder.getContext());
+    llvm::Value* imtPtr =
+        builder.CreateGEP(builder.getInt8Ty(), thisClassObject, {builder.getInt32(ClassObject::getIMTOffset())});
+    llvm::Value* imt =
+        builder.CreateLoad(builder.getPtrTy(), builder.CreateGEP(arrayRefType(builder.getContext()), imtPtr,
+                                                                 {builder.getInt32(0), builder.getInt32(0)}));
+    llvm::Value* imtSize = builder.CreateLoad(
+        builder.getIntNTy(sizeTBits),
+        builder.CreateGEP(arrayRefType(builder.getContext()), imtPtr, {builder.getInt32(0), builder.getInt32(1)}));
+    // Classes implementing an interface method always have a non-empty IMT, making the subtraction safe.
+    llvm::Value* index = builder.CreateAnd(builder.getIntN(sizeTBits, IMTEntry::hash(key)),
+                                           builder.CreateSub(imtSize, builder.getIntN(sizeTBits, 1)));
+    llvm::Value* imtEntry = builder.CreateGEP(entryType, imt, {index});
+    llvm::Value* entryKey = builder.CreateLoad(builder.getIntNTy(sizeTBits), imtEntry);
+    auto* imtHit = llvm::BasicBlock::Create(builder.getContext(), "", function);
+    auto* imtMiss = llvm::BasicBlock::Create(builder.getContext(), "", function);
+    builder.CreateCondBr(builder.CreateICmpEQ(entryKey, builder.getIntN(sizeTBits, key)), imtHit, imtMiss,
+                         llvm::MDBuilder(builder.getContext()).createLikelyBranchWeights());
+
+    builder.SetInsertPoint(imtHit);
+    llvm::Value* imtCallee = builder.CreateLoad(
+        builder.getPtrTy(), builder.CreateGEP(entryType, imtEntry, {builder.getInt32(0), builder.getInt32(2)}));
+    auto* imtCall = builder.CreateCall(functionType, imtCallee, args, llvm::OperandBundleDef("deopt", std::nullopt));
+    applyABIAttributes(imtCall, descriptor, /*isStatic=*/false);
+    buildRetCall(builder, imtCall);
+
+    // The interface method conflicts with a different interface method in the IMT.
+    builder.SetInsertPoint(imtMiss);
     llvm::Value* iTablesPtr =
         builder.CreateGEP(builder.getInt8Ty(), thisClassObject, {builder.getInt32(ClassObject::getITablesOffset())});
     llvm::Value* iTables =
@@ -15,6 +15,7 @@
 
 #include <llvm/IR/Module.h>
 
+#include <jllvm/object/ClassHierarchyAnalysis.hpp>
 #include <jllvm/object/ClassObject.hpp>
 
 #include "ClassObjectStubMangling.hpp"
@@ -37,10 +38,15 @@ llvm::Function* generateFieldAccessStub(llvm::Module& module, const ClassObject&
 /// resolution and method selection of either a virtual or interface call before calling the found method.
 /// The precise method resolution that should be used should be passed as the 'resolution' parameter.
 /// 'objectClass' must be the class object of 'java/lang/Object'.
+/// If 'classHierarchyAnalysis' is non-null, virtual calls to methods with a single implementation among all loaded
+/// classes call the implementation directly for as long as the assumption holds. 'dependent' is the method that
+/// relies on the assumption if the stub is imported into its compiled code.
 /// It is undefined behaviour if method resolution does not find a method to call.
 llvm::Function* generateMethodResolutionCallStub(llvm::Module& module, MethodResolution resolution,
                                                  const ClassObject& classObject, llvm::StringRef methodName,
-                                                 MethodType descriptor, const ClassObject& objectClass);
+                                                 MethodType descriptor, const ClassObject& objectClass,
+                                                 ClassHierarchyAnalysis* classHierarchyAnalysis = nullptr,
+                                                 const Method* dependent = nullptr);
 
 /// Generates a new LLVM function with the name returned by 'mangleSpecialMethoCall' implementing the method
 /// resolution of 'invokespecial' before calling the found method. 'callerClass' must be the class object of the caller
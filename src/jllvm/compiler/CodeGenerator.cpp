@@ -15,9 +15,11 @@
 
 #include <llvm/ADT/IntervalTree.h>
 #include <llvm/ADT/ScopeExit.h>
+#include <llvm/IR/MDBuilder.h>
 #include <llvm/Support/ModRef.h>
 
 #include <jllvm/debuginfo/TrivialDebugInfoBuilder.hpp>
+#include <jllvm/object/MethodProfile.hpp>
 #include <jllvm/support/BitArrayRef.hpp>
 
 using namespace jllvm;
@@ -99,8 +101,8 @@ llvm::FunctionCallee throwFunction(llvm::Module* module)
     function = llvm::Function::Create(llvm::FunctionType::get(llvm::Type::getVoidTy(module->getContext()),
                                                               {referenceType(module->getContext())}, false),
                                       llvm::GlobalValue::ExternalLinkage, "jllvm_throw", module);
+    // Not 'noreturn' as the runtime may resume execution after the call to dispatch to an exception handler.
     function->addFnAttrs(llvm::AttrBuilder(module->getContext())
-                             .addAttribute(llvm::Attribute::NoReturn)
                              .addAttribute(llvm::Attribute::Cold)
                              .addAttribute("gc-leaf-function"));
     function->addParamAttrs(0, llvm::AttrBuilder(module->getContext())
@@ -161,6 +163,51 @@ ArrayInfo resolveNewArrayInfo(BaseType::Values componentType, llvm::IRBuilder<>&
     }
 }
 
+/// Creates branch weight metadata from the execution counts of each successor as recorded by a profile.
+/// Returns null if no successor was ever executed.
+llvm::MDNode* createBranchWeights(llvm::LLVMContext& context, llvm::ArrayRef<std::uint64_t> counts)
+{
+    std::uint64_t max = *llvm::max_element(counts);
+    if (max == 0)
+    {
+        return nullptr;
+    }
+
+    // Branch weights are only 32 bit. Scale all counts down uniformly if any of them would not fit.
+    std::uint64_t scale = max / std::numeric_limits<std::uint32_t>::max() + 1;
+    auto weights = llvm::to_vector(
+        llvm::map_range(counts, [&](std::uint64_t count) { return static_cast<std::uint32_t>(count / scale); }));
+    return llvm::MDBuilder(context).createBranchWeights(weights);
+}
+
+/// Returns the branch weights of the conditional branch at 'offset' from 'profile' or null if there is no profile.
+llvm::MDNode* conditionalBranchWeights(llvm::LLVMContext& context, const MethodProfile* profile, std::uint16_t offset)
+{
+    const MethodProfile::BranchProfile* branchProfile = profile ? profile->getBranchProfile(offset) : nullptr;
+    if (!branchProfile)
+    {
+        return nullptr;
+    }
+    return createBranchWeights(context, {branchProfile->taken, branchProfile->notTaken});
+}
+
+/// Returns the branch weights of the switch at 'offset' with 'numCases' from 'profile' or null if there is no profile.
+llvm::MDNode* switchBranchWeights(llvm::LLVMContext& context, const MethodProfile* profile, std::uint16_t offset,
+                                  std::size_t numCases)
+{
+    const MethodProfile::SwitchProfile* switchProfile = profile ? profile->getSwitchProfile(offset) : nullptr;
+    if (!switchProfile)
+    {
+        return nullptr;
+    }
+
+    // LLVM expects the weight of the default destination first, followed by the weights of all cases.
+    llvm::SmallVector<std::uint64_t> counts{switchProfile->defaultCount};
+    llvm::append_range(counts, switchProfile->caseCounts);
+    counts.resize(numCases + 1);
+    return createBranchWeights(context, counts);
+}
+
 } // namespace
 
 llvm::PointerUnion<llvm::PHINode*, llvm::BasicBlock*> CodeGenerator::generateBody(PrologueGenFn generatePrologue,
@@ -179,6 +226,7 @@ llvm::PointerUnion<llvm::PHINode*, llvm::BasicBlock*> CodeGenerator::generateBod
     const ByteCodeTypeChecker::TypeInfo& typeInfo = checker.checkAndGetTypeInfo(offset);
 
     generatePrologue(m_builder, m_locals, m_operandStack, typeInfo);
+    generateTierUpCheck(offset);
 
     createBasicBlocks(checker);
     // If no basic block exists for the offset compilation is started at, create it. This effectively splits the basic
@@ -232,6 +280,61 @@ llvm::PointerUnion<llvm::PHINode*, llvm::BasicBlock*> CodeGenerator::generateBod
     return m_returnBlock;
 }
 
+llvm::BasicBlock* CodeGenerator::getBranchTarget(std::uint16_t byteCodeOffset, std::uint16_t offset,
+                                                 std::optional<std::uint64_t> count)
+{
+    if (m_uncommonTrapProfile && count == 0)
+    {
+        return getUncommonTrap(byteCodeOffset);
+    }
+    return getBasicBlock(offset);
+}
+
+llvm::SmallVector<llvm::BasicBlock*> CodeGenerator::getSwitchTargets(std::uint16_t byteCodeOffset,
+                                                                     llvm::ArrayRef<std::uint16_t> targets)
+{
+    const MethodProfile* profile = m_method.getProfile();
+    const MethodProfile::SwitchProfile* switchProfile = profile ? profile->getSwitchProfile(byteCodeOffset) : nullptr;
+    if (!switchProfile)
+    {
+        return llvm::to_vector(llvm::map_range(targets, [&](std::uint16_t target)
+                                               { return getBranchTarget(byteCodeOffset, target, std::nullopt); }));
+    }
+
+    // Multiple cases may branch to the same target. Only trap if none of them was ever taken.
+    llvm::SmallDenseMap<std::uint16_t, std::uint64_t> counts;
+    counts[targets.front()] += switchProfile->defaultCount;
+    for (auto [index, target] : llvm::enumerate(llvm::drop_begin(targets)))
+    {
+        counts[target] += index < switchProfile->caseCounts.size() ? switchProfile->caseCounts[index] : 0;
+    }
+
+    return llvm::to_vector(llvm::map_range(targets, [&](std::uint16_t target)
+                                           { return getBranchTarget(byteCodeOffset, target, counts[target]); }));
+}
+
+llvm::BasicBlock* CodeGenerator::getUncommonTrap(std::uint16_t byteCodeOffset)
+{
+    llvm::BasicBlock*& trapBlock = m_uncommonTraps[byteCodeOffset];
+    if (trapBlock)
+    {
+        return trapBlock;
+    }
+
+    llvm::IRBuilder<>::InsertPointGuard guard{m_builder};
+    trapBlock = llvm::BasicBlock::Create(m_builder.getContext(), "uncommon_trap", m_function);
+    m_builder.SetInsertPoint(trapBlock);
+
+    // Deoptimizing re-executes the branch instruction in the interpreter, recording the branch target in the profile.
+    llvm::Module& module = *m_function->getParent();
+    llvm::CallBase* call = m_builder.CreateCall(
+        module.getOrInsertFunction("jllvm_deoptimize", m_builder.getVoidTy(), m_builder.getInt32Ty()),
+        m_builder.getInt32(static_cast<std::uint32_t>(DeoptimizationReason::UnstableIf)));
+    addDeoptimizationDeopts(byteCodeOffset, call);
+    m_builder.CreateUnreachable();
+    return trapBlock;
+}
+
 void CodeGenerator::createBasicBlocks(const ByteCodeTypeChecker& checker)
 {
     for (const auto& [offset, state] : checker.getBasicBlocks())
@@ -249,6 +352,7 @@ void CodeGenerator::createBasicBlocks(const ByteCodeTypeChecker& checker)
     }
 
     m_retToMap = checker.makeRetToMap();
+    m_liveLocals = checker.computeLiveLocals();
 }
 
 void CodeGenerator::generateCodeBody(std::uint16_t startOffset)
@@ -330,6 +434,7 @@ void CodeGenerator::generateCodeBody(std::uint16_t startOffset)
 bool CodeGenerator::generateInstruction(ByteCodeOp operation)
 {
     bool fallsThrough = true;
+    m_operandStackSizeAtInstruction = m_operandStack.size();
 
     auto generateRet = [&](auto& ret)
     {
@@ -369,7 +474,9 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
 
             llvm::Value* gep = m_builder.CreateGEP(arrayStructType(type), array,
                                                    {m_builder.getInt32(0), m_builder.getInt32(2), index});
-            llvm::Value* value = m_builder.CreateLoad(type, gep);
+            llvm::LoadInst* load = m_builder.CreateLoad(type, gep);
+            annotateArrayElementAccess(load, type);
+            llvm::Value* value = load;
 
             match(
                 operation, [](...) {},
@@ -403,7 +510,7 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
                 [&, arrayType = type](OneOf<BAStore, CAStore, SAStore>)
                 { value = m_builder.CreateTrunc(value, arrayType); });
 
-            m_builder.CreateStore(value, gep);
+            annotateArrayElementAccess(m_builder.CreateStore(value, gep), type);
         },
         [&](AConstNull)
         { m_operandStack.push_back(llvm::ConstantPointerNull::get(referenceType(m_builder.getContext()))); },
@@ -442,11 +549,11 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
             addExceptionHandlingDeopts(getOffset(operation), object);
 
             // Type object.
-            m_builder.CreateStore(classObject, object);
+            annotateClassObjectAccess(m_builder.CreateStore(classObject, object));
             // Array length.
             auto* gep = m_builder.CreateGEP(arrayStructType(referenceType(m_builder.getContext())), object,
                                             {m_builder.getInt32(0), m_builder.getInt32(1)});
-            m_builder.CreateStore(count, gep);
+            annotateArrayLengthAccess(m_builder.CreateStore(count, gep));
 
             m_operandStack.push_back(object);
         },
@@ -481,7 +588,9 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
             // The element type of the array type here is actually irrelevant.
             llvm::Value* gep = m_builder.CreateGEP(arrayStructType(referenceType(m_builder.getContext())), array,
                                                    {m_builder.getInt32(0), m_builder.getInt32(1)});
-            m_operandStack.push_back(m_builder.CreateLoad(m_builder.getInt32Ty(), gep));
+            llvm::LoadInst* length = m_builder.CreateLoad(m_builder.getInt32Ty(), gep);
+            annotateArrayLengthAccess(length);
+            m_operandStack.push_back(length);
         },
         [&](OneOf<AStore, DStore, FStore, IStore, LStore> store) { m_locals[store.index] = m_operandStack.pop_back(); },
         [&](OneOf<AStore0, DStore0, FStore0, IStore0, LStore0, AStore1, DStore1, FStore1, IStore1, LStore1, AStore2,
@@ -502,9 +611,7 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
 
             generateNullPointerCheck(getOffset(operation), exception);
 
-            llvm::CallBase* call = m_builder.CreateCall(throwFunction(m_function->getParent()), exception);
-            addExceptionHandlingDeopts(getOffset(operation), call);
-            m_builder.CreateUnreachable();
+            generateThrow(getOffset(operation), exception);
             fallsThrough = false;
         },
         [&](BIPush biPush)
@@ -528,20 +635,20 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
 
             llvm::Value* classObject = loadClassObjectFromPool(getOffset(operation), op.index);
 
-            llvm::Instruction* call =
-                m_builder.CreateCall(instanceOfFunction(m_function->getParent()), {object, classObject});
+            llvm::Value* instanceOf = generateInstanceOf(object, classObject);
 
             match(
                 operation, [](...) { llvm_unreachable("Invalid operation"); },
                 [&](InstanceOf)
                 {
+                    llvm::BasicBlock* instanceOfDone = m_builder.GetInsertBlock();
                     m_builder.CreateBr(continueBlock);
 
                     m_builder.SetInsertPoint(continueBlock);
                     llvm::PHINode* phi = m_builder.CreatePHI(m_builder.getInt32Ty(), 2);
                     // null references always return 0.
                     phi->addIncoming(m_builder.getInt32(0), block);
-                    phi->addIncoming(call, call->getParent());
+                    phi->addIncoming(instanceOf, instanceOfDone);
 
                     m_operandStack.push_back(phi);
                 },
@@ -549,7 +656,7 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
                 {
                     m_operandStack.push_back(object);
                     auto* throwBlock = llvm::BasicBlock::Create(m_builder.getContext(), "", m_function);
-                    m_builder.CreateCondBr(m_builder.CreateTrunc(call, m_builder.getInt1Ty()), continueBlock,
+                    m_builder.CreateCondBr(m_builder.CreateTrunc(instanceOf, m_builder.getInt1Ty()), continueBlock,
                                            throwBlock);
 
                     m_builder.SetInsertPoint(throwBlock);
@@ -859,7 +966,8 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
             llvm::Value* fieldOffset = getInstanceFieldOffset(getOffset(operation), className, fieldName, fieldType);
 
             llvm::Value* fieldPtr = m_builder.CreateGEP(m_builder.getInt8Ty(), objectRef, {fieldOffset});
-            llvm::Value* field = m_builder.CreateLoad(type, fieldPtr);
+            llvm::LoadInst* field = m_builder.CreateLoad(type, fieldPtr);
+            annotateFieldAccess(field, fieldName, fieldType, /*isStatic=*/false);
 
             m_operandStack.push_back(extendToStackType(m_builder, descriptor, field));
         },
@@ -876,12 +984,17 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
             llvm::Value* fieldPtr = getStaticFieldAddress(getOffset(operation), className, fieldName, fieldType);
 
             llvm::Type* type = descriptorToType(fieldType, m_builder.getContext());
-            llvm::Value* field = m_builder.CreateLoad(type, fieldPtr);
+            llvm::LoadInst* field = m_builder.CreateLoad(type, fieldPtr);
+            annotateFieldAccess(field, fieldName, fieldType, /*isStatic=*/true);
 
             m_operandStack.push_back(extendToStackType(m_builder, fieldType, field));
         },
         [&](OneOf<Goto, GotoW> gotoOp)
         {
+            if (gotoOp.target <= 0)
+            {
+                generateTierUpCheck(gotoOp.offset);
+            }
             m_builder.CreateBr(getBasicBlock(gotoOp.offset + gotoOp.target));
             fallsThrough = false;
         },
@@ -928,8 +1041,15 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
                   IfGe, IfGt, IfLe, IfNonNull, IfNull>
                 cmpOp)
         {
-            llvm::BasicBlock* target = getBasicBlock(cmpOp.offset + cmpOp.target);
-            llvm::BasicBlock* next = getBasicBlock(cmpOp.offset + sizeof(OpCodes) + sizeof(std::int16_t));
+            const MethodProfile* profile = m_method.getProfile();
+            const MethodProfile::BranchProfile* branchProfile =
+                profile ? profile->getBranchProfile(cmpOp.offset) : nullptr;
+            llvm::BasicBlock* target =
+                getBranchTarget(cmpOp.offset, cmpOp.offset + cmpOp.target,
+                                branchProfile ? std::optional(branchProfile->taken) : std::nullopt);
+            llvm::BasicBlock* next =
+                getBranchTarget(cmpOp.offset, cmpOp.offset + sizeof(OpCodes) + sizeof(std::int16_t),
+                                branchProfile ? std::optional(branchProfile->notTaken) : std::nullopt);
 
             llvm::Value* rhs;
             llvm::Value* lhs;
@@ -963,7 +1083,13 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
                 [&](OneOf<IfICmpGe, IfGe>) { predicate = llvm::CmpInst::ICMP_SGE; });
 
             llvm::Value* cond = m_builder.CreateICmp(predicate, lhs, rhs);
-            m_builder.CreateCondBr(cond, target, next);
+            if (cmpOp.target <= 0)
+            {
+                generateTierUpCheck(cmpOp.offset);
+            }
+            m_builder.CreateCondBr(
+                cond, target, next,
+                conditionalBranchWeights(m_builder.getContext(), m_method.getProfile(), getOffset(operation)));
         },
         [&](IInc iInc)
         {
@@ -1130,14 +1256,22 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
         {
             llvm::Value* key = m_operandStack.pop_back();
 
-            llvm::BasicBlock* defaultBlock = getBasicBlock(switchOp.offset + switchOp.defaultOffset);
+            llvm::SmallVector<std::uint16_t> targets{
+                static_cast<std::uint16_t>(switchOp.offset + switchOp.defaultOffset)};
+            for (std::int32_t target : llvm::make_second_range(switchOp.matchOffsetPairs()))
+            {
+                targets.push_back(switchOp.offset + target);
+            }
+            llvm::SmallVector<llvm::BasicBlock*> targetBlocks = getSwitchTargets(switchOp.offset, targets);
 
-            auto* switchInst = m_builder.CreateSwitch(key, defaultBlock, switchOp.rawPairs.size());
+            auto* switchInst = m_builder.CreateSwitch(
+                key, targetBlocks.front(), switchOp.rawPairs.size(),
+                switchBranchWeights(m_builder.getContext(), m_method.getProfile(), switchOp.offset,
+                                    switchOp.rawPairs.size()));
 
-            for (auto [match, target] : switchOp.matchOffsetPairs())
+            for (auto [match, targetBlock] :
+                 llvm::zip_equal(llvm::make_first_range(switchOp.matchOffsetPairs()), llvm::drop_begin(targetBlocks)))
             {
-                llvm::BasicBlock* targetBlock = getBasicBlock(switchOp.offset + target);
-
                 switchInst->addCase(m_builder.getInt32(match), targetBlock);
             }
             fallsThrough = false;
@@ -1234,7 +1368,10 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
 
                 llvm::Value* gep = m_builder.CreateGEP(arrayStructType(referenceType(m_builder.getContext())),
                                                        outerArray, {m_builder.getInt32(0), m_builder.getInt32(2), phi});
-                m_builder.CreateStore(innerArray, gep);
+                annotateArrayElementAccess(m_builder.CreateStore(innerArray, gep),
+                                           referenceType(m_builder.getContext()));
+                // Allocating may have split the loop body into multiple basic blocks.
+                llvm::BasicBlock* body = m_builder.GetInsertBlock();
 
                 m_builder.SetInsertPoint(end);
 
@@ -1244,7 +1381,7 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
                 cmp = m_builder.CreateICmpEQ(counter, size);
                 m_builder.CreateCondBr(cmp, nextEnd, start);
 
-                m_builder.SetInsertPoint(start);
+                m_builder.SetInsertPoint(body);
                 descriptor = get<ArrayType>(descriptor.getComponentType());
                 outerArray = innerArray;
                 size = innerSize;
@@ -1276,7 +1413,7 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
             addExceptionHandlingDeopts(getOffset(operation), object);
 
             // Store object header (which in our case is just the class object) in the object.
-            m_builder.CreateStore(classObject, object);
+            annotateClassObjectAccess(m_builder.CreateStore(classObject, object));
             m_operandStack.push_back(object);
         },
         [&](NewArray newArray)
@@ -1300,11 +1437,11 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
             // Allocation can throw OutOfMemoryException.
             addExceptionHandlingDeopts(getOffset(operation), object);
 
-            m_builder.CreateStore(classObject, object);
+            annotateClassObjectAccess(m_builder.CreateStore(classObject, object));
             // Array length.
             llvm::Value* gep =
                 m_builder.CreateGEP(arrayStructType(type), object, {m_builder.getInt32(0), m_builder.getInt32(1)});
-            m_builder.CreateStore(count, gep);
+            annotateArrayLengthAccess(m_builder.CreateStore(count, gep));
 
             m_operandStack.push_back(object);
         },
@@ -1346,7 +1483,7 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
                 value = m_builder.CreateTrunc(value, llvmFieldType);
             }
 
-            m_builder.CreateStore(value, fieldPtr);
+            annotateFieldAccess(m_builder.CreateStore(value, fieldPtr), fieldName, fieldType, /*isStatic=*/false);
         },
         [&](PutStatic putStatic)
         {
@@ -1369,7 +1506,7 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
                 value = m_builder.CreateTrunc(value, llvmFieldType);
             }
 
-            m_builder.CreateStore(value, fieldPtr);
+            annotateFieldAccess(m_builder.CreateStore(value, fieldPtr), fieldName, fieldType, /*isStatic=*/true);
         },
         [&](Ret ret) { generateRet(ret); },
         [&](Return)
@@ -1390,14 +1527,21 @@ bool CodeGenerator::generateInstruction(ByteCodeOp operation)
         {
             llvm::Value* key = m_operandStack.pop_back();
 
-            llvm::BasicBlock* defaultBlock = getBasicBlock(tableSwitch.offset + tableSwitch.defaultOffset);
-
-            auto* switchInst = m_builder.CreateSwitch(key, defaultBlock, tableSwitch.jumpTable.size());
-            std::int32_t value = tableSwitch.low;
+            llvm::SmallVector<std::uint16_t> targets{
+                static_cast<std::uint16_t>(tableSwitch.offset + tableSwitch.defaultOffset)};
             for (std::int32_t target : tableSwitch.jumpTable)
             {
-                llvm::BasicBlock* targetBlock = getBasicBlock(tableSwitch.offset + target);
+                targets.push_back(tableSwitch.offset + target);
+            }
+            llvm::SmallVector<llvm::BasicBlock*> targetBlocks = getSwitchTargets(tableSwitch.offset, targets);
 
+            auto* switchInst = m_builder.CreateSwitch(
+                key, targetBlocks.front(), tableSwitch.jumpTable.size(),
+                switchBranchWeights(m_builder.getContext(), m_method.getProfile(), tableSwitch.offset,
+                                    tableSwitch.jumpTable.size()));
+            std::int32_t value = tableSwitch.low;
+            for (llvm::BasicBlock* targetBlock : llvm::drop_begin(targetBlocks))
+            {
                 switchInst->addCase(m_builder.getInt32(value++), targetBlock);
             }
             fallsThrough = false;
@@ -1443,17 +1587,224 @@ void CodeGenerator::addExceptionHandlingDeopts(std::uint16_t byteCodeOffset, llv
         return;
     }
 
+    {
+        llvm::IRBuilder<>::InsertPointGuard guard{m_builder};
+        m_builder.SetInsertPoint(callInst);
+
+        llvm::BitVector liveLocals(m_locals.size());
+        for (const Code::ExceptionTable* entry : m_code.getHandlersAtUnordered(byteCodeOffset))
+        {
+            liveLocals |= m_liveLocals.find(entry->handlerPc)->second;
+        }
+
+        std::vector<llvm::Value*> deoptOperands;
+        deoptOperands.push_back(m_builder.getInt16(byteCodeOffset));
+        appendDeoptValues(deoptOperands, getDeoptLocals(liveLocals));
+        appendDeoptValues(deoptOperands, /*values=*/{});
+        replaceWithDeoptCall(callInst, std::move(deoptOperands));
+    }
+
+    generatePendingExceptionDispatch(byteCodeOffset, callInst);
+}
+
+void CodeGenerator::generatePendingExceptionDispatch(std::uint16_t byteCodeOffset, llvm::CallBase* callInst)
+{
+    llvm::BasicBlock* block = callInst->getParent();
+    bool insertsIntoBlock = m_builder.GetInsertBlock() == block;
+    auto* continueBlock = llvm::BasicBlock::Create(m_builder.getContext(), "next", m_function);
+    auto* dispatchBlock = llvm::BasicBlock::Create(m_builder.getContext(), "exception_dispatch", m_function);
+    continueBlock->splice(continueBlock->end(), block, std::next(callInst->getIterator()), block->end());
+    continueBlock->replaceSuccessorsPhiUsesWith(block, continueBlock);
+
+    {
+        llvm::IRBuilder<>::InsertPointGuard guard{m_builder};
+        m_builder.SetInsertPoint(block);
+
+        // The runtime resumes execution after the call as if it returned, with the pending exception set.
+        // The return value of the call, if any, is undefined in that case.
+        llvm::Module& module = *m_function->getParent();
+        llvm::PointerType* reference = referenceType(m_builder.getContext());
+        llvm::GlobalVariable* pendingException = pendingExceptionGlobal(module);
+        llvm::Value* exception = m_builder.CreateLoad(reference, pendingException);
+        m_builder.CreateCondBr(m_builder.CreateIsNotNull(exception), dispatchBlock, continueBlock,
+                               llvm::MDBuilder(m_builder.getContext()).createUnlikelyBranchWeights());
+
+        m_builder.SetInsertPoint(dispatchBlock);
+        m_builder.CreateStore(llvm::ConstantPointerNull::get(reference), pendingException);
+        llvm::Value* handlerOffset = m_builder.CreateLoad(
+            m_builder.getInt16Ty(), m_builder.CreateConstGEP1_32(m_builder.getInt8Ty(), pendingException,
+                                                                 offsetof(PendingException, handlerOffset)));
+        m_operandStack.setBottomOfStackValue(exception);
+
+        // The runtime only ever selects one of the exception handlers active at the call.
+        auto* unreachableBlock = llvm::BasicBlock::Create(m_builder.getContext(), "", m_function);
+        llvm::SwitchInst* switchInst = m_builder.CreateSwitch(handlerOffset, unreachableBlock);
+        for (const Code::ExceptionTable* entry : m_code.getHandlersAt(byteCodeOffset))
+        {
+            llvm::ConstantInt* caseValue = m_builder.getInt16(entry->handlerPc);
+            if (switchInst->findCaseValue(caseValue) == switchInst->case_default())
+            {
+                switchInst->addCase(caseValue, getBasicBlock(entry->handlerPc));
+            }
+        }
+
+        m_builder.SetInsertPoint(unreachableBlock);
+        m_builder.CreateUnreachable();
+    }
+
+    if (insertsIntoBlock)
+    {
+        m_builder.SetInsertPoint(continueBlock);
+    }
+}
+
+void CodeGenerator::generateThrow(std::uint16_t byteCodeOffset, llvm::Value* exception)
+{
+    for (const Code::ExceptionTable* entry : m_code.getHandlersAt(byteCodeOffset))
+    {
+        // Catch-all handlers as is used by 'finally' blocks catch any exception, making any later handlers and the
+        // call to the runtime unreachable.
+        if (!entry->catchType)
+        {
+            m_operandStack.setBottomOfStackValue(exception);
+            m_builder.CreateBr(getBasicBlock(entry->handlerPc));
+            return;
+        }
+
+        // Inserted into the function after the blocks of the instance of check.
+        auto* catchBlock = llvm::BasicBlock::Create(m_builder.getContext(), "catch");
+        auto* nextBlock = llvm::BasicBlock::Create(m_builder.getContext(), "next");
+
+        // Same as when the runtime unwinds, catch types are never loaded. If the type to catch is not loaded, then
+        // it's impossible for the exception to be an instance.
+        llvm::StringRef className = entry->catchType.resolve(m_classFile)->nameIndex.resolve(m_classFile)->text;
+        llvm::Value* classObject =
+            m_builder.CreateCall(forNameLoadedFunction(m_function->getParent()),
+                                 m_builder.CreateGlobalStringPtr(ObjectType(className).textual()));
+        auto* loadedBlock = llvm::BasicBlock::Create(m_builder.getContext(), "loaded", m_function);
+        m_builder.CreateCondBr(m_builder.CreateIsNull(classObject), nextBlock, loadedBlock);
+
+        m_builder.SetInsertPoint(loadedBlock);
+        llvm::Value* instanceOf = generateInstanceOf(exception, classObject);
+        m_builder.CreateCondBr(m_builder.CreateTrunc(instanceOf, m_builder.getInt1Ty()), catchBlock, nextBlock);
+
+        catchBlock->insertInto(m_function);
+        nextBlock->insertInto(m_function);
+        m_builder.SetInsertPoint(catchBlock);
+        m_operandStack.setBottomOfStackValue(exception);
+        m_builder.CreateBr(getBasicBlock(entry->handlerPc));
+
+        m_builder.SetInsertPoint(nextBlock);
+    }
+
+    // Not caught within this method. Let the runtime unwind to the caller.
+    llvm::CallBase* call = m_builder.CreateCall(throwFunction(m_function->getParent()), exception);
+    addExceptionHandlingDeopts(byteCodeOffset, call);
+    m_builder.CreateUnreachable();
+}
+
+void CodeGenerator::addBytecodeOffsetOnlyDeopts(std::uint16_t byteCodeOffset, llvm::CallBase*& callInst)
+{
     llvm::IRBuilder<>::InsertPointGuard guard{m_builder};
     m_builder.SetInsertPoint(callInst);
 
     std::vector<llvm::Value*> deoptOperands;
-    deoptOperands.reserve(2 + m_locals.size());
     deoptOperands.push_back(m_builder.getInt16(byteCodeOffset));
-    deoptOperands.push_back(m_builder.getInt16(m_locals.size()));
-    llvm::transform(m_locals, std::back_inserter(deoptOperands),
+    appendDeoptValues(deoptOperands, /*values=*/{});
+    appendDeoptValues(deoptOperands, /*values=*/{});
+    replaceWithDeoptCall(callInst, std::move(deoptOperands));
+}
+
+void CodeGenerator::addDeoptimizationDeopts(std::uint16_t byteCodeOffset, llvm::CallBase*& callInst)
+{
+    llvm::IRBuilder<>::InsertPointGuard guard{m_builder};
+    m_builder.SetInsertPoint(callInst);
+
+    std::vector<llvm::Value*> deoptOperands;
+    deoptOperands.push_back(m_builder.getInt16(byteCodeOffset));
+    appendDeoptValues(deoptOperands, getDeoptLocals(m_liveLocals.find(byteCodeOffset)->second));
+    appendDeoptValues(deoptOperands, getDeoptOperandStack(m_operandStackSizeAtInstruction));
+    replaceWithDeoptCall(callInst, std::move(deoptOperands));
+}
+
+void CodeGenerator::addJavaCallDeopts(std::uint16_t byteCodeOffset, llvm::CallBase*& callInst)
+{
+    if (!m_recordCallFrames)
+    {
+        addExceptionHandlingDeopts(byteCodeOffset, callInst);
+        return;
+    }
+
+    {
+        llvm::IRBuilder<>::InsertPointGuard guard{m_builder};
+        m_builder.SetInsertPoint(callInst);
+
+        // The interpreter continues after the call once an inlined callee returns or at an exception handler if it
+        // throws.
+        llvm::BitVector liveLocals = m_liveLocals.find(byteCodeOffset)->second;
+        for (const Code::ExceptionTable* entry : m_code.getHandlersAtUnordered(byteCodeOffset))
+        {
+            liveLocals |= m_liveLocals.find(entry->handlerPc)->second;
+        }
+
+        // The arguments of the call have already been popped from the operand stack.
+        std::vector<llvm::Value*> deoptOperands;
+        deoptOperands.push_back(m_builder.getInt16(byteCodeOffset));
+        appendDeoptValues(deoptOperands, getDeoptLocals(liveLocals));
+        appendDeoptValues(deoptOperands, getDeoptOperandStack(m_operandStack.size()));
+        replaceWithDeoptCall(callInst, std::move(deoptOperands));
+    }
+
+    if (!llvm::hasNItems(m_code.getHandlersAtUnordered(byteCodeOffset), 0))
+    {
+        generatePendingExceptionDispatch(byteCodeOffset, callInst);
+    }
+}
+
+llvm::SmallVector<llvm::Value*> CodeGenerator::getDeoptOperandStack(std::size_t count)
+{
+    // The interpreter uses two operand stack slots for 'long' and 'double', the second having an unspecified value.
+    llvm::SmallVector<llvm::Value*> operandStack;
+    for (llvm::Value* value : m_operandStack.loadValues(count))
+    {
+        operandStack.push_back(value);
+        if (value->getType()->isIntegerTy(64) || value->getType()->isDoubleTy())
+        {
+            operandStack.push_back(nullptr);
+        }
+    }
+    return operandStack;
+}
+
+llvm::SmallVector<llvm::Value*> CodeGenerator::getDeoptLocals(const llvm::BitVector& liveLocals)
+{
+    llvm::Type* reference = referenceType(m_builder.getContext());
+    llvm::SmallVector<llvm::Value*> values(m_locals.size());
+    for (std::uint16_t index : llvm::seq<std::uint16_t>(0, m_locals.size()))
+    {
+        if (liveLocals.test(index))
+        {
+            values[index] = m_locals[index];
+            continue;
+        }
+
+        // Dead references are recorded as null rather than as uninitialized. The interpreter derives the GC mask of
+        // its local variables from their types, potentially treating the dead local variable as a root.
+        if (m_locals.getType(index) == reference)
+        {
+            values[index] = llvm::ConstantPointerNull::get(llvm::cast<llvm::PointerType>(reference));
+        }
+    }
+    return values;
+}
+
+void CodeGenerator::appendDeoptValues(std::vector<llvm::Value*>& deoptOperands, llvm::ArrayRef<llvm::Value*> values)
+{
+    deoptOperands.push_back(m_builder.getInt16(values.size()));
+    llvm::transform(values, std::back_inserter(deoptOperands),
                     [&](llvm::Value* value) -> llvm::Value*
                     {
-                        // Uninitialized locals placed in the optimization state as poison values.
+                        // Uninitialized slots are placed in the optimization state as poison values.
                         if (!value)
                         {
                             return llvm::PoisonValue::get(m_builder.getInt8Ty());
@@ -1473,35 +1824,22 @@ void CodeGenerator::addExceptionHandlingDeopts(std::uint16_t byteCodeOffset, llv
                         return value;
                     });
 
-    std::vector<std::uint64_t> localsGCMask(llvm::divideCeil(m_locals.size(), 64));
-    auto ref = MutableBitArrayRef(localsGCMask.data(), m_locals.size());
+    std::vector<std::uint64_t> gcMask(llvm::divideCeil(values.size(), 64));
+    auto ref = MutableBitArrayRef(gcMask.data(), values.size());
     llvm::Type* reference = referenceType(m_builder.getContext());
-    for (auto [index, value] : llvm::enumerate(llvm::ArrayRef<llvm::Value*>(deoptOperands).take_back(m_locals.size())))
+    for (auto [index, value] : llvm::enumerate(llvm::ArrayRef<llvm::Value*>(deoptOperands).take_back(values.size())))
     {
         if (value->getType() == reference)
         {
             ref[index] = true;
         }
     }
-    llvm::transform(localsGCMask, std::back_inserter(deoptOperands),
+    llvm::transform(gcMask, std::back_inserter(deoptOperands),
                     [&](std::uint64_t mask) { return m_builder.getInt64(mask); });
-
-    llvm::CallBase* newCall = llvm::CallBase::addOperandBundle(
-        callInst, llvm::LLVMContext::OB_deopt, llvm::OperandBundleDef("deopt", std::move(deoptOperands)), callInst);
-    callInst->replaceAllUsesWith(newCall);
-    callInst->eraseFromParent();
-    callInst = newCall;
 }
 
-void CodeGenerator::addBytecodeOffsetOnlyDeopts(std::uint16_t byteCodeOffset, llvm::CallBase*& callInst)
+void CodeGenerator::replaceWithDeoptCall(llvm::CallBase*& callInst, std::vector<llvm::Value*>&& deoptOperands)
 {
-    llvm::IRBuilder<>::InsertPointGuard guard{m_builder};
-    m_builder.SetInsertPoint(callInst);
-
-    std::vector<llvm::Value*> deoptOperands;
-    deoptOperands.push_back(m_builder.getInt16(byteCodeOffset));
-    deoptOperands.push_back(m_builder.getInt16(0));
-
     llvm::CallBase* newCall = llvm::CallBase::addOperandBundle(
         callInst, llvm::LLVMContext::OB_deopt, llvm::OperandBundleDef("deopt", std::move(deoptOperands)), callInst);
     callInst->replaceAllUsesWith(newCall);
@@ -1509,14 +1847,17 @@ void CodeGenerator::addBytecodeOffsetOnlyDeopts(std::uint16_t byteCodeOffset, ll
     callInst = newCall;
 }
 
-void CodeGenerator::generateBuiltinExceptionThrow(std::uint16_t byteCodeOffset, llvm::Value* condition,
-                                                  llvm::StringRef builderName, llvm::ArrayRef<llvm::Value*> builderArgs)
+llvm::BranchInst* CodeGenerator::generateBuiltinExceptionThrow(std::uint16_t byteCodeOffset, llvm::Value* condition,
+                                                               llvm::StringRef builderName,
+                                                               llvm::ArrayRef<llvm::Value*> builderArgs)
 {
     llvm::PointerType* exceptionType = referenceType(m_builder.getContext());
 
     auto* continueBlock = llvm::BasicBlock::Create(m_builder.getContext(), "next", m_function);
     auto* exceptionBlock = llvm::BasicBlock::Create(m_builder.getContext(), "exception", m_function);
-    m_builder.CreateCondBr(condition, exceptionBlock, continueBlock);
+    llvm::BranchInst* branch =
+        m_builder.CreateCondBr(condition, exceptionBlock, continueBlock,
+                               llvm::MDBuilder(m_builder.getContext()).createUnlikelyBranchWeights());
     m_builder.SetInsertPoint(exceptionBlock);
 
     std::vector<llvm::Type*> argTypes{builderArgs.size()};
@@ -1531,6 +1872,41 @@ void CodeGenerator::generateBuiltinExceptionThrow(std::uint16_t byteCodeOffset,
 
     m_builder.CreateUnreachable();
 
+    m_builder.SetInsertPoint(continueBlock);
+    return branch;
+}
+
+void CodeGenerator::generateTierUpCheck(std::uint16_t byteCodeOffset)
+{
+    if (!m_tierUpCounter)
+    {
+        return;
+    }
+
+    llvm::Value* counter = m_builder.CreateLoad(m_builder.getInt64Ty(), m_tierUpCounter);
+    counter = m_builder.CreateSub(counter, m_builder.getInt64(1));
+    m_builder.CreateStore(counter, m_tierUpCounter);
+
+    // The counter keeps decrementing past zero. 'jllvm_tier_up' is called when reaching zero and afterwards once every
+    // 'TierUpPollInterval' decrements. The latter allows the runtime to install the optimized code once its background
+    // compilation has finished, even if no other code calls into the runtime in the meantime.
+    constexpr std::uint64_t TierUpPollInterval = 1024;
+    auto* continueBlock = llvm::BasicBlock::Create(m_builder.getContext(), "next", m_function);
+    auto* tierUpBlock = llvm::BasicBlock::Create(m_builder.getContext(), "tier_up", m_function);
+    llvm::Value* reachedThreshold = m_builder.CreateICmpSLE(counter, m_builder.getInt64(0));
+    llvm::Value* atInterval = m_builder.CreateICmpEQ(
+        m_builder.CreateAnd(counter, m_builder.getInt64(TierUpPollInterval - 1)), m_builder.getInt64(0));
+    m_builder.CreateCondBr(m_builder.CreateAnd(reachedThreshold, atInterval), tierUpBlock, continueBlock,
+                           llvm::MDBuilder(m_builder.getContext()).createUnlikelyBranchWeights());
+    m_builder.SetInsertPoint(tierUpBlock);
+
+    llvm::Module& module = *m_function->getParent();
+    llvm::CallBase* call = m_builder.CreateCall(
+        module.getOrInsertFunction("jllvm_tier_up", m_builder.getVoidTy(), m_builder.getPtrTy()),
+        methodGlobal(module, &m_method));
+    addBytecodeOffsetOnlyDeopts(byteCodeOffset, call);
+    m_builder.CreateBr(continueBlock);
+
     m_builder.SetInsertPoint(continueBlock);
 }
 
@@ -1539,7 +1915,14 @@ void CodeGenerator::generateNullPointerCheck(std::uint16_t byteCodeOffset, llvm:
     llvm::Value* null = llvm::ConstantPointerNull::get(referenceType(m_builder.getContext()));
     llvm::Value* isNull = m_builder.CreateICmpEQ(object, null);
 
-    generateBuiltinExceptionThrow(byteCodeOffset, isNull, "jllvm_throw_null_pointer_exception", {});
+    llvm::BranchInst* branch =
+        generateBuiltinExceptionThrow(byteCodeOffset, isNull, "jllvm_throw_null_pointer_exception", {});
+
+    // Allows LLVM's implicit null check pass to fold the check into a subsequent load or store. The page at address
+    // zero is never mapped, making such memory accesses fault if 'object' is null. The faulting instruction and the
+    // exception block are recorded in the fault map, which is used by the SIGSEGV handler of the VM to continue
+    // execution in the exception block.
+    branch->setMetadata(llvm::LLVMContext::MD_make_implicit, llvm::MDNode::get(m_builder.getContext(), {}));
 }
 
 void CodeGenerator::generateArrayIndexCheck(std::uint16_t byteCodeOffset, llvm::Value* array, llvm::Value* index)
@@ -1548,11 +1931,12 @@ void CodeGenerator::generateArrayIndexCheck(std::uint16_t byteCodeOffset, llvm::
     llvm::PointerType* type = referenceType(m_builder.getContext());
     llvm::Value* gep =
         m_builder.CreateGEP(arrayStructType(type), array, {m_builder.getInt32(0), m_builder.getInt32(1)});
-    llvm::Value* size = m_builder.CreateLoad(m_builder.getInt32Ty(), gep);
+    llvm::LoadInst* size = m_builder.CreateLoad(m_builder.getInt32Ty(), gep);
+    annotateArrayLengthAccess(size);
 
-    llvm::Value* isNegative = m_builder.CreateICmpSLT(index, m_builder.getInt32(0));
-    llvm::Value* isBigger = m_builder.CreateICmpSGE(index, size);
-    llvm::Value* outOfBounds = m_builder.CreateOr(isNegative, isBigger);
+    // The length of an array is never negative. A single unsigned comparison therefore also catches negative indices.
+    // This is also the form recognized by 'ArrayBoundsCheckEliminationPass' and LLVM's 'IRCEPass'.
+    llvm::Value* outOfBounds = m_builder.CreateICmpUGE(index, size);
 
     generateBuiltinExceptionThrow(byteCodeOffset, outOfBounds, "jllvm_throw_array_index_out_of_bounds_exception",
                                   {index, size});
@@ -1565,6 +1949,43 @@ void CodeGenerator::generateNegativeArraySizeCheck(std::uint16_t byteCodeOffset,
     generateBuiltinExceptionThrow(byteCodeOffset, isNegative, "jllvm_throw_negative_array_size_exception", {size});
 }
 
+llvm::Value* CodeGenerator::generateInstanceOf(llvm::Value* object, llvm::Value* classObject)
+{
+    // Equivalent to the constant time checks in 'ClassObject::wouldBeInstanceOf'.
+    llvm::LoadInst* objectClass = m_builder.CreateLoad(referenceType(m_builder.getContext()), object);
+    annotateClassObjectAccess(objectClass);
+    llvm::Value* superCheckOffset = m_builder.CreateLoad(
+        m_builder.getInt32Ty(), m_builder.CreateGEP(m_builder.getInt8Ty(), classObject,
+                                                    {m_builder.getInt32(ClassObject::getSuperCheckOffsetOffset())}));
+    llvm::Value* candidate = m_builder.CreateLoad(
+        referenceType(m_builder.getContext()),
+        m_builder.CreateGEP(m_builder.getInt8Ty(), objectClass, {superCheckOffset}));
+
+    llvm::BasicBlock* fastPathBlock = m_builder.GetInsertBlock();
+    auto* continueBlock = llvm::BasicBlock::Create(m_builder.getContext(), "", m_function);
+    auto* notFoundBlock = llvm::BasicBlock::Create(m_builder.getContext(), "", m_function);
+    auto* slowPathBlock = llvm::BasicBlock::Create(m_builder.getContext(), "", m_function);
+    m_builder.CreateCondBr(m_builder.CreateICmpEQ(candidate, classObject), continueBlock, notFoundBlock,
+                           llvm::MDBuilder(m_builder.getContext()).createLikelyBranchWeights());
+
+    // If 'classObject' is part of the primary super display, not finding it at its offset is conclusive.
+    m_builder.SetInsertPoint(notFoundBlock);
+    llvm::Value* isSecondary =
+        m_builder.CreateICmpEQ(superCheckOffset, m_builder.getInt32(ClassObject::getSecondarySuperCacheOffset()));
+    m_builder.CreateCondBr(isSecondary, slowPathBlock, continueBlock);
+
+    m_builder.SetInsertPoint(slowPathBlock);
+    llvm::Value* call = m_builder.CreateCall(instanceOfFunction(m_function->getParent()), {object, classObject});
+    m_builder.CreateBr(continueBlock);
+
+    m_builder.SetInsertPoint(continueBlock);
+    llvm::PHINode* phi = m_builder.CreatePHI(m_builder.getInt32Ty(), 3);
+    phi->addIncoming(m_builder.getInt32(1), fastPathBlock);
+    phi->addIncoming(m_builder.getInt32(0), notFoundBlock);
+    phi->addIncoming(call, slowPathBlock);
+    return phi;
+}
+
 llvm::Value* CodeGenerator::loadClassObjectFromPool(std::uint16_t offset, PoolIndex<ClassInfo> index)
 {
     llvm::StringRef className = index.resolve(m_classFile)->nameIndex.resolve(m_classFile)->text;
@@ -1589,11 +2010,11 @@ llvm::Value* CodeGenerator::generateAllocArray(std::uint16_t offset, ArrayType d
     llvm::CallBase* array = m_builder.CreateCall(allocationFunction(m_function->getParent()), bytesNeeded);
     addExceptionHandlingDeopts(offset, array);
 
-    m_builder.CreateStore(classObject, array);
+    annotateClassObjectAccess(m_builder.CreateStore(classObject, array));
 
     llvm::Value* gep =
         m_builder.CreateGEP(arrayStructType(elementType), array, {m_builder.getInt32(0), m_builder.getInt32(1)});
-    m_builder.CreateStore(size, gep);
+    annotateArrayLengthAccess(m_builder.CreateStore(size, gep));
 
     return array;
 }
@@ -1608,7 +2029,7 @@ llvm::Value* CodeGenerator::doStaticCall(std::uint16_t offset, llvm::StringRef c
     applyABIAttributes(llvm::cast<llvm::Function>(function.getCallee()), methodType, /*isStatic=*/true);
     llvm::CallBase* call = m_builder.CreateCall(function, args);
     applyABIAttributes(call, methodType, /*isStatic=*/true);
-    addExceptionHandlingDeopts(offset, call);
+    addJavaCallDeopts(offset, call);
     return call;
 }
 
@@ -1621,10 +2042,149 @@ llvm::Value* CodeGenerator::doInstanceCall(std::uint16_t offset, llvm::StringRef
     llvm::FunctionCallee function = module->getOrInsertFunction(
         mangleMethodResolutionCall(resolution, className, methodName, methodType), functionType);
     applyABIAttributes(llvm::cast<llvm::Function>(function.getCallee()), methodType, /*isStatic=*/false);
+
+    llvm::SmallVector<SpeculatedCallee, MethodProfile::ReceiverTypeProfile::Rows> speculatedCallees =
+        getSpeculatedCallees(offset, methodName, methodType);
+    if (speculatedCallees.empty())
+    {
+        llvm::CallBase* call = m_builder.CreateCall(function, args);
+        applyABIAttributes(call, methodType, /*isStatic=*/false);
+        addJavaCallDeopts(offset, call);
+        return call;
+    }
+
+    // Guarded devirtualization: The profile has only ever seen one or two classes of receivers at this call site.
+    // Check whether the receiver is of one of these classes and call the selected method directly, falling back to the
+    // generic method resolution stub otherwise. The direct calls can later be inlined by LLVM.
+    llvm::LoadInst* thisClassObject = m_builder.CreateLoad(referenceType(m_builder.getContext()), args.front());
+    annotateClassObjectAccess(thisClassObject);
+    auto* continueBlock = llvm::BasicBlock::Create(m_builder.getContext(), "", m_function);
+    llvm::SmallVector<std::pair<llvm::Value*, llvm::BasicBlock*>> results;
+
+    std::uint64_t remainingCount = 0;
+    for (const SpeculatedCallee& speculatedCallee : speculatedCallees)
+    {
+        remainingCount += speculatedCallee.count;
+    }
+
+    for (const SpeculatedCallee& speculatedCallee : speculatedCallees)
+    {
+        llvm::Value* isSpeculatedClass = m_builder.CreateICmpEQ(
+            thisClassObject, classObjectGlobal(*module, speculatedCallee.receiverClass->getDescriptor()));
+        auto* directBlock = llvm::BasicBlock::Create(m_builder.getContext(), "", m_function);
+        auto* nextBlock = llvm::BasicBlock::Create(m_builder.getContext(), "", m_function);
+
+        // The fallback path was never taken during profiling. Keep it unlikely even if the profile counts are low.
+        remainingCount -= speculatedCallee.count;
+        llvm::LLVMContext& context = m_builder.getContext();
+        m_builder.CreateCondBr(isSpeculatedClass, directBlock, nextBlock,
+                               remainingCount == 0 ?
+                                   llvm::MDBuilder(context).createLikelyBranchWeights() :
+                                   createBranchWeights(context, {speculatedCallee.count, remainingCount}));
+
+        m_builder.SetInsertPoint(directBlock);
+        llvm::FunctionCallee directFunction =
+            module->getOrInsertFunction(mangleDirectMethodCall(speculatedCallee.callee), functionType);
+        applyABIAttributes(llvm::cast<llvm::Function>(directFunction.getCallee()), methodType, /*isStatic=*/false);
+        llvm::CallBase* directCall = m_builder.CreateCall(directFunction, args);
+        applyABIAttributes(directCall, methodType, /*isStatic=*/false);
+        addJavaCallDeopts(offset, directCall);
+        results.emplace_back(directCall, m_builder.GetInsertBlock());
+        m_builder.CreateBr(continueBlock);
+
+        m_builder.SetInsertPoint(nextBlock);
+    }
+
+    generateSpeculationFailureCheck(offset);
     llvm::CallBase* call = m_builder.CreateCall(function, args);
     applyABIAttributes(call, methodType, /*isStatic=*/false);
-    addExceptionHandlingDeopts(offset, call);
-    return call;
+    addJavaCallDeopts(offset, call);
+    results.emplace_back(call, m_builder.GetInsertBlock());
+    m_builder.CreateBr(continueBlock);
+
+    m_builder.SetInsertPoint(continueBlock);
+    if (call->getType()->isVoidTy())
+    {
+        return call;
+    }
+
+    llvm::PHINode* phi = m_builder.CreatePHI(call->getType(), results.size());
+    for (auto [value, predecessor] : results)
+    {
+        phi->addIncoming(value, predecessor);
+    }
+    return phi;
+}
+
+llvm::SmallVector<CodeGenerator::SpeculatedCallee, MethodProfile::ReceiverTypeProfile::Rows>
+    CodeGenerator::getSpeculatedCallees(std::uint16_t offset, llvm::StringRef methodName, MethodType methodType) const
+{
+    const MethodProfile* profile = m_method.getProfile();
+    if (!profile)
+    {
+        return {};
+    }
+
+    const MethodProfile::ReceiverTypeProfile* receiverProfile = profile->getReceiverTypeProfile(offset);
+    if (!receiverProfile || receiverProfile->getPolymorphicCount() != 0)
+    {
+        return {};
+    }
+
+    llvm::SmallVector<SpeculatedCallee, MethodProfile::ReceiverTypeProfile::Rows> result;
+    for (auto [receiverClass, count] : receiverProfile->getRows())
+    {
+        if (!receiverClass)
+        {
+            continue;
+        }
+
+        // Perform the same resolution and selection as would be done at runtime for a receiver of 'receiverClass'.
+        const Method* resolvedMethod = receiverClass->methodResolution(methodName, methodType);
+        if (!resolvedMethod)
+        {
+            return {};
+        }
+        const Method& selected = receiverClass->methodSelection(*resolvedMethod);
+        if (selected.isAbstract())
+        {
+            return {};
+        }
+        result.push_back({receiverClass, &selected, count});
+    }
+
+    llvm::stable_sort(result, [](const SpeculatedCallee& lhs, const SpeculatedCallee& rhs)
+                      { return lhs.count > rhs.count; });
+    return result;
+}
+
+void CodeGenerator::generateSpeculationFailureCheck(std::uint16_t byteCodeOffset)
+{
+    llvm::Module& module = *m_function->getParent();
+    auto* failureCounter = new llvm::GlobalVariable(module, m_builder.getInt64Ty(), /*isConstant=*/false,
+                                                    llvm::GlobalValue::InternalLinkage,
+                                                    m_builder.getInt64(speculationFailureThreshold),
+                                                    "speculation_failure_counter");
+
+    llvm::Value* counter = m_builder.CreateLoad(m_builder.getInt64Ty(), failureCounter);
+    counter = m_builder.CreateSub(counter, m_builder.getInt64(1));
+    m_builder.CreateStore(counter, failureCounter);
+
+    // The counter keeps decrementing past zero, making sure 'jllvm_deoptimize' is only called once.
+    auto* continueBlock = llvm::BasicBlock::Create(m_builder.getContext(), "next", m_function);
+    auto* failedBlock = llvm::BasicBlock::Create(m_builder.getContext(), "speculation_failed", m_function);
+    m_builder.CreateCondBr(m_builder.CreateICmpEQ(counter, m_builder.getInt64(0)), failedBlock, continueBlock,
+                           llvm::MDBuilder(m_builder.getContext()).createUnlikelyBranchWeights());
+    m_builder.SetInsertPoint(failedBlock);
+
+    llvm::CallBase* call = m_builder.CreateCall(
+        module.getOrInsertFunction("jllvm_deoptimize", m_builder.getVoidTy(), m_builder.getInt32Ty()),
+        m_builder.getInt32(static_cast<std::uint32_t>(DeoptimizationReason::ClassCheck)));
+    addDeoptimizationDeopts(byteCodeOffset, call);
+    // 'jllvm_deoptimize' only returns if the frame could not be deoptimized.
+    m_builder.CreateBr(continueBlock);
+
+    m_builder.SetInsertPoint(continueBlock);
 }
 
 llvm::Value* CodeGenerator::doSpecialCall(std::uint16_t offset, llvm::StringRef className, llvm::StringRef methodName,
@@ -1640,7 +2200,7 @@ llvm::Value* CodeGenerator::doSpecialCall(std::uint16_t offset, llvm::StringRef
     applyABIAttributes(llvm::cast<llvm::Function>(function.getCallee()), methodType, /*isStatic=*/false);
     llvm::CallBase* call = m_builder.CreateCall(function, args);
     applyABIAttributes(call, methodType, /*isStatic=*/false);
-    addExceptionHandlingDeopts(offset, call);
+    addJavaCallDeopts(offset, call);
     return call;
 }
 
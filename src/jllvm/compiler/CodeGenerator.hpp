@@ -16,6 +16,7 @@
 #include <llvm/IR/DIBuilder.h>
 
 #include <jllvm/class/ByteCodeIterator.hpp>
+#include <jllvm/object/MethodProfile.hpp>
 
 #include <map>
 
@@ -48,8 +49,25 @@ class CodeGenerator
     llvm::BasicBlock* m_returnBlock{};
 
     ByteCodeTypeChecker::PossibleRetsMap m_retToMap;
+    ByteCodeTypeChecker::LiveLocalsMap m_liveLocals;
     llvm::SmallSetVector<std::uint16_t, 8> m_workList;
 
+    /// Counter decremented on every method entry and loop backedge. Null if the code should not tier up.
+    llvm::GlobalVariable* m_tierUpCounter{};
+
+    /// Size of the operand stack prior to the instruction currently being compiled popping any of its operands.
+    std::size_t m_operandStackSizeAtInstruction{};
+
+    /// Profile used to replace branch targets that were never branched to with uncommon traps. Null if no uncommon
+    /// traps should be emitted.
+    const MethodProfile* m_uncommonTrapProfile{};
+    /// Uncommon trap blocks created for the branch instruction at a given bytecode offset.
+    llvm::DenseMap<std::uint16_t, llvm::BasicBlock*> m_uncommonTraps;
+
+    /// True if calls to Java methods should record the state required to continue execution in the interpreter after
+    /// the call returns.
+    bool m_recordCallFrames{};
+
     /// Returns the basic block corresponding to the given bytecode offset and schedules the basic block to be compiled.
     /// The offset must point to the start of a basic block.
     llvm::BasicBlock* getBasicBlock(std::uint16_t offset)
@@ -58,6 +76,23 @@ class CodeGenerator
         return m_basicBlocks.find(offset)->second.block;
     }
 
+    /// Returns the basic block the branch instruction at 'byteCodeOffset' should branch to for reaching the target
+    /// 'offset'. 'count' is the number of times the profile recorded the branch instruction branching to 'offset' or
+    /// an empty optional if the branch instruction was never profiled. If 'count' is zero and uncommon traps are
+    /// enabled, an uncommon trap is returned instead and 'offset' is not scheduled to be compiled.
+    llvm::BasicBlock* getBranchTarget(std::uint16_t byteCodeOffset, std::uint16_t offset,
+                                      std::optional<std::uint64_t> count);
+
+    /// Returns the basic blocks for the targets of the switch instruction at 'byteCodeOffset' as returned by
+    /// 'getBranchTarget'. 'targets' contains the bytecode offset of the default target followed by the ones of all
+    /// cases.
+    llvm::SmallVector<llvm::BasicBlock*> getSwitchTargets(std::uint16_t byteCodeOffset,
+                                                          llvm::ArrayRef<std::uint16_t> targets);
+
+    /// Returns a basic block deoptimizing the frame by calling 'jllvm_deoptimize'. The interpreter then re-executes
+    /// the branch instruction at 'byteCodeOffset'. All uses of the same 'byteCodeOffset' share the basic block.
+    llvm::BasicBlock* getUncommonTrap(std::uint16_t byteCodeOffset);
+
     void createBasicBlocks(const ByteCodeTypeChecker& checker);
 
     void generateCodeBody(std::uint16_t startOffset);
@@ -71,24 +106,85 @@ class CodeGenerator
     ///     uint16_t byteCodeOffset;
     ///     uint16_t numLocals;
     ///     locations locals[numLocals];
+    ///     uint64_t localsGCMask[ceil(numLocals / 64)];
+    ///     uint16_t numOperands;
+    ///     locations operandStack[numOperands];
+    ///     uint64_t operandStackGCMask[ceil(numOperands / 64)];
     ///
+    /// The operand stack is always empty, as exception handlers do not make use of it. Only local variables live at
+    /// any of the exception handlers are recorded, with all other local variables being recorded as constants.
     /// The original call is replaced and erased.
+    ///
+    /// If any exception handlers are active at 'byteCodeOffset', code dispatching exceptions thrown by the call to the
+    /// exception handlers is additionally generated after the call.
     void addExceptionHandlingDeopts(std::uint16_t byteCodeOffset, llvm::CallBase*& callInst);
 
+    /// Splits the basic block after 'callInst' and generates a branch to the exception handler selected by the runtime
+    /// if the runtime resumed execution after 'callInst' with a 'PendingException'.
+    void generatePendingExceptionDispatch(std::uint16_t byteCodeOffset, llvm::CallBase* callInst);
+
+    /// Generates code throwing the non-null 'exception' at 'byteCodeOffset'. Exception handlers active at
+    /// 'byteCodeOffset' are tested inline in order, branching directly to the first one catching 'exception'.
+    void generateThrow(std::uint16_t byteCodeOffset, llvm::Value* exception);
+
     /// Creates a new call from 'callInst' which contains the deoptimization information required for generating a Java
     /// backtrace. This is equal to using 'addExceptionHandlingDeopts' but with the number of local variables set to
     /// zero.
     void addBytecodeOffsetOnlyDeopts(std::uint16_t byteCodeOffset, llvm::CallBase*& callInst);
 
-    void generateBuiltinExceptionThrow(std::uint16_t byteCodeOffset, llvm::Value* condition,
-                                       llvm::StringRef builderName, llvm::ArrayRef<llvm::Value*> builderArgs);
+    /// Creates a new call from 'callInst' which contains the deoptimization information required for continuing
+    /// execution in the interpreter at 'byteCodeOffset'. This is equal to using 'addExceptionHandlingDeopts' but
+    /// additionally contains the operand stack prior to the current instruction in the layout used by the interpreter.
+    /// Only local variables live at 'byteCodeOffset' are recorded.
+    void addDeoptimizationDeopts(std::uint16_t byteCodeOffset, llvm::CallBase*& callInst);
+
+    /// Creates a new call from the call to a Java method 'callInst' which contains the deoptimization information
+    /// required for continuing execution in the interpreter once the callee returns. This is equal to using
+    /// 'addExceptionHandlingDeopts' if call frames are not recorded. Otherwise, the local variables live at
+    /// 'byteCodeOffset' or any of its exception handlers and the operand stack without the arguments of the call are
+    /// recorded. This allows deoptimizing the frames of methods inlined into the call.
+    void addJavaCallDeopts(std::uint16_t byteCodeOffset, llvm::CallBase*& callInst);
+
+    /// Returns the values of all local variables for use as deoptimization operands. Local variables not contained in
+    /// 'liveLocals' are replaced with constants, preventing their values from being kept alive across calls.
+    llvm::SmallVector<llvm::Value*> getDeoptLocals(const llvm::BitVector& liveLocals);
 
+    /// Returns the bottom-most 'count' values of the operand stack for use as deoptimization operands in the layout
+    /// used by the interpreter.
+    llvm::SmallVector<llvm::Value*> getDeoptOperandStack(std::size_t count);
+
+    /// Appends the number of 'values', the locations of 'values' and their GC mask to 'deoptOperands'. Null values
+    /// denote uninitialized slots.
+    void appendDeoptValues(std::vector<llvm::Value*>& deoptOperands, llvm::ArrayRef<llvm::Value*> values);
+
+    /// Creates a new call from 'callInst' with a 'deopt' operand bundle containing 'deoptOperands'.
+    /// The original call is replaced and erased.
+    static void replaceWithDeoptCall(llvm::CallBase*& callInst, std::vector<llvm::Value*>&& deoptOperands);
+
+    /// Generates a branch on 'condition' to a block throwing the exception created by the builtin 'builderName'.
+    /// Returns the generated branch.
+    llvm::BranchInst* generateBuiltinExceptionThrow(std::uint16_t byteCodeOffset, llvm::Value* condition,
+                                                    llvm::StringRef builderName,
+                                                    llvm::ArrayRef<llvm::Value*> builderArgs);
+
+    /// Generates a check throwing a 'NullPointerException' if 'object' is null. The check is marked as a candidate for
+    /// an implicit null check, allowing the code generator to replace it with the first memory access through
+    /// 'object' if that access faults when 'object' is null.
     void generateNullPointerCheck(std::uint16_t byteCodeOffset, llvm::Value* object);
 
     void generateArrayIndexCheck(std::uint16_t byteCodeOffset, llvm::Value* array, llvm::Value* index);
 
     void generateNegativeArraySizeCheck(std::uint16_t byteCodeOffset, llvm::Value* size);
 
+    /// Generates an i32 that is 1 if the non-null 'object' is an instance of 'classObject' and 0 otherwise.
+    /// The check is performed inline using the super check offset of 'classObject', only calling into the runtime if
+    /// 'classObject' is not a primary super of the class of 'object'.
+    llvm::Value* generateInstanceOf(llvm::Value* object, llvm::Value* classObject);
+
+    /// Decrements the tier up counter and calls 'jllvm_tier_up' with the method once it reaches zero.
+    /// Does nothing if the code should not tier up.
+    void generateTierUpCheck(std::uint16_t byteCodeOffset);
+
     llvm::Value* loadClassObjectFromPool(std::uint16_t offset, PoolIndex<ClassInfo> index);
 
     llvm::Value* generateAllocArray(std::uint16_t offset, ArrayType descriptor, llvm::Value* classObject,
@@ -104,6 +200,28 @@ class CodeGenerator
     llvm::Value* doInstanceCall(std::uint16_t offset, llvm::StringRef className, llvm::StringRef methodName,
                                 MethodType methodType, llvm::ArrayRef<llvm::Value*> args, MethodResolution resolution);
 
+    /// Receiver class a virtual call is speculated on together with the method selected for it.
+    struct SpeculatedCallee
+    {
+        const ClassObject* receiverClass;
+        const Method* callee;
+        /// Number of times 'receiverClass' was recorded as receiver by the profile.
+        std::uint64_t count;
+    };
+
+    /// Returns the receiver classes and the methods that would be called by the virtual call at 'offset' if the
+    /// receiver type profile of the method shows that at most 'MethodProfile::ReceiverTypeProfile::Rows' distinct
+    /// classes of receivers have ever been seen. The most frequent receiver class comes first.
+    /// Returns an empty vector if no such speculation is possible.
+    llvm::SmallVector<SpeculatedCallee, MethodProfile::ReceiverTypeProfile::Rows>
+        getSpeculatedCallees(std::uint16_t offset, llvm::StringRef methodName, MethodType methodType) const;
+
+    /// Decrements the failure counter of the speculated virtual call at 'byteCodeOffset' and deoptimizes the frame by
+    /// calling 'jllvm_deoptimize' once it reaches zero. The interpreter then re-executes the call, recording the
+    /// receiver class that failed the guard in the profile.
+    /// Must be called on the path taken if none of the speculated receiver classes matched.
+    void generateSpeculationFailureCheck(std::uint16_t byteCodeOffset);
+
     /// Creates an 'invokespecial' call to the function 'methodName' of the type 'methodType' within 'className' using
     /// 'args'.
     llvm::Value* doSpecialCall(std::uint16_t offset, llvm::StringRef className, llvm::StringRef methodName,
@@ -123,7 +241,22 @@ class CodeGenerator
     llvm::Value* getClassObject(std::uint16_t offset, FieldType fieldDescriptor);
 
 public:
-    CodeGenerator(llvm::Function* function, const Method& method)
+    /// Number of times none of the receiver classes speculated on at a virtual call site may match before the frame is
+    /// deoptimized and the method recompiled with the receiver class that failed the guard added to its profile.
+    constexpr static std::uint64_t speculationFailureThreshold = 1000;
+
+    /// Number of times a method may have been deoptimized before it is compiled without any uncommon traps.
+    constexpr static std::uint64_t uncommonTrapLimit = 4;
+
+    /// Creates a code generator for compiling 'method' into 'function'. If 'tierUpThreshold' is non-zero, the code
+    /// counts method entries and loop iterations and requests recompilation by calling 'jllvm_tier_up' once the count
+    /// reaches 'tierUpThreshold'.
+    /// If 'uncommonTraps' is true, branch targets that the profile of 'method' shows were never branched to are not
+    /// compiled and deoptimize the frame if reached. The resulting code must never be inlined into other methods.
+    /// If 'recordCallFrames' is true, calls to Java methods record the state required to deoptimize methods inlined
+    /// into them.
+    CodeGenerator(llvm::Function* function, const Method& method, std::uint64_t tierUpThreshold = 0,
+                  bool uncommonTraps = false, bool recordCallFrames = false)
         : m_function{function},
           m_method{method},
           m_classObject{*method.getClassObject()},
@@ -131,8 +264,20 @@ public:
           m_code{*m_method.getMethodInfo().getAttributes().find<Code>()},
           m_builder{llvm::BasicBlock::Create(function->getContext(), "entry", function)},
           m_operandStack{m_builder, m_code.getMaxStack()},
-          m_locals{m_builder, m_code.getMaxLocals()}
+          m_locals{m_builder, m_code.getMaxLocals()},
+          m_recordCallFrames{recordCallFrames}
     {
+        if (tierUpThreshold != 0)
+        {
+            m_tierUpCounter = new llvm::GlobalVariable(
+                *function->getParent(), m_builder.getInt64Ty(), /*isConstant=*/false,
+                llvm::GlobalValue::InternalLinkage, m_builder.getInt64(tierUpThreshold), "tier_up_counter");
+        }
+        const MethodProfile* profile = method.getProfile();
+        if (uncommonTraps && profile && profile->getDeoptimizationCount() < uncommonTrapLimit)
+        {
+            m_uncommonTrapProfile = profile;
+        }
     }
 
     using PrologueGenFn =
@@ -149,15 +294,16 @@ public:
 /// Generates new LLVM code at the back of 'function' from the JVM Bytecode in 'method'.
 /// 'generatePrologue' is called by the function to initialize the operand stack and local variables at the beginning of
 /// the newly created code. 'offset' is the bytecode offset at which compilation should start and must refer to a JVM
-/// instruction.
+/// instruction. See 'CodeGenerator' for the meaning of 'tierUpThreshold', 'uncommonTraps' and 'recordCallFrames'.
 /// A basic block without a terminator is created that all return instructions branch to instead of calling return.
 /// If the method returns void, this basic block is returned. Otherwise, a PHI instruction within the basic block
 /// containing the value that should be returned is returned instead.
 inline llvm::PointerUnion<llvm::PHINode*, llvm::BasicBlock*>
     compileMethodBody(llvm::Function* function, const Method& method, CodeGenerator::PrologueGenFn generatePrologue,
-                      std::uint16_t offset = 0)
+                      std::uint16_t offset = 0, std::uint64_t tierUpThreshold = 0, bool uncommonTraps = false,
+                      bool recordCallFrames = false)
 {
-    CodeGenerator codeGenerator{function, method};
+    CodeGenerator codeGenerator{function, method, tierUpThreshold, uncommonTraps, recordCallFrames};
 
     return codeGenerator.generateBody(generatePrologue, offset);
 }
@@ -115,7 +115,12 @@ void ByteCodeTypeChecker::checkBasicBlock(llvm::ArrayRef<char> block, std::uint1
             return;
         }
 
-        if (getOffset(operation) == m_byteCodeTypeInfo.offset)
+        if (m_allTypeInfo)
+        {
+            auto currentOffset = static_cast<std::uint16_t>(getOffset(operation));
+            (*m_allTypeInfo)[currentOffset] = TypeInfo{currentOffset, m_typeStack, m_locals};
+        }
+        else if (getOffset(operation) == m_byteCodeTypeInfo.offset)
         {
             m_byteCodeTypeInfo.operandStack = m_typeStack;
             m_byteCodeTypeInfo.locals = m_locals;
@@ -515,11 +520,10 @@ void ByteCodeTypeChecker::checkBasicBlock(llvm::ArrayRef<char> block, std::uint1
     }
 }
 
-const ByteCodeTypeChecker::TypeInfo& ByteCodeTypeChecker::checkAndGetTypeInfo(std::uint16_t offset)
+void ByteCodeTypeChecker::checkMethod()
 {
     m_basicBlocks.insert({0, {{}, m_locals}});
     m_offsetStack.insert(0);
-    m_byteCodeTypeInfo.offset = offset;
 
     while (!m_offsetStack.empty())
     {
@@ -527,10 +531,24 @@ const ByteCodeTypeChecker::TypeInfo& ByteCodeTypeChecker::checkAndGetTypeInfo(st
 
         checkBasicBlock(m_code.getCode(), startOffset);
     }
+}
 
+const ByteCodeTypeChecker::TypeInfo& ByteCodeTypeChecker::checkAndGetTypeInfo(std::uint16_t offset)
+{
+    m_byteCodeTypeInfo.offset = offset;
+    checkMethod();
     return m_byteCodeTypeInfo;
 }
 
+llvm::DenseMap<std::uint16_t, ByteCodeTypeChecker::TypeInfo> ByteCodeTypeChecker::checkAndGetAllTypeInfo()
+{
+    llvm::DenseMap<std::uint16_t, TypeInfo> allTypeInfo;
+    m_allTypeInfo = &allTypeInfo;
+    checkMethod();
+    m_allTypeInfo = nullptr;
+    return allTypeInfo;
+}
+
 ByteCodeTypeChecker::PossibleRetsMap ByteCodeTypeChecker::makeRetToMap() const
 {
     PossibleRetsMap map;
@@ -543,6 +561,203 @@ ByteCodeTypeChecker::PossibleRetsMap ByteCodeTypeChecker::makeRetToMap() const
     return map;
 }
 
+ByteCodeTypeChecker::LiveLocalsMap ByteCodeTypeChecker::computeLiveLocals() const
+{
+    struct InstructionInfo
+    {
+        std::uint16_t offset;
+        /// Local variables read by the instruction.
+        llvm::BitVector uses;
+        /// Local variables written by the instruction.
+        llvm::BitVector defs;
+        /// Whether the next instruction is a successor of this instruction.
+        bool fallsThrough = true;
+        /// Offsets of any other successors of this instruction.
+        llvm::SmallVector<std::uint16_t> successors;
+        /// Offsets of all exception handlers that the instruction may branch to by throwing an exception.
+        llvm::SmallVector<std::uint16_t> handlers;
+    };
+
+    PossibleRetsMap retToMap = makeRetToMap();
+    std::uint16_t numLocals = m_code.getMaxLocals();
+
+    // Returns the index of the local variable accessed by the load and store instructions with an implicit index.
+    auto implicitIndex = [](const ByteCodeOp& operation)
+    {
+        return match(
+            operation, [](...) -> std::uint16_t { llvm_unreachable("Invalid load or store operation"); },
+            [](OneOf<ALoad0, DLoad0, FLoad0, ILoad0, LLoad0, AStore0, DStore0, FStore0, IStore0, LStore0>)
+            { return 0; },
+            [](OneOf<ALoad1, DLoad1, FLoad1, ILoad1, LLoad1, AStore1, DStore1, FStore1, IStore1, LStore1>)
+            { return 1; },
+            [](OneOf<ALoad2, DLoad2, FLoad2, ILoad2, LLoad2, AStore2, DStore2, FStore2, IStore2, LStore2>)
+            { return 2; },
+            [](OneOf<ALoad3, DLoad3, FLoad3, ILoad3, LLoad3, AStore3, DStore3, FStore3, IStore3, LStore3>)
+            { return 3; });
+    };
+
+    std::vector<InstructionInfo> instructions;
+    llvm::DenseMap<std::uint16_t, std::size_t> offsetToIndex;
+    for (ByteCodeOp operation : byteCodeRange(m_code.getCode(), 0))
+    {
+        auto offset = static_cast<std::uint16_t>(getOffset(operation));
+        offsetToIndex[offset] = instructions.size();
+        InstructionInfo& info = instructions.emplace_back(
+            InstructionInfo{offset, llvm::BitVector(numLocals), llvm::BitVector(numLocals)});
+
+        // Storing double or long also overwrites the local variable after.
+        auto store = [&](std::uint16_t index, bool categoryTwo)
+        {
+            info.defs.set(index);
+            if (categoryTwo)
+            {
+                info.defs.set(index + 1);
+            }
+        };
+
+        match(
+            operation,
+            [](auto&& operation) requires(!MayThrowException<std::decay_t<decltype(operation)>>) {
+
+            },
+            [&](auto&& operation) requires MayThrowException<std::decay_t<decltype(operation)>>
+            {
+                for (const Code::ExceptionTable* entry : m_code.getHandlersAtUnordered(operation.offset))
+                {
+                    info.handlers.push_back(entry->handlerPc);
+                }
+            });
+
+        match(
+            operation, [](...) {},
+            [&](OneOf<ALoad, DLoad, FLoad, ILoad, LLoad> load) { info.uses.set(load.index); },
+            [&](OneOfBase<ALoad0, ALoad1, ALoad2, ALoad3, DLoad0, DLoad1, DLoad2, DLoad3, FLoad0, FLoad1, FLoad2,
+                          FLoad3, ILoad0, ILoad1, ILoad2, ILoad3, LLoad0, LLoad1, LLoad2, LLoad3>)
+            { info.uses.set(implicitIndex(operation)); },
+            [&](OneOf<AStore, DStore, FStore, IStore, LStore> storeOp)
+            { store(storeOp.index, holds_alternative<DStore>(operation) || holds_alternative<LStore>(operation)); },
+            [&](OneOfBase<AStore0, AStore1, AStore2, AStore3, DStore0, DStore1, DStore2, DStore3, FStore0, FStore1,
+                          FStore2, FStore3, IStore0, IStore1, IStore2, IStore3, LStore0, LStore1, LStore2, LStore3>)
+            {
+                store(implicitIndex(operation),
+                      match(
+                          operation, [](...) { return false; },
+                          [](OneOfBase<DStore0, DStore1, DStore2, DStore3, LStore0, LStore1, LStore2, LStore3>)
+                          { return true; }));
+            },
+            [&](IInc iInc)
+            {
+                info.uses.set(iInc.index);
+                info.defs.set(iInc.index);
+            },
+            [&](Wide wide)
+            {
+                switch (wide.opCode)
+                {
+                    default: llvm_unreachable("Invalid wide operation");
+                    case OpCodes::ALoad:
+                    case OpCodes::DLoad:
+                    case OpCodes::FLoad:
+                    case OpCodes::ILoad:
+                    case OpCodes::LLoad: info.uses.set(wide.index); break;
+                    case OpCodes::AStore:
+                    case OpCodes::FStore:
+                    case OpCodes::IStore: store(wide.index, /*categoryTwo=*/false); break;
+                    case OpCodes::DStore:
+                    case OpCodes::LStore: store(wide.index, /*categoryTwo=*/true); break;
+                    case OpCodes::IInc:
+                        info.uses.set(wide.index);
+                        info.defs.set(wide.index);
+                        break;
+                    case OpCodes::Ret:
+                        info.uses.set(wide.index);
+                        llvm::append_range(info.successors, retToMap.lookup(wide.offset));
+                        info.fallsThrough = false;
+                        break;
+                }
+            },
+            [&](Ret ret)
+            {
+                info.uses.set(ret.index);
+                llvm::append_range(info.successors, retToMap.lookup(ret.offset));
+                info.fallsThrough = false;
+            },
+            [&](OneOf<Goto, GotoW, JSR, JSRw> branchOp)
+            {
+                // Subroutines continue at the instruction after 'jsr' by executing 'ret'.
+                info.successors.push_back(branchOp.offset + branchOp.target);
+                info.fallsThrough = false;
+            },
+            [&](OneOf<IfACmpEq, IfACmpNe, IfICmpEq, IfICmpNe, IfICmpLt, IfICmpGe, IfICmpGt, IfICmpLe, IfEq, IfNe, IfLt,
+                      IfGe, IfGt, IfLe, IfNonNull, IfNull>
+                    cmpOp) { info.successors.push_back(cmpOp.offset + cmpOp.target); },
+            [&](const LookupSwitch& switchOp)
+            {
+                info.successors.push_back(switchOp.offset + switchOp.defaultOffset);
+                for (std::int32_t target : llvm::make_second_range(switchOp.matchOffsetPairs()))
+                {
+                    info.successors.push_back(switchOp.offset + target);
+                }
+                info.fallsThrough = false;
+            },
+            [&](const TableSwitch& tableSwitch)
+            {
+                info.successors.push_back(tableSwitch.offset + tableSwitch.defaultOffset);
+                for (std::int32_t target : tableSwitch.jumpTable)
+                {
+                    info.successors.push_back(tableSwitch.offset + target);
+                }
+                info.fallsThrough = false;
+            },
+            [&](OneOfBase<AReturn, AThrow, DReturn, FReturn, IReturn, LReturn, Return>) { info.fallsThrough = false; });
+    }
+
+    // Standard backwards dataflow analysis. Visiting instructions in reverse order propagates liveness within basic
+    // blocks in a single iteration, leaving only loops to require further iterations until a fixpoint is reached.
+    std::vector<llvm::BitVector> liveIn(instructions.size(), llvm::BitVector(numLocals));
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (std::size_t index : llvm::reverse(llvm::seq<std::size_t>(0, instructions.size())))
+        {
+            const InstructionInfo& info = instructions[index];
+
+            llvm::BitVector live(numLocals);
+            if (info.fallsThrough && index + 1 < instructions.size())
+            {
+                live |= liveIn[index + 1];
+            }
+            for (std::uint16_t successor : info.successors)
+            {
+                live |= liveIn[offsetToIndex.lookup(successor)];
+            }
+            live.reset(info.defs);
+            live |= info.uses;
+
+            // An exception may be thrown prior to the instruction writing any local variables. Local variables live
+            // at the exception handler are therefore live prior to the instruction regardless of its writes.
+            for (std::uint16_t handler : info.handlers)
+            {
+                live |= liveIn[offsetToIndex.lookup(handler)];
+            }
+
+            if (live != liveIn[index])
+            {
+                liveIn[index] = std::move(live);
+                changed = true;
+            }
+        }
+    }
+
+    LiveLocalsMap result;
+    for (auto&& [info, live] : llvm::zip_equal(instructions, liveIn))
+    {
+        result.insert({info.offset, std::move(live)});
+    }
+    return result;
+}
+
 LocalVariables::Proxy::operator llvm::Value*() const
 {
     // Uninitialized locals return null.
@@ -15,6 +15,7 @@
 
 #include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Instructions.h>
+#include <llvm/ADT/BitVector.h>
 #include <llvm/ADT/SetVector.h>
 
 #include <jllvm/class/ByteCodeIterator.hpp>
@@ -45,6 +46,7 @@ public:
     using Locals = std::vector<JVMType>;
     using BasicBlockMap = llvm::DenseMap<std::uint16_t, std::pair<TypeStack, Locals>>;
     using PossibleRetsMap = llvm::DenseMap<std::uint16_t, llvm::DenseSet<std::uint16_t>>;
+    using LiveLocalsMap = llvm::DenseMap<std::uint16_t, llvm::BitVector>;
 
     /// Point in the 'ByteCodeTypeChecker' where the local variable and operand stack types should be extracted.
     /// A local variable may be null in which case the local variable is currently uninitialized.
@@ -71,9 +73,14 @@ private:
     llvm::Type* m_intType;
     llvm::Type* m_longType;
     TypeInfo m_byteCodeTypeInfo;
+    /// Type info of every instruction if requested by 'checkAndGetAllTypeInfo', otherwise null.
+    llvm::DenseMap<std::uint16_t, TypeInfo>* m_allTypeInfo = nullptr;
 
     void checkBasicBlock(llvm::ArrayRef<char> block, std::uint16_t offset);
 
+    /// Type-checks all basic blocks reachable from the start of the method.
+    void checkMethod();
+
 public:
     ByteCodeTypeChecker(llvm::LLVMContext& context, const ClassFile& classFile, const Code& code, const Method& method)
         : m_context{context},
@@ -125,9 +132,18 @@ public:
     /// Type-checks the entire java method, returning the 'ByteCodeTypeInfo' for the instruction at 'offset'.
     const TypeInfo& checkAndGetTypeInfo(std::uint16_t offset);
 
+    /// Type-checks the entire java method, returning the 'ByteCodeTypeInfo' of every reachable instruction keyed by its
+    /// offset.
+    llvm::DenseMap<std::uint16_t, TypeInfo> checkAndGetAllTypeInfo();
+
     /// Creates a mapping between each 'ret' instruction and the offsets inside the bytecode where it could return to.
     PossibleRetsMap makeRetToMap() const;
 
+    /// Computes the local variables live prior to every instruction of the method. A local variable is live if its
+    /// current value may be read by a subsequent instruction, including instructions within exception handlers and
+    /// subroutines. Must be called after type-checking the method to know the return addresses of subroutines.
+    LiveLocalsMap computeLiveLocals() const;
+
     const BasicBlockMap& getBasicBlocks() const
     {
         return m_basicBlocks;
@@ -190,6 +206,24 @@ public:
         m_topOfStack = state.size();
     }
 
+    /// Returns the number of values currently on the operand stack.
+    std::size_t size() const
+    {
+        return m_topOfStack;
+    }
+
+    /// Loads the bottom-most 'count' values of the operand stack. 'count' may be larger than the current size of the
+    /// operand stack as long as no value has been pushed since the values above the top of the stack were popped.
+    llvm::SmallVector<llvm::Value*> loadValues(std::size_t count) const
+    {
+        llvm::SmallVector<llvm::Value*> result(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            result[i] = m_builder.CreateLoad(m_types[i], m_values[i]);
+        }
+        return result;
+    }
+
     /// Sets the value of the bottom-most stack slot of the operand stack.
     void setBottomOfStackValue(llvm::Value* value) const
     {
@@ -270,6 +304,14 @@ public:
         return Proxy(this, index);
     }
 
+    /// Returns the type that was last stored to the local variable with the given index or null if it is
+    /// uninitialized.
+    llvm::Type* getType(std::uint16_t index) const
+    {
+        assert(index < size());
+        return m_types[index];
+    }
+
     /// Iterator to the first local variable.
     /// Dereferencing the iterator is equal to calling 'operator[]' with the index corresponding to the iterator
     /// position.
@@ -16,7 +16,8 @@
 #include "ClassObjectStubMangling.hpp"
 #include "CodeGenerator.hpp"
 
-llvm::Function* jllvm::compileMethod(llvm::Module& module, const Method& method)
+llvm::Function* jllvm::compileMethod(llvm::Module& module, const Method& method, std::uint64_t tierUpThreshold,
+                                     bool uncommonTraps, bool recordCallFrames)
 {
     const MethodInfo& methodInfo = method.getMethodInfo();
     const ClassObject* classObject = method.getClassObject();
@@ -51,7 +52,8 @@ llvm::Function* jllvm::compileMethod(llvm::Module& module, const Method& method)
                     nextLocal++;
                 }
             }
-        });
+        },
+        /*offset=*/0, tierUpThreshold, uncommonTraps, recordCallFrames);
 
     if (auto* bb = ret.dyn_cast<llvm::BasicBlock*>())
     {
@@ -24,7 +24,14 @@ namespace jllvm
 {
 
 /// Compiles 'method' to a new LLVM function inside of 'module' and returns it.
-llvm::Function* compileMethod(llvm::Module& module, const Method& method);
+/// If 'tierUpThreshold' is non-zero, the function calls 'jllvm_tier_up' with the method once the sum of its invocations
+/// and loop iterations reaches 'tierUpThreshold'.
+/// If 'uncommonTraps' is true, branch targets that the profile of 'method' shows were never branched to are replaced
+/// by calls deoptimizing the frame. The function must then never be inlined into other methods.
+/// If 'recordCallFrames' is true, calls to Java methods record the frame state required to deoptimize any methods
+/// inlined into them.
+llvm::Function* compileMethod(llvm::Module& module, const Method& method, std::uint64_t tierUpThreshold = 0,
+                              bool uncommonTraps = false, bool recordCallFrames = false);
 
 /// Compiles 'method' to a LLVM function suitable for OSR entry at the bytecode offset 'offset'. The function is placed
 /// into 'module' and returned. The return type of the function is suitable for replacing the method with the given
@@ -0,0 +1,116 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#include "ArrayBoundsCheckElimination.hpp"
+
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/PatternMatch.h>
+#include <llvm/Support/Debug.h>
+
+#define DEBUG_TYPE "jvm"
+
+namespace
+{
+
+/// Returns true if 'block' throws an 'ArrayIndexOutOfBoundsException'.
+bool throwsArrayIndexOutOfBoundsException(const llvm::BasicBlock* block)
+{
+    return llvm::any_of(*block,
+                        [](const llvm::Instruction& instruction)
+                        {
+                            const auto* call = llvm::dyn_cast<llvm::CallBase>(&instruction);
+                            if (!call || !call->getCalledFunction())
+                            {
+                                return false;
+                            }
+                            return call->getCalledFunction()->getName()
+                                   == "jllvm_throw_array_index_out_of_bounds_exception";
+                        });
+}
+
+} // namespace
+
+llvm::PreservedAnalyses jllvm::ArrayBoundsCheckEliminationPass::run(llvm::Function& F,
+                                                                    llvm::FunctionAnalysisManager& AM)
+{
+    auto& loopInfo = AM.getResult<llvm::LoopAnalysis>(F);
+    if (loopInfo.empty())
+    {
+        // Checks outside of loops are cheap and already removed by other passes if redundant.
+        return llvm::PreservedAnalyses::all();
+    }
+    auto& scalarEvolution = AM.getResult<llvm::ScalarEvolutionAnalysis>(F);
+
+    bool changed = false;
+    for (llvm::BasicBlock& block : F)
+    {
+        if (!loopInfo.getLoopFor(&block))
+        {
+            continue;
+        }
+
+        auto* branch = llvm::dyn_cast<llvm::BranchInst>(block.getTerminator());
+        if (!branch || !branch->isConditional())
+        {
+            continue;
+        }
+
+        // Canonicalize to the form where the condition is true if the index is within bounds.
+        using namespace llvm::PatternMatch;
+        llvm::ICmpInst::Predicate predicate;
+        llvm::Value* index;
+        llvm::Value* length;
+        if (!match(branch->getCondition(), m_ICmp(predicate, m_Value(index), m_Value(length))))
+        {
+            continue;
+        }
+
+        unsigned inBoundsSuccessor;
+        switch (predicate)
+        {
+            case llvm::ICmpInst::ICMP_ULT: inBoundsSuccessor = 0; break;
+            case llvm::ICmpInst::ICMP_UGE: inBoundsSuccessor = 1; break;
+            default: continue;
+        }
+        if (!throwsArrayIndexOutOfBoundsException(branch->getSuccessor(1 - inBoundsSuccessor)))
+        {
+            continue;
+        }
+
+        if (!scalarEvolution.isKnownPredicateAt(llvm::ICmpInst::ICMP_ULT, scalarEvolution.getSCEV(index),
+                                                scalarEvolution.getSCEV(length), branch))
+        {
+            continue;
+        }
+
+        LLVM_DEBUG({
+            llvm::dbgs() << "Removing bounds check of " << *index << " in " << F.getName() << '\n';
+        });
+
+        // Leave removal of the then dead exception block to SimplifyCFG.
+        auto* inBounds = llvm::ConstantInt::getBool(branch->getContext(), inBoundsSuccessor == 0);
+        branch->setCondition(inBounds);
+        changed = true;
+    }
+
+    if (!changed)
+    {
+        return llvm::PreservedAnalyses::all();
+    }
+    // Only the condition of branches has been changed. The CFG is left intact.
+    llvm::PreservedAnalyses preservedAnalyses;
+    preservedAnalyses.preserveSet<llvm::CFGAnalyses>();
+    return preservedAnalyses;
+}
@@ -0,0 +1,34 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <llvm/IR/PassManager.h>
+
+namespace jllvm
+{
+/// Pass removing array bounds checks generated by 'CodeGenerator' that are known to always succeed.
+///
+/// Bounds checks are branches on 'icmp uge index, length' to a block throwing an 'ArrayIndexOutOfBoundsException'.
+/// Using scalar evolution, checks whose index is an induction variable that provably stays within the bounds of the
+/// array are removed. This is mostly the case in loops whose trip count is derived from the length of the array.
+/// Checks which cannot be proven to always succeed are left to 'IRCEPass', which versions the loop into a main loop
+/// without bounds checks and pre- and post-loops with the checks.
+class ArrayBoundsCheckEliminationPass : public llvm::PassInfoMixin<ArrayBoundsCheckEliminationPass>
+{
+public:
+    explicit ArrayBoundsCheckEliminationPass() = default;
+
+    llvm::PreservedAnalyses run(llvm::Function& F, llvm::FunctionAnalysisManager& AM);
+};
+} // namespace jllvm
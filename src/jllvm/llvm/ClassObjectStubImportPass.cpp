@@ -77,9 +77,9 @@ llvm::PreservedAnalyses jllvm::ClassObjectStubImportPass::run(llvm::Module& modu
                 {
                     return nullptr;
                 }
-                return generateMethodResolutionCallStub(module, methodResolutionCall.resolution, *classObject,
-                                                        methodResolutionCall.methodName,
-                                                        methodResolutionCall.descriptor, *objectClass);
+                return generateMethodResolutionCallStub(
+                    module, methodResolutionCall.resolution, *classObject, methodResolutionCall.methodName,
+                    methodResolutionCall.descriptor, *objectClass, m_classHierarchyAnalysis, m_dependent);
             },
             [&](const DemangledSpecialCall& specialCall) -> llvm::Function*
             {
@@ -15,6 +15,7 @@
 
 #include <llvm/IR/PassManager.h>
 
+#include <jllvm/object/ClassHierarchyAnalysis.hpp>
 #include <jllvm/object/ClassLoader.hpp>
 
 namespace jllvm
@@ -25,12 +26,21 @@ namespace jllvm
 /// The produced function definitions are marked with internal linkage and replaces the previous declarations.
 /// This pass should be run as early in the optimization pipeline as possible to allow LLVM to inline the generated
 /// definitions.
+/// If a 'ClassHierarchyAnalysis' is given, it is used to devirtualize virtual calls. 'dependent' should be the method
+/// 'module' was compiled from and is recorded as dependent on any assumptions made.
 class ClassObjectStubImportPass : public llvm::PassInfoMixin<ClassObjectStubImportPass>
 {
     ClassLoader& m_classLoader;
+    ClassHierarchyAnalysis* m_classHierarchyAnalysis;
+    const Method* m_dependent;
 
 public:
-    explicit ClassObjectStubImportPass(ClassLoader& classLoader) : m_classLoader(classLoader) {}
+    explicit ClassObjectStubImportPass(ClassLoader& classLoader,
+                                       ClassHierarchyAnalysis* classHierarchyAnalysis = nullptr,
+                                       const Method* dependent = nullptr)
+        : m_classLoader(classLoader), m_classHierarchyAnalysis(classHierarchyAnalysis), m_dependent(dependent)
+    {
+    }
 
     /// Run function with signature indicating the pass manager that this is a module pass.
     llvm::PreservedAnalyses run(llvm::Module& module, llvm::ModuleAnalysisManager& analysisManager);
@@ -0,0 +1,92 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#include "CompilationPipeline.hpp"
+
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/Analysis/GlobalsModRef.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Transforms/Instrumentation/AddressSanitizer.h>
+#include <llvm/Transforms/Scalar/InductiveRangeCheckElimination.h>
+#include <llvm/Transforms/Scalar/RewriteStatepointsForGC.h>
+
+#include <jllvm/compiler/ByteCodeCompileUtils.hpp>
+
+#include "ArrayBoundsCheckElimination.hpp"
+#include "MarkSanitizersGCLeafs.hpp"
+
+llvm::orc::JITTargetMachineBuilder jllvm::createTargetMachineBuilder()
+{
+    auto jtmb = llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost());
+    jtmb.getOptions().EmulatedTLS = false;
+    jtmb.getOptions().ExceptionModel = llvm::ExceptionHandling::DwarfCFI;
+    jtmb.setCodeGenOptLevel(llvm::CodeGenOpt::Aggressive);
+    return jtmb;
+}
+
+void jllvm::optimizeModule(llvm::Module& module, llvm::TargetMachine& targetMachine)
+{
+    // Baseline code is optimized just enough to clean up the IR produced by the code generator and uses the fast
+    // instruction selector where possible.
+    bool isBaseline = getCompilationTier(module) == CompilationTier::Baseline;
+    targetMachine.setOptLevel(isBaseline ? llvm::CodeGenOpt::Less : llvm::CodeGenOpt::Aggressive);
+    targetMachine.setFastISel(isBaseline);
+
+    llvm::LoopAnalysisManager lam;
+    llvm::FunctionAnalysisManager fam;
+    llvm::CGSCCAnalysisManager cgam;
+    llvm::ModuleAnalysisManager mam;
+
+    llvm::PipelineTuningOptions options;
+    options.LoopInterleaving = !isBaseline;
+    options.LoopUnrolling = !isBaseline;
+    options.LoopVectorization = !isBaseline;
+    options.SLPVectorization = !isBaseline;
+    options.MergeFunctions = !isBaseline;
+    llvm::PassBuilder passBuilder(&targetMachine, options, std::nullopt);
+
+    if (!isBaseline)
+    {
+        // Array bounds checks within loops prevent vectorization. Remove as many as possible right before the
+        // vectorizer.
+        passBuilder.registerVectorizerStartEPCallback(
+            [&](llvm::FunctionPassManager& functionPassManager, llvm::OptimizationLevel)
+            {
+                functionPassManager.addPass(ArrayBoundsCheckEliminationPass{});
+                functionPassManager.addPass(llvm::IRCEPass{});
+            });
+    }
+
+    passBuilder.registerOptimizerLastEPCallback(
+        [&](llvm::ModulePassManager& modulePassManager, llvm::OptimizationLevel)
+        {
+#if LLVM_ADDRESS_SANITIZER_BUILD
+            llvm::AddressSanitizerOptions options;
+            modulePassManager.addPass(llvm::AddressSanitizerPass(options));
+            modulePassManager.addPass(llvm::RequireAnalysisPass<llvm::GlobalsAA, llvm::Module>{});
+            modulePassManager.addPass(MarkSanitizersGCLeafsPass{});
+#endif
+            modulePassManager.addPass(llvm::RewriteStatepointsForGC{});
+        });
+
+    fam.registerPass([&] { return passBuilder.buildDefaultAAPipeline(); });
+    passBuilder.registerModuleAnalyses(mam);
+    passBuilder.registerCGSCCAnalyses(cgam);
+    passBuilder.registerFunctionAnalyses(fam);
+    passBuilder.registerLoopAnalyses(lam);
+    passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+
+    auto mpm = passBuilder.buildPerModuleDefaultPipeline(isBaseline ? llvm::OptimizationLevel::O1 :
+                                                                      llvm::OptimizationLevel::O3);
+    mpm.run(module, mam);
+}
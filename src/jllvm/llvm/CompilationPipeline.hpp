@@ -0,0 +1,30 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Target/TargetMachine.h>
+
+namespace jllvm
+{
+/// Returns a target machine builder for the host with the options required by code produced from Java methods.
+/// Both the JIT and ahead-of-time compilation use it to produce interchangeable object files.
+llvm::orc::JITTargetMachineBuilder createTargetMachineBuilder();
+
+/// Optimizes 'module' for 'targetMachine' and configures 'targetMachine' for code generation of 'module'.
+/// The amount of optimization depends on the compilation tier of 'module'. This does not access any VM state and may
+/// therefore be called from any thread.
+void optimizeModule(llvm::Module& module, llvm::TargetMachine& targetMachine);
+} // namespace jllvm
@@ -0,0 +1,335 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#include "JavaMethodInlining.hpp"
+
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/Support/Debug.h>
+#include <llvm/Transforms/Utils/Cloning.h>
+
+#include <jllvm/compiler/Compiler.hpp>
+
+#include "ClassObjectStubImportPass.hpp"
+
+#define DEBUG_TYPE "jvm"
+
+const jllvm::Method* jllvm::JavaMethodInliningPass::getStaticallyBoundCallee(const Method& method,
+                                                                             const ByteCodeOp& operation)
+{
+    const ClassFile& classFile = *method.getClassObject()->getClassFile();
+    return match(
+        operation, [](...) -> const Method* { return nullptr; },
+        [&](OneOf<InvokeSpecial, InvokeStatic, InvokeVirtual> invoke) -> const Method*
+        {
+            const RefInfo* refInfo = PoolIndex<RefInfo>{invoke.index}.resolve(classFile);
+            llvm::StringRef className = refInfo->classIndex.resolve(classFile)->nameIndex.resolve(classFile)->text;
+            llvm::StringRef methodName =
+                refInfo->nameAndTypeIndex.resolve(classFile)->nameIndex.resolve(classFile)->text;
+            MethodType methodType(refInfo->nameAndTypeIndex.resolve(classFile)->descriptorIndex.resolve(classFile)->text);
+
+            ClassObject* classObject = m_classLoader.forNameLoaded(FieldType::fromMangled(className));
+            ClassObject* objectClass = m_classLoader.forNameLoaded(ObjectType("java/lang/Object"));
+            if (!classObject || !objectClass)
+            {
+                return nullptr;
+            }
+
+            // Resolution performed exactly the same way as the stubs created by 'ClassObjectStubImportPass'.
+            if (holds_alternative<InvokeStatic>(operation))
+            {
+                return classObject->isInterface() ?
+                           classObject->interfaceMethodResolution(methodName, methodType, objectClass) :
+                           classObject->methodResolution(methodName, methodType);
+            }
+            if (holds_alternative<InvokeSpecial>(operation))
+            {
+                return classObject->specialMethodResolution(methodName, methodType, objectClass,
+                                                            classFile.hasSuperFlag() ? method.getClassObject() :
+                                                                                       nullptr);
+            }
+
+            // Virtual calls are only ever direct calls if the method does not take part in method selection.
+            const Method* resolved = classObject->methodResolution(methodName, methodType);
+            if (!resolved || resolved->getTableSlot())
+            {
+                return nullptr;
+            }
+            return resolved;
+        });
+}
+
+bool jllvm::JavaMethodInliningPass::canInline(const Method& caller, std::uint16_t offset, const Method& callee)
+{
+    if (callee.isNative() || callee.isAbstract())
+    {
+        return false;
+    }
+
+    const Code* code = callee.getMethodInfo().getAttributes().find<Code>();
+    if (!code)
+    {
+        return false;
+    }
+
+    std::uint16_t sizeLimit = m_options.maxInlineSize;
+    const MethodProfile* profile = caller.getProfile();
+    if (profile && profile->getCallCount(offset) >= m_options.hotCallSiteCount)
+    {
+        sizeLimit = std::max(sizeLimit, m_options.hotMaxInlineSize);
+    }
+    return code->getCode().size() <= sizeLimit;
+}
+
+std::optional<unsigned> jllvm::JavaMethodInliningPass::getInlineHeight(const Method& method)
+{
+    // Inserting an empty optional prior to visiting any callees makes recursive calls not inlinable.
+    auto [iter, inserted] = m_heights.try_emplace(&method, std::nullopt);
+    if (!inserted)
+    {
+        return iter->second;
+    }
+
+    unsigned height = 1;
+    const Code& code = *method.getMethodInfo().getAttributes().find<Code>();
+    for (ByteCodeOp operation : byteCodeRange(code.getCode()))
+    {
+        const Method* callee = getStaticallyBoundCallee(method, operation);
+        auto offset = static_cast<std::uint16_t>(getOffset(operation));
+        if (!callee || !canInline(method, offset, *callee))
+        {
+            continue;
+        }
+        std::optional<unsigned> calleeHeight = getInlineHeight(*callee);
+        if (!calleeHeight || *calleeHeight + 1 > m_options.maxInlineDepth)
+        {
+            continue;
+        }
+        m_inlinedCalls.insert({&method, offset, callee});
+        height = std::max(height, *calleeHeight + 1);
+    }
+
+    // 'iter' may have been invalidated by the recursive calls.
+    m_heights[&method] = height;
+    return height;
+}
+
+namespace
+{
+
+/// Returns the bytecode offset of the Java call 'call' as recorded in its deoptimization values or an empty optional
+/// if it has none.
+std::optional<std::uint16_t> getCallOffset(const llvm::CallBase& call)
+{
+    std::optional<llvm::OperandBundleUse> deopt = call.getOperandBundle(llvm::LLVMContext::OB_deopt);
+    if (!deopt || deopt->Inputs.empty())
+    {
+        return std::nullopt;
+    }
+    return llvm::cast<llvm::ConstantInt>(deopt->Inputs.front())->getZExtValue();
+}
+
+/// Prefixes the deoptimization values of all calls within 'function' with the address of 'method'. Once 'function' is
+/// inlined, these mark the start of the frame of 'method' within the deoptimization values.
+void prefixDeoptValues(llvm::Function& function, const jllvm::Method& method)
+{
+    llvm::Constant* methodConstant = llvm::ConstantInt::get(llvm::Type::getInt64Ty(function.getContext()),
+                                                            reinterpret_cast<std::uintptr_t>(&method));
+    for (llvm::Instruction& inst : llvm::make_early_inc_range(llvm::instructions(function)))
+    {
+        auto* call = llvm::dyn_cast<llvm::CallBase>(&inst);
+        if (!call || !getCallOffset(*call))
+        {
+            continue;
+        }
+
+        // 'addOperandBundle' does not replace an existing bundle. Recreate the call with all bundles instead.
+        llvm::SmallVector<llvm::OperandBundleDef> bundles;
+        call->getOperandBundlesAsDefs(bundles);
+        for (llvm::OperandBundleDef& bundle : bundles)
+        {
+            if (bundle.getTag() != "deopt")
+            {
+                continue;
+            }
+            std::vector<llvm::Value*> inputs{methodConstant};
+            llvm::append_range(inputs, bundle.inputs());
+            bundle = llvm::OperandBundleDef("deopt", std::move(inputs));
+        }
+
+        llvm::CallBase* newCall = llvm::CallBase::Create(call, bundles, call);
+        newCall->copyMetadata(*call);
+        newCall->takeName(call);
+        call->replaceAllUsesWith(newCall);
+        call->eraseFromParent();
+    }
+}
+
+} // namespace
+
+bool jllvm::JavaMethodInliningPass::inlineStubs(
+    llvm::Function& function, const llvm::DenseMap<const llvm::Function*, const Method*>& javaFunctions)
+{
+    // Stubs calling Java methods directly are shared by all calls to the stub. Inlining them makes the direct calls
+    // carry the deoptimization values of the call site, allowing inlining to be decided per call site.
+    auto isStubCallingJavaMethod = [&](const llvm::Function& callee)
+    {
+        if (callee.isDeclaration() || javaFunctions.contains(&callee))
+        {
+            return false;
+        }
+        return llvm::any_of(llvm::instructions(callee),
+                            [&](const llvm::Instruction& inst)
+                            {
+                                const auto* call = llvm::dyn_cast<llvm::CallBase>(&inst);
+                                const llvm::Function* called = call ? call->getCalledFunction() : nullptr;
+                                return called && called->isDeclaration() && m_lookupMethod(called->getName());
+                            });
+    };
+
+    bool changed = false;
+    bool inlined;
+    do
+    {
+        inlined = false;
+        llvm::SmallVector<llvm::CallBase*> stubCalls;
+        for (llvm::Instruction& inst : llvm::instructions(function))
+        {
+            auto* call = llvm::dyn_cast<llvm::CallBase>(&inst);
+            llvm::Function* callee = call ? call->getCalledFunction() : nullptr;
+            if (callee && isStubCallingJavaMethod(*callee))
+            {
+                stubCalls.push_back(call);
+            }
+        }
+        for (llvm::CallBase* call : stubCalls)
+        {
+            llvm::InlineFunctionInfo info;
+            inlined |= llvm::InlineFunction(*call, info).isSuccess();
+        }
+        changed |= inlined;
+    } while (inlined);
+    return changed;
+}
+
+llvm::PreservedAnalyses jllvm::JavaMethodInliningPass::run(llvm::Module& module,
+                                                          llvm::ModuleAnalysisManager& analysisManager)
+{
+    if (m_options.maxInlineSize == 0)
+    {
+        return llvm::PreservedAnalyses::all();
+    }
+
+    // Functions of Java methods defined within the module. Only the functions of callee definitions are ever inlined.
+    llvm::DenseMap<const llvm::Function*, const Method*> javaFunctions;
+    llvm::DenseMap<const Method*, llvm::Function*> definitions;
+    llvm::SmallVector<llvm::Function*> workList;
+    for (llvm::Function& function : module.functions())
+    {
+        if (function.isDeclaration())
+        {
+            continue;
+        }
+        if (const Method* method = m_lookupMethod(function.getName()))
+        {
+            javaFunctions[&function] = method;
+            workList.push_back(&function);
+        }
+    }
+    llvm::SmallPtrSet<llvm::Function*, 4> roots(workList.begin(), workList.end());
+
+    ClassObjectStubImportPass importPass(m_classLoader, m_classHierarchyAnalysis, m_dependent);
+    bool changed = false;
+    while (!workList.empty())
+    {
+        llvm::Function* function = workList.pop_back_val();
+        const Method& caller = *javaFunctions.lookup(function);
+        changed |= inlineStubs(*function, javaFunctions);
+
+        llvm::SmallVector<llvm::CallBase*> calls;
+        for (llvm::Instruction& inst : llvm::instructions(*function))
+        {
+            if (auto* call = llvm::dyn_cast<llvm::CallBase>(&inst))
+            {
+                calls.push_back(call);
+            }
+        }
+
+        for (llvm::CallBase* call : calls)
+        {
+            llvm::Function* calledFunction = call->getCalledFunction();
+            if (!calledFunction || !calledFunction->isDeclaration())
+            {
+                continue;
+            }
+            const Method* callee = m_lookupMethod(calledFunction->getName());
+            std::optional<std::uint16_t> offset = getCallOffset(*call);
+            if (!callee || !offset)
+            {
+                continue;
+            }
+
+            // Calls within inlined methods were already decided on when computing the height of the caller, making
+            // sure the maximum depth is never exceeded.
+            if (roots.contains(function))
+            {
+                if (!canInline(caller, *offset, *callee))
+                {
+                    continue;
+                }
+                std::optional<unsigned> height = getInlineHeight(*callee);
+                if (!height || *height > m_options.maxInlineDepth)
+                {
+                    continue;
+                }
+            }
+            else if (!m_inlinedCalls.contains({&caller, *offset, callee}))
+            {
+                continue;
+            }
+
+            auto [iter, inserted] = definitions.try_emplace(callee, nullptr);
+            if (inserted)
+            {
+                LLVM_DEBUG({
+                    llvm::dbgs() << "Inlining " << callee->getClassObject()->getClassName() << '.'
+                                 << callee->getName() << callee->getType().textual() << " into "
+                                 << module.getName() << '\n';
+                });
+
+                // The declaration is kept for calls that are not inlined. The definition is given a unique name by
+                // LLVM.
+                llvm::Function* definition =
+                    compileMethod(module, *callee, /*tierUpThreshold=*/0, /*uncommonTraps=*/false,
+                                  /*recordCallFrames=*/true);
+                definition->setLinkage(llvm::GlobalValue::InternalLinkage);
+                definition->addFnAttr(llvm::Attribute::AlwaysInline);
+                iter->second = definition;
+                javaFunctions[definition] = callee;
+                workList.push_back(definition);
+
+                // The calls within the newly compiled method have to be turned into direct calls as well.
+                importPass.run(module, analysisManager);
+            }
+            call->setCalledFunction(iter->second);
+            changed = true;
+        }
+
+        if (!roots.contains(function))
+        {
+            prefixDeoptValues(*function, caller);
+        }
+    }
+
+    return changed ? llvm::PreservedAnalyses::none() : llvm::PreservedAnalyses::all();
+}
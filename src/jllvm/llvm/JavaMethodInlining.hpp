@@ -0,0 +1,106 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/FunctionExtras.h>
+#include <llvm/IR/PassManager.h>
+
+#include <jllvm/class/ByteCodeIterator.hpp>
+#include <jllvm/object/ClassHierarchyAnalysis.hpp>
+#include <jllvm/object/ClassLoader.hpp>
+
+#include <optional>
+#include <tuple>
+
+namespace jllvm
+{
+
+/// Parameters determining which Java methods are inlined by 'JavaMethodInliningPass'.
+struct InliningOptions
+{
+    /// Maximum size of the bytecode of a method in bytes for it to be inlined. Inlining is disabled if 0.
+    std::uint16_t maxInlineSize = 35;
+    /// Maximum size of the bytecode of a method in bytes for it to be inlined at a hot call site.
+    std::uint16_t hotMaxInlineSize = 325;
+    /// Number of calls recorded in the profile of the caller at a call site after which the call site is considered
+    /// hot.
+    std::uint64_t hotCallSiteCount = 100;
+    /// Maximum nesting depth of inlined methods.
+    unsigned maxInlineDepth = 8;
+};
+
+/// LLVM Optimization pass that compiles the bytecode of Java methods called directly from within the module into the
+/// module, allowing LLVM to inline them. This must be run after 'ClassObjectStubImportPass', as direct calls are mostly
+/// produced by the imported stubs.
+///
+/// Inlining is decided per call site: Stubs calling Java methods are inlined first, making the direct calls part of
+/// the calling Java method. Calls are then redirected to a definition of the callee marked 'alwaysinline' if the callee
+/// is small enough, with a larger size limit applying to call sites the profile of the caller shows to be hot.
+/// When inlining, LLVM appends the deoptimization values of calls within the callee to the ones of the call being
+/// inlined. The deoptimization values of every callee definition are therefore prefixed with its 'Method*', allowing
+/// the unwinder to reconstruct the frames of all inlined methods.
+class JavaMethodInliningPass : public llvm::PassInfoMixin<JavaMethodInliningPass>
+{
+    ClassLoader& m_classLoader;
+    InliningOptions m_options;
+    llvm::unique_function<const Method*(llvm::StringRef)> m_lookupMethod;
+    ClassHierarchyAnalysis* m_classHierarchyAnalysis;
+    const Method* m_dependent;
+    /// Cache of the height of the tree of calls inlined into methods. Methods currently being visited are mapped to an
+    /// empty optional, preventing recursive calls from being inlined.
+    llvm::DenseMap<const Method*, std::optional<unsigned>> m_heights;
+    /// Calls within inlined methods that are inlined as well, given by the calling method, the bytecode offset of the
+    /// call and the callee.
+    llvm::DenseSet<std::tuple<const Method*, std::uint16_t, const Method*>> m_inlinedCalls;
+
+    /// Returns the method called by the invoke instruction 'operation' within 'method' if it can be determined at
+    /// compile time. Returns null if the call requires method selection at runtime or any class involved is not yet
+    /// loaded.
+    const Method* getStaticallyBoundCallee(const Method& method, const ByteCodeOp& operation);
+
+    /// Returns true if 'callee' is small enough to be inlined into the call at 'offset' within 'caller'.
+    bool canInline(const Method& caller, std::uint16_t offset, const Method& callee);
+
+    /// Returns the height of the tree of calls inlined into 'method', recording the calls to be inlined within
+    /// 'm_inlinedCalls'. Returns an empty optional if 'method' is already being visited.
+    std::optional<unsigned> getInlineHeight(const Method& method);
+
+    /// Inlines all calls within 'function' to stubs calling Java methods directly. 'javaFunctions' contains the
+    /// functions of Java methods defined within the module, which are never considered stubs. Returns true if any stub
+    /// was inlined.
+    bool inlineStubs(llvm::Function& function,
+                     const llvm::DenseMap<const llvm::Function*, const Method*>& javaFunctions);
+
+public:
+    /// Creates the pass. 'lookupMethod' is used to map the name of a function declaration to the method it is the
+    /// direct call of, returning null if it is not one. 'classHierarchyAnalysis' and 'dependent' are passed to
+    /// 'ClassObjectStubImportPass' when importing the stubs of inlined methods.
+    explicit JavaMethodInliningPass(ClassLoader& classLoader, InliningOptions options,
+                                    llvm::unique_function<const Method*(llvm::StringRef)> lookupMethod,
+                                    ClassHierarchyAnalysis* classHierarchyAnalysis = nullptr,
+                                    const Method* dependent = nullptr)
+        : m_classLoader(classLoader),
+          m_options(options),
+          m_lookupMethod(std::move(lookupMethod)),
+          m_classHierarchyAnalysis(classHierarchyAnalysis),
+          m_dependent(dependent)
+    {
+    }
+
+    /// Run function with signature indicating the pass manager that this is a module pass.
+    llvm::PreservedAnalyses run(llvm::Module& module, llvm::ModuleAnalysisManager& analysisManager);
+};
+} // namespace jllvm
@@ -108,6 +108,14 @@ int jllvm::main(llvm::StringRef executablePath, llvm::ArrayRef<char*> args)
         .systemInitialization = argList.hasFlag(OPT_Xsystem_init, OPT_Xno_system_init, true),
         .executionMode = executionMode,
         .debugLogging = argList.getLastArgValue(OPT_Xdebug_EQ).str(),
+        .zeroInterpreterFrames = argList.hasArg(OPT_Xzero_interpreter_frames),
+        .dumpByteCodePairs = argList.hasArg(OPT_Xdump_bytecode_pairs),
+        .byteCodePairHistogram = argList.getLastArgValue(OPT_Xbytecode_pair_histogram_EQ).str(),
+        .stacklessCalls = argList.hasArg(OPT_Xstackless_calls),
+        .dumpImplicitExceptionSites = argList.hasArg(OPT_Xdump_implicit_exception_sites),
+        .printCompilation = argList.hasArg(OPT_Xprint_compilation),
+        .codeCacheDirectory = argList.getLastArgValue(OPT_Xcode_cache_EQ).str(),
+        .aotLibrary = argList.getLastArgValue(OPT_Xaot_library_EQ).str(),
     };
 
     if (llvm::opt::Arg* arg = argList.getLastArg(OPT_Xback_edge_threshold_EQ))
@@ -118,6 +126,54 @@ int jllvm::main(llvm::StringRef executablePath, llvm::ArrayRef<char*> args)
         }
     }
 
+    if (llvm::opt::Arg* arg = argList.getLastArg(OPT_Xinvocation_threshold_EQ))
+    {
+        if (llvm::StringRef(arg->getValue()).getAsInteger(10, bootOptions.invocationThreshold))
+        {
+            llvm::report_fatal_error("Invalid command line argument '" + arg->getSpelling() + "'");
+        }
+    }
+
+    if (llvm::opt::Arg* arg = argList.getLastArg(OPT_Xtier_up_threshold_EQ))
+    {
+        if (llvm::StringRef(arg->getValue()).getAsInteger(10, bootOptions.tierUpThreshold))
+        {
+            llvm::report_fatal_error("Invalid command line argument '" + arg->getSpelling() + "'");
+        }
+    }
+
+    if (llvm::opt::Arg* arg = argList.getLastArg(OPT_Xmax_inline_size_EQ))
+    {
+        if (llvm::StringRef(arg->getValue()).getAsInteger(10, bootOptions.maxInlineSize))
+        {
+            llvm::report_fatal_error("Invalid command line argument '" + arg->getSpelling() + "'");
+        }
+    }
+
+    if (llvm::opt::Arg* arg = argList.getLastArg(OPT_Xhot_max_inline_size_EQ))
+    {
+        if (llvm::StringRef(arg->getValue()).getAsInteger(10, bootOptions.hotMaxInlineSize))
+        {
+            llvm::report_fatal_error("Invalid command line argument '" + arg->getSpelling() + "'");
+        }
+    }
+
+    if (llvm::opt::Arg* arg = argList.getLastArg(OPT_Xcompile_threads_EQ))
+    {
+        if (llvm::StringRef(arg->getValue()).getAsInteger(10, bootOptions.compileThreads))
+        {
+            llvm::report_fatal_error("Invalid command line argument '" + arg->getSpelling() + "'");
+        }
+    }
+
+    if (llvm::opt::Arg* arg = argList.getLastArg(OPT_Xfast_throw_threshold_EQ))
+    {
+        if (llvm::StringRef(arg->getValue()).getAsInteger(10, bootOptions.fastThrowThreshold))
+        {
+            llvm::report_fatal_error("Invalid command line argument '" + arg->getSpelling() + "'");
+        }
+    }
+
     auto vm = jllvm::VirtualMachine::create(std::move(bootOptions));
     if (argList.hasArg(OPT_Xenable_test_utils))
     {
@@ -0,0 +1,117 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#include "AOTLibrary.hpp"
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/SHA1.h>
+
+#include <jllvm/compiler/ClassObjectStubMangling.hpp>
+
+#include "BuildID.inc"
+
+std::string jllvm::AOTLibrary::getTargetDescription(const llvm::TargetMachine& targetMachine)
+{
+    std::string description;
+    llvm::raw_string_ostream ss(description);
+    // Objects rely on JLLVM internal layouts such as those of class objects, deoptimization values and mangled
+    // symbols, none of which are versioned individually.
+    ss << "JLLVM " << JLLVM_BUILD_ID << '\n'
+       << "LLVM " << LLVM_VERSION_STRING << '\n'
+       << targetMachine.getTargetTriple().str() << '\n'
+       << targetMachine.getTargetCPU() << '\n'
+       << targetMachine.getTargetFeatureString() << '\n';
+    return description;
+}
+
+std::string jllvm::AOTLibrary::getMemberName(const Method& method)
+{
+    const ClassFile* classFile = method.getClassObject()->getClassFile();
+    assert(classFile && "methods with code must be defined in a class file");
+
+    // Mangled method names may be arbitrarily long and contain characters that are not valid in file names.
+    // Hash them instead.
+    std::string key = (classFile->getContentHash() + "\n" + mangleDirectMethodCall(&method)).str();
+    return llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(key)), /*LowerCase=*/true) + ".o";
+}
+
+llvm::Expected<std::unique_ptr<jllvm::AOTLibrary>> jllvm::AOTLibrary::load(llvm::StringRef path,
+                                                                          const llvm::TargetMachine& targetMachine)
+{
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+        llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer)
+    {
+        return llvm::createFileError(path, buffer.getError());
+    }
+
+    llvm::Expected<std::unique_ptr<llvm::object::Archive>> archive =
+        llvm::object::Archive::create((*buffer)->getMemBufferRef());
+    if (!archive)
+    {
+        return llvm::createFileError(path, archive.takeError());
+    }
+
+    std::unique_ptr<AOTLibrary> library(new AOTLibrary(std::move(*buffer), std::move(*archive)));
+
+    std::optional<llvm::StringRef> target;
+    llvm::Error error = llvm::Error::success();
+    for (const llvm::object::Archive::Child& child : library->m_archive->children(error))
+    {
+        llvm::Expected<llvm::StringRef> name = child.getName();
+        if (!name)
+        {
+            // 'error' is only set once iteration has finished and has to be checked regardless.
+            llvm::consumeError(std::move(error));
+            return llvm::createFileError(path, name.takeError());
+        }
+        llvm::Expected<llvm::MemoryBufferRef> memberBuffer = child.getMemoryBufferRef();
+        if (!memberBuffer)
+        {
+            llvm::consumeError(std::move(error));
+            return llvm::createFileError(path, memberBuffer.takeError());
+        }
+
+        if (*name == targetMemberName)
+        {
+            target = memberBuffer->getBuffer();
+            continue;
+        }
+        library->m_members[*name] = *memberBuffer;
+    }
+    if (error)
+    {
+        return llvm::createFileError(path, std::move(error));
+    }
+
+    if (target != getTargetDescription(targetMachine))
+    {
+        return llvm::createFileError(
+            path, llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                          "library was compiled for a different target or JLLVM build"));
+    }
+
+    return library;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> jllvm::AOTLibrary::lookup(const Method& method) const
+{
+    auto iter = m_members.find(getMemberName(method));
+    if (iter == m_members.end())
+    {
+        return nullptr;
+    }
+    // The buffer is owned by the library, which must outlive any uses of the returned object.
+    return llvm::MemoryBuffer::getMemBuffer(iter->second, /*RequiresNullTerminator=*/false);
+}
@@ -0,0 +1,73 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Object/Archive.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <jllvm/object/ClassObject.hpp>
+
+#include <memory>
+#include <string>
+
+namespace jllvm
+{
+
+/// Library of Java methods compiled ahead-of-time by 'jllvm-jvmc --aot'.
+///
+/// The library is an archive containing one object file per method, produced the same way as the JIT would produce
+/// it. Every object is named after 'getMemberName' of its method, which includes the hash of the class file the method
+/// was compiled from. Methods of class files that have changed since compiling the library are therefore never found.
+/// Additionally, the archive contains a member named 'targetMemberName' describing the target and JLLVM build the
+/// objects were compiled for.
+class AOTLibrary
+{
+    std::unique_ptr<llvm::MemoryBuffer> m_buffer;
+    std::unique_ptr<llvm::object::Archive> m_archive;
+    llvm::StringMap<llvm::MemoryBufferRef> m_members;
+
+    AOTLibrary(std::unique_ptr<llvm::MemoryBuffer>&& buffer, std::unique_ptr<llvm::object::Archive>&& archive)
+        : m_buffer(std::move(buffer)), m_archive(std::move(archive))
+    {
+    }
+
+public:
+    /// Name of the archive member containing the result of 'getTargetDescription'.
+    constexpr static llvm::StringLiteral targetMemberName = "jllvm.target";
+
+    /// Returns a description of the target 'targetMachine' compiles for and of the JLLVM build. Libraries may only be
+    /// loaded by a VM built from the same sources compiling for the same target.
+    static std::string getTargetDescription(const llvm::TargetMachine& targetMachine);
+
+    /// Returns the name of the archive member containing the object file of 'method'.
+    static std::string getMemberName(const Method& method);
+
+    /// Loads the library at 'path'. Fails if the file is not a valid library or was compiled for a different target
+    /// than 'targetMachine' or by a different JLLVM build.
+    static llvm::Expected<std::unique_ptr<AOTLibrary>> load(llvm::StringRef path,
+                                                           const llvm::TargetMachine& targetMachine);
+
+    /// Returns the object file containing the compiled code of 'method' or null if not contained in the library.
+    std::unique_ptr<llvm::MemoryBuffer> lookup(const Method& method) const;
+
+    /// Returns true if the library contains compiled code for 'method'.
+    bool contains(const Method& method) const
+    {
+        return m_members.contains(getMemberName(method));
+    }
+};
+
+} // namespace jllvm
@@ -0,0 +1,141 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#include "BackgroundCompileLayer.hpp"
+
+#include <llvm/Support/Debug.h>
+
+#define DEBUG_TYPE "jvm"
+
+char jllvm::BackgroundCompileTask::ID = 0;
+
+jllvm::BackgroundCompileLayer::BackgroundCompileLayer(llvm::orc::ExecutionSession& session,
+                                                      llvm::orc::ObjectLayer& baseLayer,
+                                                      llvm::orc::JITTargetMachineBuilder targetMachineBuilder,
+                                                      llvm::TargetMachine& targetMachine, OptimizeFunction optimize,
+                                                      llvm::ObjectCache* objectCache)
+    : llvm::orc::IRLayer(session, m_manglingOptions),
+      m_baseLayer(baseLayer),
+      m_targetMachineBuilder(std::move(targetMachineBuilder)),
+      m_targetMachine(targetMachine),
+      m_objectCache(objectCache),
+      m_compiler(targetMachine, objectCache),
+      m_manglingOptions(&m_compiler.getManglingOptions()),
+      m_optimize(std::move(optimize))
+{
+}
+
+jllvm::BackgroundCompileLayer::~BackgroundCompileLayer()
+{
+    cancelBackgroundCompilations();
+}
+
+void jllvm::BackgroundCompileLayer::emit(std::unique_ptr<llvm::orc::MaterializationResponsibility> mr,
+                                         llvm::orc::ThreadSafeModule tsm)
+{
+    bool inBackground = llvm::any_of(llvm::make_first_range(mr->getSymbols()),
+                                     [&](const llvm::orc::SymbolStringPtr& symbol)
+                                     { return m_backgroundSymbols.erase(symbol); });
+    if (!inBackground)
+    {
+        llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> object = tsm.withModuleDo(
+            [&](llvm::Module& module)
+            {
+                m_optimize(module, m_targetMachine);
+                return m_compiler(module);
+            });
+        if (!object)
+        {
+            mr->failMaterialization();
+            getExecutionSession().reportError(object.takeError());
+            return;
+        }
+        m_baseLayer.emit(std::move(mr), std::move(*object));
+        return;
+    }
+
+    LLVM_DEBUG({ llvm::dbgs() << "Compiling " << tsm.getModuleUnlocked()->getName() << " in the background\n"; });
+
+    {
+        std::scoped_lock lock(m_mutex);
+        m_runningTasks++;
+    }
+
+    getExecutionSession().dispatchTask(std::make_unique<BackgroundCompileTask>(
+        [this, mr = std::move(mr), tsm = std::move(tsm)]() mutable
+        {
+            // Target machines are not thread-safe. Every compilation therefore creates its own.
+            llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> object =
+                [&]() -> llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>>
+            {
+                llvm::Expected<std::unique_ptr<llvm::TargetMachine>> targetMachine =
+                    m_targetMachineBuilder.createTargetMachine();
+                if (!targetMachine)
+                {
+                    return targetMachine.takeError();
+                }
+                return tsm.withModuleDo(
+                    [&](llvm::Module& module)
+                    {
+                        m_optimize(module, **targetMachine);
+                        return llvm::orc::SimpleCompiler(**targetMachine, m_objectCache)(module);
+                    });
+            }();
+
+            std::scoped_lock lock(m_mutex);
+            m_finishedCompilations.push_back({std::move(mr), std::move(object)});
+            m_hasFinishedCompilations.store(true, std::memory_order_relaxed);
+            if (--m_runningTasks == 0)
+            {
+                m_allTasksDone.notify_all();
+            }
+        }));
+}
+
+void jllvm::BackgroundCompileLayer::emitFinishedCompilations()
+{
+    std::vector<FinishedCompilation> finishedCompilations;
+    {
+        std::scoped_lock lock(m_mutex);
+        std::swap(finishedCompilations, m_finishedCompilations);
+        m_hasFinishedCompilations.store(false, std::memory_order_relaxed);
+    }
+
+    for (FinishedCompilation& finished : finishedCompilations)
+    {
+        if (!finished.object)
+        {
+            finished.responsibility->failMaterialization();
+            getExecutionSession().reportError(finished.object.takeError());
+            continue;
+        }
+        m_baseLayer.emit(std::move(finished.responsibility), std::move(*finished.object));
+    }
+}
+
+void jllvm::BackgroundCompileLayer::cancelBackgroundCompilations()
+{
+    std::vector<FinishedCompilation> finishedCompilations;
+    {
+        std::unique_lock lock(m_mutex);
+        m_allTasksDone.wait(lock, [&] { return m_runningTasks == 0; });
+        std::swap(finishedCompilations, m_finishedCompilations);
+        m_hasFinishedCompilations.store(false, std::memory_order_relaxed);
+    }
+
+    for (FinishedCompilation& finished : finishedCompilations)
+    {
+        llvm::consumeError(finished.object.takeError());
+        finished.responsibility->failMaterialization();
+    }
+}
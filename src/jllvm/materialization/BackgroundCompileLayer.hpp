@@ -0,0 +1,133 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/Layer.h>
+#include <llvm/ExecutionEngine/Orc/TaskDispatch.h>
+#include <llvm/Support/ExtensibleRTTI.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace jllvm
+{
+
+/// Task dispatched by the 'BackgroundCompileLayer' to optimize and compile a module. Task dispatchers may run these on
+/// a different thread than the thread that dispatched it.
+class BackgroundCompileTask : public llvm::RTTIExtends<BackgroundCompileTask, llvm::orc::Task>
+{
+    llvm::unique_function<void()> m_compile;
+
+public:
+    static char ID;
+
+    explicit BackgroundCompileTask(llvm::unique_function<void()>&& compile) : m_compile(std::move(compile)) {}
+
+    void printDescription(llvm::raw_ostream& os) override
+    {
+        os << "background compilation";
+    }
+
+    void run() override
+    {
+        m_compile();
+    }
+};
+
+/// Layer optimizing and compiling LLVM IR modules to object files that are then emitted in the base layer.
+///
+/// By default, modules are compiled synchronously on the thread that emits them. Modules defining any symbol
+/// previously passed to 'compileInBackground' are instead optimized and compiled by a 'BackgroundCompileTask'
+/// dispatched through the execution session. Since linking may load classes and registers stack maps with the garbage
+/// collector, the resulting objects are only emitted in the base layer once 'emitFinishedCompilations' is called.
+class BackgroundCompileLayer : public llvm::orc::IRLayer
+{
+public:
+    /// Function called to optimize a module prior to code generation. May be called from multiple threads at once
+    /// with the target machine used for code generation of the module.
+    using OptimizeFunction = std::function<void(llvm::Module&, llvm::TargetMachine&)>;
+
+private:
+    struct FinishedCompilation
+    {
+        std::unique_ptr<llvm::orc::MaterializationResponsibility> responsibility;
+        llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> object;
+    };
+
+    llvm::orc::ObjectLayer& m_baseLayer;
+    llvm::orc::JITTargetMachineBuilder m_targetMachineBuilder;
+    llvm::TargetMachine& m_targetMachine;
+    llvm::ObjectCache* m_objectCache;
+    llvm::orc::SimpleCompiler m_compiler;
+    const llvm::orc::IRSymbolMapper::ManglingOptions* m_manglingOptions;
+    OptimizeFunction m_optimize;
+
+    /// Symbols whose materialization should be compiled in the background.
+    llvm::DenseSet<llvm::orc::SymbolStringPtr> m_backgroundSymbols;
+
+    std::mutex m_mutex;
+    std::condition_variable m_allTasksDone;
+    std::size_t m_runningTasks = 0;
+    std::vector<FinishedCompilation> m_finishedCompilations;
+    std::atomic<bool> m_hasFinishedCompilations = false;
+
+public:
+    /// Creates a new 'BackgroundCompileLayer' emitting objects into 'baseLayer'. 'targetMachine' is used for
+    /// synchronous compilation, while every background compilation creates its own target machine using
+    /// 'targetMachineBuilder'. If non-null, 'objectCache' is notified about every compiled object and must therefore be
+    /// thread-safe.
+    BackgroundCompileLayer(llvm::orc::ExecutionSession& session, llvm::orc::ObjectLayer& baseLayer,
+                           llvm::orc::JITTargetMachineBuilder targetMachineBuilder,
+                           llvm::TargetMachine& targetMachine, OptimizeFunction optimize,
+                           llvm::ObjectCache* objectCache = nullptr);
+
+    ~BackgroundCompileLayer() override;
+
+    /// Causes the next materialization of 'symbol' to be compiled in the background.
+    void compileInBackground(llvm::orc::SymbolStringPtr symbol)
+    {
+        m_backgroundSymbols.insert(std::move(symbol));
+    }
+
+    /// Cancels a previous request to compile 'symbol' in the background if its materialization has not yet started.
+    void cancelCompileInBackground(const llvm::orc::SymbolStringPtr& symbol)
+    {
+        m_backgroundSymbols.erase(symbol);
+    }
+
+    /// Returns true if any background compilations are ready to be emitted by 'emitFinishedCompilations'.
+    /// This is cheap enough to be polled frequently.
+    bool hasFinishedCompilations() const
+    {
+        return m_hasFinishedCompilations.load(std::memory_order_relaxed);
+    }
+
+    /// Emits all objects of finished background compilations in the base layer.
+    void emitFinishedCompilations();
+
+    /// Waits for all currently running background compilations to finish and fails the materialization of any that
+    /// have not yet been emitted. Must be called prior to ending the execution session.
+    void cancelBackgroundCompilations();
+
+    void emit(std::unique_ptr<llvm::orc::MaterializationResponsibility> mr, llvm::orc::ThreadSafeModule tsm) override;
+};
+
+} // namespace jllvm
@@ -26,12 +26,39 @@ void jllvm::ByteCodeCompileLayer::emit(std::unique_ptr<llvm::orc::Materializatio
                                        const Method* method)
 {
     std::string methodName = mangleDirectMethodCall(method);
+
+    std::string cacheKey;
+    if (m_codeCache)
+    {
+        // The tier up counter is part of the generated code and the threshold must therefore be part of the key.
+        // Methods are recompiled after deoptimizing, which must not lead to the same code being loaded again.
+        const MethodProfile* profile = method->getProfile();
+        cacheKey = m_codeCache->getKey(
+            *method, "tier=" + std::to_string(static_cast<unsigned>(m_tier)) + ";tier-up-threshold="
+                         + std::to_string(m_tierUpThreshold)
+                         + ";deoptimizations=" + std::to_string(profile ? profile->getDeoptimizationCount() : 0));
+        if (std::unique_ptr<llvm::MemoryBuffer> object = m_codeCache->lookup(cacheKey))
+        {
+            LLVM_DEBUG({ llvm::dbgs() << "Emitting cached object for " << methodName << '\n'; });
+            m_codeCache->getObjectLayer().emit(std::move(mr), std::move(object));
+            return;
+        }
+    }
+
     LLVM_DEBUG({ llvm::dbgs() << "Emitting LLVM IR for " << methodName << '\n'; });
 
     auto context = std::make_unique<llvm::LLVMContext>();
     auto module = std::make_unique<llvm::Module>(methodName, *context);
 
-    compileMethod(*module, *method);
+    // Optimized code is never inlined into other methods and may therefore contain uncommon traps. Methods may be
+    // inlined into its calls, requiring the calls to record the state needed to deoptimize the inlined frames.
+    bool optimized = m_tier == CompilationTier::Optimized;
+    compileMethod(*module, *method, m_tierUpThreshold, /*uncommonTraps=*/optimized, /*recordCallFrames=*/optimized);
+    setCompilationTier(*module, m_tier);
+    if (m_codeCache)
+    {
+        CodeCache::setKey(*module, cacheKey);
+    }
 
     module->setDataLayout(m_dataLayout);
     module->setTargetTriple(LLVM_HOST_TRIPLE);
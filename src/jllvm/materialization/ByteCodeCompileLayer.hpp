@@ -15,7 +15,10 @@
 
 #include <llvm/ExecutionEngine/Orc/Layer.h>
 
+#include <jllvm/compiler/ByteCodeCompileUtils.hpp>
+
 #include "ByteCodeLayer.hpp"
+#include "CodeCache.hpp"
 
 namespace jllvm
 {
@@ -24,11 +27,27 @@ class ByteCodeCompileLayer : public ByteCodeLayer
 {
     llvm::orc::IRLayer& m_baseLayer;
     llvm::DataLayout m_dataLayout;
+    CompilationTier m_tier;
+    std::uint64_t m_tierUpThreshold;
+    CodeCache* m_codeCache;
 
 public:
+    /// Creates a layer compiling methods to code of the given 'tier'. If 'tierUpThreshold' is non-zero, the code
+    /// requests its recompilation by calling 'jllvm_tier_up' once the sum of invocations and loop iterations reaches
+    /// 'tierUpThreshold'.
+    /// If 'codeCache' is non-null and 'tier' is 'CompilationTier::Baseline', methods found in the code cache are
+    /// emitted directly into its object layer without generating any LLVM IR. All other methods are stored in the code
+    /// cache once compiled. Optimized code is never cached as it relies on class hierarchy analysis and inlining, which
+    /// depend on the classes loaded by the current process.
     ByteCodeCompileLayer(llvm::orc::IRLayer& baseLayer, llvm::orc::MangleAndInterner& mangler,
-                         const llvm::DataLayout& dataLayout)
-        : ByteCodeLayer{mangler}, m_baseLayer{baseLayer}, m_dataLayout{dataLayout}
+                         const llvm::DataLayout& dataLayout, CompilationTier tier = CompilationTier::Optimized,
+                         std::uint64_t tierUpThreshold = 0, CodeCache* codeCache = nullptr)
+        : ByteCodeLayer{mangler},
+          m_baseLayer{baseLayer},
+          m_dataLayout{dataLayout},
+          m_tier{tier},
+          m_tierUpThreshold{tierUpThreshold},
+          m_codeCache{tier == CompilationTier::Baseline ? codeCache : nullptr}
     {
     }
 
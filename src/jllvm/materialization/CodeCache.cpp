@@ -0,0 +1,171 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#include "CodeCache.hpp"
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/BLAKE3.h>
+#include <llvm/Support/Debug.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA1.h>
+
+#include <jllvm/compiler/ClassObjectStubMangling.hpp>
+
+#include <chrono>
+
+#define DEBUG_TYPE "jvm"
+
+namespace
+{
+/// Name of the module flag containing the code cache key of a module.
+constexpr llvm::StringLiteral codeCacheKeyFlag = "jllvm.code-cache-key";
+
+std::string sha1Hex(llvm::StringRef bytes)
+{
+    return llvm::toHex(llvm::SHA1::hash(llvm::arrayRefFromStringRef(bytes)), /*LowerCase=*/true);
+}
+
+/// Returns a hash identifying both the JLLVM build running and the target that objects are compiled for.
+std::string computeBuildID(const llvm::TargetMachine& targetMachine)
+{
+    std::string buildID;
+    llvm::raw_string_ostream ss(buildID);
+    ss << LLVM_VERSION_STRING << '\n'
+       << targetMachine.getTargetTriple().str() << '\n'
+       << targetMachine.getTargetCPU() << '\n'
+       << targetMachine.getTargetFeatureString() << '\n';
+
+    // JLLVM builds do not have a version or build number. Use a hash of the content of the executable instead, which
+    // contrary to e.g. its modification time, identifies the code generator exactly regardless of how the executable
+    // was copied or installed. BLAKE3 is used as the executable may be large.
+    std::string executable = llvm::sys::fs::getMainExecutable(nullptr, reinterpret_cast<void*>(&computeBuildID));
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> content =
+        llvm::MemoryBuffer::getFile(executable, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!content)
+    {
+        // Without knowing the build, objects of a different build could be loaded. Make the ID unique to this process
+        // instead, effectively disabling the cache.
+        LLVM_DEBUG({
+            llvm::dbgs() << "Failed to read " << executable << " to compute code cache build ID: "
+                         << content.getError().message() << '\n';
+        });
+        ss << llvm::sys::Process::getProcessId() << '\n'
+           << std::chrono::steady_clock::now().time_since_epoch().count();
+        return sha1Hex(ss.str());
+    }
+    ss << llvm::toHex(llvm::BLAKE3::hash(llvm::arrayRefFromStringRef((*content)->getBuffer())), /*LowerCase=*/true);
+    return sha1Hex(ss.str());
+}
+
+} // namespace
+
+jllvm::CodeCache::CodeCache(llvm::StringRef directory, llvm::orc::ObjectLayer& objectLayer,
+                            const llvm::TargetMachine& targetMachine)
+    : m_directory(directory), m_buildID(computeBuildID(targetMachine)), m_objectLayer(objectLayer)
+{
+    if (std::error_code ec = llvm::sys::fs::create_directories(m_directory))
+    {
+        // Not fatal. All lookups and stores simply fail.
+        LLVM_DEBUG({
+            llvm::dbgs() << "Failed to create code cache directory " << m_directory << ": " << ec.message() << '\n';
+        });
+    }
+}
+
+std::string jllvm::CodeCache::getKey(const Method& method, llvm::StringRef variant) const
+{
+    const ClassFile* classFile = method.getClassObject()->getClassFile();
+    assert(classFile && "methods with code must be defined in a class file");
+
+    std::string key;
+    llvm::raw_string_ostream ss(key);
+    ss << m_buildID << '\n' << classFile->getContentHash() << '\n' << mangleDirectMethodCall(&method) << '\n'
+       << variant;
+    return sha1Hex(ss.str());
+}
+
+std::unique_ptr<llvm::MemoryBuffer> jllvm::CodeCache::lookup(llvm::StringRef key) const
+{
+    llvm::SmallString<128> path(m_directory);
+    llvm::sys::path::append(path, key + ".o");
+
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer =
+        llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer)
+    {
+        return nullptr;
+    }
+    return std::move(*buffer);
+}
+
+void jllvm::CodeCache::setKey(llvm::Module& module, llvm::StringRef key)
+{
+    module.addModuleFlag(llvm::Module::Error, codeCacheKeyFlag, llvm::MDString::get(module.getContext(), key));
+}
+
+std::optional<llvm::StringRef> jllvm::CodeCache::getKey(const llvm::Module& module)
+{
+    auto* flag = llvm::dyn_cast_or_null<llvm::MDString>(module.getModuleFlag(codeCacheKeyFlag));
+    if (!flag)
+    {
+        return std::nullopt;
+    }
+    return flag->getString();
+}
+
+void jllvm::CodeCache::notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object)
+{
+    std::optional<llvm::StringRef> key = getKey(*module);
+    if (!key)
+    {
+        return;
+    }
+
+    llvm::SmallString<128> path(m_directory);
+    llvm::sys::path::append(path, *key + ".o");
+
+    // The object is first written to a temporary file which is then renamed. This makes storing the object atomic for
+    // any other JLLVM process using the same cache directory.
+    int fd;
+    llvm::SmallString<128> tempPath;
+    if (std::error_code ec = llvm::sys::fs::createUniqueFile(llvm::Twine(path) + ".%%%%%%.tmp", fd, tempPath))
+    {
+        LLVM_DEBUG({ llvm::dbgs() << "Failed to store " << path << " in code cache: " << ec.message() << '\n'; });
+        return;
+    }
+
+    llvm::raw_fd_ostream os(fd, /*shouldClose=*/true);
+    os << object.getBuffer();
+    os.close();
+    if (os.has_error())
+    {
+        LLVM_DEBUG({
+            llvm::dbgs() << "Failed to store " << path << " in code cache: " << os.error().message() << '\n';
+        });
+        os.clear_error();
+        llvm::sys::fs::remove(tempPath);
+        return;
+    }
+
+    if (llvm::sys::fs::rename(tempPath, path))
+    {
+        llvm::sys::fs::remove(tempPath);
+        return;
+    }
+    LLVM_DEBUG({ llvm::dbgs() << "Stored " << module->getName() << " in code cache as " << path << '\n'; });
+}
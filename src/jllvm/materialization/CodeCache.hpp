@@ -0,0 +1,83 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+#include <llvm/ExecutionEngine/Orc/Layer.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include <jllvm/object/ClassObject.hpp>
+
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace jllvm
+{
+
+/// Persistent on-disk cache of the object files produced when compiling Java methods.
+///
+/// Objects are keyed by the content of the class file defining the method, the method itself, a variant string
+/// describing how the method was compiled and the build of JLLVM and target machine producing it. Cached objects only
+/// contain symbolic references to other methods, class objects and runtime functions and can therefore be linked into
+/// any process running the same JLLVM build. Only baseline code is cached as optimized code relies on assumptions
+/// about the classes loaded by the process compiling it.
+///
+/// Layers producing LLVM IR for a method first look up the object using 'lookup' and emit it directly into
+/// 'getObjectLayer()' if found. Otherwise, they attach the key to the module using 'setKey', causing the object to be
+/// stored once compiled. To be notified about compiled objects, the cache has to be passed as 'llvm::ObjectCache' to
+/// the compiler.
+class CodeCache : public llvm::ObjectCache
+{
+    std::string m_directory;
+    std::string m_buildID;
+    llvm::orc::ObjectLayer& m_objectLayer;
+
+public:
+    /// Creates a new code cache storing objects within 'directory', creating it if it does not exist.
+    /// Objects found in the cache are meant to be emitted in 'objectLayer'. 'targetMachine' is the target machine
+    /// objects are compiled for.
+    CodeCache(llvm::StringRef directory, llvm::orc::ObjectLayer& objectLayer, const llvm::TargetMachine& targetMachine);
+
+    /// Returns the object layer that objects returned by 'lookup' should be emitted in.
+    llvm::orc::ObjectLayer& getObjectLayer() const
+    {
+        return m_objectLayer;
+    }
+
+    /// Returns the key for the object file produced by compiling 'method'. 'variant' must uniquely describe any
+    /// compilation options that change the object file produced for 'method'.
+    std::string getKey(const Method& method, llvm::StringRef variant) const;
+
+    /// Returns the cached object for 'key' or null if not contained in the cache.
+    std::unique_ptr<llvm::MemoryBuffer> lookup(llvm::StringRef key) const;
+
+    /// Marks 'module' as cacheable under 'key'. The object file produced for 'module' is stored in the cache once
+    /// compiled.
+    static void setKey(llvm::Module& module, llvm::StringRef key);
+
+    /// Returns the key 'module' was marked with using 'setKey' or an empty optional if 'module' is not cacheable.
+    static std::optional<llvm::StringRef> getKey(const llvm::Module& module);
+
+    /// Stores 'object' in the cache if 'module' was marked as cacheable. Thread-safe.
+    void notifyObjectCompiled(const llvm::Module* module, llvm::MemoryBufferRef object) override;
+
+    /// Always returns null as lookups already happen prior to generating LLVM IR.
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module*) override
+    {
+        return nullptr;
+    }
+};
+
+} // namespace jllvm
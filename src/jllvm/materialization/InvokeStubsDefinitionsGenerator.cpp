@@ -22,7 +22,8 @@ using namespace jllvm;
 /// Compiles the given 'variant' to its corresponding function definition and returns the new module containing the
 /// function definition.
 llvm::orc::ThreadSafeModule compile(const DemangledVariant& variant, ClassLoader& classLoader,
-                                    const llvm::DataLayout& dataLayout, const ClassObject* objectClass)
+                                    ClassHierarchyAnalysis& classHierarchyAnalysis, const llvm::DataLayout& dataLayout,
+                                    const ClassObject* objectClass)
 {
     auto context = std::make_unique<llvm::LLVMContext>();
     auto module = std::make_unique<llvm::Module>("name", *context);
@@ -47,9 +48,11 @@ llvm::orc::ThreadSafeModule compile(const DemangledVariant& variant, ClassLoader
         [&](const DemangledMethodResolutionCall& methodResolutionCall)
         {
             ClassObject& classObject = classLoader.forName(FieldType::fromMangled(methodResolutionCall.className));
+            // Stubs are shared by all callers and never recompiled. Invalidated assumptions fall back to the
+            // v-table.
             generateMethodResolutionCallStub(*module, methodResolutionCall.resolution, classObject,
                                              methodResolutionCall.methodName, methodResolutionCall.descriptor,
-                                             *objectClass);
+                                             *objectClass, &classHierarchyAnalysis);
         },
         [&](const DemangledSpecialCall& specialCall)
         {
@@ -115,8 +118,9 @@ llvm::Error jllvm::InvokeStubsDefinitionsGenerator::tryToGenerate(llvm::orc::Loo
             llvm::cantFail(m_callbackManager->getCompileCallback(
                 [this, demangleVariant, name, symbol]
                 {
-                    llvm::orc::ThreadSafeModule module =
-                        compile(demangleVariant, m_classLoader, m_dataLayout, m_objectClassCache);
+                    llvm::orc::ThreadSafeModule module = compile(demangleVariant, m_classLoader,
+                                                                 m_classHierarchyAnalysis, m_dataLayout,
+                                                                 m_objectClassCache);
 
                     llvm::cantFail(m_baseLayer.add(m_impl, std::move(module)));
                     llvm::JITTargetAddress address =
@@ -17,6 +17,7 @@
 #include <llvm/ExecutionEngine/Orc/IndirectionUtils.h>
 #include <llvm/ExecutionEngine/Orc/Layer.h>
 
+#include <jllvm/object/ClassHierarchyAnalysis.hpp>
 #include <jllvm/object/ClassLoader.hpp>
 
 namespace jllvm
@@ -34,12 +35,14 @@ class InvokeStubsDefinitionsGenerator : public llvm::orc::DefinitionGenerator
     llvm::orc::JITDylib& m_impl;
     llvm::DataLayout m_dataLayout;
     ClassLoader& m_classLoader;
+    ClassHierarchyAnalysis& m_classHierarchyAnalysis;
     ClassObject* m_objectClassCache = nullptr;
 
 public:
     explicit InvokeStubsDefinitionsGenerator(std::unique_ptr<llvm::orc::IndirectStubsManager>&& stubsManager,
                                              llvm::orc::IRLayer& baseLayer, const llvm::DataLayout& dataLayout,
-                                             const llvm::orc::JITDylibSearchOrder& linkOrder, ClassLoader& classLoader)
+                                             const llvm::orc::JITDylibSearchOrder& linkOrder, ClassLoader& classLoader,
+                                             ClassHierarchyAnalysis& classHierarchyAnalysis)
         : m_stubsManager(std::move(stubsManager)),
           m_callbackManager{llvm::cantFail(llvm::orc::createLocalCompileCallbackManager(
               llvm::Triple(LLVM_HOST_TRIPLE), baseLayer.getExecutionSession(),
@@ -47,7 +50,8 @@ public:
           m_baseLayer{baseLayer},
           m_impl{m_baseLayer.getExecutionSession().createBareJITDylib("<classObjectStubs>")},
           m_dataLayout{dataLayout},
-          m_classLoader{classLoader}
+          m_classLoader{classLoader},
+          m_classHierarchyAnalysis{classHierarchyAnalysis}
     {
         m_impl.setLinkOrder(linkOrder);
     }
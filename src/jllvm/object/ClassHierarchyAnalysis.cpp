@@ -0,0 +1,113 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#include "ClassHierarchyAnalysis.hpp"
+
+#include <llvm/Support/Debug.h>
+
+#define DEBUG_TYPE "jvm"
+
+const jllvm::ClassHierarchyAnalysis::Assumption*
+    jllvm::ClassHierarchyAnalysis::devirtualize(const ClassObject& receiverType, const Method& resolvedMethod,
+                                                const Method* dependent)
+{
+    assert(receiverType.isClass() && "interface calls are not devirtualized");
+
+    std::pair key{&receiverType, &resolvedMethod};
+    if (m_polymorphic.contains(key))
+    {
+        return nullptr;
+    }
+
+    Assumption*& assumption = m_assumptions[key];
+    if (!assumption)
+    {
+        // Only classes that can be instantiated can be the class of a 'this' object. Array class objects are never
+        // part of the subclass lists but do not override any methods of 'java/lang/Object' either.
+        const Method* target = nullptr;
+        llvm::SmallVector<const ClassObject*> worklist{&receiverType};
+        while (!worklist.empty())
+        {
+            const ClassObject* curr = worklist.pop_back_val();
+            if (!curr->isAbstract())
+            {
+                const Method& selected = curr->methodSelection(resolvedMethod);
+                if (selected.isAbstract() || (target && target != &selected))
+                {
+                    m_assumptions.erase(key);
+                    m_polymorphic.insert(key);
+                    return nullptr;
+                }
+                target = &selected;
+            }
+            llvm::append_range(worklist, m_classLoader.getDirectSubClasses(*curr));
+        }
+        if (!target)
+        {
+            // No instances can exist yet. The call is not worth optimizing for.
+            m_assumptions.erase(key);
+            return nullptr;
+        }
+
+        assumption = m_storage.emplace_back(std::make_unique<Assumption>(receiverType, resolvedMethod, *target)).get();
+        m_assumptionsByReceiver[&receiverType].push_back(assumption);
+    }
+
+    if (dependent)
+    {
+        assumption->m_dependents.insert(dependent);
+    }
+    return assumption;
+}
+
+llvm::SmallVector<const jllvm::Method*> jllvm::ClassHierarchyAnalysis::classLoaded(const ClassObject& classObject)
+{
+    if (!classObject.isClass() || classObject.isAbstract())
+    {
+        return {};
+    }
+
+    llvm::SetVector<const Method*, llvm::SmallVector<const Method*>> dependents;
+
+    // Assumptions are only ever made about class receiver types, making it sufficient to only check the super classes.
+    for (const ClassObject* superClass : classObject.getSuperClasses(/*includeThis=*/false))
+    {
+        auto iter = m_assumptionsByReceiver.find(superClass);
+        if (iter == m_assumptionsByReceiver.end())
+        {
+            continue;
+        }
+
+        llvm::erase_if(iter->second,
+                       [&](Assumption* assumption)
+                       {
+                           if (&classObject.methodSelection(*assumption->m_resolvedMethod) == assumption->m_target)
+                           {
+                               return false;
+                           }
+
+                           LLVM_DEBUG({
+                               llvm::dbgs() << "Loading " << classObject.getClassName()
+                                            << " invalidates single implementation of "
+                                            << assumption->m_resolvedMethod->getName() << " in "
+                                            << superClass->getClassName() << '\n';
+                           });
+                           assumption->m_valid = false;
+                           dependents.insert(assumption->m_dependents.begin(), assumption->m_dependents.end());
+                           m_assumptions.erase({assumption->m_receiverType, assumption->m_resolvedMethod});
+                           m_polymorphic.insert({assumption->m_receiverType, assumption->m_resolvedMethod});
+                           return true;
+                       });
+    }
+    return dependents.takeVector();
+}
@@ -0,0 +1,106 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/SetVector.h>
+#include <llvm/ADT/SmallVector.h>
+
+#include <memory>
+#include <vector>
+
+#include "ClassLoader.hpp"
+#include "ClassObject.hpp"
+
+namespace jllvm
+{
+
+/// Class hierarchy analysis (CHA) over all class objects loaded by a class loader.
+///
+/// CHA is used to devirtualize calls to methods that have exactly one implementation among all loaded subclasses of
+/// the receiver type. Since loading further classes may add more implementations, every devirtualization is recorded
+/// as an 'Assumption' which is invalidated once a class selecting a different implementation is loaded.
+class ClassHierarchyAnalysis
+{
+public:
+    /// Assumption that every instance of a receiver type selects the same target method when calling a resolved
+    /// method.
+    class Assumption
+    {
+        const ClassObject* m_receiverType;
+        const Method* m_resolvedMethod;
+        const Method* m_target;
+        /// Read by compiled code prior to calling 'm_target' directly. Must therefore have a stable address.
+        std::uint8_t m_valid = true;
+        llvm::SmallSetVector<const Method*, 2> m_dependents;
+
+        friend class ClassHierarchyAnalysis;
+
+    public:
+        Assumption(const ClassObject& receiverType, const Method& resolvedMethod, const Method& target)
+            : m_receiverType(&receiverType), m_resolvedMethod(&resolvedMethod), m_target(&target)
+        {
+        }
+
+        /// Returns the method called by every instance of the receiver type.
+        const Method& getTarget() const
+        {
+            return *m_target;
+        }
+
+        /// Returns true if the assumption still holds.
+        bool isValid() const
+        {
+            return m_valid;
+        }
+
+        /// Returns the address of a byte that is non-zero as long as the assumption holds. Compiled code relying on the
+        /// assumption has to check it as it may continue to be executed after the assumption has been invalidated.
+        const std::uint8_t* getValidFlag() const
+        {
+            return &m_valid;
+        }
+    };
+
+private:
+    ClassLoader& m_classLoader;
+    /// Storage of all assumptions ever made. Invalidated assumptions are kept alive as compiled code may still read
+    /// their valid flag.
+    std::vector<std::unique_ptr<Assumption>> m_storage;
+    /// Valid assumptions keyed by receiver type and resolved method.
+    llvm::DenseMap<std::pair<const ClassObject*, const Method*>, Assumption*> m_assumptions;
+    /// Valid assumptions indexed by their receiver type.
+    llvm::DenseMap<const ClassObject*, llvm::SmallVector<Assumption*, 1>> m_assumptionsByReceiver;
+    /// Receiver type and resolved method pairs known to have more than one implementation. Since classes are never
+    /// unloaded, these can never be devirtualized.
+    llvm::DenseSet<std::pair<const ClassObject*, const Method*>> m_polymorphic;
+
+public:
+    explicit ClassHierarchyAnalysis(ClassLoader& classLoader) : m_classLoader(classLoader) {}
+
+    /// Attempts to devirtualize a call to 'resolvedMethod' with an instance of 'receiverType' as 'this' object, which
+    /// must be a class. Returns the assumption that all such calls select the same method or null if more than one
+    /// implementation exists among the loaded classes.
+    /// If 'dependent' is non-null, it is returned by 'classLoaded' once the assumption is invalidated. This should be
+    /// the method whose compiled code relies on the assumption.
+    const Assumption* devirtualize(const ClassObject& receiverType, const Method& resolvedMethod,
+                                   const Method* dependent = nullptr);
+
+    /// Must be called once 'classObject' has been loaded. Invalidates any assumptions no longer holding due to
+    /// instances of 'classObject' selecting a different method and returns the methods that depended on them.
+    llvm::SmallVector<const Method*> classLoaded(const ClassObject& classObject);
+};
+
+} // namespace jllvm
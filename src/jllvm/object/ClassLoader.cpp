@@ -177,6 +177,11 @@ jllvm::ClassObject& jllvm::ClassLoader::add(std::unique_ptr<llvm::MemoryBuffer>&
                                      methods, fields, interfaces, classFile);
     }
     m_mapping.insert({ObjectType(className), result});
+    // 'interfaces' contains the super class as well in the case of classes.
+    for (ClassObject* base : interfaces)
+    {
+        m_directSubClasses[base].push_back(result);
+    }
     m_prepareClassObject(*result);
 
     return *result;
@@ -23,6 +23,7 @@
 #include <jllvm/class/ClassFile.hpp>
 
 #include <list>
+#include <vector>
 
 #include "ClassObject.hpp"
 #include "StringInterner.hpp"
@@ -35,6 +36,8 @@ class ClassLoader
 {
     llvm::BumpPtrAllocator m_classAllocator;
     llvm::DenseMap<FieldType, ClassObject*> m_mapping;
+    /// Direct subclasses, implementing classes and subinterfaces of every loaded class object.
+    llvm::DenseMap<const ClassObject*, std::vector<ClassObject*>> m_directSubClasses;
 
     llvm::BumpPtrAllocator m_stringAllocator;
     llvm::StringSaver m_stringSaver{m_stringAllocator};
@@ -103,6 +106,18 @@ public:
         return llvm::make_second_range(m_mapping);
     }
 
+    /// Returns all loaded class objects directly extending or implementing 'classObject'. Array class objects are never
+    /// contained.
+    llvm::ArrayRef<ClassObject*> getDirectSubClasses(const ClassObject& classObject) const
+    {
+        auto iter = m_directSubClasses.find(&classObject);
+        if (iter == m_directSubClasses.end())
+        {
+            return {};
+        }
+        return iter->second;
+    }
+
     /// Returns the string interner used for interning constant strings
     StringInterner& getStringInterner() const
     {
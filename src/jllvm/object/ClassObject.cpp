@@ -15,8 +15,11 @@
 
 #include <llvm/ADT/Twine.h>
 #include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/MathExtras.h>
 #include <llvm/Support/raw_ostream.h>
 
+#include <memory>
+
 namespace
 {
 template <class Range>
@@ -47,6 +50,7 @@ jllvm::ClassObject* jllvm::ClassObject::create(llvm::BumpPtrAllocator& allocator
 {
     bool isAbstract = classFile.isAbstract();
     llvm::SmallVector<ITable*> iTables;
+    std::size_t interfaceMethodCount = 0;
     if (!isAbstract)
     {
         llvm::df_iterator_default_set<const jllvm::ClassObject*> seen;
@@ -60,10 +64,20 @@ jllvm::ClassObject* jllvm::ClassObject::create(llvm::BumpPtrAllocator& allocator
                 }
                 iTables.push_back(
                     ITable::create(allocator, classObject->getInterfaceId(), classObject->getTableSize()));
+                interfaceMethodCount += classObject->getTableSize();
             }
         }
     }
 
+    // Keep the load factor of the IMT at or below 50% to make conflicts unlikely.
+    llvm::MutableArrayRef<IMTEntry> imt;
+    if (interfaceMethodCount != 0)
+    {
+        std::size_t imtSize = llvm::PowerOf2Ceil(2 * interfaceMethodCount);
+        imt = {allocator.Allocate<IMTEntry>(imtSize), imtSize};
+        std::uninitialized_fill(imt.begin(), imt.end(), IMTEntry{});
+    }
+
     std::vector<std::uint32_t> gcMask;
     if (!bases.empty() && bases.front()->isClass())
     {
@@ -91,11 +105,12 @@ jllvm::ClassObject* jllvm::ClassObject::create(llvm::BumpPtrAllocator& allocator
     auto* result = new (storage) ClassObject(
         metaClass, vTableSlots, fieldAreaSize, NonOwningFrozenSet(methodsAlloc, allocator),
         NonOwningFrozenSet(arrayRefAlloc(allocator, fields), allocator), arrayRefAlloc(allocator, bases),
-        arrayRefAlloc(allocator, iTables), classFile.getThisClass(), classFile, arrayRefAlloc(allocator, gcMask));
+        arrayRefAlloc(allocator, iTables), imt, classFile.getThisClass(), classFile, arrayRefAlloc(allocator, gcMask));
     for (Method& method : methodsAlloc)
     {
         method.setClassObject(result);
     }
+    result->initializeSupers(allocator);
     // Zero out vTable.
     std::fill(result->getVTable().begin(), result->getVTable().end(), nullptr);
     return result;
@@ -104,8 +119,8 @@ jllvm::ClassObject* jllvm::ClassObject::create(llvm::BumpPtrAllocator& allocator
 jllvm::ClassObject::ClassObject(const ClassObject* metaClass, std::uint32_t vTableSlots, std::int32_t fieldAreaSize,
                                 const NonOwningFrozenSet<Method>& methods, const NonOwningFrozenSet<Field>& fields,
                                 llvm::ArrayRef<ClassObject*> bases, llvm::ArrayRef<ITable*> iTables,
-                                llvm::StringRef className, const ClassFile& classFile,
-                                llvm::ArrayRef<std::uint32_t> gcMask)
+                                llvm::MutableArrayRef<IMTEntry> imt, llvm::StringRef className,
+                                const ClassFile& classFile, llvm::ArrayRef<std::uint32_t> gcMask)
     : m_objectHeader(metaClass),
       m_fieldAreaSize(fieldAreaSize),
       m_tableSize(vTableSlots),
@@ -113,6 +128,7 @@ jllvm::ClassObject::ClassObject(const ClassObject* metaClass, std::uint32_t vTab
       m_fields(fields),
       m_bases(bases),
       m_iTables(iTables),
+      m_imt(imt),
       m_className(className),
       m_gcMask(gcMask),
       m_classFile(&classFile)
@@ -149,6 +165,7 @@ jllvm::ClassObject* jllvm::ClassObject::createArray(llvm::BumpPtrAllocator& allo
     result->m_initialized = InitializationStatus::Initialized;
     result->m_tableSize = vTableSlots;
     result->m_bases = arrayBases;
+    result->initializeSupers(allocator);
     std::fill(result->getVTable().begin(), result->getVTable().end(), nullptr);
     return result;
 }
@@ -193,9 +210,46 @@ jllvm::ClassObject* jllvm::ClassObject::createInterface(llvm::BumpPtrAllocator&
     {
         method.setClassObject(result);
     }
+    result->initializeSupers(allocator);
     return result;
 }
 
+void jllvm::ClassObject::initializeSupers(llvm::BumpPtrAllocator& allocator)
+{
+    llvm::SmallVector<const ClassObject*> secondarySupers;
+    if (isClass())
+    {
+        if (const ClassObject* superClass = getSuperClass())
+        {
+            m_primarySupers = superClass->m_primarySupers;
+            m_depth = superClass->m_depth + 1;
+        }
+        if (m_depth < m_primarySupers.size())
+        {
+            m_primarySupers[m_depth] = this;
+            m_superCheckOffset = offsetof(ClassObject, m_primarySupers) + m_depth * sizeof(const ClassObject*);
+        }
+        else
+        {
+            llvm::append_range(secondarySupers,
+                               llvm::make_filter_range(getSuperClasses(), [](const ClassObject* classObject)
+                                                       { return classObject->m_depth >= primarySuperDisplaySize; }));
+        }
+    }
+    else if (isArray())
+    {
+        // Arrays are only subtypes of 'java/lang/Object' among all classes. Subtyping between array types is checked
+        // using their component types instead.
+        m_primarySupers = getSuperClass()->m_primarySupers;
+    }
+
+    if (!isInterface())
+    {
+        llvm::append_range(secondarySupers, getAllInterfaces());
+    }
+    m_secondarySupers = arrayRefAlloc(allocator, secondarySupers);
+}
+
 jllvm::ITable* jllvm::ITable::create(llvm::BumpPtrAllocator& allocator, std::size_t id, std::size_t iTableSlots)
 {
     auto* result =
@@ -204,6 +258,37 @@ jllvm::ITable* jllvm::ITable::create(llvm::BumpPtrAllocator& allocator, std::siz
     return result;
 }
 
+void jllvm::ClassObject::insertIntoIMT(const Method& interfaceMethod, const Method& selected, VTableSlot code)
+{
+    assert(interfaceMethod.getClassObject()->isInterface() && interfaceMethod.getTableSlot());
+
+    std::size_t key = IMTEntry::getKey(interfaceMethod.getClassObject()->getInterfaceId(),
+                                       *interfaceMethod.getTableSlot());
+    IMTEntry& entry = m_imt[IMTEntry::hash(key) & (m_imt.size() - 1)];
+    if (entry.key != IMTEntry::emptyKey && entry.key != key)
+    {
+        return;
+    }
+    entry = {key, &selected, code};
+}
+
+const jllvm::Method& jllvm::ClassObject::interfaceMethodSelection(const Method& resolvedMethod) const
+{
+    assert(resolvedMethod.getClassObject()->isInterface() && resolvedMethod.getTableSlot());
+
+    if (!m_imt.empty())
+    {
+        std::size_t key =
+            IMTEntry::getKey(resolvedMethod.getClassObject()->getInterfaceId(), *resolvedMethod.getTableSlot());
+        const IMTEntry& entry = m_imt[IMTEntry::hash(key) & (m_imt.size() - 1)];
+        if (entry.key == key)
+        {
+            return *entry.method;
+        }
+    }
+    return methodSelection(resolvedMethod);
+}
+
 bool jllvm::ClassObject::wouldBeInstanceOf(const ClassObject* other) const
 {
     assert(!isInterface());
@@ -212,49 +297,65 @@ bool jllvm::ClassObject::wouldBeInstanceOf(const ClassObject* other) const
         return true;
     }
 
+    // Constant time check for any classes in the primary super display or the last secondary super found.
+    if (*reinterpret_cast<const ClassObject* const*>(reinterpret_cast<const char*>(this) + other->m_superCheckOffset)
+        == other)
+    {
+        return true;
+    }
+    if (other->m_superCheckOffset != getSecondarySuperCacheOffset())
+    {
+        // 'other' is part of the primary super display. The check above is therefore conclusive.
+        return false;
+    }
+
     // Primitive class objects have no concept of inheritance.
     if (isPrimitive() || other->isPrimitive())
     {
         return false;
     }
 
-    if (isArray())
+    if (isArray() && other->isArray())
     {
-        if (other->isInterface())
-        {
-            // If T is an interface type, then T must be one of the interfaces implemented by arrays.
-            return llvm::is_contained(getAllInterfaces(), other);
-        }
-
         // Strip array types and check that the component types are compatible.
         const ClassObject* curr = this;
-        while (curr->isArray() && other->isArray())
+        const ClassObject* otherComponent = other;
+        while (curr->isArray() && otherComponent->isArray())
         {
             curr = curr->getComponentType();
-            other = other->getComponentType();
+            otherComponent = otherComponent->getComponentType();
         }
-        if (curr->isArray())
-        {
-            if (other->isClass())
-            {
-                // If T is a class type, then T must be Object.
-                // Object is easy to identify as it is a normal class with no super class.
-                return !other->getSuperClass();
-            }
 
-            // Not the same depth of array types.
-            return false;
+        bool result;
+        if (curr->isInterface())
+        {
+            // Interface types are only subtypes of 'Object' and their superinterfaces.
+            // Object is easy to identify as it is a normal class with no super class.
+            result = (otherComponent->isClass() && !otherComponent->getSuperClass())
+                     || llvm::is_contained(curr->getAllInterfaces(), otherComponent);
         }
-        return curr->wouldBeInstanceOf(other);
+        else
+        {
+            // If 'curr' is still an array, this correctly checks whether 'otherComponent' is 'Object' or one of the
+            // interfaces implemented by arrays.
+            result = curr->wouldBeInstanceOf(otherComponent);
+        }
+        if (result)
+        {
+            m_secondarySuperCache = other;
+        }
+        return result;
     }
 
-    if (other->isInterface())
+    // If T is an interface type, then S must implement interface T. If T is a class type, then S must be a subclass of
+    // T. Since T is not part of the primary super display, it must be a secondary super of S in both cases.
+    // For arrays, the secondary supers are the interfaces implemented by arrays.
+    if (!llvm::is_contained(m_secondarySupers, other))
     {
-        // If T is an interface type, then S must implement interface T.
-        return llvm::is_contained(getAllInterfaces(), other);
+        return false;
     }
-    // If T is a class type, then S must be a subclass of T.
-    return llvm::is_contained(getSuperClasses(), other);
+    m_secondarySuperCache = other;
+    return true;
 }
 
 namespace
@@ -30,7 +30,9 @@
 #include <jllvm/class/Descriptors.hpp>
 #include <jllvm/support/NonOwningFrozenSet.hpp>
 
+#include <array>
 #include <functional>
+#include <limits>
 
 #include "InteropHelpers.hpp"
 #include "Object.hpp"
@@ -47,6 +49,7 @@ enum class Visibility : std::uint8_t
 };
 
 class Method;
+class MethodProfile;
 
 /// Interpreter calling convention. The first parameter is the method that should be executed while the second
 /// parameter is the array of arguments where all values are bitcast to 'std::uint64_t'. Values of type 'long' or
@@ -61,6 +64,8 @@ class Method
     const ClassObject* m_classObject{};
     InterpreterCC* m_interpreterCCImplementation{};
     void* m_jitCCImplementation{};
+    // Profile gathered during execution of the method. This is purely a cache filled lazily by the interpreter.
+    mutable MethodProfile* m_profile{};
     std::uint32_t m_tableSlot;
     std::uint8_t m_hasTableSlot : 1;
     std::uint8_t m_isStatic : 1;
@@ -173,6 +178,18 @@ public:
         m_jitCCImplementation = jitCCImplementation;
     }
 
+    /// Returns the profile gathered during execution of this method or null if no profile exists.
+    MethodProfile* getProfile() const
+    {
+        return m_profile;
+    }
+
+    /// Sets the profile of this method. The profile is not owned by the method and must outlive it.
+    void setProfile(MethodProfile* profile) const
+    {
+        m_profile = profile;
+    }
+
     /// Calls this method using the interpreter calling convention. If the method is abstract, the behaviour is
     /// undefined.
     std::uint64_t callInterpreterCC(const std::uint64_t* arguments) const
@@ -444,6 +461,39 @@ public:
     }
 };
 
+/// Entry of the interface method table (IMT) of a class.
+///
+/// The IMT is a hash table with a power of two amount of entries mapping an interface method, identified by the ID of
+/// its interface and its I-Table slot, to the method selected by the class. It allows interface method selection to
+/// be performed in constant time. If several interface methods hash to the same entry, only the first one is
+/// contained in the IMT. Method selection of the remaining ones has to fall back to searching the ITables.
+struct IMTEntry
+{
+    /// Key of an empty entry.
+    constexpr static std::size_t emptyKey = std::numeric_limits<std::size_t>::max();
+
+    /// Key of the interface method, as returned by 'getKey'.
+    std::size_t key = emptyKey;
+    /// The method selected by the class.
+    const Method* method = nullptr;
+    /// The implementation of 'method' using the JIT calling convention.
+    VTableSlot code = nullptr;
+
+    /// Returns the key of the interface method in the slot 'slot' of the interface with the ID 'interfaceId'.
+    static std::size_t getKey(std::size_t interfaceId, std::uint16_t slot)
+    {
+        return interfaceId << std::numeric_limits<std::uint16_t>::digits | slot;
+    }
+
+    /// Returns the hash of 'key'. The index of the entry within an IMT is the hash modulo the size of the IMT.
+    static std::size_t hash(std::size_t key)
+    {
+        // Fibonacci hashing. Interface IDs and slots are small, dense integers that would otherwise only ever make use
+        // of the lower entries of an IMT.
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(key) * 0x9E3779B97F4A7C15ull) >> 32);
+    }
+};
+
 /// Initialization status of a class
 enum class InitializationStatus : std::uint8_t
 {
@@ -491,7 +541,20 @@ class ClassObject final : private llvm::TrailingObjects<ClassObject, VTableSlot>
     // followed by all direct superinterfaces. For interfaces, this is simply their direct superinterfaces.
     llvm::ArrayRef<ClassObject*> m_bases;
     llvm::ArrayRef<ITable*> m_iTables;
+    llvm::MutableArrayRef<IMTEntry> m_imt;
     llvm::ArrayRef<std::uint32_t> m_gcMask;
+    constexpr static std::size_t primarySuperDisplaySize = 8;
+    // Display of the superclasses of a class indexed by their depth in the class hierarchy, with 'java/lang/Object'
+    // having a depth of 0. Classes nested deeper than the size of the display are secondary supers instead.
+    std::array<const ClassObject*, primarySuperDisplaySize> m_primarySupers{};
+    // Interfaces and superclasses not contained in the primary super display.
+    llvm::ArrayRef<const ClassObject*> m_secondarySupers;
+    // The last class object found in 'm_secondarySupers' by 'wouldBeInstanceOf'. This is purely a cache.
+    mutable const ClassObject* m_secondarySuperCache = nullptr;
+    // Offset from the start of a class object to the member that is equal to this class object if the class object is
+    // a subtype of this class object. This is either within 'm_primarySupers' or 'm_secondarySuperCache'.
+    std::uint32_t m_superCheckOffset = getSecondarySuperCacheOffset();
+    std::uint32_t m_depth = 0;
     llvm::StringRef m_className;
     bool m_isPrimitive = false;
     InitializationStatus m_initialized = InitializationStatus::Uninitialized;
@@ -499,13 +562,18 @@ class ClassObject final : private llvm::TrailingObjects<ClassObject, VTableSlot>
 
     ClassObject(const ClassObject* metaClass, std::uint32_t vTableSlots, std::int32_t fieldAreaSize,
                 const NonOwningFrozenSet<Method>& methods, const NonOwningFrozenSet<Field>& fields,
-                llvm::ArrayRef<ClassObject*> bases, llvm::ArrayRef<ITable*> iTables, llvm::StringRef className,
-                const ClassFile& classFile, llvm::ArrayRef<std::uint32_t> gcMask);
+                llvm::ArrayRef<ClassObject*> bases, llvm::ArrayRef<ITable*> iTables,
+                llvm::MutableArrayRef<IMTEntry> imt, llvm::StringRef className, const ClassFile& classFile,
+                llvm::ArrayRef<std::uint32_t> gcMask);
 
     ClassObject(const ClassObject* metaClass, std::size_t interfaceId, const NonOwningFrozenSet<Method>& methods,
                 const NonOwningFrozenSet<Field>& fields, llvm::ArrayRef<ClassObject*> interfaces,
                 llvm::StringRef className, const ClassFile& m_classFile);
 
+    /// Initializes the primary super display and the secondary supers of a class object, allocating the latter in
+    /// 'allocator'. Must be called once all bases have been set.
+    void initializeSupers(llvm::BumpPtrAllocator& allocator);
+
     class SuperclassIterator
         : public llvm::iterator_facade_base<SuperclassIterator, std::forward_iterator_tag, const ClassObject*,
                                             std::ptrdiff_t, const ClassObject**, const ClassObject*>
@@ -816,8 +884,40 @@ public:
 
     /// Returns true if an instance of this class object would also be an instance of 'other'.
     /// Not valid for class objects representing interfaces.
+    ///
+    /// Most checks are performed in constant time by comparing the class object at 'getSuperCheckOffset' of 'other'
+    /// within this class object to 'other'. Only if 'other' is not a primary super (i.e. an interface, array or a
+    /// class nested too deeply in the class hierarchy) and the last secondary super found does not match, are the
+    /// secondary supers searched.
     bool wouldBeInstanceOf(const ClassObject* other) const;
 
+    /// Returns the depth of this class in the class hierarchy. 'java/lang/Object' has a depth of 0 and every other
+    /// class a depth one greater than its superclass. Interfaces, arrays and primitives have a depth of 0.
+    std::uint32_t getDepth() const
+    {
+        return m_depth;
+    }
+
+    /// Returns the offset from the start of a class object which contains this class object if the class object is a
+    /// subtype of this class object. Equal to 'getSecondarySuperCacheOffset' if this class object is not part of the
+    /// primary super display of its subtypes.
+    std::uint32_t getSuperCheckOffset() const
+    {
+        return m_superCheckOffset;
+    }
+
+    /// Byte offset from the start of the class object to the super check offset.
+    constexpr static std::size_t getSuperCheckOffsetOffset()
+    {
+        return offsetof(ClassObject, m_superCheckOffset);
+    }
+
+    /// Byte offset from the start of the class object to the cache of the last secondary super found.
+    constexpr static std::size_t getSecondarySuperCacheOffset()
+    {
+        return offsetof(ClassObject, m_secondarySuperCache);
+    }
+
     /// Byte offset from the start of the class object to the start of the VTable.
     constexpr static std::size_t getInitializedOffset()
     {
@@ -863,6 +963,28 @@ public:
         return offsetof(ClassObject, m_iTables);
     }
 
+    /// Returns the interface method table of this class. Empty for interfaces, abstract classes and classes not
+    /// implementing any interface methods.
+    llvm::MutableArrayRef<IMTEntry> getIMT()
+    {
+        return m_imt;
+    }
+
+    /// Byte offset from the start of the class object to the interface method table.
+    constexpr static std::size_t getIMTOffset()
+    {
+        return offsetof(ClassObject, m_imt);
+    }
+
+    /// Inserts the method 'selected' with the implementation 'code' as implementation of the interface method
+    /// 'interfaceMethod' into the IMT. Does nothing if the corresponding entry is already occupied by a different
+    /// interface method.
+    void insertIntoIMT(const Method& interfaceMethod, const Method& selected, VTableSlot code);
+
+    /// Performs method selection of 'resolvedMethod', which must be a method of an interface with an I-Table slot,
+    /// using the IMT. Falls back to 'methodSelection' if the interface method is not contained in the IMT.
+    const Method& interfaceMethodSelection(const Method& resolvedMethod) const;
+
     /// Returns the size of the I-Table if this class object represents an interface and the size of the V-Table
     /// otherwise.
     /// If the class is abstract, the v-table size does not reflect the actual size of the v-table of this class, as
@@ -0,0 +1,238 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/SmallVector.h>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+
+namespace jllvm
+{
+class ClassObject;
+
+/// Profiling data of a single method gathered while the method is being executed. The profile is filled by the
+/// interpreter and consumed by the JIT when compiling the method, e.g. to attach branch weights or to speculate on the
+/// type of receivers.
+/// All per-instruction data is keyed by the bytecode offset of the instruction.
+class MethodProfile
+{
+public:
+    /// Taken and not-taken counts of a conditional branch instruction.
+    struct BranchProfile
+    {
+        std::uint64_t taken{};
+        std::uint64_t notTaken{};
+    };
+
+    /// Histogram of the class objects of a value at a given instruction. Only the first 'Rows' distinct classes are
+    /// recorded with their count. Any further classes are only counted within 'getPolymorphicCount'.
+    class ReceiverTypeProfile
+    {
+    public:
+        constexpr static std::size_t Rows = 2;
+
+    private:
+        std::array<const ClassObject*, Rows> m_classes{};
+        std::array<std::uint64_t, Rows> m_counts{};
+        std::uint64_t m_polymorphicCount{};
+
+    public:
+        /// Records an occurrence of 'classObject'.
+        void record(const ClassObject* classObject)
+        {
+            for (std::size_t i = 0; i < Rows; i++)
+            {
+                if (m_classes[i] == classObject)
+                {
+                    m_counts[i]++;
+                    return;
+                }
+                if (!m_classes[i])
+                {
+                    m_classes[i] = classObject;
+                    m_counts[i] = 1;
+                    return;
+                }
+            }
+            m_polymorphicCount++;
+        }
+
+        /// Returns the class objects recorded together with their counts. Unused rows have a null class object.
+        auto getRows() const
+        {
+            return llvm::zip(m_classes, m_counts);
+        }
+
+        /// Returns the number of occurrences of classes that did not fit into any row.
+        std::uint64_t getPolymorphicCount() const
+        {
+            return m_polymorphicCount;
+        }
+
+        /// Returns the total amount of recorded occurrences.
+        std::uint64_t getTotalCount() const
+        {
+            std::uint64_t sum = m_polymorphicCount;
+            for (std::uint64_t count : m_counts)
+            {
+                sum += count;
+            }
+            return sum;
+        }
+
+        /// Returns the single class object that has ever been recorded or null if either no or more than one distinct
+        /// class has been recorded.
+        const ClassObject* getMonomorphicClass() const
+        {
+            if (m_polymorphicCount != 0 || m_classes[1])
+            {
+                return nullptr;
+            }
+            return m_classes[0];
+        }
+    };
+
+    /// Counts of how often each target of a switch instruction was taken.
+    struct SwitchProfile
+    {
+        std::uint64_t defaultCount{};
+        /// Counts of the switch cases in the order they appear in the instruction.
+        llvm::SmallVector<std::uint64_t> caseCounts;
+    };
+
+private:
+    std::uint64_t m_invocationCount{};
+    std::uint64_t m_backEdgeCount{};
+    std::uint64_t m_deoptimizationCount{};
+    llvm::DenseMap<std::uint32_t, BranchProfile> m_branches;
+    llvm::DenseMap<std::uint32_t, ReceiverTypeProfile> m_receiverTypes;
+    llvm::DenseMap<std::uint32_t, SwitchProfile> m_switches;
+    llvm::DenseMap<std::uint32_t, std::uint64_t> m_calls;
+
+    template <class Map>
+    static auto* lookup(const Map& map, std::uint16_t offset)
+    {
+        auto iter = map.find(offset);
+        return iter == map.end() ? nullptr : &iter->second;
+    }
+
+public:
+    /// Increments the number of times the method was invoked.
+    void incrementInvocationCount()
+    {
+        m_invocationCount++;
+    }
+
+    /// Returns the number of times the method was invoked.
+    std::uint64_t getInvocationCount() const
+    {
+        return m_invocationCount;
+    }
+
+    /// Increments the number of backedges taken within the method.
+    void incrementBackEdgeCount()
+    {
+        m_backEdgeCount++;
+    }
+
+    /// Returns the number of backedges taken within the method.
+    std::uint64_t getBackEdgeCount() const
+    {
+        return m_backEdgeCount;
+    }
+
+    /// Increments the number of times compiled code of the method deoptimized its frame.
+    void incrementDeoptimizationCount()
+    {
+        m_deoptimizationCount++;
+    }
+
+    /// Returns the number of times compiled code of the method deoptimized its frame.
+    std::uint64_t getDeoptimizationCount() const
+    {
+        return m_deoptimizationCount;
+    }
+
+    /// Records the outcome of the conditional branch at 'offset'.
+    void recordBranch(std::uint16_t offset, bool taken)
+    {
+        BranchProfile& profile = m_branches[offset];
+        if (taken)
+        {
+            profile.taken++;
+        }
+        else
+        {
+            profile.notTaken++;
+        }
+    }
+
+    /// Records 'classObject' as the class of the value being operated on at 'offset'. This is used for the receiver of
+    /// virtual and interface calls as well as the operand of 'checkcast' and 'instanceof'.
+    void recordReceiverType(std::uint16_t offset, const ClassObject* classObject)
+    {
+        m_receiverTypes[offset].record(classObject);
+    }
+
+    /// Records the switch instruction at 'offset' containing 'numCases' cases to have branched to the case at
+    /// 'caseIndex'. An empty 'caseIndex' denotes the default target.
+    void recordSwitch(std::uint16_t offset, std::optional<std::size_t> caseIndex, std::size_t numCases)
+    {
+        SwitchProfile& profile = m_switches[offset];
+        if (!caseIndex)
+        {
+            profile.defaultCount++;
+            return;
+        }
+        profile.caseCounts.resize(numCases);
+        profile.caseCounts[*caseIndex]++;
+    }
+
+    /// Increments the number of times the invoke instruction at 'offset' was executed.
+    void incrementCallCount(std::uint16_t offset)
+    {
+        m_calls[offset]++;
+    }
+
+    /// Returns the branch profile of the instruction at 'offset' or null if it was never executed.
+    const BranchProfile* getBranchProfile(std::uint16_t offset) const
+    {
+        return lookup(m_branches, offset);
+    }
+
+    /// Returns the receiver type profile of the instruction at 'offset' or null if it was never executed.
+    const ReceiverTypeProfile* getReceiverTypeProfile(std::uint16_t offset) const
+    {
+        return lookup(m_receiverTypes, offset);
+    }
+
+    /// Returns the switch profile of the instruction at 'offset' or null if it was never executed.
+    const SwitchProfile* getSwitchProfile(std::uint16_t offset) const
+    {
+        return lookup(m_switches, offset);
+    }
+
+    /// Returns the number of times the invoke instruction at 'offset' was executed.
+    std::uint64_t getCallCount(std::uint16_t offset) const
+    {
+        const std::uint64_t* count = lookup(m_calls, offset);
+        return count ? *count : 0;
+    }
+};
+
+} // namespace jllvm
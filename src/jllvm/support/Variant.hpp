@@ -45,4 +45,12 @@ constexpr decltype(auto) match(Variant&& variant, Matchers&&... matchers)
     }
     return visit(detail::Overload{std::forward<Matchers>(matchers)...}, std::forward<Variant>(variant));
 }
+
+/// Returns a callable object combining all 'matchers' into one overload set as is used by 'match'.
+/// This is useful when the same set of matchers is applied to many values, avoiding recreating the matchers each time.
+template <typename... Matchers>
+constexpr auto overload(Matchers&&... matchers)
+{
+    return detail::Overload{std::forward<Matchers>(matchers)...};
+}
 } // namespace jllvm
@@ -94,6 +94,16 @@ void jllvm::UnwindFrame::resumeExecutionAtFunctionImpl(std::uintptr_t functionPo
         nextFrame.setIntegerRegister(argRegisterNumbers[i], arguments[i]);
     }
 
+    resumeWithRegisterState(nextFrame, getProgramCounter());
+}
+
+void jllvm::UnwindFrame::resumeExecution() const
+{
+    resumeWithRegisterState(*this, getProgramCounter());
+}
+
+void jllvm::UnwindFrame::resumeWithRegisterState(const UnwindFrame& target, std::uintptr_t stopPc)
+{
     // Exception object for the force unwind of the C++ stack.
     struct ForcedException : _Unwind_Exception
     {
@@ -112,11 +122,11 @@ void jllvm::UnwindFrame::resumeExecutionAtFunctionImpl(std::uintptr_t functionPo
     // Exception object for the force unwind must not be a local as the stack unwinding destroys all local variables.
     thread_local static std::optional<ForcedException> forcedExceptionStorage;
     forcedExceptionStorage.emplace(
-        nextFrame, +[](_Unwind_Reason_Code, _Unwind_Exception*) { forcedExceptionStorage.reset(); });
+        target, +[](_Unwind_Reason_Code, _Unwind_Exception*) { forcedExceptionStorage.reset(); });
 
-    // Unwind the C++ stack until the Java frame that should be replaced is reached. The program counter of that frame
-    // is passed as 'stopPc' and always compared with the current frame being unwound by the '_Unwind_ForcedUnwind'
-    // implementation.
+    // Unwind the C++ stack until the Java frame that should be replaced or resumed is reached. The program counter of
+    // that frame is passed as 'stopPc' and always compared with the current frame being unwound by the
+    // '_Unwind_ForcedUnwind' implementation.
     _Unwind_ForcedUnwind(
         &*forcedExceptionStorage,
         +[](int, _Unwind_Action, std::uint64_t, _Unwind_Exception* exception, _Unwind_Context* context, void* stopPc)
@@ -128,8 +138,8 @@ void jllvm::UnwindFrame::resumeExecutionAtFunctionImpl(std::uintptr_t functionPo
                 return _URC_NO_REASON;
             }
 
-            // Reached the Java frame to replace. Get the internal cursor that all modifications have been performed on
-            // so far and apply them.
+            // Reached the Java frame to replace or resume. Get the internal cursor that all modifications have been
+            // performed on so far and apply them.
             auto* forcedException = static_cast<ForcedException*>(exception);
             jllvm_unw_cursor_t cursor = forcedException->frame.m_cursor;
             // Make sure to now erase the heap allocated exception object.
@@ -138,7 +148,7 @@ void jllvm::UnwindFrame::resumeExecutionAtFunctionImpl(std::uintptr_t functionPo
 
             llvm_unreachable("resume should not have returned");
         },
-        reinterpret_cast<void*>(getProgramCounter()));
+        reinterpret_cast<void*>(stopPc));
 
     llvm_unreachable("_Unwind_ForcedUnwind should not have returned");
 }
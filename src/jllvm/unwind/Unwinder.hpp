@@ -56,6 +56,10 @@ class UnwindFrame
     [[noreturn]] void resumeExecutionAtFunctionImpl(std::uintptr_t functionPointer,
                                                     llvm::ArrayRef<std::uint64_t> arguments) const;
 
+    /// Unwinds the C++ stack up to the frame with the program counter 'stopPc' and then continues execution with the
+    /// register state of 'target'.
+    [[noreturn]] static void resumeWithRegisterState(const UnwindFrame& target, std::uintptr_t stopPc);
+
 public:
 
     /// Returns the current program counter in this frame.
@@ -106,6 +110,11 @@ public:
         std::array<std::uint64_t, sizeof...(args)> array{llvm::bit_cast<std::uint64_t>(args)...};
         resumeExecutionAtFunctionImpl(reinterpret_cast<std::uintptr_t>(fnPtr), array);
     }
+
+    /// Continues execution in this frame at its program counter as if all its direct or indirect callees returned.
+    /// This first performs C++ stack unwinding to run any destructors in all callee frames. Caller-saved registers,
+    /// including any return value registers, have unspecified values once execution continues.
+    [[noreturn]] void resumeExecution() const;
 };
 
 /// Class representing a specific location of a value interpreted as type 'T' within a 'UnwindFrame'.
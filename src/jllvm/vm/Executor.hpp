@@ -39,6 +39,23 @@ public:
     /// Returns true if the executor is capable of executing 'method'.
     virtual bool canExecute(const Method& method) const = 0;
 
+    /// Returns true if the executor can execute 'method' without having to compile it first. The runtime uses such an
+    /// executor rather than the default executor when first executing 'method'.
+    /// This method assumes that 'canExecute' returned true for 'method'.
+    virtual bool hasPrecompiledCode(const Method&) const
+    {
+        return false;
+    }
+
+    /// Discards any code compiled for 'method' such that the next lookup of 'method' in 'getJITCCDylib' compiles it
+    /// anew. Code that is currently executing remains valid. Returns false if no code was discarded.
+    /// Code that is still being compiled cannot be discarded. The dylibs it is being compiled for are added to
+    /// 'compiling' instead, allowing the caller to discard it once it has been installed.
+    virtual bool discardCompiledCode(const Method&, llvm::SmallVectorImpl<llvm::orc::JITDylib*>& /*compiling*/)
+    {
+        return false;
+    }
+
     /// Returns the dylib used for lookups when calling a given method with the JIT Calling Convention.
     /// All registered methods must be contained with the "direct-method-call" mangling.
     virtual llvm::orc::JITDylib& getJITCCDylib() = 0;
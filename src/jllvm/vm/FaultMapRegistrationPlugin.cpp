@@ -0,0 +1,275 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#include "FaultMapRegistrationPlugin.hpp"
+
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Object/FaultMapParser.h>
+#include <llvm/Support/Debug.h>
+
+#include <atomic>
+#include <memory>
+
+#if JLLVM_IMPLICIT_NULL_CHECKS
+    #include <csignal>
+    #include <ucontext.h>
+#endif
+
+#define DEBUG_TYPE "jvm"
+
+namespace
+{
+/// Mapping of the address of faulting instructions to the address execution should continue at, sorted by the former.
+using FaultingPCTable = std::vector<std::pair<std::uintptr_t, std::uintptr_t>>;
+
+/// Table used by the signal handler. This has to be global as the signal handler has no other way of accessing it.
+/// Published tables are never modified. Writers instead replace the table with a modified copy, making lookups within
+/// the signal handler lock-free and therefore async-signal-safe.
+std::atomic<const FaultingPCTable*> faultingPCs = new FaultingPCTable;
+/// Number of signal handlers currently reading a table. Replaced tables are only deleted while no reader is active.
+std::atomic<std::size_t> activeReaders = 0;
+/// Serializes writers of 'faultingPCs'. Never taken within the signal handler.
+std::mutex faultingPCsWriteMutex;
+/// Replaced tables that may still be read by a signal handler.
+std::vector<std::unique_ptr<const FaultingPCTable>> retiredTables;
+
+/// Replaces the table used by the signal handler with a copy modified by 'modify'.
+template <class F>
+void modifyFaultingPCs(F&& modify)
+{
+    std::scoped_lock lock(faultingPCsWriteMutex);
+    auto table = std::make_unique<FaultingPCTable>(*faultingPCs.load());
+    modify(*table);
+    llvm::sort(*table, llvm::less_first{});
+    retiredTables.emplace_back(faultingPCs.exchange(table.release()));
+
+    // A reader incrementing 'activeReaders' after it was read here is guaranteed to load the new table, making it safe
+    // to delete all previously replaced tables.
+    if (activeReaders.load() == 0)
+    {
+        retiredTables.clear();
+    }
+}
+
+#if JLLVM_IMPLICIT_NULL_CHECKS
+
+/// Signal action that was installed prior to ours. Signals not caused by implicit null checks are forwarded to it.
+struct sigaction previousAction;
+
+/// Returns the address execution should continue at if the instruction at 'pc' faults or 0 if 'pc' is not an implicit
+/// null check. Safe to call within a signal handler.
+std::uintptr_t lookupFaultingPC(std::uintptr_t pc)
+{
+    activeReaders.fetch_add(1);
+    const FaultingPCTable& table = *faultingPCs.load();
+    auto iter = llvm::lower_bound(table, pc,
+                                  [](const auto& entry, std::uintptr_t value) { return entry.first < value; });
+    std::uintptr_t handler = iter != table.end() && iter->first == pc ? iter->second : 0;
+    activeReaders.fetch_sub(1);
+    return handler;
+}
+
+std::uintptr_t getProgramCounter(const ucontext_t& context)
+{
+    #if defined(__linux__) && defined(__x86_64__)
+    return context.uc_mcontext.gregs[REG_RIP];
+    #elif defined(__linux__) && defined(__aarch64__)
+    return context.uc_mcontext.pc;
+    #elif defined(__APPLE__) && defined(__x86_64__)
+    return context.uc_mcontext->__ss.__rip;
+    #elif defined(__APPLE__) && defined(__aarch64__)
+    return __darwin_arm_thread_state64_get_pc(context.uc_mcontext->__ss);
+    #endif
+}
+
+void setProgramCounter(ucontext_t& context, std::uintptr_t pc)
+{
+    #if defined(__linux__) && defined(__x86_64__)
+    context.uc_mcontext.gregs[REG_RIP] = pc;
+    #elif defined(__linux__) && defined(__aarch64__)
+    context.uc_mcontext.pc = pc;
+    #elif defined(__APPLE__) && defined(__x86_64__)
+    context.uc_mcontext->__ss.__rip = pc;
+    #elif defined(__APPLE__) && defined(__aarch64__)
+    __darwin_arm_thread_state64_set_pc_fptr(context.uc_mcontext->__ss, reinterpret_cast<void*>(pc));
+    #endif
+}
+
+void handleSegmentationFault(int signal, siginfo_t* info, void* context)
+{
+    auto& ucontext = *reinterpret_cast<ucontext_t*>(context);
+    if (std::uintptr_t handler = lookupFaultingPC(getProgramCounter(ucontext)))
+    {
+        // Continue execution in the block that throws the 'NullPointerException', exactly as if the explicit null
+        // check had failed.
+        setProgramCounter(ucontext, handler);
+        return;
+    }
+
+    if (previousAction.sa_flags & SA_SIGINFO)
+    {
+        previousAction.sa_sigaction(signal, info, context);
+        return;
+    }
+    if (previousAction.sa_handler == SIG_DFL || previousAction.sa_handler == SIG_IGN)
+    {
+        // Returning re-executes the faulting instruction, which now leads to the default action of crashing the
+        // process.
+        std::signal(signal, SIG_DFL);
+        return;
+    }
+    previousAction.sa_handler(signal);
+}
+
+void installSignalHandler()
+{
+    static std::once_flag flag;
+    std::call_once(flag,
+                   []
+                   {
+                       struct sigaction action = {};
+                       action.sa_sigaction = handleSegmentationFault;
+                       action.sa_flags = SA_SIGINFO | SA_NODEFER;
+                       sigemptyset(&action.sa_mask);
+                       sigaction(SIGSEGV, &action, &previousAction);
+                   });
+}
+
+#endif
+
+} // namespace
+
+jllvm::FaultMapRegistrationPlugin::FaultMapRegistrationPlugin()
+{
+    m_faultMapSection = ".llvm_faultmaps";
+    if (llvm::Triple(LLVM_HOST_TRIPLE).isOSBinFormatMachO())
+    {
+        m_faultMapSection = "__LLVM_FAULTMAPS,__llvm_faultmaps";
+    }
+
+#if JLLVM_IMPLICIT_NULL_CHECKS
+    installSignalHandler();
+#endif
+}
+
+llvm::Error jllvm::FaultMapRegistrationPlugin::notifyFailed(llvm::orc::MaterializationResponsibility&)
+{
+    return llvm::Error::success();
+}
+
+llvm::Error jllvm::FaultMapRegistrationPlugin::notifyRemovingResources(llvm::orc::JITDylib&,
+                                                                       llvm::orc::ResourceKey resourceKey)
+{
+    std::vector<std::uintptr_t> addresses;
+    {
+        std::scoped_lock lock(m_mutex);
+        auto iter = m_needsCleanup.find(resourceKey);
+        if (iter == m_needsCleanup.end())
+        {
+            return llvm::Error::success();
+        }
+        addresses = std::move(iter->second);
+        m_needsCleanup.erase(iter);
+    }
+
+    llvm::DenseSet<std::uintptr_t> removed(addresses.begin(), addresses.end());
+    modifyFaultingPCs([&](FaultingPCTable& table)
+                      { llvm::erase_if(table, [&](const auto& entry) { return removed.contains(entry.first); }); });
+    return llvm::Error::success();
+}
+
+void jllvm::FaultMapRegistrationPlugin::notifyTransferringResources(llvm::orc::JITDylib&,
+                                                                    llvm::orc::ResourceKey dstKey,
+                                                                    llvm::orc::ResourceKey srcKey)
+{
+    std::scoped_lock lock(m_mutex);
+    auto iter = m_needsCleanup.find(srcKey);
+    if (iter == m_needsCleanup.end())
+    {
+        return;
+    }
+    std::vector<std::uintptr_t> addresses = std::move(iter->second);
+    m_needsCleanup.erase(iter);
+    llvm::append_range(m_needsCleanup[dstKey], addresses);
+}
+
+void jllvm::FaultMapRegistrationPlugin::modifyPassConfig(llvm::orc::MaterializationResponsibility& mr,
+                                                         llvm::jitlink::LinkGraph&,
+                                                         llvm::jitlink::PassConfiguration& config)
+{
+    llvm::orc::ResourceKey resourceKey;
+    llvm::cantFail(mr.withResourceKeyDo([&](llvm::orc::ResourceKey key) { resourceKey = key; }));
+
+    // Nothing references the fault map. Prevent it from being garbage collected by marking it as alive prior to
+    // pruning.
+    config.PrePrunePasses.emplace_back(
+        [&](llvm::jitlink::LinkGraph& g)
+        {
+            llvm::jitlink::Section* section = g.findSectionByName(m_faultMapSection);
+            if (!section)
+            {
+                return llvm::Error::success();
+            }
+            for (llvm::jitlink::Symbol* symbol : section->symbols())
+            {
+                symbol->setLive(true);
+            }
+            return llvm::Error::success();
+        });
+
+    // The function addresses within the fault map are only valid after all relocations have been applied.
+    config.PostFixupPasses.emplace_back(
+        [&, resourceKey](llvm::jitlink::LinkGraph& g)
+        {
+            llvm::jitlink::Section* section = g.findSectionByName(m_faultMapSection);
+            if (!section)
+            {
+                return llvm::Error::success();
+            }
+            auto range = llvm::jitlink::SectionRange(*section);
+            auto* start = range.getStart().toPtr<std::uint8_t*>();
+
+            llvm::FaultMapParser parser(start, start + range.getSize());
+            if (parser.getNumFunctions() == 0)
+            {
+                return llvm::Error::success();
+            }
+
+            std::vector<std::uintptr_t> addresses;
+            FaultingPCTable added;
+            llvm::FaultMapParser::FunctionInfoAccessor function = parser.getFirstFunctionInfo();
+            for (std::uint32_t i = 0; i < parser.getNumFunctions(); i++)
+            {
+                if (i != 0)
+                {
+                    function = function.getNextFunctionInfo();
+                }
+                std::uintptr_t functionAddress = function.getFunctionAddr();
+                for (std::uint32_t j = 0; j < function.getNumFaultingPCs(); j++)
+                {
+                    llvm::FaultMapParser::FunctionFaultInfoAccessor faultInfo = function.getFunctionFaultInfoAt(j);
+                    std::uintptr_t faultingPC = functionAddress + faultInfo.getFaultingPCOffset();
+                    added.emplace_back(faultingPC, functionAddress + faultInfo.getHandlerPCOffset());
+                    addresses.push_back(faultingPC);
+                }
+            }
+            modifyFaultingPCs([&](FaultingPCTable& table) { llvm::append_range(table, added); });
+
+            LLVM_DEBUG({ llvm::dbgs() << "Registered " << addresses.size() << " implicit null checks\n"; });
+
+            std::scoped_lock lock(m_mutex);
+            llvm::append_range(m_needsCleanup[resourceKey], addresses);
+            return llvm::Error::success();
+        });
+}
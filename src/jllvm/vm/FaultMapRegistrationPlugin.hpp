@@ -0,0 +1,59 @@
+// Copyright (C) 2023 The JLLVM Contributors.
+//
+// This file is part of JLLVM.
+//
+// JLLVM is free software; you can redistribute it and/or modify it under  the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 3, or (at your option) any later version.
+//
+// JLLVM is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+// of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
+// see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Implicit null checks require a signal handler capable of changing the program counter of the faulting thread.
+#if (defined(__linux__) || defined(__APPLE__)) && (defined(__x86_64__) || defined(__aarch64__))
+    #define JLLVM_IMPLICIT_NULL_CHECKS 1
+#else
+    #define JLLVM_IMPLICIT_NULL_CHECKS 0
+#endif
+
+namespace jllvm
+{
+/// JIT link plugin for extracting the LLVM generated fault map section out of materialized objects.
+///
+/// The fault map contains every load and store that LLVM's implicit null check pass used in place of an explicit null
+/// check, together with the address of the block that would have been executed if the explicit null check failed.
+/// The plugin registers these in a process wide table used by a SIGSEGV handler, which redirects execution of a
+/// faulting thread to the corresponding handler block. The handler block throws the 'NullPointerException'.
+class FaultMapRegistrationPlugin : public llvm::orc::ObjectLinkingLayer::Plugin
+{
+    llvm::StringRef m_faultMapSection;
+    std::mutex m_mutex;
+    /// Faulting instruction addresses registered for each resource key. Deregistered once the resource is removed.
+    llvm::DenseMap<llvm::orc::ResourceKey, std::vector<std::uintptr_t>> m_needsCleanup;
+
+public:
+    /// Creates the plugin and installs the SIGSEGV handler if not yet installed.
+    FaultMapRegistrationPlugin();
+
+    llvm::Error notifyFailed(llvm::orc::MaterializationResponsibility&) override;
+
+    llvm::Error notifyRemovingResources(llvm::orc::JITDylib&, llvm::orc::ResourceKey resourceKey) override;
+
+    void notifyTransferringResources(llvm::orc::JITDylib&, llvm::orc::ResourceKey dstKey,
+                                     llvm::orc::ResourceKey srcKey) override;
+
+    void modifyPassConfig(llvm::orc::MaterializationResponsibility& mr, llvm::jitlink::LinkGraph&,
+                          llvm::jitlink::PassConfiguration& config) override;
+};
+} // namespace jllvm
@@ -14,12 +14,50 @@
 #include "Interpreter.hpp"
 
 #include <jllvm/class/ByteCodeIterator.hpp>
+#include <jllvm/compiler/CodeGeneratorUtils.hpp>
+
+#include <llvm/ADT/ScopeExit.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
 
 #include "VirtualMachine.hpp"
 
-jllvm::Interpreter::Interpreter(VirtualMachine& virtualMachine, std::uint64_t backEdgeThreshold)
+namespace
+{
+/// Initializes the local variables of a frame of 'method' from the arguments of the call.
+void initLocals(const jllvm::Method& method, const std::uint64_t* arguments, std::uint64_t* locals)
+{
+    std::size_t argumentIndex = 0;
+    if (!method.isStatic())
+    {
+        locals[argumentIndex] = arguments[argumentIndex];
+        argumentIndex++;
+    }
+
+    for (jllvm::FieldType fieldType : method.getType().parameters())
+    {
+        locals[argumentIndex] = arguments[argumentIndex];
+        argumentIndex++;
+        if (fieldType.isWide())
+        {
+            argumentIndex++;
+        }
+    }
+}
+} // namespace
+
+jllvm::Interpreter::Interpreter(VirtualMachine& virtualMachine, std::uint64_t backEdgeThreshold,
+                                std::uint64_t invocationThreshold, bool profilingEnabled, bool zeroFrames,
+                                bool dumpByteCodePairs, llvm::StringRef byteCodePairHistogram, bool stacklessCalls)
     : m_virtualMachine(virtualMachine),
       m_backEdgeThreshold(backEdgeThreshold),
+      m_invocationThreshold(invocationThreshold),
+      m_profilingEnabled(profilingEnabled),
+      m_zeroFrames(zeroFrames),
+      m_stacklessCalls(stacklessCalls),
+      m_byteCodePairCounts(dumpByteCodePairs ? std::make_unique<decltype(m_byteCodePairCounts)::element_type>() :
+                                               nullptr),
       m_jit2InterpreterSymbols(
           m_virtualMachine.getRuntime().getJITCCDylib().getExecutionSession().createBareJITDylib("<jit2interpreter>")),
       m_interpreterCCSymbols(m_jit2InterpreterSymbols.getExecutionSession().createBareJITDylib("<interpreterSymbols>")),
@@ -27,6 +65,23 @@ jllvm::Interpreter::Interpreter(VirtualMachine& virtualMachine, std::uint64_t ba
                                   virtualMachine.getRuntime().getLLVMIRLayer(),
                                   virtualMachine.getRuntime().getDataLayout())
 {
+    m_selectedSuperInstructions.set();
+    if (!byteCodePairHistogram.empty())
+    {
+        llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> buffer = llvm::MemoryBuffer::getFile(byteCodePairHistogram);
+        if (!buffer)
+        {
+            llvm::report_fatal_error(llvm::createFileError(byteCodePairHistogram, buffer.getError()));
+        }
+        llvm::Expected<std::bitset<QuickenedInstruction::NumSuperInstructions>> selected =
+            selectSuperInstructions((*buffer)->getBuffer());
+        if (!selected)
+        {
+            llvm::report_fatal_error(llvm::createFileError(byteCodePairHistogram, selected.takeError()));
+        }
+        m_selectedSuperInstructions = *selected;
+    }
+
     m_interpreterCCSymbols.addToLinkOrder(virtualMachine.getRuntime().getCLibDylib());
     m_jit2InterpreterSymbols.addToLinkOrder(m_interpreterCCSymbols);
     m_jit2InterpreterSymbols.addToLinkOrder(virtualMachine.getRuntime().getClassAndMethodObjectsDylib());
@@ -36,12 +91,11 @@ jllvm::Interpreter::Interpreter(VirtualMachine& virtualMachine, std::uint64_t ba
         m_interpreterCCSymbols,
         std::pair{"jllvm_interpreter",
                   [&](const Method* method, std::uint16_t* byteCodeOffset, std::uint16_t* topOfStack,
-                      std::uint64_t* operandStack, std::uint64_t* operandGCMask, std::uint64_t* localVariables,
-                      std::uint64_t* localVariablesGCMask)
+                      std::uint64_t* operandStack, std::uint64_t* /*operandGCMask*/, std::uint64_t* localVariables,
+                      std::uint64_t* /*localVariablesGCMask*/, StacklessFrame** stacklessFrames)
                   {
-                      InterpreterContext context(*topOfStack, operandStack, operandGCMask, localVariables,
-                                                 localVariablesGCMask);
-                      return executeMethod(*method, *byteCodeOffset, context);
+                      InterpreterContext context(*topOfStack, operandStack, localVariables);
+                      return executeMethod(*method, *byteCodeOffset, context, *stacklessFrames);
                   }},
         std::pair{"jllvm_interpreter_frame_sizes",
                   [](const Method* method, std::uint16_t* numLocals, std::uint16_t* numOperands)
@@ -52,30 +106,8 @@ jllvm::Interpreter::Interpreter(VirtualMachine& virtualMachine, std::uint64_t ba
                   }},
         std::pair{
             "jllvm_interpreter_init_locals",
-            [](const Method* method, const std::uint64_t* arguments, std::uint64_t* locals, std::uint64_t* localsGCMask)
-            {
-                std::size_t argumentIndex = 0;
-                if (!method->isStatic())
-                {
-                    locals[argumentIndex] = arguments[argumentIndex];
-                    MutableBitArrayRef<>(localsGCMask, argumentIndex + 1)[argumentIndex] = true;
-                    argumentIndex++;
-                }
-
-                for (FieldType fieldType : method->getType().parameters())
-                {
-                    locals[argumentIndex] = arguments[argumentIndex];
-                    if (fieldType.isReference())
-                    {
-                        MutableBitArrayRef<>(localsGCMask, argumentIndex + 1)[argumentIndex] = true;
-                    }
-                    argumentIndex++;
-                    if (fieldType.isWide())
-                    {
-                        argumentIndex++;
-                    }
-                }
-            }},
+            [](const Method* method, const std::uint64_t* arguments, std::uint64_t* locals)
+            { initLocals(*method, arguments, locals); }},
         std::pair{"jllvm_osr_frame_delete", [](const std::uint64_t* osrFrame) { delete[] osrFrame; }});
 
     generateInterpreterEntry();
@@ -89,6 +121,14 @@ jllvm::Interpreter::Interpreter(VirtualMachine& virtualMachine, std::uint64_t ba
     }
 }
 
+jllvm::Interpreter::~Interpreter()
+{
+    if (m_byteCodePairCounts)
+    {
+        dumpByteCodePairHistogram(llvm::errs());
+    }
+}
+
 namespace
 {
 llvm::Value* divideCeil(llvm::IRBuilder<>& builder, llvm::Value* value, llvm::Value* rhs)
@@ -167,37 +207,46 @@ void jllvm::Interpreter::generateInterpreterEntry()
     builder.CreateMemSet(byteCodeOffset, builder.getInt8(0), sizeof(std::uint16_t), std::nullopt);
     builder.CreateMemSet(topOfStack, builder.getInt8(0), sizeof(std::uint16_t), std::nullopt);
 
-    // These three technically do not have to be zeroed, but we do so anyway for ease of debugging and security.
-    // Can be changed in the future for performance.
-    builder.CreateMemSet(operandStack, builder.getInt8(0),
-                         builder.CreateMul(numOperands, builder.getInt32(sizeof(std::uint64_t))), std::nullopt);
+    // The GC masks are always zeroed to never expose stale bits to a reader of the frame. They are small, being only a
+    // 64th of the size of the operand stack and local variables.
     builder.CreateMemSet(operandGCMask, builder.getInt8(0),
                          builder.CreateMul(operandGCMask->getArraySize(), builder.getInt32(sizeof(std::uint64_t))),
                          std::nullopt);
-    builder.CreateMemSet(localVariables, builder.getInt8(0),
-                         builder.CreateMul(numLocals, builder.getInt32(sizeof(std::uint64_t))), std::nullopt);
-
     builder.CreateMemSet(
         localVariablesGCMask, builder.getInt8(0),
         builder.CreateMul(localVariablesGCMask->getArraySize(), builder.getInt32(sizeof(std::uint64_t))), std::nullopt);
 
+    // The operand stack and local variables do not have to be zeroed as only slots that were previously written to
+    // are ever read, including by the GC. Zeroing them is optional for ease of debugging.
+    if (m_zeroFrames)
+    {
+        builder.CreateMemSet(operandStack, builder.getInt8(0),
+                             builder.CreateMul(numOperands, builder.getInt32(sizeof(std::uint64_t))), std::nullopt);
+        builder.CreateMemSet(localVariables, builder.getInt8(0),
+                             builder.CreateMul(numLocals, builder.getInt32(sizeof(std::uint64_t))), std::nullopt);
+    }
+
     // Initialize the local variables from the argument array.
     builder.CreateCall(module->getOrInsertFunction(
                            "jllvm_interpreter_init_locals",
                            llvm::FunctionType::get(builder.getVoidTy(),
                                                    {methodRef->getType(), callerArguments->getType(),
-                                                    localVariables->getType(), localVariablesGCMask->getType()},
+                                                    localVariables->getType()},
                                                    /*isVarArg=*/false)),
-                       {methodRef, callerArguments, localVariables, localVariablesGCMask});
+                       {methodRef, callerArguments, localVariables});
 
-    std::array<llvm::Value*, 7> arguments = {methodRef,     byteCodeOffset, topOfStack,          operandStack,
-                                             operandGCMask, localVariables, localVariablesGCMask};
-    std::array<llvm::Type*, 7> types{};
+    // Head of the chain of stackless frames executed by the interpreter within this frame.
+    llvm::AllocaInst* stacklessFrames = builder.CreateAlloca(builder.getPtrTy());
+    builder.CreateStore(llvm::ConstantPointerNull::get(builder.getPtrTy()), stacklessFrames);
+
+    std::array<llvm::Value*, 8> arguments = {methodRef,     byteCodeOffset, topOfStack,           operandStack,
+                                             operandGCMask, localVariables, localVariablesGCMask, stacklessFrames};
+    std::array<llvm::Type*, 8> types{};
     llvm::transform(arguments, types.begin(), std::mem_fn(&llvm::Value::getType));
 
     // Deopt all values used as context during interpretation. This makes it possible for the unwinder to read the
-    // method, local variables, the operand stack, the bytecode offset and where GC pointers are contained during
-    // unwinding.
+    // method, local variables, the operand stack, the bytecode offset, where GC pointers are contained and any
+    // stackless frames during unwinding.
     llvm::CallInst* callInst = builder.CreateCall(
         module->getOrInsertFunction("jllvm_interpreter",
                                     llvm::FunctionType::get(builder.getInt64Ty(), types, /*isVarArg=*/false)),
@@ -290,20 +339,26 @@ void* jllvm::Interpreter::generateOSREntry(FieldType returnType, CallingConventi
     builder.CreateMemCpy(operandGCMask, /*DstAlign=*/std::nullopt, currOsrState, /*SrcAlign=*/std::nullopt,
                          builder.CreateMul(operandGCMask->getArraySize(), builder.getInt32(sizeof(std::uint64_t))));
 
+    // Head of the chain of stackless frames executed by the interpreter within this frame. These are the frames of
+    // methods that were inlined into the JITted code being replaced, if any.
+    currOsrState = builder.CreateGEP(builder.getInt64Ty(), currOsrState, operandGCMask->getArraySize());
+    llvm::AllocaInst* stacklessFrames = builder.CreateAlloca(builder.getPtrTy());
+    builder.CreateStore(builder.CreateLoad(builder.getPtrTy(), currOsrState), stacklessFrames);
+
     // The OSR frame is responsible for deleting its input arrays as the frame that originally allocated the
     // pointer is replaced.
     llvm::FunctionCallee callee =
         function->getParent()->getOrInsertFunction("jllvm_osr_frame_delete", builder.getVoidTy(), builder.getPtrTy());
     builder.CreateCall(callee, function->getArg(0));
 
-    std::array<llvm::Value*, 7> arguments = {methodRef,     byteCodeOffset, topOfStack,          operandStack,
-                                             operandGCMask, localVariables, localVariablesGCMask};
-    std::array<llvm::Type*, 7> types{};
+    std::array<llvm::Value*, 8> arguments = {methodRef,     byteCodeOffset, topOfStack,           operandStack,
+                                             operandGCMask, localVariables, localVariablesGCMask, stacklessFrames};
+    std::array<llvm::Type*, 8> types{};
     llvm::transform(arguments, types.begin(), std::mem_fn(&llvm::Value::getType));
 
     // Deopt all values used as context during interpretation. This makes it possible for the unwinder to read the
-    // method, local variables, the operand stack, the bytecode offset and where GC pointers are contained during
-    // unwinding.
+    // method, local variables, the operand stack, the bytecode offset, where GC pointers are contained and any
+    // stackless frames during unwinding.
     llvm::CallInst* callInst = builder.CreateCall(
         module->getOrInsertFunction("jllvm_interpreter",
                                     llvm::FunctionType::get(builder.getInt64Ty(), types, /*isVarArg=*/false)),
@@ -382,13 +437,146 @@ void jllvm::Interpreter::escapeToJIT()
     m_virtualMachine.unwindJavaStack(
         [&](JavaFrame frame)
         {
-            m_virtualMachine.getRuntime().doOnStackReplacement(
-                frame,
-                m_virtualMachine.getJIT().createOSRStateFromInterpreterFrame(llvm::cast<InterpreterFrame>(frame)));
+            auto interpreterFrame = llvm::cast<InterpreterFrame>(frame);
+            OSRState state = m_virtualMachine.getJIT().createOSRStateFromInterpreterFrame(interpreterFrame);
+            if (!interpreterFrame.isStackless())
+            {
+                m_virtualMachine.getRuntime().doOnStackReplacement(frame, std::move(state));
+            }
+
+            // Stackless frames do not have a native frame of their own that could be replaced. The 'executeMethod'
+            // activation executing the frame calls the OSR version instead.
+            m_stacklessOSRState = std::move(state);
+            throw StacklessTransfer{.kind = StacklessTransfer::OnStackReplacement,
+                                    .activation = interpreterFrame.getStacklessFrameChain(),
+                                    .target = interpreterFrame.getStacklessFrame()};
         });
     llvm_unreachable("not possible");
 }
 
+void jllvm::Interpreter::resumeAtExceptionHandler(InterpreterFrame frame, std::uint16_t handlerOffset,
+                                                  Throwable* throwable)
+{
+    assert((frame.isStackless() || *frame.getStacklessFrameChain())
+           && "frame must be executed by an activation with stackless frames");
+    throw StacklessTransfer{.kind = StacklessTransfer::ExceptionHandler,
+                            .activation = frame.getStacklessFrameChain(),
+                            .target = frame.getStacklessFrame(),
+                            .handlerOffset = handlerOffset,
+                            .throwable = throwable};
+}
+
+std::uint64_t* jllvm::StacklessFrameStack::allocate(std::size_t words)
+{
+    if (m_chunks.empty() || m_used + words > m_chunks[m_currentChunk].size)
+    {
+        // All chunks after the current one are unused and can be reused unless they are too small.
+        if (!m_chunks.empty())
+        {
+            m_currentChunk++;
+        }
+        m_used = 0;
+        std::size_t size = std::max(ChunkSize, words);
+        if (m_currentChunk == m_chunks.size())
+        {
+            m_chunks.push_back({std::make_unique<std::uint64_t[]>(size), size});
+        }
+        else if (m_chunks[m_currentChunk].size < words)
+        {
+            m_chunks[m_currentChunk] = {std::make_unique<std::uint64_t[]>(size), size};
+        }
+    }
+
+    std::uint64_t* result = m_chunks[m_currentChunk].memory.get() + m_used;
+    m_used += words;
+    return result;
+}
+
+namespace
+{
+// The record of a stackless frame is followed by the local variables, the operand stack and their GC masks.
+template <class Record>
+constexpr std::size_t recordWords = (sizeof(Record) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+} // namespace
+
+std::size_t jllvm::Interpreter::getStacklessFrameWords(const Method& method)
+{
+    Code* code = method.getMethodInfo().getAttributes().find<Code>();
+    std::uint16_t numLocals = code->getMaxLocals();
+    std::uint16_t numOperands = code->getMaxStack();
+    return recordWords<StacklessRecord> + numLocals + numOperands + llvm::divideCeil(numLocals, 64)
+           + llvm::divideCeil(numOperands, 64);
+}
+
+jllvm::Interpreter::StacklessRecord* jllvm::Interpreter::constructStacklessRecord(std::uint64_t* memory,
+                                                                                  const Method& method)
+{
+    static_assert(alignof(StacklessRecord) <= alignof(std::uint64_t));
+
+    Code* code = method.getMethodInfo().getAttributes().find<Code>();
+    std::uint16_t numLocals = code->getMaxLocals();
+    std::uint16_t numOperands = code->getMaxStack();
+
+    auto* record = new (memory) StacklessRecord;
+    record->method = &method;
+    record->byteCodeOffset = 0;
+    record->topOfStack = 0;
+    record->localVariables = memory + recordWords<StacklessRecord>;
+    record->operandStack = record->localVariables + numLocals;
+    record->localVariablesGCMask = record->operandStack + numOperands;
+    record->operandGCMask = record->localVariablesGCMask + llvm::divideCeil(numLocals, 64);
+    record->caller = nullptr;
+    record->backEdgeCounter = 0;
+    return record;
+}
+
+void jllvm::Interpreter::pushStacklessFrame(StacklessFrame*& stacklessFrames, const Method& callee,
+                                            llvm::ArrayRef<std::uint64_t> arguments)
+{
+    Code* code = callee.getMethodInfo().getAttributes().find<Code>();
+    std::uint16_t numLocals = code->getMaxLocals();
+    std::uint16_t numOperands = code->getMaxStack();
+
+    StacklessFrameStack::Mark mark = m_stacklessFrameStack.mark();
+    StacklessRecord* record =
+        constructStacklessRecord(m_stacklessFrameStack.allocate(getStacklessFrameWords(callee)), callee);
+    record->caller = stacklessFrames;
+    record->mark = mark;
+
+    // Same initialization as done by the interpreter entry.
+    std::fill_n(record->localVariablesGCMask, llvm::divideCeil(numLocals, 64) + llvm::divideCeil(numOperands, 64), 0);
+    if (m_zeroFrames)
+    {
+        std::fill_n(record->localVariables, numLocals + numOperands, 0);
+    }
+    initLocals(callee, arguments.data(), record->localVariables);
+
+    stacklessFrames = record;
+}
+
+void jllvm::Interpreter::pushStacklessFrame(StacklessFrame*& stacklessFrames, const StacklessFrame& state)
+{
+    // The masks directly follow the operand stack in the layout created by 'constructStacklessRecord', making the
+    // whole layout after the record a single copy.
+    std::size_t words = getStacklessFrameWords(*state.method);
+    StacklessFrameStack::Mark mark = m_stacklessFrameStack.mark();
+    StacklessRecord* record = constructStacklessRecord(m_stacklessFrameStack.allocate(words), *state.method);
+    std::copy_n(state.localVariables, words - recordWords<StacklessRecord>, record->localVariables);
+    record->byteCodeOffset = state.byteCodeOffset;
+    record->topOfStack = state.topOfStack;
+    record->caller = stacklessFrames;
+    record->mark = mark;
+
+    stacklessFrames = record;
+}
+
+void jllvm::Interpreter::popStacklessFrame(StacklessFrame*& stacklessFrames)
+{
+    auto* record = static_cast<StacklessRecord*>(stacklessFrames);
+    stacklessFrames = record->caller;
+    m_stacklessFrameStack.release(record->mark);
+}
+
 namespace
 {
 
@@ -564,6 +752,8 @@ struct MultiTypeImpls
 {
     VirtualMachine& virtualMachine;
     InterpreterContext& context;
+    /// Profile of the method being executed or null if profiling is disabled.
+    MethodProfile* profile;
 
     template <IsAdd T>
     NextPC operator()(T) const
@@ -712,7 +902,12 @@ struct MultiTypeImpls
     {
         auto value2 = context.pop<typename InstructionElementType<T>::signed_type>();
         auto value1 = context.pop<typename InstructionElementType<T>::signed_type>();
-        if (ComparisonOperator<T>{}(value1, value2))
+        bool taken = ComparisonOperator<T>{}(value1, value2);
+        if (profile)
+        {
+            profile->recordBranch(instruction.offset, taken);
+        }
+        if (taken)
         {
             return SetPC{static_cast<std::uint16_t>(instruction.offset + instruction.target)};
         }
@@ -724,7 +919,12 @@ struct MultiTypeImpls
     {
         auto value = context.pop<typename InstructionElementType<T>::signed_type>();
         // NOLINTNEXTLINE(*-use-nullptr): clang-tidy warns the use of '0' rather than 'nullptr' despite being templated.
-        if (ComparisonOperator<T>{}(value, static_cast<decltype(value)>(0)))
+        bool taken = ComparisonOperator<T>{}(value, static_cast<decltype(value)>(0));
+        if (profile)
+        {
+            profile->recordBranch(instruction.offset, taken);
+        }
+        if (taken)
         {
             return SetPC{static_cast<std::uint16_t>(instruction.offset + instruction.target)};
         }
@@ -861,7 +1061,7 @@ struct MultiTypeImpls
     NextPC operator()(T store) const
     {
         using type = typename InstructionElementType<T>::type;
-        context.setLocalAsRaw<type>(store.index, context.popAsRaw<type>());
+        context.setLocalAsRaw(store.index, context.popAsRaw<type>());
         return {};
     }
 
@@ -869,7 +1069,7 @@ struct MultiTypeImpls
     NextPC operator()(T) const
     {
         using type = typename InstructionElementType<T>::type;
-        context.setLocalAsRaw<type>(0, context.popAsRaw<type>());
+        context.setLocalAsRaw(0, context.popAsRaw<type>());
         return {};
     }
 
@@ -877,7 +1077,7 @@ struct MultiTypeImpls
     NextPC operator()(T) const
     {
         using type = typename InstructionElementType<T>::type;
-        context.setLocalAsRaw<type>(1, context.popAsRaw<type>());
+        context.setLocalAsRaw(1, context.popAsRaw<type>());
         return {};
     }
 
@@ -885,7 +1085,7 @@ struct MultiTypeImpls
     NextPC operator()(T) const
     {
         using type = typename InstructionElementType<T>::type;
-        context.setLocalAsRaw<type>(2, context.popAsRaw<type>());
+        context.setLocalAsRaw(2, context.popAsRaw<type>());
         return {};
     }
 
@@ -893,7 +1093,7 @@ struct MultiTypeImpls
     NextPC operator()(T) const
     {
         using type = typename InstructionElementType<T>::type;
-        context.setLocalAsRaw<type>(3, context.popAsRaw<type>());
+        context.setLocalAsRaw(3, context.popAsRaw<type>());
         return {};
     }
 
@@ -948,585 +1148,1085 @@ struct MultiTypeImpls
 } // namespace
 
 std::uint64_t jllvm::Interpreter::executeMethod(const Method& method, std::uint16_t& offset,
-                                                InterpreterContext& context)
+                                                InterpreterContext& context, StacklessFrame*& stacklessFrames)
 {
-    const ClassFile& classFile = *method.getClassObject()->getClassFile();
-    Code* code = method.getMethodInfo().getAttributes().find<Code>();
-    assert(code && "method being interpreted must have code");
-    llvm::ArrayRef<char> codeArray = code->getCode();
-    auto curr = ByteCodeIterator(codeArray.data(), offset);
-    MethodType methodType = method.getType();
     std::uint64_t backEdgeCounter = 0;
+    if (!m_stacklessCalls && !stacklessFrames)
+    {
+        StacklessCall stacklessCall;
+        return executeFrame(method, offset, context, backEdgeCounter, stacklessCall);
+    }
 
-    // Lazily fetches and caches the class object for 'Object'.
-    auto getObjectClass = [&, objectClass = static_cast<ClassObject*>(nullptr)]() mutable
+    // Any stackless frames are freed when the activation is left, be it by returning, by a Java exception unwinding
+    // it or by OSR replacing the frame of 'method'.
+    StacklessFrameStack::Mark entryMark = m_stacklessFrameStack.mark();
+    auto freeStacklessFrames = llvm::make_scope_exit([&] { m_stacklessFrameStack.release(entryMark); });
+
+    // Frames of methods inlined into deoptimized JITted code are passed by the OSR entry as a chain of heap allocated
+    // stackless frames. Moving them onto the stackless frame stack frees them like any other stackless frame.
+    if (stacklessFrames)
     {
-        if (!objectClass)
+        llvm::SmallVector<StacklessFrame*> heapFrames;
+        for (StacklessFrame* iter = std::exchange(stacklessFrames, nullptr); iter; iter = iter->caller)
         {
-            objectClass = &m_virtualMachine.getClassLoader().forName("Ljava/lang/Object;");
+            heapFrames.push_back(iter);
         }
-        return objectClass;
+        for (StacklessFrame* heapFrame : llvm::reverse(heapFrames))
+        {
+            pushStacklessFrame(stacklessFrames, *heapFrame);
+        }
+        for (StacklessFrame* heapFrame : heapFrames)
+        {
+            delete[] reinterpret_cast<std::uint64_t*>(heapFrame);
+        }
+    }
+
+    // Calls 'f' with the method, bytecode offset, context and backedge counter of the innermost frame.
+    auto withInnermostFrame = [&](auto&& f)
+    {
+        auto* record = static_cast<StacklessRecord*>(stacklessFrames);
+        if (!record)
+        {
+            return f(method, offset, context, backEdgeCounter);
+        }
+        InterpreterContext frameContext(record->topOfStack, record->operandStack, record->localVariables);
+        return f(*record->method, record->byteCodeOffset, frameContext, record->backEdgeCounter);
     };
 
+    // Method of a stackless frame that was popped to be continued by an OSR version using 'm_stacklessOSRState'.
+    const Method* osrMethod = nullptr;
     while (true)
     {
-        // Update the current offset to the new instruction.
-        offset = curr.getOffset();
-        ByteCodeOp operation = *curr;
-        InstructionResult result = match(
-            operation, MultiTypeImpls{m_virtualMachine, context},
-            [&](AConstNull)
+        try
+        {
+            const Method* callee;
+            std::uint64_t returnValue;
+            if (osrMethod)
             {
-                context.push<ObjectInterface*>(nullptr);
-                return NextPC{};
-            },
-            [&](ANewArray aNewArray)
+                callee = std::exchange(osrMethod, nullptr);
+                OSRState state = std::move(*m_stacklessOSRState);
+                m_stacklessOSRState.reset();
+                auto* entry = reinterpret_cast<std::uint64_t (*)(std::uint64_t*)>(state.getTarget().getOSREntry(
+                    *callee, state.getByteCodeOffset(), CallingConvention::Interpreter));
+                returnValue = entry(state.release());
+            }
+            else
             {
-                auto count = context.pop<std::int32_t>();
-                if (count < 0)
+                StacklessCall stacklessCall;
+                returnValue = withInnermostFrame(
+                    [&](const Method& frameMethod, std::uint16_t& frameOffset, InterpreterContext& frameContext,
+                        std::uint64_t& frameBackEdgeCounter)
+                    {
+                        return executeFrame(frameMethod, frameOffset, frameContext, frameBackEdgeCounter,
+                                            stacklessCall);
+                    });
+                if (stacklessCall.callee)
                 {
-                    m_virtualMachine.throwNegativeArraySizeException(count);
+                    pushStacklessFrame(stacklessFrames, *stacklessCall.callee, stacklessCall.arguments);
+                    continue;
                 }
-                ClassObject* componentType = getClassObject(classFile, aNewArray.index);
-                ClassObject& arrayType =
-                    m_virtualMachine.getClassLoader().forName(ArrayType(componentType->getDescriptor()));
-                auto* array = m_virtualMachine.getGC().allocate<AbstractArray>(&arrayType, count);
-                context.push(array);
-                return NextPC{};
-            },
-            [&](ArrayLength)
-            {
-                auto* array = context.pop<AbstractArray*>();
-                if (!array)
+                if (!stacklessFrames)
                 {
-                    m_virtualMachine.throwNullPointerException();
+                    return returnValue;
                 }
-                context.push<std::uint32_t>(array->size());
-                return NextPC{};
-            },
-            [&](AThrow) -> InstructionResult
-            {
-                auto* exception = context.pop<ObjectInterface*>();
-                if (!exception)
+                callee = stacklessFrames->method;
+                popStacklessFrame(stacklessFrames);
+            }
+
+            // Continue the caller after its call instruction with the return value pushed to its operand stack.
+            withInnermostFrame(
+                [&](const Method& caller, std::uint16_t& callerOffset, InterpreterContext& callerContext,
+                    std::uint64_t&)
                 {
-                    m_virtualMachine.throwNullPointerException();
-                }
-                // Verifier checks that the exception is an instance of 'Throwable' rather than performing it at
-                // runtime.
-                m_virtualMachine.throwJavaException(static_cast<Throwable*>(exception));
-            },
-            [&](BIPush biPush)
+                    FieldType returnType = callee->getType().returnType();
+                    if (returnType != BaseType(BaseType::Void))
+                    {
+                        callerContext.push(returnValue, returnType);
+                    }
+                    DecodedCode& callerCode = decode(caller);
+                    callerOffset = callerCode.offsets[callerCode.indices[callerOffset] + 1];
+                });
+        }
+        catch (const StacklessTransfer& transfer)
+        {
+            if (transfer.activation != &stacklessFrames)
             {
-                context.push<std::int32_t>(biPush.value);
-                return NextPC{};
-            },
-            [&](CheckCast checkCast)
+                throw;
+            }
+
+            // Pop all callees of the target frame.
+            while (stacklessFrames != transfer.target)
             {
-                auto* object = context.pop<ObjectInterface*>();
-                context.push(object);
-                if (!object)
-                {
-                    return NextPC{};
-                }
+                popStacklessFrame(stacklessFrames);
+            }
 
-                ClassObject* classObject = getClassObject(classFile, checkCast.index);
-                if (object->instanceOf(classObject))
-                {
-                    return NextPC{};
-                }
+            switch (transfer.kind)
+            {
+                case StacklessTransfer::ExceptionHandler:
+                    withInnermostFrame(
+                        [&](const Method&, std::uint16_t& frameOffset, InterpreterContext& frameContext,
+                            std::uint64_t&)
+                        {
+                            frameContext.clearOperandStack();
+                            frameContext.push<ObjectInterface*>(transfer.throwable);
+                            frameOffset = transfer.handlerOffset;
+                        });
+                    break;
+                case StacklessTransfer::OnStackReplacement:
+                    // The OSR version is called outside the catch clause for transfers to this activation from
+                    // within the OSR version to be caught.
+                    osrMethod = stacklessFrames->method;
+                    popStacklessFrame(stacklessFrames);
+                    break;
+            }
+        }
+    }
+}
+
+std::uint64_t jllvm::Interpreter::executeFrame(const Method& method, std::uint16_t& offset,
+                                               InterpreterContext& context, std::uint64_t& backEdgeCounter,
+                                               StacklessCall& stacklessCall)
+{
+    const ClassFile& classFile = *method.getClassObject()->getClassFile();
+    DecodedCode& decodedCode = decode(method);
+    // Index of the current instruction within 'decodedCode'.
+    std::size_t index = decodedCode.indices[offset];
+    MethodType methodType = method.getType();
 
-                m_virtualMachine.throwClassCastException(object, classObject);
-            },
-            [&](Dup)
+    MethodProfile* profile = nullptr;
+    if (m_profilingEnabled)
+    {
+        profile = method.getProfile();
+        if (!profile)
+        {
+            profile = new (m_profileAllocator.Allocate()) MethodProfile;
+            method.setProfile(profile);
+        }
+        if (offset == 0)
+        {
+            profile->incrementInvocationCount();
+            // Compilation is done in the background if possible. This and any further invocations until the
+            // compilation has finished are still executed by the interpreter.
+            if (profile->getInvocationCount() == m_invocationThreshold)
             {
-                InterpreterContext::RawValue value = context.popRaw();
-                context.pushRaw(value);
-                context.pushRaw(value);
-                return NextPC{};
-            },
-            [&](DupX1)
+                m_virtualMachine.getRuntime().changeExecutor(method, m_virtualMachine.getJIT());
+            }
+        }
+    }
+
+    // Link any methods whose background compilation has finished. Method entry is a safe point to do so, as linking may
+    // load classes. This is done regardless of profiling as e.g. JIT code called from interpreted code may have
+    // requested optimized code.
+    if (offset == 0)
+    {
+        m_virtualMachine.getRuntime().pollBackgroundCompilations();
+    }
+
+    // The histogram is gathered without quickening to count the instructions as they appear in the bytecode.
+    QuickenedCode* quickenedCode = m_byteCodePairCounts ? nullptr : &quicken(method);
+
+    // Replaces the instruction at the current offset with 'quickenedInstruction' for all future executions.
+    auto quickenInstruction = [&](QuickenedInstruction quickenedInstruction)
+    {
+        if (!quickenedCode)
+        {
+            return;
+        }
+        quickenedInstruction.nextOffset = decodedCode.offsets[index + 1];
+        quickenedCode->add(offset, quickenedInstruction);
+    };
+
+    // Lazily fetches and caches the class object for 'Object'.
+    auto getObjectClass = [&, objectClass = static_cast<ClassObject*>(nullptr)]() mutable
+    {
+        if (!objectClass)
+        {
+            objectClass = &m_virtualMachine.getClassLoader().forName("Ljava/lang/Object;");
+        }
+        return objectClass;
+    };
+
+    const ByteCodeOp* operation = &decodedCode.ops[index];
+    auto handlers = overload(
+        MultiTypeImpls{m_virtualMachine, context, profile},
+        [&](AConstNull)
+        {
+            context.push<ObjectInterface*>(nullptr);
+            return NextPC{};
+        },
+        [&](ANewArray aNewArray)
+        {
+            auto count = context.pop<std::int32_t>();
+            if (count < 0)
             {
-                InterpreterContext::RawValue value1 = context.popRaw();
-                InterpreterContext::RawValue value2 = context.popRaw();
-                context.pushRaw(value1);
-                context.pushRaw(value2);
-                context.pushRaw(value1);
-                return NextPC{};
-            },
-            [&](DupX2)
+                m_virtualMachine.throwNegativeArraySizeException(count);
+            }
+            ClassObject* componentType = getClassObject(classFile, aNewArray.index);
+            ClassObject& arrayType =
+                m_virtualMachine.getClassLoader().forName(ArrayType(componentType->getDescriptor()));
+            auto* array = m_virtualMachine.getGC().allocate<AbstractArray>(&arrayType, count);
+            context.push(array);
+            return NextPC{};
+        },
+        [&](ArrayLength)
+        {
+            auto* array = context.pop<AbstractArray*>();
+            if (!array)
             {
-                InterpreterContext::RawValue value1 = context.popRaw();
-                InterpreterContext::RawValue value2 = context.popRaw();
-                InterpreterContext::RawValue value3 = context.popRaw();
-                context.pushRaw(value1);
-                context.pushRaw(value3);
-                context.pushRaw(value2);
-                context.pushRaw(value1);
-                return NextPC{};
-            },
-            [&](Dup2)
+                m_virtualMachine.throwNullPointerException();
+            }
+            context.push<std::uint32_t>(array->size());
+            return NextPC{};
+        },
+        [&](AThrow) -> InstructionResult
+        {
+            auto* exception = context.pop<ObjectInterface*>();
+            if (!exception)
             {
-                InterpreterContext::RawValue value1 = context.popRaw();
-                InterpreterContext::RawValue value2 = context.popRaw();
-                context.pushRaw(value2);
-                context.pushRaw(value1);
-                context.pushRaw(value2);
-                context.pushRaw(value1);
-                return NextPC{};
-            },
-            [&](Dup2X1)
+                m_virtualMachine.throwNullPointerException();
+            }
+            // Verifier checks that the exception is an instance of 'Throwable' rather than performing it at
+            // runtime.
+            m_virtualMachine.throwJavaException(static_cast<Throwable*>(exception));
+        },
+        [&](BIPush biPush)
+        {
+            context.push<std::int32_t>(biPush.value);
+            return NextPC{};
+        },
+        [&](CheckCast checkCast)
+        {
+            auto* object = context.pop<ObjectInterface*>();
+            context.push(object);
+            if (!object)
             {
-                InterpreterContext::RawValue value1 = context.popRaw();
-                InterpreterContext::RawValue value2 = context.popRaw();
-                InterpreterContext::RawValue value3 = context.popRaw();
-                context.pushRaw(value2);
-                context.pushRaw(value1);
-                context.pushRaw(value3);
-                context.pushRaw(value2);
-                context.pushRaw(value1);
                 return NextPC{};
-            },
-            [&](Dup2X2)
+            }
+
+            if (profile)
             {
-                InterpreterContext::RawValue value1 = context.popRaw();
-                InterpreterContext::RawValue value2 = context.popRaw();
-                InterpreterContext::RawValue value3 = context.popRaw();
-                InterpreterContext::RawValue value4 = context.popRaw();
-                context.pushRaw(value2);
-                context.pushRaw(value1);
-                context.pushRaw(value4);
-                context.pushRaw(value3);
-                context.pushRaw(value2);
-                context.pushRaw(value1);
-                return NextPC{};
-            },
-            [&](GetField getField)
+                profile->recordReceiverType(checkCast.offset, object->getClass());
+            }
+
+            ClassObject* classObject = getClassObject(classFile, checkCast.index);
+            if (object->instanceOf(classObject))
             {
-                auto [classObject, fieldName, descriptor] = getFieldInfo(classFile, getField.index);
+                return NextPC{};
+            }
 
-                const Field* field = classObject->getInstanceField(fieldName, descriptor);
-                auto* object = context.pop<ObjectInterface*>();
-                if (!object)
-                {
-                    m_virtualMachine.throwNullPointerException();
-                }
+            m_virtualMachine.throwClassCastException(object, classObject);
+        },
+        [&](Dup)
+        {
+            InterpreterContext::RawValue value = context.popRaw();
+            context.pushRaw(value);
+            context.pushRaw(value);
+            return NextPC{};
+        },
+        [&](DupX1)
+        {
+            InterpreterContext::RawValue value1 = context.popRaw();
+            InterpreterContext::RawValue value2 = context.popRaw();
+            context.pushRaw(value1);
+            context.pushRaw(value2);
+            context.pushRaw(value1);
+            return NextPC{};
+        },
+        [&](DupX2)
+        {
+            InterpreterContext::RawValue value1 = context.popRaw();
+            InterpreterContext::RawValue value2 = context.popRaw();
+            InterpreterContext::RawValue value3 = context.popRaw();
+            context.pushRaw(value1);
+            context.pushRaw(value3);
+            context.pushRaw(value2);
+            context.pushRaw(value1);
+            return NextPC{};
+        },
+        [&](Dup2)
+        {
+            InterpreterContext::RawValue value1 = context.popRaw();
+            InterpreterContext::RawValue value2 = context.popRaw();
+            context.pushRaw(value2);
+            context.pushRaw(value1);
+            context.pushRaw(value2);
+            context.pushRaw(value1);
+            return NextPC{};
+        },
+        [&](Dup2X1)
+        {
+            InterpreterContext::RawValue value1 = context.popRaw();
+            InterpreterContext::RawValue value2 = context.popRaw();
+            InterpreterContext::RawValue value3 = context.popRaw();
+            context.pushRaw(value2);
+            context.pushRaw(value1);
+            context.pushRaw(value3);
+            context.pushRaw(value2);
+            context.pushRaw(value1);
+            return NextPC{};
+        },
+        [&](Dup2X2)
+        {
+            InterpreterContext::RawValue value1 = context.popRaw();
+            InterpreterContext::RawValue value2 = context.popRaw();
+            InterpreterContext::RawValue value3 = context.popRaw();
+            InterpreterContext::RawValue value4 = context.popRaw();
+            context.pushRaw(value2);
+            context.pushRaw(value1);
+            context.pushRaw(value4);
+            context.pushRaw(value3);
+            context.pushRaw(value2);
+            context.pushRaw(value1);
+            return NextPC{};
+        },
+        [&](GetField getField)
+        {
+            auto [classObject, fieldName, descriptor] = getFieldInfo(classFile, getField.index);
 
-                std::uint64_t value{};
-                std::memcpy(&value, reinterpret_cast<char*>(object) + field->getOffset(), descriptor.sizeOf());
-                context.push(value, descriptor);
-                return NextPC{};
-            },
-            [&](GetStatic getStatic)
+            const Field* field = classObject->getInstanceField(fieldName, descriptor);
+            auto* object = context.pop<ObjectInterface*>();
+            if (!object)
             {
-                auto [classObject, fieldName, descriptor] = getFieldInfo(classFile, getStatic.index);
+                m_virtualMachine.throwNullPointerException();
+            }
 
-                m_virtualMachine.initialize(*classObject);
-                const Field* field = classObject->getStaticField(fieldName, descriptor);
+            std::uint64_t value{};
+            std::memcpy(&value, reinterpret_cast<char*>(object) + field->getOffset(), descriptor.sizeOf());
+            context.push(value, descriptor);
+            return NextPC{};
+        },
+        [&](GetStatic getStatic)
+        {
+            auto [classObject, fieldName, descriptor] = getFieldInfo(classFile, getStatic.index);
 
-                std::uint64_t value{};
-                std::memcpy(&value, field->getAddressOfStatic(), descriptor.sizeOf());
-                context.push(value, descriptor);
-                return NextPC{};
-            },
-            [&](OneOf<Goto, GotoW> gotoInst)
-            { return SetPC{static_cast<std::uint16_t>(gotoInst.offset + gotoInst.target)}; },
-            [&](IConst3)
-            {
-                context.push<std::int32_t>(3);
-                return NextPC{};
-            },
-            [&](IConst4)
-            {
-                context.push<std::int32_t>(4);
-                return NextPC{};
-            },
-            [&](IConst5)
+            m_virtualMachine.initialize(*classObject);
+            Field* field = classObject->getStaticField(fieldName, descriptor);
+            // The class may still be under initialization by this thread, requiring the check to be repeated.
+            if (classObject->isInitialized())
             {
-                context.push<std::int32_t>(5);
-                return NextPC{};
-            },
-            [&](IConstM1)
+                quickenInstruction({.kind = QuickenedInstruction::GetStaticInitialized, .field = field});
+            }
+
+            std::uint64_t value{};
+            std::memcpy(&value, field->getAddressOfStatic(), descriptor.sizeOf());
+            context.push(value, descriptor);
+            return NextPC{};
+        },
+        [&](OneOf<Goto, GotoW> gotoInst)
+        { return SetPC{static_cast<std::uint16_t>(gotoInst.offset + gotoInst.target)}; },
+        [&](IConst3)
+        {
+            context.push<std::int32_t>(3);
+            return NextPC{};
+        },
+        [&](IConst4)
+        {
+            context.push<std::int32_t>(4);
+            return NextPC{};
+        },
+        [&](IConst5)
+        {
+            context.push<std::int32_t>(5);
+            return NextPC{};
+        },
+        [&](IConstM1)
+        {
+            context.push<std::int32_t>(-1);
+            return NextPC{};
+        },
+        [&](IInc iInc)
+        {
+            context.setLocal(iInc.index,
+                             static_cast<std::int32_t>(iInc.byte) + context.getLocal<std::uint32_t>(iInc.index));
+            return NextPC{};
+        },
+        [&](InstanceOf instanceOf)
+        {
+            auto* object = context.pop<ObjectInterface*>();
+            if (!object)
             {
-                context.push<std::int32_t>(-1);
+                context.push<std::int32_t>(0);
                 return NextPC{};
-            },
-            [&](IInc iInc)
+            }
+
+            if (profile)
             {
-                context.setLocal(iInc.index,
-                                 static_cast<std::int32_t>(iInc.byte) + context.getLocal<std::uint32_t>(iInc.index));
-                return NextPC{};
-            },
-            [&](InstanceOf instanceOf)
+                profile->recordReceiverType(instanceOf.offset, object->getClass());
+            }
+
+            ClassObject* classObject = getClassObject(classFile, instanceOf.index);
+            context.push<std::int32_t>(object->instanceOf(classObject));
+            return NextPC{};
+        },
+        // TODO: InvokeDynamic
+        [&](OneOf<InvokeStatic, InvokeSpecial, InvokeInterface, InvokeVirtual> invoke)
+        {
+            const RefInfo* refInfo = PoolIndex<RefInfo>{invoke.index}.resolve(classFile);
+
+            llvm::StringRef methodName =
+                refInfo->nameAndTypeIndex.resolve(classFile)->nameIndex.resolve(classFile)->text;
+            MethodType descriptor(
+                refInfo->nameAndTypeIndex.resolve(classFile)->descriptorIndex.resolve(classFile)->text);
+
+            // Resolution of the call site only has to be done once as its result never changes.
+            std::pair callSiteKey{&method, static_cast<std::uint16_t>(invoke.offset)};
+            ClassObject* classObject = m_callSiteCaches.lookup(callSiteKey).classObject;
+            if (!classObject)
             {
-                auto* object = context.pop<ObjectInterface*>();
-                if (!object)
-                {
-                    context.push<std::int32_t>(0);
-                    return NextPC{};
-                }
+                classObject = getClassObject(classFile, refInfo->classIndex);
+                m_callSiteCaches[callSiteKey].classObject = classObject;
+            }
 
-                ClassObject* classObject = getClassObject(classFile, instanceOf.index);
-                context.push<std::int32_t>(object->instanceOf(classObject));
-                return NextPC{};
-            },
-            // TODO: InvokeDynamic
-            [&](OneOf<InvokeStatic, InvokeSpecial, InvokeInterface, InvokeVirtual> invoke)
+            // Initialize the class object if it's an 'invokestatic'. This has to be done before the call to
+            // 'viewAndPopArguments' as the arguments on the operand stack could otherwise be garbage collected.
+            if (holds_alternative<InvokeStatic>(*operation))
             {
-                const RefInfo* refInfo = PoolIndex<RefInfo>{invoke.index}.resolve(classFile);
+                m_virtualMachine.initialize(*classObject);
+            }
 
-                llvm::StringRef methodName =
-                    refInfo->nameAndTypeIndex.resolve(classFile)->nameIndex.resolve(classFile)->text;
-                MethodType descriptor(
-                    refInfo->nameAndTypeIndex.resolve(classFile)->descriptorIndex.resolve(classFile)->text);
+            // Note: This reference is invalidated by executing any Java code as it may insert new call sites.
+            CallSiteCache& callSite = m_callSiteCaches[callSiteKey];
 
-                // Initialize the class object if it's an 'invokestatic'. This has to be done before the call to
-                // 'viewAndPopArguments' as the arguments on the operand stack could otherwise be garbage collected.
-                ClassObject* classObject = getClassObject(classFile, refInfo->classIndex);
-                if (holds_alternative<InvokeStatic>(operation))
-                {
-                    m_virtualMachine.initialize(*classObject);
-                }
+            llvm::ArrayRef<std::uint64_t> arguments =
+                context.viewAndPopArguments(descriptor, /*isStatic=*/holds_alternative<InvokeStatic>(*operation));
 
-                llvm::ArrayRef<std::uint64_t> arguments =
-                    context.viewAndPopArguments(descriptor, /*isStatic=*/holds_alternative<InvokeStatic>(operation));
+            if (profile)
+            {
+                profile->incrementCallCount(invoke.offset);
+            }
 
-                // Find the callee with the resolution of the given call.
-                const Method* callee = match(
-                    operation,
-                    [&](InvokeStatic) -> const Method*
+            // Find the callee with the resolution of the given call.
+            const Method* callee = match(
+                *operation,
+                [&](InvokeStatic) -> const Method*
+                {
+                    if (!callSite.resolvedMethod)
+                    {
+                        callSite.resolvedMethod =
+                            classObject->isInterface() ?
+                                classObject->interfaceMethodResolution(methodName, descriptor, getObjectClass()) :
+                                classObject->methodResolution(methodName, descriptor);
+                    }
+                    return callSite.resolvedMethod;
+                },
+                [&](OneOf<InvokeInterface, InvokeVirtual>) -> const Method*
+                {
+                    auto* thisArg = llvm::bit_cast<ObjectInterface*>(arguments.front());
+                    if (!thisArg)
                     {
-                        return classObject->isInterface() ?
-                                   classObject->interfaceMethodResolution(methodName, descriptor, getObjectClass()) :
-                                   classObject->methodResolution(methodName, descriptor);
-                    },
-                    [&](OneOf<InvokeInterface, InvokeVirtual>) -> const Method*
+                        m_virtualMachine.throwNullPointerException();
+                    }
+
+                    if (profile)
                     {
-                        auto* thisArg = llvm::bit_cast<ObjectInterface*>(arguments.front());
-                        if (!thisArg)
-                        {
-                            m_virtualMachine.throwNullPointerException();
-                        }
+                        profile->recordReceiverType(invoke.offset, thisArg->getClass());
+                    }
 
-                        // TODO: This is super unoptimized. V-Table and I-Table lookups could be introduced just for
-                        //       the interpreter, and inline-caching used.
-                        const Method* resolvedMethod;
-                        if (holds_alternative<InvokeVirtual>(operation))
+                    if (!callSite.resolvedMethod)
+                    {
+                        if (holds_alternative<InvokeVirtual>(*operation))
                         {
-                            resolvedMethod = classObject->methodResolution(methodName, descriptor);
+                            callSite.resolvedMethod = classObject->methodResolution(methodName, descriptor);
                         }
                         else
                         {
-                            resolvedMethod =
+                            callSite.resolvedMethod =
                                 classObject->interfaceMethodResolution(methodName, descriptor, getObjectClass());
                         }
+                    }
+                    const Method* resolvedMethod = callSite.resolvedMethod;
 
-                        // Fast path: If its known that the method has no table slot due to not being overridable, we
-                        // do not have to perform method selection.
-                        if (!resolvedMethod->getTableSlot())
-                        {
-                            return resolvedMethod;
-                        }
+                    // Fast path: If its known that the method has no table slot due to not being overridable, we
+                    // do not have to perform method selection.
+                    if (!resolvedMethod->getTableSlot())
+                    {
+                        return resolvedMethod;
+                    }
 
-                        // Select the correct method based on the dynamic type of the 'this' argument.
-                        return &thisArg->getClass()->methodSelection(*resolvedMethod);
-                    },
-                    [&](InvokeSpecial)
+                    // Select the correct method based on the dynamic type of the 'this' argument. The last selection
+                    // is cached as most call sites only ever see a single class of receiver.
+                    const ClassObject* receiverClass = thisArg->getClass();
+                    if (callSite.receiverClass != receiverClass)
                     {
-                        auto* thisArg = llvm::bit_cast<ObjectInterface*>(arguments.front());
-                        if (!thisArg)
-                        {
-                            m_virtualMachine.throwNullPointerException();
-                        }
+                        callSite.receiverClass = receiverClass;
+                        callSite.selectedMethod = resolvedMethod->getClassObject()->isInterface() ?
+                                                      &receiverClass->interfaceMethodSelection(*resolvedMethod) :
+                                                      &receiverClass->methodSelection(*resolvedMethod);
+                    }
+                    return callSite.selectedMethod;
+                },
+                [&](InvokeSpecial)
+                {
+                    auto* thisArg = llvm::bit_cast<ObjectInterface*>(arguments.front());
+                    if (!thisArg)
+                    {
+                        m_virtualMachine.throwNullPointerException();
+                    }
 
-                        return classObject->specialMethodResolution(methodName, descriptor, getObjectClass(),
-                                                                    method.getClassObject());
-                    },
-                    [&](...) -> const Method* { llvm_unreachable("unexpected op"); });
+                    if (!callSite.resolvedMethod)
+                    {
+                        callSite.resolvedMethod = classObject->specialMethodResolution(
+                            methodName, descriptor, getObjectClass(), method.getClassObject());
+                    }
+                    return callSite.resolvedMethod;
+                },
+                [&](...) -> const Method* { llvm_unreachable("unexpected op"); });
 
-                std::uint64_t returnValue = callee->callInterpreterCC(arguments.data());
-                FieldType returnType = descriptor.returnType();
-                if (returnType != BaseType(BaseType::Void))
-                {
-                    context.push(returnValue, returnType);
-                }
+            // Stackless calls fall back to this handler from the quickened instruction. It is only quickened once.
+            if (holds_alternative<InvokeStatic>(*operation) && classObject->isInitialized()
+                && !(quickenedCode && quickenedCode->lookup(offset)))
+            {
+                quickenInstruction({.kind = QuickenedInstruction::InvokeStaticInitialized, .callee = callee});
+            }
 
-                return NextPC{};
-            },
-            [&](IReturn)
+            // Callees executed by the interpreter are executed as stackless frames by 'executeMethod'. The return
+            // value is ignored in this case.
+            if (m_stacklessCalls && m_virtualMachine.getRuntime().getExecutor(*callee) == this)
             {
-                auto value = context.pop<std::uint32_t>();
-                switch (get<BaseType>(methodType.returnType()).getValue())
-                {
-                    case BaseType::Boolean: value &= 0b1; break;
-                    case BaseType::Char: value = static_cast<std::int32_t>(static_cast<std::uint16_t>(value)); break;
-                    case BaseType::Byte: value = static_cast<std::int32_t>(static_cast<std::int8_t>(value)); break;
-                    case BaseType::Short: value = static_cast<std::int32_t>(static_cast<std::int16_t>(value)); break;
-                    case BaseType::Int: break;
-                    case BaseType::Long:
-                    case BaseType::Void:
-                    case BaseType::Float:
-                    case BaseType::Double:
-                    default: llvm_unreachable("not possible");
-                }
-                return ReturnValue(value);
-            },
-            [&](OneOf<JSR, JSRw> jsr)
+                stacklessCall = {callee, arguments};
+                return ReturnValue(std::uint64_t{});
+            }
+
+            std::uint64_t returnValue = callee->callInterpreterCC(arguments.data());
+            FieldType returnType = descriptor.returnType();
+            if (returnType != BaseType(BaseType::Void))
             {
-                std::uint16_t retAddress =
-                    jsr.offset + sizeof(OpCodes)
-                    + (holds_alternative<JSRw>(*curr) ? sizeof(std::int32_t) : sizeof(std::int16_t));
-                context.pushRaw(retAddress, /*isReference=*/false);
-                return SetPC{static_cast<std::uint16_t>(jsr.offset + jsr.target)};
-            },
-            [&](OneOf<LDC, LDCW, LDC2W> ldc)
+                context.push(returnValue, returnType);
+            }
+
+            return NextPC{};
+        },
+        [&](IReturn)
+        {
+            auto value = context.pop<std::uint32_t>();
+            switch (get<BaseType>(methodType.returnType()).getValue())
             {
-                PoolIndex<IntegerInfo, FloatInfo, LongInfo, DoubleInfo, StringInfo, ClassInfo, MethodRefInfo,
-                          InterfaceMethodRefInfo, MethodTypeInfo, DynamicInfo>
-                    pool{ldc.index};
-
-                match(
-                    pool.resolve(classFile), [&](const IntegerInfo* integerInfo) { context.push(integerInfo->value); },
-                    [&](const FloatInfo* floatInfo) { context.push(floatInfo->value); },
-                    [&](const LongInfo* longInfo) { context.push(longInfo->value); },
-                    [&](const DoubleInfo* doubleInfo) { context.push(doubleInfo->value); },
-                    [&](const ClassInfo* classInfo) { context.push(getClassObject(classFile, *classInfo)); },
-                    [&](const StringInfo* stringInfo)
-                    {
-                        llvm::StringRef utf8String = stringInfo->stringValue.resolve(classFile)->text;
-                        context.push(m_virtualMachine.getStringInterner().intern(utf8String));
-                    },
-                    [&](const auto*) { escapeToJIT(); });
-                return NextPC{};
-            },
-            [&](const LookupSwitch& switchOp)
+                case BaseType::Boolean: value &= 0b1; break;
+                case BaseType::Char: value = static_cast<std::int32_t>(static_cast<std::uint16_t>(value)); break;
+                case BaseType::Byte: value = static_cast<std::int32_t>(static_cast<std::int8_t>(value)); break;
+                case BaseType::Short: value = static_cast<std::int32_t>(static_cast<std::int16_t>(value)); break;
+                case BaseType::Int: break;
+                case BaseType::Long:
+                case BaseType::Void:
+                case BaseType::Float:
+                case BaseType::Double:
+                default: llvm_unreachable("not possible");
+            }
+            return ReturnValue(value);
+        },
+        [&](OneOf<JSR, JSRw> jsr)
+        {
+            std::uint16_t retAddress =
+                jsr.offset + sizeof(OpCodes)
+                + (holds_alternative<JSRw>(*operation) ? sizeof(std::int32_t) : sizeof(std::int16_t));
+            context.pushRaw(retAddress);
+            return SetPC{static_cast<std::uint16_t>(jsr.offset + jsr.target)};
+        },
+        [&](OneOf<LDC, LDCW, LDC2W> ldc)
+        {
+            PoolIndex<IntegerInfo, FloatInfo, LongInfo, DoubleInfo, StringInfo, ClassInfo, MethodRefInfo,
+                      InterfaceMethodRefInfo, MethodTypeInfo, DynamicInfo>
+                pool{ldc.index};
+
+            // Resolution of 'String' and 'Class' constants is only done once per pool index. This avoids the hash
+            // lookups by name within the class loader or string interner on every subsequent execution.
+            auto pushReferenceConstant = [&](auto resolve)
             {
-                auto index = context.pop<std::int32_t>();
-                auto result =
-                    llvm::lower_bound(switchOp.matchOffsetPairs(), index,
-                                      [](const auto& pair, std::int32_t value) { return pair.first < value; });
-                if (result == switchOp.matchOffsetPairs().end() || (*result).first != index)
+                GCRootRef<ObjectInterface> constantRoot = m_ldcConstants.lookup({&classFile, ldc.index});
+                if (!constantRoot.hasRoot())
                 {
-                    return SetPC{static_cast<std::uint16_t>(switchOp.offset + switchOp.defaultOffset)};
+                    ObjectInterface* constant = resolve();
+                    constantRoot = m_virtualMachine.getGC().allocateStatic();
+                    constantRoot.assign(constant);
+                    m_ldcConstants[{&classFile, ldc.index}] = constantRoot;
                 }
-                return SetPC{static_cast<std::uint16_t>(switchOp.offset + (*result).second)};
-            },
-            [&](OneOf<MonitorEnter, MonitorExit>)
+                quickenInstruction({.kind = QuickenedInstruction::LDCReference, .constantRoot = constantRoot});
+                context.push(constantRoot.get());
+            };
+
+            match(
+                pool.resolve(classFile), [&](const IntegerInfo* integerInfo) { context.push(integerInfo->value); },
+                [&](const FloatInfo* floatInfo) { context.push(floatInfo->value); },
+                [&](const LongInfo* longInfo) { context.push(longInfo->value); },
+                [&](const DoubleInfo* doubleInfo) { context.push(doubleInfo->value); },
+                [&](const ClassInfo* classInfo)
+                { pushReferenceConstant([&] { return getClassObject(classFile, *classInfo); }); },
+                [&](const StringInfo* stringInfo)
+                {
+                    pushReferenceConstant(
+                        [&]
+                        {
+                            llvm::StringRef utf8String = stringInfo->stringValue.resolve(classFile)->text;
+                            return m_virtualMachine.getStringInterner().intern(utf8String);
+                        });
+                },
+                [&](const auto*) { escapeToJIT(); });
+            return NextPC{};
+        },
+        [&](const LookupSwitch& switchOp)
+        {
+            auto index = context.pop<std::int32_t>();
+            auto result =
+                llvm::lower_bound(switchOp.matchOffsetPairs(), index,
+                                  [](const auto& pair, std::int32_t value) { return pair.first < value; });
+            if (result == switchOp.matchOffsetPairs().end() || (*result).first != index)
             {
-                // Pop object as is required by the instruction.
-                // TODO: If we ever care about multi threading, this would require lazily creating a mutex and
-                //  (un)locking it.
-                if (!context.pop<ObjectInterface*>())
+                if (profile)
                 {
-                    m_virtualMachine.throwNullPointerException();
+                    profile->recordSwitch(switchOp.offset, std::nullopt, switchOp.rawPairs.size());
                 }
-                return NextPC{};
-            },
-            [&](MultiANewArray multiANewArray)
+                return SetPC{static_cast<std::uint16_t>(switchOp.offset + switchOp.defaultOffset)};
+            }
+            if (profile)
+            {
+                profile->recordSwitch(switchOp.offset, std::distance(switchOp.matchOffsetPairs().begin(), result),
+                                      switchOp.rawPairs.size());
+            }
+            return SetPC{static_cast<std::uint16_t>(switchOp.offset + (*result).second)};
+        },
+        [&](OneOf<MonitorEnter, MonitorExit>)
+        {
+            // Pop object as is required by the instruction.
+            // TODO: If we ever care about multi threading, this would require lazily creating a mutex and
+            //  (un)locking it.
+            if (!context.pop<ObjectInterface*>())
             {
-                GarbageCollector& gc = m_virtualMachine.getGC();
-                ClassObject* classObject = getClassObject(classFile, multiANewArray.index);
-                std::vector<std::int32_t> counts(multiANewArray.dimensions);
+                m_virtualMachine.throwNullPointerException();
+            }
+            return NextPC{};
+        },
+        [&](MultiANewArray multiANewArray)
+        {
+            GarbageCollector& gc = m_virtualMachine.getGC();
+            ClassObject* classObject = getClassObject(classFile, multiANewArray.index);
+            std::vector<std::int32_t> counts(multiANewArray.dimensions);
 
-                std::generate(counts.rbegin(), counts.rend(), [&] { return context.pop<std::int32_t>(); });
+            std::generate(counts.rbegin(), counts.rend(), [&] { return context.pop<std::int32_t>(); });
 
-                for (std::int32_t count : counts)
+            for (std::int32_t count : counts)
+            {
+                if (count < 0)
                 {
-                    if (count < 0)
-                    {
-                        m_virtualMachine.throwNegativeArraySizeException(count);
-                    }
-                };
+                    m_virtualMachine.throwNegativeArraySizeException(count);
+                }
+            };
 
-                auto generateArray = [&](llvm::ArrayRef<std::int32_t> counts, ArrayType currentType,
-                                         const auto generator) -> ObjectInterface*
+            auto generateArray = [&](llvm::ArrayRef<std::int32_t> counts, ArrayType currentType,
+                                     const auto generator) -> ObjectInterface*
+            {
+                std::int32_t count = counts.front();
+                counts = counts.drop_front();
+                ClassObject& arrayType = m_virtualMachine.getClassLoader().forName(currentType);
+                GCUniqueRoot array = gc.root(gc.allocate<AbstractArray>(&arrayType, count));
+                if (!counts.empty())
                 {
-                    std::int32_t count = counts.front();
-                    counts = counts.drop_front();
-                    ClassObject& arrayType = m_virtualMachine.getClassLoader().forName(currentType);
-                    GCUniqueRoot array = gc.root(gc.allocate<AbstractArray>(&arrayType, count));
-                    if (!counts.empty())
+                    auto outerArray = static_cast<GCRootRef<Array<>>>(array);
+                    auto componentType = get<ArrayType>(currentType.getComponentType());
+                    // necessary, because iterator for Arrays is not gc safe
+                    for (std::uint32_t i : llvm::seq(0u, outerArray->size()))
                     {
-                        auto outerArray = static_cast<GCRootRef<Array<>>>(array);
-                        auto componentType = get<ArrayType>(currentType.getComponentType());
-                        // necessary, because iterator for Arrays is not gc safe
-                        for (std::uint32_t i : llvm::seq(0u, outerArray->size()))
-                        {
-                            // allocation must happen before indexing
-                            ObjectInterface* innerArray = generator(counts, componentType, generator);
-                            (*outerArray)[i] = innerArray;
-                        }
+                        // allocation must happen before indexing
+                        ObjectInterface* innerArray = generator(counts, componentType, generator);
+                        (*outerArray)[i] = innerArray;
                     }
-                    return array;
-                };
+                }
+                return array;
+            };
 
-                context.push(generateArray(counts, get<ArrayType>(classObject->getDescriptor()), generateArray));
+            context.push(generateArray(counts, get<ArrayType>(classObject->getDescriptor()), generateArray));
 
-                return NextPC{};
-            },
-            [&](New newInst)
+            return NextPC{};
+        },
+        [&](New newInst)
+        {
+            ClassObject* classObject = getClassObject(classFile, newInst.index);
+            m_virtualMachine.initialize(*classObject);
+            if (classObject->isInitialized())
             {
-                ClassObject* classObject = getClassObject(classFile, newInst.index);
-                m_virtualMachine.initialize(*classObject);
-                context.push(m_virtualMachine.getGC().allocate(classObject));
-                return NextPC{};
-            },
-            [&](NewArray newArray)
+                quickenInstruction({.kind = QuickenedInstruction::NewInitialized, .classObject = classObject});
+            }
+            context.push(m_virtualMachine.getGC().allocate(classObject));
+            return NextPC{};
+        },
+        [&](NewArray newArray)
+        {
+            auto count = context.pop<std::int32_t>();
+            if (count < 0)
             {
-                auto count = context.pop<std::int32_t>();
-                if (count < 0)
-                {
-                    m_virtualMachine.throwNegativeArraySizeException(count);
-                }
+                m_virtualMachine.throwNegativeArraySizeException(count);
+            }
 
-                ClassObject& arrayType =
-                    m_virtualMachine.getClassLoader().forName(ArrayType{BaseType{newArray.componentType}});
-                auto* array = m_virtualMachine.getGC().allocate<AbstractArray>(&arrayType, count);
-                context.push(array);
-                return NextPC{};
-            },
-            [&](Nop) { return NextPC{}; },
-            [&](Pop)
+            ClassObject& arrayType =
+                m_virtualMachine.getClassLoader().forName(ArrayType{BaseType{newArray.componentType}});
+            auto* array = m_virtualMachine.getGC().allocate<AbstractArray>(&arrayType, count);
+            context.push(array);
+            return NextPC{};
+        },
+        [&](Nop) { return NextPC{}; },
+        [&](Pop)
+        {
+            context.popRaw();
+            return NextPC{};
+        },
+        [&](Pop2)
+        {
+            context.popRaw();
+            context.popRaw();
+            return NextPC{};
+        },
+        [&](PutField putField)
+        {
+            auto [classObject, fieldName, descriptor] = getFieldInfo(classFile, putField.index);
+            const Field* field = classObject->getInstanceField(fieldName, descriptor);
+
+            std::uint64_t value = context.pop(descriptor);
+            auto* object = context.pop<ObjectInterface*>();
+            if (!object)
             {
-                context.popRaw();
-                return NextPC{};
-            },
-            [&](Pop2)
+                m_virtualMachine.throwNullPointerException();
+            }
+
+            std::memcpy(reinterpret_cast<char*>(object) + field->getOffset(), &value, descriptor.sizeOf());
+            return NextPC{};
+        },
+        [&](PutStatic getStatic)
+        {
+            auto [classObject, fieldName, descriptor] = getFieldInfo(classFile, getStatic.index);
+
+            m_virtualMachine.initialize(*classObject);
+            Field* field = classObject->getStaticField(fieldName, descriptor);
+            if (classObject->isInitialized())
             {
-                context.popRaw();
-                context.popRaw();
-                return NextPC{};
-            },
-            [&](PutField putField)
+                quickenInstruction({.kind = QuickenedInstruction::PutStaticInitialized, .field = field});
+            }
+
+            std::uint64_t value = context.pop(descriptor);
+            std::memcpy(field->getAddressOfStatic(), &value, descriptor.sizeOf());
+            return NextPC{};
+        },
+        [&](Ret ret)
+        {
+            std::uint16_t retAddress = context.getLocalRaw(ret.index);
+            return SetPC{retAddress};
+        },
+        [&](Return)
+        {
+            // "Noop" return value for void methods.
+            return ReturnValue{0};
+        },
+        [&](SIPush siPush)
+        {
+            context.push<std::int32_t>(siPush.value);
+            return NextPC{};
+        },
+        [&](Swap)
+        {
+            InterpreterContext::RawValue value1 = context.popRaw();
+            InterpreterContext::RawValue value2 = context.popRaw();
+            context.pushRaw(value1);
+            context.pushRaw(value2);
+            return NextPC{};
+        },
+        [&](const TableSwitch& tableSwitch)
+        {
+            auto index = context.pop<std::int32_t>();
+            if (index < tableSwitch.low || (index - tableSwitch.low) >= tableSwitch.jumpTable.size())
             {
-                auto [classObject, fieldName, descriptor] = getFieldInfo(classFile, putField.index);
-                const Field* field = classObject->getInstanceField(fieldName, descriptor);
+                if (profile)
+                {
+                    profile->recordSwitch(tableSwitch.offset, std::nullopt, tableSwitch.jumpTable.size());
+                }
+                return SetPC{static_cast<std::uint16_t>(tableSwitch.offset + tableSwitch.defaultOffset)};
+            }
+            if (profile)
+            {
+                profile->recordSwitch(tableSwitch.offset, index - tableSwitch.low, tableSwitch.jumpTable.size());
+            }
+            return SetPC{
+                static_cast<std::uint16_t>(tableSwitch.offset + tableSwitch.jumpTable[index - tableSwitch.low])};
+        },
+        [&](Wide wide) -> InstructionResult
+        {
+#define WIDE_LOAD_CASE(op)                                                            \
+case OpCodes::op:                                                                 \
+{                                                                                 \
+    context.push(context.getLocal<InstructionElementType<op>::type>(wide.index)); \
+    break;                                                                        \
+}
 
-                std::uint64_t value = context.pop(descriptor);
-                auto* object = context.pop<ObjectInterface*>();
-                if (!object)
+#define WIDE_STORE_CASE(op)                                                            \
+case OpCodes::op:                                                                  \
+{                                                                                  \
+    context.setLocal(wide.index, context.pop<InstructionElementType<op>::type>()); \
+    break;                                                                         \
+}
+            switch (wide.opCode)
+            {
+                WIDE_LOAD_CASE(ALoad)
+                WIDE_LOAD_CASE(DLoad)
+                WIDE_LOAD_CASE(FLoad)
+                WIDE_LOAD_CASE(ILoad)
+                WIDE_LOAD_CASE(LLoad)
+                WIDE_STORE_CASE(AStore)
+                WIDE_STORE_CASE(DStore)
+                WIDE_STORE_CASE(FStore)
+                WIDE_STORE_CASE(IStore)
+                WIDE_STORE_CASE(LStore)
+                case OpCodes::Ret:
+                {
+                    std::uint16_t retAddress = context.getLocalRaw(wide.index);
+                    return SetPC{retAddress};
+                }
+                case OpCodes::IInc:
                 {
-                    m_virtualMachine.throwNullPointerException();
+                    context.setLocal(wide.index, static_cast<std::int32_t>(*wide.value)
+                                                     + context.getLocal<std::uint32_t>(wide.index));
+                    break;
                 }
+                default: llvm_unreachable("Invalid wide operation");
+            }
+#undef WIDE_LOAD_CASE
+#undef WIDE_STORE_CASE
 
-                std::memcpy(reinterpret_cast<char*>(object) + field->getOffset(), &value, descriptor.sizeOf());
-                return NextPC{};
-            },
-            [&](PutStatic getStatic)
+            return NextPC{};
+        },
+        [&](...) -> InstructionResult
+        {
+            // TODO: Remove this once the interpreter implements all opcodes.
+            llvm_unreachable("NOT YET IMPLEMENTED");
+        });
+
+    // Executes the quickened instruction at the current offset if there is one. Returns an empty optional if the
+    // current instruction should be executed individually instead.
+    auto executeQuickenedInstruction = [&]() -> std::optional<SetPC>
+    {
+        QuickenedInstruction* quickenedInstruction = quickenedCode ? quickenedCode->lookup(offset) : nullptr;
+        if (!quickenedInstruction)
+        {
+            return std::nullopt;
+        }
+
+        switch (quickenedInstruction->kind)
+        {
+            case QuickenedInstruction::ALoadGetField:
             {
-                auto [classObject, fieldName, descriptor] = getFieldInfo(classFile, getStatic.index);
+                if (!quickenedInstruction->field)
+                {
+                    // Resolution may load classes and therefore garbage collect. This is safe as the object is still
+                    // contained in the local variable rather than the C++ stack.
+                    auto [classObject, fieldName, descriptor] =
+                        getFieldInfo(classFile, static_cast<std::uint16_t>(quickenedInstruction->constant));
+                    quickenedInstruction->field = classObject->getInstanceField(fieldName, descriptor);
+                }
 
-                m_virtualMachine.initialize(*classObject);
-                Field* field = classObject->getStaticField(fieldName, descriptor);
+                auto* object = context.getLocal<ObjectInterface*>(quickenedInstruction->locals[0]);
+                if (!object)
+                {
+                    // Let the individual instructions throw the 'NullPointerException'.
+                    return std::nullopt;
+                }
 
-                std::uint64_t value = context.pop(descriptor);
-                std::memcpy(field->getAddressOfStatic(), &value, descriptor.sizeOf());
-                return NextPC{};
-            },
-            [&](Ret ret)
+                const Field* field = quickenedInstruction->field;
+                std::uint64_t value{};
+                std::memcpy(&value, reinterpret_cast<char*>(object) + field->getOffset(), field->getType().sizeOf());
+                context.push(value, field->getType());
+                return SetPC{quickenedInstruction->nextOffset};
+            }
+            case QuickenedInstruction::ILoadILoadIAddIStore:
             {
-                std::uint16_t retAddress = context.getLocalRaw(ret.index).first;
-                return SetPC{retAddress};
-            },
-            [&](Return)
+                context.setLocal(quickenedInstruction->locals[2],
+                                 context.getLocal<std::uint32_t>(quickenedInstruction->locals[0])
+                                     + context.getLocal<std::uint32_t>(quickenedInstruction->locals[1]));
+                return SetPC{quickenedInstruction->nextOffset};
+            }
+            case QuickenedInstruction::IIncGoto:
             {
-                // "Noop" return value for void methods.
-                return ReturnValue{0};
-            },
-            [&](SIPush siPush)
+                context.setLocal(quickenedInstruction->locals[0],
+                                 static_cast<std::uint32_t>(quickenedInstruction->constant)
+                                     + context.getLocal<std::uint32_t>(quickenedInstruction->locals[0]));
+                // Continue as if the 'goto' was executed individually for backedges to be counted and OSR to start
+                // at the 'goto'.
+                offset = quickenedInstruction->lastOffset;
+                return SetPC{quickenedInstruction->nextOffset};
+            }
+            case QuickenedInstruction::ILoadILoadIfICmp:
             {
-                context.push<std::int32_t>(siPush.value);
-                return NextPC{};
-            },
-            [&](Swap)
+                auto lhs = context.getLocal<std::int32_t>(quickenedInstruction->locals[0]);
+                auto rhs = context.getLocal<std::int32_t>(quickenedInstruction->locals[1]);
+                bool taken = false;
+                switch (quickenedInstruction->comparison)
+                {
+                    case QuickenedInstruction::Equal: taken = lhs == rhs; break;
+                    case QuickenedInstruction::NotEqual: taken = lhs != rhs; break;
+                    case QuickenedInstruction::Less: taken = lhs < rhs; break;
+                    case QuickenedInstruction::GreaterEqual: taken = lhs >= rhs; break;
+                    case QuickenedInstruction::Greater: taken = lhs > rhs; break;
+                    case QuickenedInstruction::LessEqual: taken = lhs <= rhs; break;
+                }
+                if (profile)
+                {
+                    profile->recordBranch(quickenedInstruction->lastOffset, taken);
+                }
+                // The branch is always forward, making it unnecessary to count backedges.
+                return SetPC{taken ? static_cast<std::uint16_t>(quickenedInstruction->constant) :
+                                     quickenedInstruction->nextOffset};
+            }
+            case QuickenedInstruction::GetStaticInitialized:
             {
-                InterpreterContext::RawValue value1 = context.popRaw();
-                InterpreterContext::RawValue value2 = context.popRaw();
-                context.pushRaw(value1);
-                context.pushRaw(value2);
-                return NextPC{};
-            },
-            [&](const TableSwitch& tableSwitch)
+                const Field* field = quickenedInstruction->field;
+                std::uint64_t value{};
+                std::memcpy(&value, field->getAddressOfStatic(), field->getType().sizeOf());
+                context.push(value, field->getType());
+                return SetPC{quickenedInstruction->nextOffset};
+            }
+            case QuickenedInstruction::PutStaticInitialized:
             {
-                auto index = context.pop<std::int32_t>();
-                if (index < tableSwitch.low || (index - tableSwitch.low) >= tableSwitch.jumpTable.size())
+                Field* field = quickenedInstruction->field;
+                std::uint64_t value = context.pop(field->getType());
+                std::memcpy(field->getAddressOfStatic(), &value, field->getType().sizeOf());
+                return SetPC{quickenedInstruction->nextOffset};
+            }
+            case QuickenedInstruction::NewInitialized:
+            {
+                context.push(m_virtualMachine.getGC().allocate(quickenedInstruction->classObject));
+                return SetPC{quickenedInstruction->nextOffset};
+            }
+            case QuickenedInstruction::InvokeStaticInitialized:
+            {
+                // Copy everything required as executing Java code may invalidate 'quickenedInstruction'.
+                const Method* callee = quickenedInstruction->callee;
+                std::uint16_t nextOffset = quickenedInstruction->nextOffset;
+
+                // Let the 'invokestatic' instruction request a stackless call.
+                if (m_stacklessCalls && m_virtualMachine.getRuntime().getExecutor(*callee) == this)
                 {
-                    return SetPC{static_cast<std::uint16_t>(tableSwitch.offset + tableSwitch.defaultOffset)};
+                    return std::nullopt;
                 }
-                return SetPC{
-                    static_cast<std::uint16_t>(tableSwitch.offset + tableSwitch.jumpTable[index - tableSwitch.low])};
-            },
-            [&](Wide wide) -> InstructionResult
-            {
-#define WIDE_LOAD_CASE(op)                                                            \
-    case OpCodes::op:                                                                 \
-    {                                                                                 \
-        context.push(context.getLocal<InstructionElementType<op>::type>(wide.index)); \
-        break;                                                                        \
-    }
 
-#define WIDE_STORE_CASE(op)                                                            \
-    case OpCodes::op:                                                                  \
-    {                                                                                  \
-        context.setLocal(wide.index, context.pop<InstructionElementType<op>::type>()); \
-        break;                                                                         \
-    }
-                switch (wide.opCode)
+                if (profile)
                 {
-                    WIDE_LOAD_CASE(ALoad)
-                    WIDE_LOAD_CASE(DLoad)
-                    WIDE_LOAD_CASE(FLoad)
-                    WIDE_LOAD_CASE(ILoad)
-                    WIDE_LOAD_CASE(LLoad)
-                    WIDE_STORE_CASE(AStore)
-                    WIDE_STORE_CASE(DStore)
-                    WIDE_STORE_CASE(FStore)
-                    WIDE_STORE_CASE(IStore)
-                    WIDE_STORE_CASE(LStore)
-                    case OpCodes::Ret:
-                    {
-                        std::uint16_t retAddress = context.getLocalRaw(wide.index).first;
-                        return SetPC{retAddress};
-                    }
-                    case OpCodes::IInc:
-                    {
-                        context.setLocal(wide.index, static_cast<std::int32_t>(*wide.value)
-                                                         + context.getLocal<std::uint32_t>(wide.index));
-                        break;
-                    }
-                    default: llvm_unreachable("Invalid wide operation");
+                    profile->incrementCallCount(offset);
                 }
-#undef WIDE_LOAD_CASE
-#undef WIDE_STORE_CASE
 
-                return NextPC{};
-            },
-            [&](...) -> InstructionResult
+                MethodType descriptor = callee->getType();
+                llvm::ArrayRef<std::uint64_t> arguments = context.viewAndPopArguments(descriptor, /*isStatic=*/true);
+                std::uint64_t returnValue = callee->callInterpreterCC(arguments.data());
+                FieldType returnType = descriptor.returnType();
+                if (returnType != BaseType(BaseType::Void))
+                {
+                    context.push(returnValue, returnType);
+                }
+                return SetPC{nextOffset};
+            }
+            case QuickenedInstruction::LDCReference:
             {
-                // TODO: Remove this once the interpreter implements all opcodes.
-                llvm_unreachable("NOT YET IMPLEMENTED");
-            });
+                context.push(quickenedInstruction->constantRoot.get());
+                return SetPC{quickenedInstruction->nextOffset};
+            }
+        }
+        llvm_unreachable("unknown quickened instruction");
+    };
 
-        if (auto* returnValue = get_if<ReturnValue>(&result))
+    // Alternative index of the previously executed instruction within 'ByteCodeOp'.
+    std::optional<std::size_t> previousIndex;
+    auto recordByteCodePair = [&]
+    {
+        if (!m_byteCodePairCounts)
         {
-            return returnValue->value;
+            return;
         }
+        if (previousIndex)
+        {
+            (*m_byteCodePairCounts)[*previousIndex][operation->index()]++;
+        }
+        previousIndex = operation->index();
+    };
 
+    // Advances 'index' to the next instruction to execute as determined by 'result'.
+    auto advance = [&](const InstructionResult& result)
+    {
         match(
-            result, [](ReturnValue) {}, [&](NextPC) { ++curr; },
+            result, [](ReturnValue) {}, [&](NextPC) { index++; },
             [&](SetPC setPc)
             {
                 // Backedge.
                 if (setPc.newPC < offset)
                 {
+                    if (profile)
+                    {
+                        profile->incrementBackEdgeCount();
+                    }
                     backEdgeCounter++;
                     if (backEdgeCounter == m_backEdgeThreshold)
                     {
                         escapeToJIT();
                     }
                 }
-                curr = ByteCodeIterator(codeArray.data(), setPc.newPC);
+                index = decodedCode.indices[setPc.newPC];
             });
+    };
+
+#ifdef JLLVM_INTERPRETER_THREADED_DISPATCH
+    // Threaded dispatch using labels-as-values. Every handler contains its own copy of the dispatch to the next
+    // instruction, giving the branch predictor one indirect branch per opcode rather than a single shared one.
+    // The table is indexed by the alternative index of the decoded 'ByteCodeOp' and therefore generated in the same
+    // order. No decoding of the bytecode happens during dispatch.
+    static void* const dispatchTable[] = {
+    #define GENERATE_SELECTOR(name, base, body, parser, size, code) &&name##Handler,
+    #define GENERATE_SELECTOR_END(name, base, body, parser, size, code) &&name##Handler
+    #include <jllvm/class/ByteCode.def>
+    };
+
+    InstructionResult result;
+
+    #define DISPATCH()                                                                    \
+        offset = decodedCode.offsets[index];                                              \
+        while (std::optional<SetPC> quickenedResult = executeQuickenedInstruction())      \
+        {                                                                                 \
+            advance(*quickenedResult);                                                    \
+            offset = decodedCode.offsets[index];                                          \
+        }                                                                                 \
+        operation = &decodedCode.ops[index];                                              \
+        recordByteCodePair();                                                             \
+        goto* dispatchTable[operation->index()]
+
+    DISPATCH();
+
+    #define GENERATE_SELECTOR(name, base, body, parser, size, code) \
+        name##Handler:                                              \
+        result = handlers(*get_if<name>(operation));                \
+        if (auto* returnValue = get_if<ReturnValue>(&result))       \
+        {                                                           \
+            return returnValue->value;                              \
+        }                                                           \
+        advance(result);                                            \
+        DISPATCH();
+    #define GENERATE_SELECTOR_END(name, base, body, parser, size, code) \
+        GENERATE_SELECTOR(name, base, body, parser, size, code)
+    #include <jllvm/class/ByteCode.def>
+
+    #undef DISPATCH
+#else
+    while (true)
+    {
+        // Update the current offset to the new instruction.
+        offset = decodedCode.offsets[index];
+        if (std::optional<SetPC> quickenedResult = executeQuickenedInstruction())
+        {
+            advance(*quickenedResult);
+            continue;
+        }
+
+        operation = &decodedCode.ops[index];
+        recordByteCodePair();
+        InstructionResult result = visit(handlers, *operation);
+        if (auto* returnValue = get_if<ReturnValue>(&result))
+        {
+            return returnValue->value;
+        }
+        advance(result);
     }
+#endif
 }
 
 void* Interpreter::getOSREntry(const Method& method, std::uint16_t /*byteCodeOffset*/,
@@ -1544,8 +2244,347 @@ void* Interpreter::getOSREntry(const Method& method, std::uint16_t /*byteCodeOff
     return m_interpreterJITCCOSREntries[get<BaseType>(type).getValue() - BaseType::MinValue];
 }
 
+namespace
+{
+/// Returns the local variable index of 'op' if it is any of the forms of a load or store instruction 'T', where 'T0'
+/// to 'T3' are the forms with an implicit index.
+template <class T, class T0, class T1, class T2, class T3>
+std::optional<std::uint16_t> getLocalIndex(const ByteCodeOp& op)
+{
+    return match(
+        op, [](T t) -> std::optional<std::uint16_t> { return t.index; },
+        [](T0) -> std::optional<std::uint16_t> { return 0; }, [](T1) -> std::optional<std::uint16_t> { return 1; },
+        [](T2) -> std::optional<std::uint16_t> { return 2; }, [](T3) -> std::optional<std::uint16_t> { return 3; },
+        [](...) -> std::optional<std::uint16_t> { return std::nullopt; });
+}
+} // namespace
+
+std::optional<std::pair<Interpreter::QuickenedInstruction, std::size_t>>
+    Interpreter::matchSuperInstruction(llvm::ArrayRef<ByteCodeOp> ops)
+{
+    auto offsetOf = [&](std::size_t index) { return static_cast<std::uint16_t>(getOffset(ops[index])); };
+
+    if (ops.size() >= 3)
+    {
+        std::optional<std::uint16_t> local = getLocalIndex<ALoad, ALoad0, ALoad1, ALoad2, ALoad3>(ops[0]);
+        if (const auto* getField = get_if<GetField>(&ops[1]); local && getField)
+        {
+            return std::pair{QuickenedInstruction{.kind = QuickenedInstruction::ALoadGetField,
+                                              .locals = {*local},
+                                              .constant = getField->index,
+                                              .lastOffset = offsetOf(1),
+                                              .nextOffset = offsetOf(2)},
+                             2};
+        }
+    }
+
+    if (ops.size() >= 5)
+    {
+        std::optional<std::uint16_t> lhs = getLocalIndex<ILoad, ILoad0, ILoad1, ILoad2, ILoad3>(ops[0]);
+        std::optional<std::uint16_t> rhs = getLocalIndex<ILoad, ILoad0, ILoad1, ILoad2, ILoad3>(ops[1]);
+        std::optional<std::uint16_t> result = getLocalIndex<IStore, IStore0, IStore1, IStore2, IStore3>(ops[3]);
+        if (lhs && rhs && holds_alternative<IAdd>(ops[2]) && result)
+        {
+            return std::pair{QuickenedInstruction{.kind = QuickenedInstruction::ILoadILoadIAddIStore,
+                                              .locals = {*lhs, *rhs, *result},
+                                              .lastOffset = offsetOf(3),
+                                              .nextOffset = offsetOf(4)},
+                             4};
+        }
+    }
+
+    if (ops.size() >= 4)
+    {
+        std::optional<std::uint16_t> lhs = getLocalIndex<ILoad, ILoad0, ILoad1, ILoad2, ILoad3>(ops[0]);
+        std::optional<std::uint16_t> rhs = getLocalIndex<ILoad, ILoad0, ILoad1, ILoad2, ILoad3>(ops[1]);
+        using Branch = std::optional<std::pair<QuickenedInstruction::Comparison, std::uint16_t>>;
+        auto branch = [](auto ifICmp, QuickenedInstruction::Comparison comparison) -> Branch
+        { return std::pair{comparison, static_cast<std::uint16_t>(ifICmp.offset + ifICmp.target)}; };
+        Branch ifICmp = match(
+            ops[2], [&](IfICmpEq op) { return branch(op, QuickenedInstruction::Equal); },
+            [&](IfICmpNe op) { return branch(op, QuickenedInstruction::NotEqual); },
+            [&](IfICmpLt op) { return branch(op, QuickenedInstruction::Less); },
+            [&](IfICmpGe op) { return branch(op, QuickenedInstruction::GreaterEqual); },
+            [&](IfICmpGt op) { return branch(op, QuickenedInstruction::Greater); },
+            [&](IfICmpLe op) { return branch(op, QuickenedInstruction::LessEqual); },
+            [](...) -> Branch { return std::nullopt; });
+        // Backward branches are not fused as OSR on the backedge would have to start at the 'if_icmp<cond>'
+        // instruction with both operands on the operand stack.
+        if (lhs && rhs && ifICmp && ifICmp->second > offsetOf(2))
+        {
+            return std::pair{QuickenedInstruction{.kind = QuickenedInstruction::ILoadILoadIfICmp,
+                                              .locals = {*lhs, *rhs},
+                                              .constant = ifICmp->second,
+                                              .comparison = ifICmp->first,
+                                              .lastOffset = offsetOf(2),
+                                              .nextOffset = offsetOf(3)},
+                             3};
+        }
+    }
+
+    if (ops.size() >= 2)
+    {
+        const auto* iInc = get_if<IInc>(&ops[0]);
+        std::optional<std::uint16_t> target = match(
+            ops[1],
+            [](OneOf<Goto, GotoW> gotoInst) -> std::optional<std::uint16_t>
+            { return static_cast<std::uint16_t>(gotoInst.offset + gotoInst.target); },
+            [](...) -> std::optional<std::uint16_t> { return std::nullopt; });
+        if (iInc && target)
+        {
+            return std::pair{QuickenedInstruction{.kind = QuickenedInstruction::IIncGoto,
+                                              .locals = {iInc->index},
+                                              .constant = iInc->byte,
+                                              .lastOffset = offsetOf(1),
+                                              .nextOffset = *target},
+                             2};
+        }
+    }
+
+    return std::nullopt;
+}
+
+Interpreter::DecodedCode& Interpreter::decode(const Method& method)
+{
+    std::unique_ptr<DecodedCode>& decodedCode = m_decodedCode[&method];
+    if (decodedCode)
+    {
+        return *decodedCode;
+    }
+    decodedCode = std::make_unique<DecodedCode>();
+
+    llvm::ArrayRef<char> code = method.getMethodInfo().getAttributes().find<Code>()->getCode();
+    decodedCode->indices.resize(code.size());
+    for (ByteCodeOp op : byteCodeRange(code))
+    {
+        auto offset = static_cast<std::uint16_t>(getOffset(op));
+        decodedCode->indices[offset] = decodedCode->ops.size();
+        decodedCode->offsets.push_back(offset);
+        decodedCode->ops.push_back(op);
+    }
+    decodedCode->offsets.push_back(code.size());
+    return *decodedCode;
+}
+
+Interpreter::QuickenedCode& Interpreter::quicken(const Method& method)
+{
+    std::unique_ptr<QuickenedCode>& quickenedCode = m_quickenedCode[&method];
+    if (quickenedCode)
+    {
+        return *quickenedCode;
+    }
+    quickenedCode = std::make_unique<QuickenedCode>();
+
+    llvm::ArrayRef<ByteCodeOp> ops = decode(method).ops;
+    quickenedCode->indices.resize(method.getMethodInfo().getAttributes().find<Code>()->getCode().size());
+
+    // Super instructions do not overlap. Branches into the middle of a sequence simply execute the remaining
+    // instructions individually.
+    for (std::size_t i = 0; i < ops.size();)
+    {
+        std::optional match = matchSuperInstruction(llvm::ArrayRef(ops).drop_front(i));
+        if (!match)
+        {
+            i++;
+            continue;
+        }
+
+        auto [superInstruction, length] = *match;
+        if (!m_selectedSuperInstructions[superInstruction.kind])
+        {
+            i++;
+            continue;
+        }
+        quickenedCode->add(getOffset(ops[i]), superInstruction);
+        i += length;
+    }
+    return *quickenedCode;
+}
+
+namespace
+{
+/// Names of all instructions indexed by the alternative index within 'ByteCodeOp'.
+constexpr llvm::StringLiteral byteCodeOpNames[] = {
+#define GENERATE_SELECTOR(name, base, body, parser, size, code) #name,
+#define GENERATE_SELECTOR_END(name, base, body, parser, size, code) #name
+#include <jllvm/class/ByteCode.def>
+};
+} // namespace
+
+void Interpreter::dumpByteCodePairHistogram(llvm::raw_ostream& os) const
+{
+    static_assert(std::size(byteCodeOpNames) == NumByteCodeOps);
+
+    std::vector<std::tuple<std::uint64_t, std::size_t, std::size_t>> pairs;
+    for (auto&& [first, counts] : llvm::enumerate(*m_byteCodePairCounts))
+    {
+        for (auto&& [second, count] : llvm::enumerate(counts))
+        {
+            if (count != 0)
+            {
+                pairs.emplace_back(count, first, second);
+            }
+        }
+    }
+    llvm::sort(pairs, std::greater<>{});
+
+    os << "Bytecode pair histogram:\n";
+    for (auto [count, first, second] : pairs)
+    {
+        os << llvm::format_decimal(count, 12) << ' ' << byteCodeOpNames[first] << ' ' << byteCodeOpNames[second]
+           << '\n';
+    }
+}
+
+llvm::Expected<std::bitset<Interpreter::QuickenedInstruction::NumSuperInstructions>>
+    Interpreter::selectSuperInstructions(llvm::StringRef histogram)
+{
+    llvm::StringMap<std::uint64_t> pairCounts;
+    std::uint64_t total = 0;
+    llvm::SmallVector<llvm::StringRef> lines;
+    histogram.split(lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+    for (llvm::StringRef line : lines)
+    {
+        if (line == "Bytecode pair histogram:")
+        {
+            continue;
+        }
+
+        llvm::SmallVector<llvm::StringRef, 3> fields;
+        line.split(fields, ' ', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+        std::uint64_t count;
+        if (fields.size() != 3 || fields[0].getAsInteger(10, count))
+        {
+            return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                           "malformed bytecode pair histogram line '" + line + "'");
+        }
+        pairCounts[(fields[1] + " " + fields[2]).str()] += count;
+        total += count;
+    }
+
+    // Returns how often any instruction in 'first' was followed by any instruction in 'second'.
+    auto count = [&](llvm::ArrayRef<llvm::StringRef> first, llvm::ArrayRef<llvm::StringRef> second)
+    {
+        std::uint64_t result = 0;
+        for (llvm::StringRef lhs : first)
+        {
+            for (llvm::StringRef rhs : second)
+            {
+                result += pairCounts.lookup((lhs + " " + rhs).str());
+            }
+        }
+        return result;
+    };
+
+    llvm::StringRef aLoads[] = {"ALoad", "ALoad0", "ALoad1", "ALoad2", "ALoad3"};
+    llvm::StringRef iLoads[] = {"ILoad", "ILoad0", "ILoad1", "ILoad2", "ILoad3"};
+    llvm::StringRef iStores[] = {"IStore", "IStore0", "IStore1", "IStore2", "IStore3"};
+    llvm::StringRef gotos[] = {"Goto", "GotoW"};
+    llvm::StringRef ifICmps[] = {"IfICmpEq", "IfICmpNe", "IfICmpLt", "IfICmpGe", "IfICmpGt", "IfICmpLe"};
+
+    // Counts of every pair of instructions fused by each super instruction.
+    std::array<llvm::SmallVector<std::uint64_t>, QuickenedInstruction::NumSuperInstructions> superInstructionPairs;
+    superInstructionPairs[QuickenedInstruction::ALoadGetField] = {count(aLoads, {"GetField"})};
+    superInstructionPairs[QuickenedInstruction::ILoadILoadIAddIStore] = {
+        count(iLoads, iLoads), count(iLoads, {"IAdd"}), count({"IAdd"}, iStores)};
+    superInstructionPairs[QuickenedInstruction::IIncGoto] = {count({"IInc"}, gotos)};
+    superInstructionPairs[QuickenedInstruction::ILoadILoadIfICmp] = {count(iLoads, iLoads), count(iLoads, ifICmps)};
+
+    std::bitset<QuickenedInstruction::NumSuperInstructions> result;
+    for (auto&& [kind, pairs] : llvm::enumerate(superInstructionPairs))
+    {
+        assert(!pairs.empty() && "every super instruction must have its pairs listed");
+        result[kind] =
+            total != 0 && llvm::all_of(pairs, [&](std::uint64_t pairCount) { return pairCount * 100 >= total; });
+    }
+    return result;
+}
+
+const Interpreter::ReferenceMap& Interpreter::getReferenceMap(const Method& method, std::uint16_t offset)
+{
+    std::unique_ptr<MethodReferenceMaps>& referenceMaps = m_referenceMaps[&method];
+    if (!referenceMaps)
+    {
+        referenceMaps = computeReferenceMaps(method);
+    }
+    auto iter = referenceMaps->find(offset);
+    // Also checked in release builds, as the garbage collector would otherwise scan the frame using arbitrary masks.
+    if (iter == referenceMaps->end())
+    {
+        llvm::report_fatal_error(llvm::Twine("No reference map for offset ") + llvm::Twine(offset) + " of "
+                                 + method.getClassObject()->getClassName() + "." + method.getName()
+                                 + method.getType().textual());
+    }
+    return iter->second;
+}
+
+std::unique_ptr<Interpreter::MethodReferenceMaps> Interpreter::computeReferenceMaps(const Method& method)
+{
+    auto referenceMaps = std::make_unique<MethodReferenceMaps>();
+
+    // The types of all local variables and operand stack slots are already computed by the type checker used by the
+    // JIT. Reuse it to compute which of these contain references at the start of every instruction.
+    const Code& code = *method.getMethodInfo().getAttributes().find<Code>();
+    ByteCodeTypeChecker checker(m_typeCheckerContext, *method.getClassObject()->getClassFile(), code, method);
+    llvm::DenseMap<std::uint16_t, ByteCodeTypeChecker::TypeInfo> allTypeInfo = checker.checkAndGetAllTypeInfo();
+
+    llvm::Type* reference = referenceType(m_typeCheckerContext);
+    auto isType = [](ByteCodeTypeChecker::JVMType jvmType, auto predicate)
+    { return jvmType.is<llvm::Type*>() && jvmType.get<llvm::Type*>() && predicate(jvmType.get<llvm::Type*>()); };
+    auto isReference = [&](llvm::Type* type) { return type == reference; };
+    auto isWide = [](llvm::Type* type) { return type->isIntegerTy(64) || type->isDoubleTy(); };
+
+    for (auto&& [instructionOffset, typeInfo] : allTypeInfo)
+    {
+        ReferenceMap& referenceMap = (*referenceMaps)[instructionOffset];
+
+        referenceMap.locals.resize(llvm::divideCeil(code.getMaxLocals(), 64));
+        MutableBitArrayRef<> locals(referenceMap.locals.data(), code.getMaxLocals());
+        for (auto&& [index, type] : llvm::enumerate(typeInfo.locals))
+        {
+            locals[index] = isType(type, isReference);
+        }
+
+        // Types of the operand stack always occupy one element in the type checker, while 'long' and 'double' occupy
+        // two slots in the interpreter.
+        referenceMap.operandStack.resize(llvm::divideCeil(code.getMaxStack(), 64));
+        MutableBitArrayRef<> operandStack(referenceMap.operandStack.data(), code.getMaxStack());
+        std::size_t slot = 0;
+        for (ByteCodeTypeChecker::JVMType type : typeInfo.operandStack)
+        {
+            operandStack[slot++] = isType(type, isReference);
+            if (isType(type, isWide))
+            {
+                slot++;
+            }
+        }
+    }
+
+    return referenceMaps;
+}
+
+void Interpreter::materializeGCMasks(InterpreterFrame frame)
+{
+    const ReferenceMap& referenceMap = getReferenceMap(*frame.getMethod(), *frame.getByteCodeOffset());
+
+    // Instructions may have already popped operands from the operand stack when the masks are requested, e.g. during
+    // a call. The remaining operand stack slots are unchanged from the start of the instruction, making it sufficient
+    // to only copy the prefix of the reference map.
+    auto copy = [](const llvm::SmallVector<std::uint64_t>& words, MutableBitArrayRef<> mask)
+    {
+        BitArrayRef<> source(words.data(), mask.size());
+        for (auto&& [dest, isReference] : llvm::zip_equal(mask, source))
+        {
+            dest = isReference;
+        }
+    };
+    copy(referenceMap.locals, frame.getLocalsGCMask());
+    copy(referenceMap.operandStack, frame.getOperandStackGCMask());
+}
+
 OSRState Interpreter::createOSRStateFromInterpreterFrame(InterpreterFrame frame)
 {
+    materializeGCMasks(frame);
     return OSRState(*this, *frame.getByteCodeOffset(),
                     createOSRBuffer(*frame.getMethod(), *frame.getByteCodeOffset(), frame.readLocals(),
                                     frame.getOperandStack(), frame.getLocalsGCMask(), frame.getOperandStackGCMask()));
@@ -1554,6 +2593,19 @@ OSRState Interpreter::createOSRStateFromInterpreterFrame(InterpreterFrame frame)
 OSRState Interpreter::createOSRStateForExceptionHandler(JavaFrame frame, std::uint16_t handlerOffset,
                                                         Throwable* throwable)
 {
+    if (frame.isInlined())
+    {
+        auto operandStackGCMask = std::initializer_list<std::uint64_t>{0b1};
+        return createOSRStateForInlinedFrame(
+            frame, handlerOffset,
+            /*operandStack=*/std::initializer_list<std::uint64_t>{reinterpret_cast<std::uint64_t>(throwable)},
+            BitArrayRef(data(operandStackGCMask), 1));
+    }
+
+    if (std::optional interpreterFrame = llvm::dyn_cast<InterpreterFrame>(frame))
+    {
+        materializeGCMasks(*interpreterFrame);
+    }
     llvm::SmallVector<std::uint64_t> localsGcMask = frame.readLocalsGCMask();
     auto operandStackGCMask = std::initializer_list<std::uint64_t>{0b1};
     return OSRState(
@@ -1565,27 +2617,108 @@ OSRState Interpreter::createOSRStateForExceptionHandler(JavaFrame frame, std::ui
             BitArrayRef(data(operandStackGCMask), operandStackGCMask.size() * 64)));
 }
 
+OSRState Interpreter::createOSRStateForDeoptimization(JavaFrame frame)
+{
+    if (frame.isInlined())
+    {
+        llvm::SmallVector<std::uint64_t> operandStack = frame.readOperandStack();
+        llvm::SmallVector<std::uint64_t> operandStackGCMask = frame.readOperandStackGCMask();
+        return createOSRStateForInlinedFrame(frame, *frame.getByteCodeOffset(), operandStack,
+                                             BitArrayRef(operandStackGCMask.data(), operandStack.size()));
+    }
+
+    llvm::SmallVector<std::uint64_t> locals = frame.readLocals();
+    llvm::SmallVector<std::uint64_t> operandStack = frame.readOperandStack();
+    llvm::SmallVector<std::uint64_t> localsGCMask = frame.readLocalsGCMask();
+    llvm::SmallVector<std::uint64_t> operandStackGCMask = frame.readOperandStackGCMask();
+    return OSRState(*this, *frame.getByteCodeOffset(),
+                    createOSRBuffer(*frame.getMethod(), *frame.getByteCodeOffset(), locals, operandStack,
+                                    BitArrayRef(localsGCMask.data(), locals.size()),
+                                    BitArrayRef(operandStackGCMask.data(), operandStack.size())));
+}
+
 std::unique_ptr<std::uint64_t[]> Interpreter::createOSRBuffer(const Method& method, std::uint16_t byteCodeOffset,
                                                               llvm::ArrayRef<std::uint64_t> locals,
                                                               llvm::ArrayRef<std::uint64_t> operandStack,
                                                               BitArrayRef<> localsGCMask,
-                                                              BitArrayRef<> operandStackGCMask)
+                                                              BitArrayRef<> operandStackGCMask,
+                                                              StacklessFrame* stacklessFrames)
 {
     std::size_t numLocals = llvm::size(locals);
     std::size_t numOperandStack = llvm::size(operandStack);
 
     auto buffer = std::make_unique<std::uint64_t[]>(2 + numLocals + numOperandStack + localsGCMask.numWords()
-                                                    + operandStackGCMask.numWords());
+                                                    + operandStackGCMask.numWords() + 1);
     buffer[0] = reinterpret_cast<std::uintptr_t>(&method);
     buffer[1] = byteCodeOffset | numOperandStack << 16;
 
     auto* outIter = llvm::copy(locals, std::next(buffer.get(), 2));
     outIter = llvm::copy(operandStack, outIter);
     outIter = std::copy_n(localsGCMask.words_begin(), localsGCMask.numWords(), outIter);
-    std::copy_n(operandStackGCMask.words_begin(), operandStackGCMask.numWords(), outIter);
+    outIter = std::copy_n(operandStackGCMask.words_begin(), operandStackGCMask.numWords(), outIter);
+    *outIter = reinterpret_cast<std::uintptr_t>(stacklessFrames);
     return buffer;
 }
 
+StacklessFrame* Interpreter::createHeapStacklessFrame(const Method& method, std::uint16_t byteCodeOffset,
+                                                      llvm::ArrayRef<std::uint64_t> locals,
+                                                      llvm::ArrayRef<std::uint64_t> operandStack,
+                                                      BitArrayRef<> localsGCMask, BitArrayRef<> operandStackGCMask,
+                                                      StacklessFrame* caller)
+{
+    StacklessRecord* record = constructStacklessRecord(new std::uint64_t[getStacklessFrameWords(method)], method);
+    record->byteCodeOffset = byteCodeOffset;
+    record->topOfStack = operandStack.size();
+    record->caller = caller;
+    llvm::copy(locals, record->localVariables);
+    llvm::copy(operandStack, record->operandStack);
+    std::copy_n(localsGCMask.words_begin(), localsGCMask.numWords(), record->localVariablesGCMask);
+    std::copy_n(operandStackGCMask.words_begin(), operandStackGCMask.numWords(), record->operandGCMask);
+    return record;
+}
+
+OSRState Interpreter::createOSRStateForInlinedFrame(JavaFrame frame, std::uint16_t byteCodeOffset,
+                                                    llvm::ArrayRef<std::uint64_t> operandStack,
+                                                    BitArrayRef<> operandStackGCMask)
+{
+    auto createFrame = [](JavaFrame javaFrame, std::uint16_t offset, llvm::ArrayRef<std::uint64_t> operands,
+                          BitArrayRef<> operandsGCMask, StacklessFrame* caller)
+    {
+        llvm::SmallVector<std::uint64_t> locals = javaFrame.readLocals();
+        llvm::SmallVector<std::uint64_t> localsGCMask = javaFrame.readLocalsGCMask();
+        return createHeapStacklessFrame(*javaFrame.getMethod(), offset, locals, operands,
+                                        BitArrayRef(localsGCMask.data(), locals.size()), operandsGCMask, caller);
+    };
+
+    // The inlined callers of 'frame' continue after their call once their callee returns, with the arguments of the
+    // call already popped from their operand stack.
+    llvm::SmallVector<JavaFrame> callers;
+    for (JavaFrame iter = frame.getInlinedCaller(); iter.isInlined(); iter = iter.getInlinedCaller())
+    {
+        callers.push_back(iter);
+    }
+
+    StacklessFrame* stacklessFrames = nullptr;
+    for (JavaFrame caller : llvm::reverse(callers))
+    {
+        llvm::SmallVector<std::uint64_t> operands = caller.readOperandStack();
+        llvm::SmallVector<std::uint64_t> operandsGCMask = caller.readOperandStackGCMask();
+        stacklessFrames = createFrame(caller, *caller.getByteCodeOffset(), operands,
+                                      BitArrayRef(operandsGCMask.data(), operands.size()), stacklessFrames);
+    }
+    stacklessFrames = createFrame(frame, byteCodeOffset, operandStack, operandStackGCMask, stacklessFrames);
+
+    JavaFrame outermost = frame.getOutermostFrame();
+    llvm::SmallVector<std::uint64_t> locals = outermost.readLocals();
+    llvm::SmallVector<std::uint64_t> operands = outermost.readOperandStack();
+    llvm::SmallVector<std::uint64_t> localsGCMask = outermost.readLocalsGCMask();
+    llvm::SmallVector<std::uint64_t> operandsGCMask = outermost.readOperandStackGCMask();
+    return OSRState(*this, *outermost.getByteCodeOffset(),
+                    createOSRBuffer(*outermost.getMethod(), *outermost.getByteCodeOffset(), locals, operands,
+                                    BitArrayRef(localsGCMask.data(), locals.size()),
+                                    BitArrayRef(operandsGCMask.data(), operands.size()), stacklessFrames));
+}
+
 void Interpreter::add(const Method& method)
 {
     llvm::cantFail(m_compiled2InterpreterLayer.add(m_jit2InterpreterSymbols, &method));
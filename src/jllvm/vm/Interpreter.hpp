@@ -13,13 +13,23 @@
 
 #pragma once
 
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/LLVMContext.h>
+
 #include <jllvm/class/ByteCodeIterator.hpp>
+#include <jllvm/gc/RootFreeList.hpp>
 #include <jllvm/materialization/JIT2InterpreterLayer.hpp>
 #include <jllvm/object/ClassObject.hpp>
+#include <jllvm/object/MethodProfile.hpp>
 #include <jllvm/support/BitArrayRef.hpp>
 #include <jllvm/support/Bytes.hpp>
 
+#include <bitset>
 #include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
 
 #include "OSRState.hpp"
 #include "Runtime.hpp"
@@ -48,42 +58,21 @@ concept InterpreterValue =
 
 /// Context used in the execution of one Java frame. It incorporates and contains convenience methods for interacting
 /// with local variables and the operand stack.
+/// Note that the context does not keep track of which operand stack slots or local variables contain Java references.
+/// These are instead lazily computed from the bytecode when required, see 'Interpreter::materializeGCMasks'.
 class InterpreterContext
 {
     std::uint16_t& m_topOfStack;
     std::uint64_t* m_operandStack;
-    std::uint64_t* m_operandGCMask;
     std::uint64_t* m_localVariables;
-    std::uint64_t* m_localVariableGCMask;
-
-    /// Returns true if 'T' is a reference to the Java heap.
-    template <InterpreterValue T>
-    constexpr static bool isReference()
-    {
-        return !InterpreterPrimitive<T>;
-    }
-
-    /// Sets the corresponding bit in 'mask' at index to 'value'.
-    static void setMaskBit(std::uint64_t* mask, std::size_t index, bool value)
-    {
-        // While we cannot permanently keep around a 'MutableBitArrayRef' unless wastefully storing the size,
-        // we can reuse its dereferencing implementation with a proper upper bound.
-        MutableBitArrayRef(mask, index + 1)[index] = value;
-    }
 
 public:
     /// Creates a new 'InterpreterContext' from the given parameters. 'topOfStack' is a reference that is always kept
-    /// up to date as the current top of stack. The two 'gc' mask parameters are used as bitsets and have their "i"th
-    /// bit always set to true if the corresponding operand stack slot or local variable contains a Java reference.
+    /// up to date as the current top of stack.
     /// All the pointers passed here are not taken ownership of and must be allocated externally and valid while the
     /// 'InterpreterContext' is still in use.
-    InterpreterContext(std::uint16_t& topOfStack, std::uint64_t* operandStack, std::uint64_t* operandGCMask,
-                       std::uint64_t* localVariables, std::uint64_t* localVariableGCMask)
-        : m_topOfStack(topOfStack),
-          m_operandStack(operandStack),
-          m_operandGCMask(operandGCMask),
-          m_localVariables(localVariables),
-          m_localVariableGCMask(localVariableGCMask)
+    InterpreterContext(std::uint16_t& topOfStack, std::uint64_t* operandStack, std::uint64_t* localVariables)
+        : m_topOfStack(topOfStack), m_operandStack(operandStack), m_localVariables(localVariables)
     {
     }
 
@@ -91,59 +80,52 @@ public:
     template <InterpreterValue T>
     void push(T value)
     {
-        pushRaw(llvm::bit_cast<NextSizedUInt<T>>(value), isReference<T>());
+        pushRaw(llvm::bit_cast<NextSizedUInt<T>>(value));
         if constexpr (InterpreterClass2<T>)
         {
             // "overwrite" the operand stack after as well.
-            pushRaw(0, isReference<T>());
+            pushRaw(0);
         }
     }
 
     /// Pushes a value of the type give by 'descriptor' to the operand stack.
     void push(std::uint64_t value, FieldType descriptor)
     {
-        pushRaw(value, descriptor.isReference());
+        pushRaw(value);
         if (descriptor.isWide())
         {
-            pushRaw(0, descriptor.isReference());
+            pushRaw(0);
         }
     }
 
+    /// A raw value of an operand stack slot or local variable.
+    using RawValue = std::uint64_t;
+
     /// Pushes the value into the top operand stack slot.
     /// This method operates on operand slots rather than 'InterpreterValue' as 'push' does.
     /// This notably has different behaviour for types such as 'long' or 'double'.
-    void pushRaw(std::uint64_t value, bool isReference)
+    void pushRaw(RawValue value)
     {
-        m_operandStack[m_topOfStack] = value;
-        setMaskBit(m_operandGCMask, m_topOfStack, isReference);
-        m_topOfStack++;
+        m_operandStack[m_topOfStack++] = value;
     }
 
-    /// A raw value consisting of the value and a boolean denoting whether the type is a reference type.
-    using RawValue = std::pair<std::uint64_t, bool>;
-
-    /// Pushes a raw value pair of type 'T' to the operand stack.
+    /// Pushes a raw value of type 'T' to the operand stack.
     template <InterpreterValue T>
-    void pushAsRaw(RawValue pair)
+    void pushAsRaw(RawValue value)
     {
-        pushRaw(pair);
+        pushRaw(value);
         if constexpr (InterpreterClass2<T>)
         {
             // "overwrite" the operand stack after as well.
-            pushRaw(0, pair.second);
+            pushRaw(0);
         }
     }
 
-    void pushRaw(RawValue pair)
-    {
-        pushRaw(pair.first, pair.second);
-    }
-
     /// Pops the top value of type 'T' from the operand stack.
     template <InterpreterValue T>
     T pop()
     {
-        return llvm::bit_cast<T>(static_cast<NextSizedUInt<T>>(popAsRaw<T>().first));
+        return llvm::bit_cast<T>(static_cast<NextSizedUInt<T>>(popAsRaw<T>()));
     }
 
     /// Pops the top value of the type given by 'descriptor' from the operand stack.
@@ -153,10 +135,10 @@ public:
         {
             popRaw();
         }
-        return popRaw().first;
+        return popRaw();
     }
 
-    /// Pops the top value of type 'T' as a raw value pair from the operand stack.
+    /// Pops the top value of type 'T' as a raw value from the operand stack.
     template <InterpreterValue T>
     RawValue popAsRaw()
     {
@@ -171,9 +153,13 @@ public:
     RawValue popRaw()
     {
         assert(m_topOfStack != 0 && "bottom of stack already reached");
-        bool isReference = BitArrayRef(m_operandGCMask, m_topOfStack)[--m_topOfStack];
-        std::uint64_t copy = m_operandStack[m_topOfStack];
-        return {copy, isReference};
+        return m_operandStack[--m_topOfStack];
+    }
+
+    /// Pops all values from the operand stack.
+    void clearOperandStack()
+    {
+        m_topOfStack = 0;
     }
 
     /// Sets the local 'index' to the given 'value'.
@@ -181,25 +167,12 @@ public:
     void setLocal(std::uint16_t index, T value)
     {
         std::memcpy(m_localVariables + index, &value, sizeof(T));
-        setMaskBit(m_localVariableGCMask, index, isReference<T>());
-        if constexpr (InterpreterClass2<T>)
-        {
-            // overwrite local variable after.
-            setMaskBit(m_localVariableGCMask, index + 1, isReference<T>());
-        }
     }
 
-    /// Sets the local 'index' to the given raw value pair.
-    template <InterpreterValue T>
-    void setLocalAsRaw(std::uint16_t index, RawValue pair)
+    /// Sets the local 'index' to the given raw value.
+    void setLocalAsRaw(std::uint16_t index, RawValue value)
     {
-        m_localVariables[index] = pair.first;
-        setMaskBit(m_localVariableGCMask, index, pair.second);
-        if constexpr (InterpreterClass2<T>)
-        {
-            // overwrite local variable after.
-            setMaskBit(m_localVariableGCMask, index + 1, pair.second);
-        }
+        m_localVariables[index] = value;
     }
 
     /// Gets the value of the local 'index' and interprets it as 'T'.
@@ -211,12 +184,10 @@ public:
         return result;
     }
 
-    /// Gets the raw value pair of the local 'index'.
+    /// Gets the raw value of the local 'index'.
     RawValue getLocalRaw(std::uint16_t index) const
     {
-        bool isReference = BitArrayRef(m_localVariableGCMask, index + 1)[index];
-        std::uint64_t copy = m_localVariables[index];
-        return {copy, isReference};
+        return m_localVariables[index];
     }
 
     /// Pops arguments from the stack matching a call to a possibly static method of type 'methodType'.
@@ -242,12 +213,63 @@ public:
     }
 };
 
+/// LIFO allocator for the memory of stackless frames. Memory is allocated in chunks that are never moved, keeping all
+/// frames at stable addresses while further frames are allocated.
+class StacklessFrameStack
+{
+    struct Chunk
+    {
+        std::unique_ptr<std::uint64_t[]> memory;
+        std::size_t size;
+    };
+
+    constexpr static std::size_t ChunkSize = 1 << 16;
+
+    std::vector<Chunk> m_chunks;
+    std::size_t m_currentChunk = 0;
+    std::size_t m_used = 0;
+
+public:
+    /// Position within the stack all allocations made after it can be freed up to.
+    struct Mark
+    {
+        std::size_t chunk;
+        std::size_t used;
+    };
+
+    /// Returns the current position within the stack.
+    Mark mark() const
+    {
+        return {m_currentChunk, m_used};
+    }
+
+    /// Frees all allocations made since 'mark' was returned by 'mark()'.
+    void release(Mark mark)
+    {
+        m_currentChunk = mark.chunk;
+        m_used = mark.used;
+    }
+
+    /// Allocates 'words' many uninitialized words.
+    std::uint64_t* allocate(std::size_t words);
+};
+
 /// Interpreter instance containing all global state of the interpreter.
 class Interpreter : public OSRTarget
 {
     VirtualMachine& m_virtualMachine;
     /// Number of backedges before the Interpreter performs OSR into the JIT.
     std::uint64_t m_backEdgeThreshold;
+    /// Number of invocations of a method before the Interpreter requests its compilation by the JIT.
+    std::uint64_t m_invocationThreshold;
+    /// Whether the interpreter records a 'MethodProfile' for every method it executes.
+    bool m_profilingEnabled;
+    /// Whether the operand stack and local variables are zero-initialized when entering the interpreter.
+    bool m_zeroFrames;
+    /// Whether calls from the interpreter to methods executed by the interpreter push stackless frames instead of
+    /// calling the method natively.
+    bool m_stacklessCalls;
+    llvm::SpecificBumpPtrAllocator<MethodProfile> m_profileAllocator;
 
     /// Single entry for use in 'm_interpreterCCSymbols' as an implementation for ALL methods.
     std::uint64_t (*m_interpreterEntry)(const Method*, const std::uint64_t*){};
@@ -258,11 +280,222 @@ class Interpreter : public OSRTarget
     /// OSR Entries for frames with JIT calling convention returning a base type.
     std::array<void*, (BaseType::MaxValue - BaseType::MinValue) + 1> m_interpreterJITCCOSREntries{};
 
+    /// Map of operand stack slots and local variables containing Java references at a given bytecode offset.
+    struct ReferenceMap
+    {
+        llvm::SmallVector<std::uint64_t> locals;
+        llvm::SmallVector<std::uint64_t> operandStack;
+    };
+
+    /// Reference maps of a method at the start of every instruction, keyed by bytecode offset.
+    using MethodReferenceMaps = llvm::DenseMap<std::uint16_t, ReferenceMap>;
+
+    /// Context used to type check methods when computing reference maps.
+    llvm::LLVMContext m_typeCheckerContext;
+    /// Reference maps of all methods whose frames were inspected so far. Allocated separately to remain valid while
+    /// the map grows.
+    llvm::DenseMap<const Method*, std::unique_ptr<MethodReferenceMaps>> m_referenceMaps;
+
+    /// Bytecode of a method decoded once into a sequence of 'ByteCodeOp's. The interpreter dispatches on the decoded
+    /// instructions, avoiding decoding the instruction at the current offset on every execution.
+    struct DecodedCode
+    {
+        /// Index into 'ops' for every bytecode offset starting an instruction. Unspecified for all other offsets.
+        std::vector<std::uint16_t> indices;
+        std::vector<ByteCodeOp> ops;
+        /// Bytecode offset of every instruction in 'ops' followed by the size of the bytecode.
+        std::vector<std::uint16_t> offsets;
+    };
+
+    /// Decoded code of all methods executed so far. Allocated separately to remain valid while the map grows.
+    llvm::DenseMap<const Method*, std::unique_ptr<DecodedCode>> m_decodedCode;
+
+    /// Results of the resolution and selection of a call site within a method.
+    struct CallSiteCache
+    {
+        /// Class object referred to by the call instruction or null if not yet loaded.
+        ClassObject* classObject{};
+        /// Method resolved by the call instruction or null if not yet resolved.
+        const Method* resolvedMethod{};
+        /// Class object of the receiver seen by the last executed virtual or interface call and the method selected
+        /// for it.
+        const ClassObject* receiverClass{};
+        const Method* selectedMethod{};
+    };
+
+    /// Call site caches of all call instructions executed so far.
+    llvm::DenseMap<std::pair<const Method*, std::uint16_t>, CallSiteCache> m_callSiteCaches;
+
+    /// Instruction or sequence of instructions replaced by a faster variant during quickening.
+    ///
+    /// Sequences of instructions are fused into super instructions when a method is first executed. Intermediate
+    /// values of the sequence are kept in local variables of 'executeFrame' rather than being pushed to the operand
+    /// stack, caching the top of the operand stack in registers for the duration of the sequence. The sequences were
+    /// chosen based on the bytecode pair histogram, see 'dumpByteCodePairHistogram'. Which of them are used can be
+    /// selected based on a histogram of the workload, see 'selectSuperInstructions'.
+    ///
+    /// Instructions requiring class initialization are replaced once the class is initialized, making any later
+    /// execution skip both the class lookup and the initialization check.
+    struct QuickenedInstruction
+    {
+        enum Kind : std::uint8_t
+        {
+            /// Any form of 'aload' followed by 'getfield'.
+            ALoadGetField,
+            /// Any forms of 'iload', 'iload', 'iadd' and 'istore' in sequence.
+            ILoadILoadIAddIStore,
+            /// 'iinc' followed by 'goto' or 'goto_w'.
+            IIncGoto,
+            /// Any forms of 'iload', 'iload' and a forward 'if_icmp<cond>' in sequence.
+            ILoadILoadIfICmp,
+            /// 'getstatic' of a field within an initialized class.
+            GetStaticInitialized,
+            /// 'putstatic' of a field within an initialized class.
+            PutStaticInitialized,
+            /// 'new' of an initialized class.
+            NewInitialized,
+            /// 'invokestatic' of a method within an initialized class.
+            InvokeStaticInitialized,
+            /// 'ldc' or 'ldc_w' of a resolved 'String' or 'Class' constant.
+            LDCReference,
+        };
+
+        /// Number of kinds that are super instructions. These are all kinds prior to 'GetStaticInitialized'.
+        constexpr static std::size_t NumSuperInstructions = GetStaticInitialized;
+
+        /// Condition of an 'if_icmp<cond>' instruction.
+        enum Comparison : std::uint8_t
+        {
+            Equal,
+            NotEqual,
+            Less,
+            GreaterEqual,
+            Greater,
+            LessEqual,
+        };
+
+        Kind kind;
+        /// Local variable indices used by the instructions in the order they appear.
+        std::array<std::uint16_t, 3> locals{};
+        /// Pool index of the 'getfield' instruction, increment of the 'iinc' instruction or the branch target of the
+        /// 'if_icmp<cond>' instruction.
+        std::int32_t constant{};
+        Comparison comparison{};
+        /// Offset of the last instruction in the sequence.
+        std::uint16_t lastOffset{};
+        /// Offset of the instruction executed after the sequence.
+        std::uint16_t nextOffset{};
+        /// Field accessed by the instruction or null if not yet resolved.
+        Field* field{};
+        /// Class object instantiated by 'new'.
+        ClassObject* classObject{};
+        /// Method called by 'invokestatic'.
+        const Method* callee{};
+        /// Constant loaded by 'ldc'.
+        GCRootRef<ObjectInterface> constantRoot;
+    };
+
+    /// Result of quickening the bytecode of a method. Quickened instructions are kept in a side table as the bytecode
+    /// within the class file is shared with the JIT and must not be modified.
+    struct QuickenedCode
+    {
+        /// One plus the index into 'instructions' for every bytecode offset starting a quickened instruction and zero
+        /// for all other offsets.
+        std::vector<std::uint16_t> indices;
+        std::vector<QuickenedInstruction> instructions;
+
+        /// Returns the quickened instruction starting at 'offset' or null if there is none.
+        /// Note: The pointer is invalidated by 'add'.
+        QuickenedInstruction* lookup(std::uint16_t offset)
+        {
+            std::uint16_t index = indices[offset];
+            return index ? &instructions[index - 1] : nullptr;
+        }
+
+        /// Replaces the instruction at 'offset' with 'instruction'. Offsets already quickened reuse their slot.
+        /// New offsets are not quickened once 'indices' is unable to refer to any further instructions.
+        void add(std::uint16_t offset, const QuickenedInstruction& instruction)
+        {
+            if (std::uint16_t index = indices[offset])
+            {
+                instructions[index - 1] = instruction;
+                return;
+            }
+            if (instructions.size() >= std::numeric_limits<std::uint16_t>::max())
+            {
+                return;
+            }
+            instructions.push_back(instruction);
+            indices[offset] = instructions.size();
+        }
+    };
+
+    /// Resolved 'String' and 'Class' constants loaded by 'ldc' instructions, keyed by the class file and the constant
+    /// pool index. The constants are stored in static roots of the garbage collector to remain valid across
+    /// garbage collections.
+    llvm::DenseMap<std::pair<const ClassFile*, std::uint16_t>, GCRootRef<ObjectInterface>> m_ldcConstants;
+
+    /// Quickened code of all methods executed so far. Allocated separately to remain valid while the map grows.
+    llvm::DenseMap<const Method*, std::unique_ptr<QuickenedCode>> m_quickenedCode;
+
+    constexpr static std::size_t NumByteCodeOps = swl::variant_size_v<ByteCodeOp>;
+
+    /// Number of times any two instructions were executed in sequence, indexed by the alternative index within
+    /// 'ByteCodeOp' of both instructions. Null unless the histogram should be dumped.
+    std::unique_ptr<std::array<std::array<std::uint64_t, NumByteCodeOps>, NumByteCodeOps>> m_byteCodePairCounts;
+
+    /// Super instructions used when quickening, indexed by 'QuickenedInstruction::Kind'.
+    std::bitset<QuickenedInstruction::NumSuperInstructions> m_selectedSuperInstructions;
+
     llvm::orc::JITDylib& m_jit2InterpreterSymbols;
     llvm::orc::JITDylib& m_interpreterCCSymbols;
 
     JIT2InterpreterLayer m_compiled2InterpreterLayer;
 
+    /// State of a stackless frame that is private to the interpreter.
+    struct StacklessRecord : StacklessFrame
+    {
+        std::uint64_t backEdgeCounter;
+        /// Position of the frame stack prior to allocating this frame.
+        StacklessFrameStack::Mark mark;
+    };
+
+    /// Memory of all stackless frames.
+    StacklessFrameStack m_stacklessFrameStack;
+
+    /// Call to be performed by pushing a stackless frame, as requested by an invoke instruction in 'executeFrame'.
+    struct StacklessCall
+    {
+        const Method* callee{};
+        /// View of the arguments on the caller's operand stack. See 'InterpreterContext::viewAndPopArguments'.
+        llvm::ArrayRef<std::uint64_t> arguments;
+    };
+
+    /// C++ exception thrown to transfer control to a frame of an 'executeMethod' activation further up the native
+    /// stack that executes stackless frames. Caught and handled by the activation.
+    struct StacklessTransfer
+    {
+        enum Kind
+        {
+            /// Continue 'target' at 'handlerOffset' with 'throwable' as the only value on its operand stack.
+            ExceptionHandler,
+            /// Replace 'target' with an OSR version using 'm_stacklessOSRState'.
+            OnStackReplacement,
+        };
+
+        Kind kind;
+        /// Chain of stackless frames of the activation. Identifies the activation.
+        StacklessFrame** activation;
+        /// Frame to transfer control to or null for the frame the activation was called for.
+        StacklessFrame* target;
+        std::uint16_t handlerOffset{};
+        Throwable* throwable{};
+    };
+
+    /// OSR state used by a 'StacklessTransfer::OnStackReplacement' transfer. Kept outside the C++ exception as
+    /// exceptions must be copyable.
+    std::optional<OSRState> m_stacklessOSRState;
+
     /// Returns the class object referred to by 'index' within 'classFile', loading it if necessary.
     ClassObject* getClassObject(const ClassFile& classFile, PoolIndex<ClassInfo> index);
 
@@ -273,20 +506,98 @@ class Interpreter : public OSRTarget
                                                                       PoolIndex<FieldRefInfo> index);
 
     /// Replaces the current interpreter frame with a compiled frame. This should only be called from within
-    /// 'executeMethod' when called from the 'jllvm_interpreter' implementation in 'VirtualMachine'.
+    /// 'executeMethod' when called from the 'jllvm_interpreter' implementation in 'VirtualMachine'. Stackless frames
+    /// are replaced by the 'executeMethod' activation executing them.
     [[noreturn]] void escapeToJIT();
 
+    /// Creates the buffer used to enter the OSR version of 'method' at 'byteCodeOffset'. 'stacklessFrames' is an
+    /// optional chain of stackless frames created by 'createHeapStacklessFrame' that are continued as callees of the
+    /// frame. The OSR version takes ownership of the chain.
     static std::unique_ptr<std::uint64_t[]> createOSRBuffer(const Method& method, std::uint16_t byteCodeOffset,
                                                             llvm::ArrayRef<std::uint64_t> locals,
                                                             llvm::ArrayRef<std::uint64_t> operandStack,
                                                             BitArrayRef<> localsGCMask,
-                                                            BitArrayRef<> operandStackGCMask);
+                                                            BitArrayRef<> operandStackGCMask,
+                                                            StacklessFrame* stacklessFrames = nullptr);
+
+    /// Creates a stackless frame of 'method' on the heap continuing at 'byteCodeOffset' with the given local
+    /// variables and operand stack. 'caller' is the next frame in the chain. The frame must be freed using 'delete[]'
+    /// on its address cast to 'std::uint64_t*'.
+    static StacklessFrame* createHeapStacklessFrame(const Method& method, std::uint16_t byteCodeOffset,
+                                                    llvm::ArrayRef<std::uint64_t> locals,
+                                                    llvm::ArrayRef<std::uint64_t> operandStack,
+                                                    BitArrayRef<> localsGCMask, BitArrayRef<> operandStackGCMask,
+                                                    StacklessFrame* caller);
+
+    /// Creates an 'OSRState' replacing the native frame of the method inlined into JITted code 'frame'. The outermost
+    /// method of the native frame and all inlined methods up to and including 'frame' are continued as stackless
+    /// frames. 'frame' itself continues at 'byteCodeOffset' with the given operand stack, while all its callers
+    /// continue after the call they are executing.
+    OSRState createOSRStateForInlinedFrame(JavaFrame frame, std::uint16_t byteCodeOffset,
+                                           llvm::ArrayRef<std::uint64_t> operandStack,
+                                           BitArrayRef<> operandStackGCMask);
 
     /// Method called to start executing 'method' at the given 'offset' with the given 'context'. Both the context and
     /// offset are kept up-to-date during execution with the current local variables, operand stack and offset being
-    /// executed.
+    /// executed. If stackless calls are enabled, the frames of any callees executed by the interpreter are pushed to
+    /// 'stacklessFrames' and executed within the same activation.
     /// Returns the result of the method bitcast to an uint64_t.
-    std::uint64_t executeMethod(const Method& method, std::uint16_t& offset, InterpreterContext& context);
+    std::uint64_t executeMethod(const Method& method, std::uint16_t& offset, InterpreterContext& context,
+                                StacklessFrame*& stacklessFrames);
+
+    /// Executes a single frame of 'method' as described by 'executeMethod'. 'backEdgeCounter' is the number of
+    /// backedges taken by the frame so far. If the frame requests a call to be performed as a stackless frame,
+    /// 'stacklessCall' is set and the returned value should be ignored. The frame is resumed after the call
+    /// instruction once the callee returns.
+    std::uint64_t executeFrame(const Method& method, std::uint16_t& offset, InterpreterContext& context,
+                               std::uint64_t& backEdgeCounter, StacklessCall& stacklessCall);
+
+    /// Returns the number of words required by a stackless frame of 'method' including its local variables, operand
+    /// stack and their GC masks.
+    static std::size_t getStacklessFrameWords(const Method& method);
+
+    /// Constructs the record of a stackless frame of 'method' at the start of 'memory', which must be
+    /// 'getStacklessFrameWords(method)' words large. The local variables, operand stack and GC masks are placed after
+    /// the record and are left uninitialized.
+    static StacklessRecord* constructStacklessRecord(std::uint64_t* memory, const Method& method);
+
+    /// Pushes a new stackless frame calling 'callee' with 'arguments' to 'stacklessFrames'.
+    void pushStacklessFrame(StacklessFrame*& stacklessFrames, const Method& callee,
+                            llvm::ArrayRef<std::uint64_t> arguments);
+
+    /// Pushes a copy of the stackless frame 'state' to 'stacklessFrames'. 'state' must have been constructed by
+    /// 'constructStacklessRecord'.
+    void pushStacklessFrame(StacklessFrame*& stacklessFrames, const StacklessFrame& state);
+
+    /// Pops the innermost stackless frame from 'stacklessFrames'.
+    void popStacklessFrame(StacklessFrame*& stacklessFrames);
+
+    /// Returns the super instruction that the instructions at the start of 'ops' can be fused into or an empty optional
+    /// if they can't be fused. The second element is the number of instructions fused.
+    static std::optional<std::pair<QuickenedInstruction, std::size_t>>
+        matchSuperInstruction(llvm::ArrayRef<ByteCodeOp> ops);
+
+    /// Returns the decoded code of 'method', decoding it if this is the first time it is executed.
+    DecodedCode& decode(const Method& method);
+
+    /// Returns the quickened code of 'method', quickening it if this is the first time it is executed.
+    QuickenedCode& quicken(const Method& method);
+
+    /// Prints the bytecode pair histogram to 'os', sorted by frequency.
+    void dumpByteCodePairHistogram(llvm::raw_ostream& os) const;
+
+    /// Returns the super instructions worth fusing according to 'histogram', which must be in the format printed by
+    /// 'dumpByteCodePairHistogram'. A super instruction is selected if every pair of instructions it fuses makes up at
+    /// least one percent of all pairs executed.
+    static llvm::Expected<std::bitset<QuickenedInstruction::NumSuperInstructions>>
+        selectSuperInstructions(llvm::StringRef histogram);
+
+    /// Returns the reference map of 'method' at the start of the instruction at 'offset'. The reference maps of all
+    /// instructions of 'method' are computed with a single type checker pass the first time any of them is requested.
+    const ReferenceMap& getReferenceMap(const Method& method, std::uint16_t offset);
+
+    /// Computes the reference maps at the start of every instruction of 'method'.
+    std::unique_ptr<MethodReferenceMaps> computeReferenceMaps(const Method& method);
 
     /// Initializes 'm_interpreterEntry' by generating LLVM IR.
     void generateInterpreterEntry();
@@ -296,7 +607,16 @@ class Interpreter : public OSRTarget
     void* generateOSREntry(FieldType returnType, CallingConvention callingConvention);
 
 public:
-    explicit Interpreter(VirtualMachine& virtualMachine, std::uint64_t backEdgeThreshold);
+    /// Creates a new interpreter. If 'dumpByteCodePairs' is true, the interpreter counts how often any two
+    /// instructions are executed in sequence and prints the resulting histogram on destruction. Quickening is disabled
+    /// in this mode to count the instructions as they appear in the bytecode. If 'byteCodePairHistogram' is not empty,
+    /// only the super instructions selected by the histogram in the given file are used. All super instructions are
+    /// used otherwise.
+    explicit Interpreter(VirtualMachine& virtualMachine, std::uint64_t backEdgeThreshold,
+                         std::uint64_t invocationThreshold, bool profilingEnabled, bool zeroFrames,
+                         bool dumpByteCodePairs, llvm::StringRef byteCodePairHistogram, bool stacklessCalls);
+
+    ~Interpreter() override;
 
     void add(const Method& method) override;
 
@@ -317,9 +637,21 @@ public:
 
     void* getOSREntry(const Method& method, std::uint16_t byteCodeOffset, CallingConvention callingConvention) override;
 
+    /// Writes the GC masks of 'frame' denoting which local variables and operand stack slots contain Java references.
+    /// The interpreter does not keep the GC masks of its frames up to date during execution. This must therefore be
+    /// called before any use of 'InterpreterFrame::getLocalsGCMask' or 'InterpreterFrame::getOperandStackGCMask'.
+    void materializeGCMasks(InterpreterFrame frame);
+
     OSRState createOSRStateFromInterpreterFrame(InterpreterFrame frame) override;
 
     OSRState createOSRStateForExceptionHandler(JavaFrame frame, std::uint16_t handlerOffset,
                                                Throwable* throwable) override;
+
+    OSRState createOSRStateForDeoptimization(JavaFrame frame) override;
+
+    /// Continues execution of 'frame' at the exception handler at 'handlerOffset' with 'throwable' as the only value on
+    /// its operand stack. 'frame' must be a stackless frame or an interpreter frame with stackless callees.
+    [[noreturn]] void resumeAtExceptionHandler(InterpreterFrame frame, std::uint16_t handlerOffset,
+                                               Throwable* throwable);
 };
 } // namespace jllvm
@@ -14,6 +14,7 @@
 #include "JIT.hpp"
 
 #include <llvm/ExecutionEngine/Orc/Shared/OrcError.h>
+#include <llvm/Support/Debug.h>
 
 #include <jllvm/materialization/InvokeStubsDefinitionsGenerator.hpp>
 #include <jllvm/materialization/LambdaMaterialization.hpp>
@@ -35,18 +36,27 @@ void allowDuplicateDefinitions(llvm::Error&& error)
 
 } // namespace
 
-jllvm::JIT::JIT(VirtualMachine& virtualMachine)
+jllvm::JIT::JIT(VirtualMachine& virtualMachine, std::uint64_t tierUpThreshold)
     : m_virtualMachine(virtualMachine),
       m_javaJITSymbols(
           llvm::cantFail(virtualMachine.getRuntime().getCLibDylib().getExecutionSession().createJITDylib("<javaJIT>"))),
+      m_javaJITOptimizedSymbols(
+          llvm::cantFail(m_javaJITSymbols.getExecutionSession().createJITDylib("<javaJITOptimized>"))),
       m_javaJITImplDetails(
           llvm::cantFail(m_javaJITSymbols.getExecutionSession().createJITDylib("<javaJITImplDetails>"))),
       m_interpreter2JITSymbols(
           llvm::cantFail(m_javaJITSymbols.getExecutionSession().createJITDylib("<interpreter2jit>"))),
+      m_aotLibrary(virtualMachine.getRuntime().getAOTLibrary()),
       m_byteCodeCompileLayer(virtualMachine.getRuntime().getLLVMIRLayer(), virtualMachine.getRuntime().getInterner(),
-                             virtualMachine.getRuntime().getDataLayout()),
+                             virtualMachine.getRuntime().getDataLayout(),
+                             tierUpThreshold == 0 ? CompilationTier::Optimized : CompilationTier::Baseline,
+                             tierUpThreshold, virtualMachine.getRuntime().getCodeCache()),
+      m_optimizedByteCodeCompileLayer(m_byteCodeCompileLayer.getBaseLayer(), m_byteCodeCompileLayer.getInterner(),
+                                      m_byteCodeCompileLayer.getDataLayout(), CompilationTier::Optimized,
+                                      /*tierUpThreshold=*/0, virtualMachine.getRuntime().getCodeCache()),
       m_byteCodeOSRCompileLayer(m_byteCodeCompileLayer.getBaseLayer(), m_byteCodeCompileLayer.getInterner(),
-                                m_byteCodeCompileLayer.getDataLayout())
+                                m_byteCodeCompileLayer.getDataLayout()),
+      m_tieredCompilation(tierUpThreshold != 0)
 {
     // JITted Java methods mustn't lookup symbols within 'm_javaJITSymbols', as these are always JITted methods, but
     // rather resolve direct method calls to the stubs in the runtimes JITCC dylib.
@@ -59,12 +69,13 @@ jllvm::JIT::JIT(VirtualMachine& virtualMachine)
     };
 
     m_javaJITSymbols.setLinkOrder(searchOrder, /*LinkAgainstThisJITDylibFirst=*/false);
+    m_javaJITOptimizedSymbols.setLinkOrder(searchOrder, /*LinkAgainstThisJITDylibFirst=*/false);
 
     // The functions created by the 'InvokeStubsDefinitionsGenerator' are also considered an
     // implementation detail and may only link against the stubs.
     m_javaJITImplDetails.addGenerator(std::make_unique<InvokeStubsDefinitionsGenerator>(
         runtime.createIndirectStubsManager(), runtime.getLLVMIRLayer(), runtime.getDataLayout(), searchOrder,
-        m_virtualMachine.getClassLoader()));
+        m_virtualMachine.getClassLoader(), runtime.getClassHierarchyAnalysis()));
 
     GarbageCollector& gc = m_virtualMachine.getGC();
     ClassLoader& classLoader = m_virtualMachine.getClassLoader();
@@ -77,6 +88,30 @@ jllvm::JIT::JIT(VirtualMachine& virtualMachine)
                   [](const Object* object, const ClassObject* classObject) -> std::int32_t
                   { return object->instanceOf(classObject); }},
         std::pair{"jllvm_osr_frame_delete", [](const std::uint64_t* osrFrame) { delete[] osrFrame; }},
+        std::pair{"jllvm_tier_up",
+                  [&](const Method* method)
+                  {
+                      // Baseline code keeps executing until the optimized code has been compiled. Without an
+                      // interpreter frame executing in between, this is also the place where the optimized code of
+                      // methods tiered up in the background gets linked.
+                      Runtime& runtime = m_virtualMachine.getRuntime();
+                      if (m_tierUpRequested.insert(method).second)
+                      {
+                          runtime.replaceJITCCImplementation(*method, m_javaJITOptimizedSymbols);
+                      }
+                      runtime.pollBackgroundCompilations();
+                  }},
+        std::pair{"jllvm_deoptimize",
+                  [&](std::uint32_t reason)
+                  {
+                      m_virtualMachine.getRuntime().pollBackgroundCompilations();
+                      m_virtualMachine.unwindJavaStack(
+                          [&](JavaFrame frame)
+                          {
+                              m_virtualMachine.deoptimize(frame, static_cast<DeoptimizationReason>(reason));
+                              return UnwindAction::StopUnwinding;
+                          });
+                  }},
         std::pair{"jllvm_throw", [&](Throwable* object) { m_virtualMachine.throwJavaException(object); }},
         std::pair{"jllvm_initialize_class_object",
                   [&](ClassObject* classObject)
@@ -92,11 +127,24 @@ jllvm::JIT::JIT(VirtualMachine& virtualMachine)
                   { m_virtualMachine.throwArrayIndexOutOfBoundsException(index, size); }},
         std::pair{"jllvm_throw_negative_array_size_exception",
                   [&](std::int32_t size) { m_virtualMachine.throwNegativeArraySizeException(size); }});
+    runtime.addDataSymbol(m_javaJITImplDetails, "jllvm_pending_exception", &m_pendingException);
 }
 
 void jllvm::JIT::add(const Method& method)
 {
-    llvm::cantFail(m_byteCodeCompileLayer.add(m_javaJITSymbols, &method));
+    if (std::unique_ptr<llvm::MemoryBuffer> object = m_aotLibrary ? m_aotLibrary->lookup(method) : nullptr)
+    {
+        // Ahead-of-time compiled code is fully optimized and never tiers up.
+        llvm::cantFail(m_virtualMachine.getRuntime().getObjectLayer().add(m_javaJITSymbols, std::move(object)));
+    }
+    else
+    {
+        llvm::cantFail(m_byteCodeCompileLayer.add(m_javaJITSymbols, &method));
+        if (m_tieredCompilation)
+        {
+            llvm::cantFail(m_optimizedByteCodeCompileLayer.add(m_javaJITOptimizedSymbols, &method));
+        }
+    }
     llvm::cantFail(m_virtualMachine.getRuntime().getInterpreter2JITLayer().add(m_interpreter2JITSymbols, &method));
 }
 
@@ -127,6 +175,27 @@ jllvm::OSRState jllvm::JIT::createOSRStateForExceptionHandler(JavaFrame frame, s
                                         reinterpret_cast<std::uint64_t>(throwable)}));
 }
 
+jllvm::OSRState jllvm::JIT::createOSRStateForDeoptimization(JavaFrame frame)
+{
+    return OSRState(*this, *frame.getByteCodeOffset(), createOSRBuffer(frame.readLocals(), frame.readOperandStack()));
+}
+
+void jllvm::JIT::resumeAtExceptionHandler(JavaFrame frame, std::uint16_t handlerOffset, Throwable* throwable)
+{
+    assert(frame.isJIT() && !frame.hasInlinedFrames() && "exception handler must be within the frame's own code");
+    assert(!m_pendingException.exception && "previous exception must have been dispatched");
+
+    LLVM_DEBUG({
+        const Method& method = *frame.getMethod();
+        llvm::dbgs() << "Dispatching exception to handler at offset " << handlerOffset << " of "
+                     << method.getClassObject()->getClassName() << '.' << method.getName()
+                     << method.getType().textual() << '\n';
+    });
+
+    m_pendingException = {throwable, handlerOffset};
+    frame.getUnwindFrame().resumeExecution();
+}
+
 std::unique_ptr<std::uint64_t[]> jllvm::JIT::createOSRBuffer(llvm::ArrayRef<std::uint64_t> locals,
                                                              llvm::ArrayRef<std::uint64_t> operandStack)
 {
@@ -136,3 +205,46 @@ std::unique_ptr<std::uint64_t[]> jllvm::JIT::createOSRBuffer(llvm::ArrayRef<std:
     llvm::copy(operandStack, outIter);
     return buffer;
 }
+
+bool jllvm::JIT::hasPrecompiledCode(const Method& method) const
+{
+    return m_aotLibrary && m_aotLibrary->contains(method);
+}
+
+bool jllvm::JIT::discardCompiledCode(const Method& method, llvm::SmallVectorImpl<llvm::orc::JITDylib*>& compiling)
+{
+    if (hasPrecompiledCode(method))
+    {
+        return false;
+    }
+
+    llvm::orc::SymbolStringPtr name = m_byteCodeCompileLayer.getInterner()(mangleDirectMethodCall(&method));
+    // Removing a symbol fails if it is currently being compiled. The code will be installed regardless but checks the
+    // validity of any assumptions it relies on until the caller discards it after installation.
+    auto discard = [&](llvm::orc::JITDylib& dylib)
+    {
+        if (llvm::Error error = dylib.remove({name}))
+        {
+            llvm::consumeError(std::move(error));
+            compiling.push_back(&dylib);
+            return false;
+        }
+        return true;
+    };
+
+    if (!discard(m_javaJITSymbols))
+    {
+        return false;
+    }
+    LLVM_DEBUG({ llvm::dbgs() << "Discarding compiled code of " << *name << '\n'; });
+
+    // The code itself is not freed as it may still be executing.
+    llvm::cantFail(m_byteCodeCompileLayer.add(m_javaJITSymbols, &method));
+    if (m_tieredCompilation && discard(m_javaJITOptimizedSymbols))
+    {
+        llvm::cantFail(m_optimizedByteCodeCompileLayer.add(m_javaJITOptimizedSymbols, &method));
+        // The new baseline code starts counting from the threshold again and may tier up anew.
+        m_tierUpRequested.erase(&method);
+    }
+    return true;
+}
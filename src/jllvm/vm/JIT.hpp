@@ -13,8 +13,10 @@
 
 #pragma once
 
+#include <jllvm/compiler/ByteCodeCompileUtils.hpp>
 #include <jllvm/materialization/ByteCodeCompileLayer.hpp>
 #include <jllvm/materialization/ByteCodeOSRCompileLayer.hpp>
+#include <llvm/ADT/DenseSet.h>
 
 #include <memory>
 
@@ -31,18 +33,34 @@ class JIT : public OSRTarget
 {
     VirtualMachine& m_virtualMachine;
 
+    /// Dylib containing the code first executed by the JIT. If tiered compilation is enabled, this is baseline code
+    /// that tiers up to the code in 'm_javaJITOptimizedSymbols' once hot.
     llvm::orc::JITDylib& m_javaJITSymbols;
+    llvm::orc::JITDylib& m_javaJITOptimizedSymbols;
     llvm::orc::JITDylib& m_javaJITImplDetails;
     llvm::orc::JITDylib& m_interpreter2JITSymbols;
+    /// Library of ahead-of-time compiled methods or null if none.
+    const AOTLibrary* m_aotLibrary;
 
     ByteCodeCompileLayer m_byteCodeCompileLayer;
+    ByteCodeCompileLayer m_optimizedByteCodeCompileLayer;
     ByteCodeOSRCompileLayer m_byteCodeOSRCompileLayer;
+    bool m_tieredCompilation;
+    /// Methods whose baseline code has already requested to be replaced by optimized code. Baseline code keeps calling
+    /// 'jllvm_tier_up' periodically after reaching the threshold, which is then only used to emit finished background
+    /// compilations.
+    llvm::DenseSet<const Method*> m_tierUpRequested;
+    /// Exception being dispatched to an exception handler by a resumed JITted frame.
+    PendingException m_pendingException{};
 
     static std::unique_ptr<std::uint64_t[]> createOSRBuffer(llvm::ArrayRef<std::uint64_t> locals,
                                                             llvm::ArrayRef<std::uint64_t> operandStack);
 
 public:
-    explicit JIT(VirtualMachine& virtualMachine);
+    /// Creates a new JIT. If 'tierUpThreshold' is non-zero, methods are first compiled to baseline code which is
+    /// replaced by optimized code once the sum of its invocations and loop iterations reaches 'tierUpThreshold'.
+    /// Otherwise, methods are compiled to optimized code right away.
+    explicit JIT(VirtualMachine& virtualMachine, std::uint64_t tierUpThreshold);
 
     void add(const Method& method) override;
 
@@ -51,6 +69,10 @@ public:
         return !(method.isNative() || method.isAbstract());
     }
 
+    bool hasPrecompiledCode(const Method& method) const override;
+
+    bool discardCompiledCode(const Method& method, llvm::SmallVectorImpl<llvm::orc::JITDylib*>& compiling) override;
+
     llvm::orc::JITDylib& getJITCCDylib() override
     {
         return m_javaJITSymbols;
@@ -67,5 +89,12 @@ public:
 
     OSRState createOSRStateForExceptionHandler(JavaFrame frame, std::uint16_t handlerOffset,
                                                Throwable* throwable) override;
+
+    OSRState createOSRStateForDeoptimization(JavaFrame frame) override;
+
+    /// Continues execution of the JITted 'frame' in its exception handler at 'handlerOffset' with 'throwable' as the
+    /// caught exception. Contrary to OSR, the frame is not replaced but resumed after the call that threw, where the
+    /// compiled code branches to the exception handler. 'frame' must not be executing an inlined method.
+    [[noreturn]] void resumeAtExceptionHandler(JavaFrame frame, std::uint16_t handlerOffset, Throwable* throwable);
 };
 } // namespace jllvm
@@ -17,9 +17,12 @@ std::optional<std::uint16_t> jllvm::JavaFrame::getByteCodeOffset() const
 {
     switch (m_javaMethodMetadata->getKind())
     {
-        case JavaMethodMetadata::Kind::JIT:
-            return m_javaMethodMetadata->getJITData()[m_unwindFrame->getProgramCounter()].byteCodeOffset;
+        case JavaMethodMetadata::Kind::JIT: return getJITFrameState().byteCodeOffset;
         case JavaMethodMetadata::Kind::Interpreter:
+            if (m_stacklessFrame)
+            {
+                return m_stacklessFrame->byteCodeOffset;
+            }
             return *m_javaMethodMetadata->getInterpreterData().byteCodeOffset.readScalar(*m_unwindFrame);
         case JavaMethodMetadata::Kind::Native: return std::nullopt;
     }
@@ -33,8 +36,7 @@ llvm::SmallVector<std::uint64_t> jllvm::JavaFrame::readLocals() const
         case JavaMethodMetadata::Kind::Native: return {};
         case JavaMethodMetadata::Kind::JIT:
         {
-            llvm::ArrayRef<FrameValue<std::uint64_t>> locals =
-                m_javaMethodMetadata->getJITData()[m_unwindFrame->getProgramCounter()].locals;
+            llvm::ArrayRef<FrameValue<std::uint64_t>> locals = getJITFrameState().locals;
             return llvm::to_vector(llvm::map_range(locals, [&](FrameValue<std::uint64_t> frameValue)
                                                    { return frameValue.readScalar(*m_unwindFrame); }));
         }
@@ -47,29 +49,46 @@ llvm::SmallVector<std::uint64_t> jllvm::JavaFrame::readLocals() const
 llvm::MutableArrayRef<std::uint64_t> jllvm::InterpreterFrame::getLocals() const
 {
     std::uint16_t numLocals = getMethod()->getMethodInfo().getAttributes().find<Code>()->getMaxLocals();
-    std::uint64_t* locals = m_javaMethodMetadata->getInterpreterData().localVariables.readScalar(*m_unwindFrame);
+    std::uint64_t* locals = m_stacklessFrame ?
+                                m_stacklessFrame->localVariables :
+                                m_javaMethodMetadata->getInterpreterData().localVariables.readScalar(*m_unwindFrame);
     return llvm::MutableArrayRef<std::uint64_t>(locals, locals + numLocals);
 }
 
-jllvm::BitArrayRef<> jllvm::InterpreterFrame::getLocalsGCMask() const
+jllvm::MutableBitArrayRef<> jllvm::InterpreterFrame::getLocalsGCMask() const
 {
     std::uint16_t numLocals = getMethod()->getMethodInfo().getAttributes().find<Code>()->getMaxLocals();
-    std::uint64_t* mask = m_javaMethodMetadata->getInterpreterData().localVariablesGCMask.readScalar(*m_unwindFrame);
-    return BitArrayRef<>(mask, numLocals);
+    std::uint64_t* mask =
+        m_stacklessFrame ? m_stacklessFrame->localVariablesGCMask :
+                           m_javaMethodMetadata->getInterpreterData().localVariablesGCMask.readScalar(*m_unwindFrame);
+    return MutableBitArrayRef<>(mask, numLocals);
 }
 
 llvm::MutableArrayRef<std::uint64_t> jllvm::InterpreterFrame::getOperandStack() const
 {
+    if (m_stacklessFrame)
+    {
+        return llvm::MutableArrayRef<std::uint64_t>(m_stacklessFrame->operandStack, m_stacklessFrame->topOfStack);
+    }
     std::uint16_t numStack = *m_javaMethodMetadata->getInterpreterData().topOfStack.readScalar(*m_unwindFrame);
     std::uint64_t* operands = m_javaMethodMetadata->getInterpreterData().operandStack.readScalar(*m_unwindFrame);
     return llvm::MutableArrayRef<std::uint64_t>(operands, operands + numStack);
 }
 
-jllvm::BitArrayRef<> jllvm::InterpreterFrame::getOperandStackGCMask() const
+jllvm::MutableBitArrayRef<> jllvm::InterpreterFrame::getOperandStackGCMask() const
 {
+    if (m_stacklessFrame)
+    {
+        return MutableBitArrayRef<>(m_stacklessFrame->operandGCMask, m_stacklessFrame->topOfStack);
+    }
     std::uint16_t numStack = *m_javaMethodMetadata->getInterpreterData().topOfStack.readScalar(*m_unwindFrame);
     std::uint64_t* mask = m_javaMethodMetadata->getInterpreterData().operandGCMask.readScalar(*m_unwindFrame);
-    return BitArrayRef<>(mask, numStack);
+    return MutableBitArrayRef<>(mask, numStack);
+}
+
+jllvm::StacklessFrame** jllvm::InterpreterFrame::getStacklessFrameChain() const
+{
+    return m_javaMethodMetadata->getInterpreterData().stacklessFrames.readScalar(*m_unwindFrame);
 }
 
 llvm::SmallVector<std::uint64_t> jllvm::JavaFrame::readLocalsGCMask() const
@@ -77,8 +96,7 @@ llvm::SmallVector<std::uint64_t> jllvm::JavaFrame::readLocalsGCMask() const
     switch (m_javaMethodMetadata->getKind())
     {
         case JavaMethodMetadata::Kind::Native: return {};
-        case JavaMethodMetadata::Kind::JIT:
-            return llvm::to_vector(m_javaMethodMetadata->getJITData()[m_unwindFrame->getProgramCounter()].localsGCMask);
+        case JavaMethodMetadata::Kind::JIT: return llvm::to_vector(getJITFrameState().localsGCMask);
 
         case JavaMethodMetadata::Kind::Interpreter:
         {
@@ -88,13 +106,64 @@ llvm::SmallVector<std::uint64_t> jllvm::JavaFrame::readLocalsGCMask() const
     }
 }
 
+llvm::SmallVector<std::uint64_t> jllvm::JavaFrame::readOperandStack() const
+{
+    switch (m_javaMethodMetadata->getKind())
+    {
+        case JavaMethodMetadata::Kind::Native: return {};
+        case JavaMethodMetadata::Kind::JIT:
+        {
+            llvm::ArrayRef<FrameValue<std::uint64_t>> operandStack = getJITFrameState().operandStack;
+            return llvm::to_vector(llvm::map_range(operandStack, [&](FrameValue<std::uint64_t> frameValue)
+                                                   { return frameValue.readScalar(*m_unwindFrame); }));
+        }
+        case JavaMethodMetadata::Kind::Interpreter:
+            return llvm::to_vector(llvm::cast<InterpreterFrame>(*this).getOperandStack());
+    }
+    llvm_unreachable("invalid kind");
+}
+
+llvm::SmallVector<std::uint64_t> jllvm::JavaFrame::readOperandStackGCMask() const
+{
+    switch (m_javaMethodMetadata->getKind())
+    {
+        case JavaMethodMetadata::Kind::Native: return {};
+        case JavaMethodMetadata::Kind::JIT: return llvm::to_vector(getJITFrameState().operandStackGCMask);
+
+        case JavaMethodMetadata::Kind::Interpreter:
+        {
+            BitArrayRef<> bitArray = llvm::cast<InterpreterFrame>(*this).getOperandStackGCMask();
+            return llvm::SmallVector<std::uint64_t>(bitArray.words_begin(), bitArray.words_end());
+        }
+    }
+    llvm_unreachable("invalid kind");
+}
+
+bool jllvm::JavaFrame::hasInlinedFrames() const
+{
+    if (!m_javaMethodMetadata->isJIT())
+    {
+        return false;
+    }
+    return m_inlinedFrame + 1 < m_javaMethodMetadata->getJITData()[m_unwindFrame->getProgramCounter()].frames.size();
+}
+
 const jllvm::Method* jllvm::JavaFrame::getMethod() const
 {
     switch (m_javaMethodMetadata->getKind())
     {
-        case JavaMethodMetadata::Kind::JIT: return m_javaMethodMetadata->getJITData().getMethod();
+        case JavaMethodMetadata::Kind::JIT:
+            if (m_inlinedFrame != 0)
+            {
+                return getJITFrameState().method;
+            }
+            return m_javaMethodMetadata->getJITData().getMethod();
         case JavaMethodMetadata::Kind::Native: return m_javaMethodMetadata->getNativeData().method;
         case JavaMethodMetadata::Kind::Interpreter:
+            if (m_stacklessFrame)
+            {
+                return m_stacklessFrame->method;
+            }
             return m_javaMethodMetadata->getInterpreterData().method.readScalar(*m_unwindFrame);
     }
 }
@@ -30,12 +30,34 @@ class JavaFrame
 protected:
     const JavaMethodMetadata* m_javaMethodMetadata;
     UnwindFrame* m_unwindFrame;
+    StacklessFrame* m_stacklessFrame{};
+    /// Index of the frame within the frames recorded at the current call of a JITted frame. 0 for the frame of the
+    /// JITted method itself.
+    std::size_t m_inlinedFrame{};
+
+    /// Returns the state of this frame recorded at the current call of the JITted frame.
+    const JavaMethodMetadata::JITData::FrameState& getJITFrameState() const
+    {
+        return m_javaMethodMetadata->getJITData()[m_unwindFrame->getProgramCounter()].frames[m_inlinedFrame];
+    }
 
 public:
-    /// Constructs a 'JavaFrame' from a frame and its corresponding java method metadata.
-    explicit JavaFrame(const JavaMethodMetadata& javaMethodMetadata, UnwindFrame& frame)
-        : m_javaMethodMetadata(&javaMethodMetadata), m_unwindFrame(&frame)
+    /// Constructs a 'JavaFrame' from a frame and its corresponding java method metadata. If 'stacklessFrame' is
+    /// non-null, the Java frame is the given stackless frame executed within the interpreter frame 'frame'.
+    explicit JavaFrame(const JavaMethodMetadata& javaMethodMetadata, UnwindFrame& frame,
+                       StacklessFrame* stacklessFrame = nullptr)
+        : m_javaMethodMetadata(&javaMethodMetadata), m_unwindFrame(&frame), m_stacklessFrame(stacklessFrame)
     {
+        assert((!stacklessFrame || javaMethodMetadata.isInterpreter()) && "only the interpreter has stackless frames");
+    }
+
+    /// Constructs a 'JavaFrame' for the frame of a method inlined into the JITted frame 'frame'. 'inlinedFrame' is the
+    /// index of the frame within the frames recorded at the current call of 'frame', with 0 being the frame of the
+    /// JITted method itself.
+    explicit JavaFrame(const JavaMethodMetadata& javaMethodMetadata, UnwindFrame& frame, std::size_t inlinedFrame)
+        : m_javaMethodMetadata(&javaMethodMetadata), m_unwindFrame(&frame), m_inlinedFrame(inlinedFrame)
+    {
+        assert(javaMethodMetadata.isJIT() && "only JITted frames have inlined frames");
     }
 
     /// Returns true if this java frame is being executed in the JIT.
@@ -56,6 +78,13 @@ public:
         return m_javaMethodMetadata->isNative();
     }
 
+    /// Returns true if this java frame is a stackless frame of the interpreter. Stackless frames share the unwind frame
+    /// of the interpreter frame they are executed in, which can therefore not be used to replace or resume them.
+    bool isStackless() const
+    {
+        return m_stacklessFrame != nullptr;
+    }
+
     /// Returns the calling convention used by this frame.
     CallingConvention getCallingConvention() const
     {
@@ -96,7 +125,45 @@ public:
     /// Reads the GC mask for the local variables at the current bytecode offset.
     /// This is a bitset where the 'i'th bit being set corresponding to the 'i'th local variable being a reference type.
     /// This method will return an empty array in the same scenarios as 'readLocals'.
+    /// For interpreter frames, 'Interpreter::materializeGCMasks' must have been called prior.
     llvm::SmallVector<std::uint64_t> readLocalsGCMask() const;
+
+    /// Reads out the values of the operand stack at the current bytecode offset in the layout used by the interpreter.
+    /// This method will always return an empty array unless the frame is an interpreter frame, a JITted frame
+    /// currently calling 'jllvm_deoptimize' or a fully optimized JITted frame calling a Java method. The arguments of
+    /// the call are not part of the operand stack in the latter case.
+    llvm::SmallVector<std::uint64_t> readOperandStack() const;
+
+    /// Reads the GC mask for the operand stack at the current bytecode offset.
+    /// This method will return an empty array in the same scenarios as 'readOperandStack'.
+    /// For interpreter frames, 'Interpreter::materializeGCMasks' must have been called prior.
+    llvm::SmallVector<std::uint64_t> readOperandStackGCMask() const;
+
+    /// Returns true if this frame is the frame of a method inlined into JITted code. Such frames share the unwind
+    /// frame of the JITted frame they were inlined into, which can therefore not be used to resume them.
+    bool isInlined() const
+    {
+        return m_inlinedFrame != 0;
+    }
+
+    /// Returns true if this frame is a JITted frame currently calling a method inlined into its code. Its callee frames
+    /// are then frames of inlined methods sharing its unwind frame.
+    bool hasInlinedFrames() const;
+
+    /// Returns the frame of the method that the unwind frame of this frame was created for. This is this frame unless
+    /// it is a stackless or an inlined frame.
+    JavaFrame getOutermostFrame() const
+    {
+        return JavaFrame(*m_javaMethodMetadata, *m_unwindFrame);
+    }
+
+    /// Returns the frame of the method that the method of this frame was inlined into. Must only be called if
+    /// 'isInlined' returns true.
+    JavaFrame getInlinedCaller() const
+    {
+        assert(isInlined() && "frame must be an inlined frame");
+        return JavaFrame(*m_javaMethodMetadata, *m_unwindFrame, m_inlinedFrame - 1);
+    }
 };
 
 /// Specialization of 'JavaFrame' for interpreter frames. This contains all methods specific to interpreter frames.
@@ -107,7 +174,7 @@ public:
 /// InterpreterFrame interpreterFrame = llvm::cast<InterpreterFrame>(javaFrame);
 class InterpreterFrame : public JavaFrame
 {
-    using JavaFrame::JavaFrame;
+    explicit InterpreterFrame(JavaFrame frame) : JavaFrame(frame) {}
 
     template <typename To, typename From, typename Enable>
     friend struct llvm::CastInfo;
@@ -117,7 +184,8 @@ public:
     llvm::MutableArrayRef<std::uint64_t> getLocals() const;
 
     /// Returns the bitset denoting where Java references are contained within the interpreter locals.
-    BitArrayRef<> getLocalsGCMask() const;
+    /// Note that the bitset is only valid after a call to 'Interpreter::materializeGCMasks' with this frame.
+    MutableBitArrayRef<> getLocalsGCMask() const;
 
     /// Returns a mutable view of the operand stack of the interpreter.
     ///
@@ -126,7 +194,19 @@ public:
     llvm::MutableArrayRef<std::uint64_t> getOperandStack() const;
 
     /// Returns the bitset denoting where Java references are contained within the interpreter operand stack.
-    BitArrayRef<> getOperandStackGCMask() const;
+    /// Note that the bitset is only valid after a call to 'Interpreter::materializeGCMasks' with this frame.
+    MutableBitArrayRef<> getOperandStackGCMask() const;
+
+    /// Returns the state of this frame if it is a stackless frame or null otherwise.
+    StacklessFrame* getStacklessFrame() const
+    {
+        return m_stacklessFrame;
+    }
+
+    /// Returns the slot containing the innermost stackless frame executed within the native frame of this interpreter
+    /// frame. The slot contains null if there is none. Stackless frames in the slot are callees of this frame unless
+    /// this frame is a stackless frame itself.
+    StacklessFrame** getStacklessFrameChain() const;
 };
 
 } // namespace jllvm
@@ -144,7 +224,7 @@ struct llvm::CastInfo<jllvm::InterpreterFrame, jllvm::JavaFrame>
 
     static jllvm::InterpreterFrame doCast(jllvm::JavaFrame frame)
     {
-        return jllvm::InterpreterFrame(frame.getJavaMethodMetadata(), frame.getUnwindFrame());
+        return jllvm::InterpreterFrame(frame);
     }
 
     static std::optional<jllvm::InterpreterFrame> castFailed()
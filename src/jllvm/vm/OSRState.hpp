@@ -44,6 +44,10 @@ public:
 
     virtual OSRState createOSRStateForExceptionHandler(JavaFrame frame, std::uint16_t handlerOffset,
                                                        Throwable* throwable) = 0;
+
+    /// Creates an 'OSRState' continuing execution of 'frame' at its current bytecode offset with its local variables
+    /// and operand stack. 'frame' must be a JITted frame calling 'jllvm_deoptimize'.
+    virtual OSRState createOSRStateForDeoptimization(JavaFrame frame) = 0;
 };
 
 /// Class representing the abstract machine state required for transitioning execution from one tier to another.
@@ -14,24 +14,23 @@
 #include "Runtime.hpp"
 
 #include <llvm/ADT/ScopeExit.h>
-#include <llvm/Analysis/AliasAnalysis.h>
-#include <llvm/Analysis/GlobalsModRef.h>
 #include <llvm/ExecutionEngine/JITLink/EHFrameSupport.h>
 #include <llvm/ExecutionEngine/Orc/CompileUtils.h>
 #include <llvm/ExecutionEngine/Orc/DebugObjectManagerPlugin.h>
 #include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
 #include <llvm/ExecutionEngine/Orc/TargetProcess/JITLoaderGDB.h>
-#include <llvm/Passes/PassBuilder.h>
-#include <llvm/Transforms/Instrumentation/AddressSanitizer.h>
-#include <llvm/Transforms/Scalar/RewriteStatepointsForGC.h>
+#include <llvm/Support/Debug.h>
 
 #include <jllvm/llvm/ClassObjectStubImportPass.hpp>
-#include <jllvm/llvm/MarkSanitizersGCLeafs.hpp>
+#include <jllvm/llvm/CompilationPipeline.hpp>
 #include <jllvm/materialization/ClassObjectDefinitionsGenerator.hpp>
 
+#include "FaultMapRegistrationPlugin.hpp"
 #include "StackMapRegistrationPlugin.hpp"
 #include "VirtualMachine.hpp"
 
+#define DEBUG_TYPE "jvm"
+
 namespace
 {
 /// Custom 'EHFrameRegistrar' which registers the 'eh_frame' sections in our unwinder. This is very similar to
@@ -54,30 +53,64 @@ public:
     }
 };
 
+/// Task dispatcher running 'BackgroundCompileTask's on a thread pool. All other tasks, most notably materialization
+/// tasks, are run immediately on the dispatching thread as these may load classes or otherwise modify VM state.
+class BackgroundCompileDispatcher : public llvm::orc::TaskDispatcher
+{
+    llvm::ThreadPool& m_threadPool;
+
+public:
+    explicit BackgroundCompileDispatcher(llvm::ThreadPool& threadPool) : m_threadPool(threadPool) {}
+
+    void dispatch(std::unique_ptr<llvm::orc::Task> task) override
+    {
+        if (!llvm::isa<jllvm::BackgroundCompileTask>(*task))
+        {
+            task->run();
+            return;
+        }
+        // 'ThreadPool' requires copyable functions.
+        m_threadPool.async([task = std::shared_ptr<llvm::orc::Task>(std::move(task))] { task->run(); });
+    }
+
+    void shutdown() override
+    {
+        m_threadPool.wait();
+    }
+};
+
+std::unique_ptr<llvm::orc::TaskDispatcher> createTaskDispatcher(llvm::ThreadPool* compileThreadPool)
+{
+    if (!compileThreadPool)
+    {
+        return std::make_unique<llvm::orc::InPlaceTaskDispatcher>();
+    }
+    return std::make_unique<BackgroundCompileDispatcher>(*compileThreadPool);
+}
+
 } // namespace
 
 #ifdef __APPLE__
 extern "C" void __bzero();
 #endif
 
-jllvm::Runtime::Runtime(VirtualMachine& virtualMachine, llvm::ArrayRef<Executor*> executors)
-    : m_session(std::make_unique<llvm::orc::ExecutionSession>(
-          llvm::cantFail(llvm::orc::SelfExecutorProcessControl::Create()))),
+jllvm::Runtime::Runtime(VirtualMachine& virtualMachine, llvm::ArrayRef<Executor*> executors,
+                        unsigned compileThreads, llvm::StringRef codeCacheDirectory,
+                        llvm::StringRef aotLibraryPath, InliningOptions inliningOptions,
+                        bool printCompilation)
+    : m_compileThreadPool(compileThreads == 0 ?
+                              nullptr :
+                              std::make_unique<llvm::ThreadPool>(llvm::hardware_concurrency(compileThreads))),
+      m_session(std::make_unique<llvm::orc::ExecutionSession>(
+          llvm::cantFail(llvm::orc::SelfExecutorProcessControl::Create(
+              /*SSP=*/nullptr, createTaskDispatcher(m_compileThreadPool.get()))))),
       m_executors(executors.begin(), executors.end()),
       m_jitCCStubs(m_session->createBareJITDylib("<jitCCStubs>")),
       m_interpreterCCStubs(m_session->createBareJITDylib("<interpreterCCStubs>")),
       m_classAndMethodObjects(m_session->createBareJITDylib("<class-and-method-objects>")),
       m_clib(m_session->createBareJITDylib("<clib>")),
       m_epciu(llvm::cantFail(llvm::orc::EPCIndirectionUtils::Create(m_session->getExecutorProcessControl()))),
-      m_targetMachine(
-          []
-          {
-              auto jtmb = llvm::cantFail(llvm::orc::JITTargetMachineBuilder::detectHost());
-              jtmb.getOptions().EmulatedTLS = false;
-              jtmb.getOptions().ExceptionModel = llvm::ExceptionHandling::DwarfCFI;
-              jtmb.setCodeGenOptLevel(llvm::CodeGenOpt::Aggressive);
-              return llvm::cantFail(jtmb.createTargetMachine());
-          }()),
+      m_targetMachine(llvm::cantFail(createTargetMachineBuilder().createTargetMachine())),
       m_lazyCallThroughManager(m_epciu->createLazyCallThroughManager(
           *m_session, llvm::pointerToJITTargetAddress(+[] { llvm::report_fatal_error("Dynamic linking failed"); }))),
       m_jitCCStubsManager(m_epciu->createIndirectStubsManager()),
@@ -85,18 +118,37 @@ jllvm::Runtime::Runtime(VirtualMachine& virtualMachine, llvm::ArrayRef<Executor*
       m_dataLayout(m_targetMachine->createDataLayout()),
       m_interner(*m_session, m_dataLayout),
       m_classLoader(virtualMachine.getClassLoader()),
+      m_classHierarchyAnalysis(m_classLoader),
+      m_inliningOptions(inliningOptions),
+      m_printCompilation(printCompilation),
       m_objectLayer(*m_session),
-      m_compilerLayer(*m_session, m_objectLayer, std::make_unique<llvm::orc::SimpleCompiler>(*m_targetMachine)),
-      m_optimizeLayer(*m_session, m_compilerLayer,
-                      [&](llvm::orc::ThreadSafeModule tsm, const llvm::orc::MaterializationResponsibility&)
-                      {
-                          tsm.withModuleDo([&](llvm::Module& module) { optimize(module); });
-                          return std::move(tsm);
-                      }),
-      m_interpreter2JITLayer(m_optimizeLayer, m_interner, m_dataLayout)
+      m_codeCache(codeCacheDirectory.empty() ?
+                      nullptr :
+                      std::make_unique<CodeCache>(codeCacheDirectory, m_objectLayer, *m_targetMachine)),
+      m_compilerLayer(*m_session, m_objectLayer, createTargetMachineBuilder(), *m_targetMachine, &optimizeModule,
+                      m_codeCache.get()),
+      m_classObjectStubImportLayer(*m_session, m_compilerLayer,
+                                   [&](llvm::orc::ThreadSafeModule tsm,
+                                       const llvm::orc::MaterializationResponsibility& mr)
+                                   {
+                                       tsm.withModuleDo([&](llvm::Module& module)
+                                                        { importClassObjectStubs(module, mr); });
+                                       return std::move(tsm);
+                                   }),
+      m_interpreter2JITLayer(m_classObjectStubImportLayer, m_interner, m_dataLayout)
 {
     llvm::cantFail(llvm::orc::setUpInProcessLCTMReentryViaEPCIU(*m_epciu));
 
+    if (!aotLibraryPath.empty())
+    {
+        llvm::Expected<std::unique_ptr<AOTLibrary>> aotLibrary = AOTLibrary::load(aotLibraryPath, *m_targetMachine);
+        if (!aotLibrary)
+        {
+            llvm::report_fatal_error(aotLibrary.takeError());
+        }
+        m_aotLibrary = std::move(*aotLibrary);
+    }
+
     m_objectLayer.addPlugin(std::make_unique<llvm::orc::DebugObjectManagerPlugin>(
         *m_session, std::make_unique<llvm::orc::EPCDebugObjectRegistrar>(
                         *m_session, llvm::orc::ExecutorAddr::fromPtr(&llvm_orc_registerJITLoaderGDBWrapper))));
@@ -107,6 +159,7 @@ jllvm::Runtime::Runtime(VirtualMachine& virtualMachine, llvm::ArrayRef<Executor*
         *m_session, std::make_unique<llvm::jitlink::InProcessEHFrameRegistrar>()));
 
     m_objectLayer.addPlugin(std::make_unique<StackMapRegistrationPlugin>(virtualMachine.getGC(), m_javaFrames));
+    m_objectLayer.addPlugin(std::make_unique<FaultMapRegistrationPlugin>());
 
     m_classAndMethodObjects.addGenerator(
         std::make_unique<ClassObjectDefinitionsGenerator>(m_classLoader, m_dataLayout));
@@ -156,8 +209,17 @@ void jllvm::Runtime::add(ClassObject* classObject, Executor& defaultExecutor)
             }
         }
 
+        // Executors that already have code for the method ready are preferred as these avoid interpreting or compiling
+        // the method entirely.
         Executor* executor = &defaultExecutor;
-        if (!executor->canExecute(method))
+        auto precompiled =
+            llvm::find_if(m_executors, [&](Executor* executor)
+                          { return executor->canExecute(method) && executor->hasPrecompiledCode(method); });
+        if (precompiled != m_executors.end())
+        {
+            executor = *precompiled;
+        }
+        else if (!executor->canExecute(method))
         {
             // If the default executor is not capable of executing the method, find the first one that does.
             auto iter = llvm::find_if(m_executors, [&](Executor* executor) { return executor->canExecute(method); });
@@ -170,6 +232,7 @@ void jllvm::Runtime::add(ClassObject* classObject, Executor& defaultExecutor)
 
         std::string name = mangleDirectMethodCall(&method);
         llvm::orc::SymbolStringPtr mangledName = m_interner(name);
+        m_methodSymbols[mangledName] = &method;
 
         auto addStub = [&](llvm::orc::IndirectStubsManager::StubInitsMap& stubInitsMap,
                            llvm::orc::JITDylib& sourceDylib, llvm::orc::IndirectStubsManager& stubsManager)
@@ -209,52 +272,170 @@ void jllvm::Runtime::add(ClassObject* classObject, Executor& defaultExecutor)
     defineStubs(interpreterStubInits, *m_interpreterCCStubsManager, m_interpreterCCStubs);
 
     prepare(*classObject);
+
+    // Instances of 'classObject' can only be created after it has been added. Recompiling any code that relied on
+    // 'classObject' not existing at this point is therefore early enough. Code of these methods that is already
+    // executing checks the validity of the assumptions prior to relying on them.
+    for (const Method* dependent : m_classHierarchyAnalysis.classLoaded(*classObject))
+    {
+        recompile(*dependent);
+    }
 }
 
-void jllvm::Runtime::optimize(llvm::Module& module)
+void jllvm::Runtime::changeExecutor(const Method& method, Executor& executor)
 {
-    llvm::LoopAnalysisManager lam;
-    llvm::FunctionAnalysisManager fam;
-    llvm::CGSCCAnalysisManager cgam;
-    llvm::ModuleAnalysisManager mam;
+    assert(executor.canExecute(method));
 
-    llvm::PipelineTuningOptions options;
-    options.LoopInterleaving = true;
-    options.LoopUnrolling = true;
-    options.LoopVectorization = true;
-    options.SLPVectorization = true;
-    options.MergeFunctions = true;
-    llvm::PassBuilder passBuilder(m_targetMachine.get(), options, std::nullopt);
+    Executor*& currentExecutor = m_executorState[&method];
+    if (currentExecutor == &executor)
+    {
+        return;
+    }
+    currentExecutor = &executor;
 
-    passBuilder.registerPipelineStartEPCallback(
-        [&](llvm::ModulePassManager& modulePassManager, llvm::OptimizationLevel)
-        { modulePassManager.addPass(ClassObjectStubImportPass{m_classLoader}); });
+    updateStubsWhenReady(method, executor.getJITCCDylib(), &executor.getInterpreterCCDylib());
+}
 
-    passBuilder.registerOptimizerLastEPCallback(
-        [&](llvm::ModulePassManager& modulePassManager, llvm::OptimizationLevel)
-        {
-#if LLVM_ADDRESS_SANITIZER_BUILD
-            llvm::AddressSanitizerOptions options;
-            modulePassManager.addPass(llvm::AddressSanitizerPass(options));
-            modulePassManager.addPass(llvm::RequireAnalysisPass<llvm::GlobalsAA, llvm::Module>{});
-            modulePassManager.addPass(MarkSanitizersGCLeafsPass{});
-#endif
-            modulePassManager.addPass(llvm::RewriteStatepointsForGC{});
-        });
+void jllvm::Runtime::replaceJITCCImplementation(const Method& method, llvm::orc::JITDylib& jitCCDylib)
+{
+    updateStubsWhenReady(method, jitCCDylib, /*interpreterCCDylib=*/nullptr);
+}
+
+void jllvm::Runtime::updateStubsWhenReady(const Method& method, llvm::orc::JITDylib& jitCCDylib,
+                                          llvm::orc::JITDylib* interpreterCCDylib)
+{
+    std::string name = mangleDirectMethodCall(&method);
+    llvm::orc::SymbolStringPtr mangledName = m_interner(name);
+    if (m_compileThreadPool)
+    {
+        m_compilerLayer.compileInBackground(mangledName);
+    }
+
+    // Schedule the lookup of the implementation of 'method' within 'dylib', updating the stub of 'method' in
+    // 'stubsManager' once it is ready. 'then' is called afterwards.
+    auto scheduleStubUpdate = [this, name, mangledName](llvm::orc::JITDylib& dylib,
+                                                        llvm::orc::IndirectStubsManager& stubsManager, auto then)
+    {
+        m_session->lookup(
+            llvm::orc::LookupKind::Static, llvm::orc::makeJITDylibSearchOrder({&dylib}),
+            llvm::orc::SymbolLookupSet(mangledName), llvm::orc::SymbolState::Ready,
+            [&stubsManager, name, then = std::move(then)](llvm::Expected<llvm::orc::SymbolMap> symbolMap)
+            {
+                if (!symbolMap)
+                {
+                    // Compilation failed or was cancelled during shutdown. Errors during compilation were already
+                    // reported to the execution session. The method simply continues to be executed by the
+                    // implementation the stub currently points to.
+                    llvm::consumeError(symbolMap.takeError());
+                    return;
+                }
+                // Stubs are updated with a single pointer-sized store, making the change atomic for any thread
+                // currently calling the method.
+                llvm::cantFail(stubsManager.updatePointer(name, symbolMap->begin()->second.getAddress()));
+                then();
+            },
+            llvm::orc::NoDependenciesToRegister);
+    };
 
-    fam.registerPass([&] { return passBuilder.buildDefaultAAPipeline(); });
-    passBuilder.registerModuleAnalyses(mam);
-    passBuilder.registerCGSCCAnalyses(cgam);
-    passBuilder.registerFunctionAnalyses(fam);
-    passBuilder.registerLoopAnalyses(lam);
-    passBuilder.crossRegisterProxies(lam, fam, cgam, mam);
+    // The interpreter calling convention implementation of executors may call the JIT calling convention
+    // implementation. Update its stub only once the latter is ready to avoid detours while compilation is in progress.
+    scheduleStubUpdate(jitCCDylib, *m_jitCCStubsManager,
+                       [this, scheduleStubUpdate, interpreterCCDylib, name, &jitCCDylib, &method]
+                       {
+                           if (m_printCompilation)
+                           {
+                               llvm::errs() << "Installed " << name << " from " << jitCCDylib.getName() << '\n';
+                           }
+                           if (interpreterCCDylib)
+                           {
+                               scheduleStubUpdate(*interpreterCCDylib, *m_interpreterCCStubsManager, [] {});
+                           }
+
+                           // The code just installed may have been compiled with assumptions that were invalidated
+                           // during its compilation. It can be discarded now that its compilation has finished.
+                           auto pending = m_pendingRecompilations.find(&method);
+                           if (pending == m_pendingRecompilations.end()
+                               || !llvm::is_contained(pending->second, &jitCCDylib))
+                           {
+                               return;
+                           }
+                           llvm::erase_value(pending->second, &jitCCDylib);
+                           if (pending->second.empty())
+                           {
+                               m_pendingRecompilations.erase(pending);
+                           }
+                           recompile(method);
+                       });
+
+    // Remove the symbol in case it was already materialized prior to this call and the request was therefore not
+    // consumed by the compiler layer.
+    m_compilerLayer.cancelCompileInBackground(mangledName);
+}
 
-    auto mpm = passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
-    mpm.run(module, mam);
+void jllvm::Runtime::importClassObjectStubs(llvm::Module& module, const llvm::orc::MaterializationResponsibility& mr)
+{
+    if (CodeCache::getKey(module))
+    {
+        return;
+    }
+
+    // Modules of Java methods define exactly the symbol of the method. OSR versions and other modules are never
+    // recompiled.
+    const Method* dependent = nullptr;
+    if (mr.getSymbols().size() == 1)
+    {
+        dependent = m_methodSymbols.lookup(mr.getSymbols().begin()->first);
+    }
+
+    llvm::ModuleAnalysisManager mam;
+    ClassObjectStubImportPass{m_classLoader, &m_classHierarchyAnalysis, dependent}.run(module, mam);
+
+    // Baseline code is meant to be compiled quickly and is replaced by fully optimized code once hot.
+    if (!dependent || getCompilationTier(module) != CompilationTier::Optimized)
+    {
+        return;
+    }
+    JavaMethodInliningPass{m_classLoader, m_inliningOptions,
+                           [&](llvm::StringRef name) { return m_methodSymbols.lookup(m_interner(name)); },
+                           &m_classHierarchyAnalysis, dependent}
+        .run(module, mam);
+}
+
+void jllvm::Runtime::recompile(const Method& method)
+{
+    Executor* executor = m_executorState.lookup(&method);
+    if (!executor)
+    {
+        return;
+    }
+
+    llvm::SmallVector<llvm::orc::JITDylib*> compiling;
+    bool discarded = executor->discardCompiledCode(method, compiling);
+    if (!compiling.empty())
+    {
+        LLVM_DEBUG({
+            llvm::dbgs() << "Deferring recompilation of " << method.getClassObject()->getClassName() << '.'
+                         << method.getName() << method.getType().textual() << " until its compilation has finished\n";
+        });
+        llvm::SmallVector<llvm::orc::JITDylib*, 2>& pending = m_pendingRecompilations[&method];
+        for (llvm::orc::JITDylib* dylib : compiling)
+        {
+            if (!llvm::is_contained(pending, dylib))
+            {
+                pending.push_back(dylib);
+            }
+        }
+    }
+    if (!discarded)
+    {
+        return;
+    }
+    replaceJITCCImplementation(method, executor->getJITCCDylib());
 }
 
 jllvm::Runtime::~Runtime()
 {
+    m_compilerLayer.cancelBackgroundCompilations();
     llvm::cantFail(m_session->endSession());
     llvm::cantFail(m_epciu->cleanup());
 }
@@ -341,7 +522,7 @@ void jllvm::Runtime::prepare(ClassObject& classObject)
         }
     }
 
-    // Initialize the ITable slots of 'classObject'.
+    // Initialize the ITable slots and the IMT of 'classObject'.
     llvm::DenseMap<std::size_t, const jllvm::ClassObject*> idToInterface;
     for (const ClassObject* interface : classObject.getAllInterfaces())
     {
@@ -364,7 +545,9 @@ void jllvm::Runtime::prepare(ClassObject& classObject)
             {
                 continue;
             }
-            iTable->getMethods()[*slot] = lookupJITCC(selection);
+            void* code = lookupJITCC(selection);
+            iTable->getMethods()[*slot] = code;
+            classObject.insertIntoIMT(iter, selection, code);
         }
     }
 }
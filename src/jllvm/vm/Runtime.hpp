@@ -15,14 +15,19 @@
 
 #include <llvm/ExecutionEngine/Orc/Core.h>
 #include <llvm/ExecutionEngine/Orc/EPCIndirectionUtils.h>
-#include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
 #include <llvm/ExecutionEngine/Orc/IRTransformLayer.h>
 #include <llvm/ExecutionEngine/Orc/ObjectLinkingLayer.h>
+#include <llvm/Support/ThreadPool.h>
 #include <llvm/Target/TargetMachine.h>
 
 #include <jllvm/compiler/ByteCodeCompileUtils.hpp>
 #include <jllvm/compiler/ClassObjectStubMangling.hpp>
+#include <jllvm/llvm/JavaMethodInlining.hpp>
+#include <jllvm/materialization/AOTLibrary.hpp>
+#include <jllvm/materialization/BackgroundCompileLayer.hpp>
+#include <jllvm/materialization/CodeCache.hpp>
 #include <jllvm/materialization/Interpreter2JITLayer.hpp>
+#include <jllvm/object/ClassHierarchyAnalysis.hpp>
 #include <jllvm/object/ClassObject.hpp>
 
 #include <memory>
@@ -39,6 +44,8 @@ class VirtualMachine;
 /// executed.
 class Runtime
 {
+    /// Thread pool used to compile methods in the background. Null if all compilation happens synchronously.
+    std::unique_ptr<llvm::ThreadPool> m_compileThreadPool;
     std::unique_ptr<llvm::orc::ExecutionSession> m_session;
 
     std::vector<Executor*> m_executors;
@@ -48,6 +55,11 @@ class Runtime
     llvm::orc::JITDylib& m_interpreterCCStubs;
     /// Mapping of a Java method to the executor it is being executed by.
     llvm::DenseMap<const Method*, Executor*> m_executorState;
+    /// Mapping of the "direct-method-call" mangled name of a Java method to the method.
+    llvm::DenseMap<llvm::orc::SymbolStringPtr, const Method*> m_methodSymbols;
+    /// Mapping of a Java method that has to be recompiled to the dylibs its code was still being compiled for when its
+    /// recompilation was requested. The method is recompiled once the code of any of these dylibs has been installed.
+    llvm::DenseMap<const Method*, llvm::SmallVector<llvm::orc::JITDylib*, 2>> m_pendingRecompilations;
 
     /// Dylib containing all functions that may be produced by compilation of LLVM. This mainly contains C library
     /// symbols and instrumentation symbols such as for ASAN.
@@ -63,16 +75,36 @@ class Runtime
 
     llvm::DataLayout m_dataLayout;
     ClassLoader& m_classLoader;
+    ClassHierarchyAnalysis m_classHierarchyAnalysis;
+    InliningOptions m_inliningOptions;
+    /// Whether a line is printed to stderr whenever the stubs of a method are updated to newly compiled code.
+    bool m_printCompilation;
 
     llvm::orc::MangleAndInterner m_interner;
     llvm::orc::ObjectLinkingLayer m_objectLayer;
-    llvm::orc::IRCompileLayer m_compilerLayer;
-    llvm::orc::IRTransformLayer m_optimizeLayer;
+    /// On-disk cache of compiled Java methods. Null if disabled.
+    std::unique_ptr<CodeCache> m_codeCache;
+    /// Library of ahead-of-time compiled Java methods. Null if none was given.
+    std::unique_ptr<AOTLibrary> m_aotLibrary;
+    BackgroundCompileLayer m_compilerLayer;
+    llvm::orc::IRTransformLayer m_classObjectStubImportLayer;
     Interpreter2JITLayer m_interpreter2JITLayer;
 
     llvm::DenseSet<std::uintptr_t> m_javaFrames;
 
-    void optimize(llvm::Module& module);
+    /// Updates the stubs of 'method' to point to its implementation in 'jitCCDylib' and, if non-null,
+    /// 'interpreterCCDylib' once these are ready.
+    void updateStubsWhenReady(const Method& method, llvm::orc::JITDylib& jitCCDylib,
+                              llvm::orc::JITDylib* interpreterCCDylib);
+
+    /// Imports the definitions of class object stubs into 'module' prior to optimizing it. This has to be done on the
+    /// Java thread as it accesses the class loader. Modules stored in the code cache are left untouched as the stub
+    /// definitions depend on the state of the current process. Only baseline code is ever cached, which is replaced by
+    /// optimized code making full use of class hierarchy analysis and inlining once hot.
+    /// 'mr' is used to determine the Java method 'module' was compiled from, which is recompiled if any assumption of
+    /// class hierarchy analysis made while importing is invalidated. Small callees of fully optimized Java methods are
+    /// additionally compiled into 'module' to be inlined.
+    void importClassObjectStubs(llvm::Module& module, const llvm::orc::MaterializationResponsibility& mr);
 
     void prepare(ClassObject& classObject);
 
@@ -89,7 +121,16 @@ class Runtime
 public:
     /// Creates a runtime instance from a virtual machine and a list of executors.
     /// The list of executors must be the full list of executors that are capable of executing some JVM methods.
-    explicit Runtime(VirtualMachine& virtualMachine, llvm::ArrayRef<Executor*> executors);
+    /// 'compileThreads' is the number of threads used by 'changeExecutor' to compile methods in the background.
+    /// If 0, all compilation happens synchronously.
+    /// If 'codeCacheDirectory' is non-empty, compiled Java methods are cached within the given directory.
+    /// If 'aotLibraryPath' is non-empty, the library of ahead-of-time compiled methods at the given path is loaded.
+    /// Aborts if the library could not be loaded.
+    /// 'inliningOptions' determine which Java methods are inlined into fully optimized JIT code.
+    /// If 'printCompilation' is true, every installation of newly compiled code of a method is printed to stderr.
+    explicit Runtime(VirtualMachine& virtualMachine, llvm::ArrayRef<Executor*> executors, unsigned compileThreads,
+                     llvm::StringRef codeCacheDirectory, llvm::StringRef aotLibraryPath,
+                     InliningOptions inliningOptions, bool printCompilation);
 
     ~Runtime();
     Runtime(const Runtime&) = delete;
@@ -126,7 +167,31 @@ public:
     /// Returns the LLVM IR Layer that should be used by any LLVM IR producing layer.
     llvm::orc::IRLayer& getLLVMIRLayer()
     {
-        return m_optimizeLayer;
+        return m_classObjectStubImportLayer;
+    }
+
+    /// Returns the class hierarchy analysis used to devirtualize calls in compiled code.
+    ClassHierarchyAnalysis& getClassHierarchyAnalysis()
+    {
+        return m_classHierarchyAnalysis;
+    }
+
+    /// Returns the on-disk cache that should be used for compiled Java methods or null if disabled.
+    CodeCache* getCodeCache() const
+    {
+        return m_codeCache.get();
+    }
+
+    /// Returns the library of ahead-of-time compiled methods or null if none was loaded.
+    const AOTLibrary* getAOTLibrary() const
+    {
+        return m_aotLibrary.get();
+    }
+
+    /// Returns the object layer that should be used to link object files.
+    llvm::orc::ObjectLayer& getObjectLayer()
+    {
+        return m_objectLayer;
     }
 
     /// Returns the adaptor layer that can be used by executors for reusing JIT calling convention implementations
@@ -157,8 +222,57 @@ public:
     /// Registers the methods of 'classObject' within all executors and prepares it for execution.
     /// 'defaultExecutor' is used during registering as the initial executor that should be used when executing the
     /// methods within 'classObject' if possible.
+    /// Any methods whose compiled code relied on no subclass of 'classObject' overriding a method are recompiled.
     void add(ClassObject* classObject, Executor& defaultExecutor);
 
+    /// Discards the compiled code of 'method' and replaces it with newly compiled code once ready. Used when
+    /// assumptions or speculations made when compiling 'method' no longer hold. Code of 'method' that is still being
+    /// compiled is discarded once it has been installed.
+    void recompile(const Method& method);
+
+    /// Changes the executor used to execute 'method' to 'executor'. 'method' continues to be executed by its previous
+    /// executor until the implementation within 'executor' is ready, at which point the stubs of 'method' are updated
+    /// to point to the new implementation.
+    /// If the runtime was created with compile threads, any compilation required by 'executor' happens in the
+    /// background and the new implementation only becomes ready during a later call to
+    /// 'emitFinishedBackgroundCompilations'.
+    void changeExecutor(const Method& method, Executor& executor);
+
+    /// Returns the executor 'method' is executed by or null if the method was never added.
+    Executor* getExecutor(const Method& method) const
+    {
+        return m_executorState.lookup(&method);
+    }
+
+    /// Replaces the JIT calling convention implementation of 'method' with the one defined in 'jitCCDylib' once it is
+    /// ready, without changing the executor of 'method'. This is used by executors to replace code of a lower tier
+    /// with optimized code. Compilation happens in the background as described in 'changeExecutor'.
+    void replaceJITCCImplementation(const Method& method, llvm::orc::JITDylib& jitCCDylib);
+
+    /// Returns true if any background compilations are waiting to be emitted by
+    /// 'emitFinishedBackgroundCompilations'. This is cheap enough to be polled frequently.
+    bool hasFinishedBackgroundCompilations() const
+    {
+        return m_compilerLayer.hasFinishedCompilations();
+    }
+
+    /// Links all finished background compilations and updates the stubs of the corresponding methods.
+    /// Linking may load classes and must therefore only be done on the Java thread.
+    void emitFinishedBackgroundCompilations()
+    {
+        m_compilerLayer.emitFinishedCompilations();
+    }
+
+    /// Emits any finished background compilations. Called by executors at points where the Java thread may link code,
+    /// such as method entries in the interpreter and runtime calls of JIT code.
+    void pollBackgroundCompilations()
+    {
+        if (hasFinishedBackgroundCompilations())
+        {
+            emitFinishedBackgroundCompilations();
+        }
+    }
+
     /// Returns a pointer in the JIT calling convention to the method with the given name.
     /// This pointer can also be called from C++ when cast to the correct signature.
     /// Returns nullptr if no such method exists.
@@ -225,7 +339,8 @@ public:
         requires(!IsVarArg<std::decay_t<F>>::value)
     {
         llvm::cantFail(dylib.define(
-            createLambdaMaterializationUnit(std::move(symbol), m_optimizeLayer, f, m_dataLayout, m_interner)));
+            createLambdaMaterializationUnit(std::move(symbol), m_classObjectStubImportLayer, f, m_dataLayout,
+                                            m_interner)));
     }
 
     /// Adds the C-variadic function 'f' as implementation for symbol 'symbol' to the given library.
@@ -236,5 +351,13 @@ public:
             {{m_interner(symbol), llvm::JITEvaluatedSymbol::fromPointer(f, llvm::JITSymbolFlags::Exported
                                                                                | llvm::JITSymbolFlags::Callable)}})));
     }
+
+    /// Adds 'data' as the storage of the global variable 'symbol' to the given library.
+    template <class T>
+    void addDataSymbol(llvm::orc::JITDylib& dylib, llvm::StringRef symbol, T* data)
+    {
+        llvm::cantFail(dylib.define(llvm::orc::absoluteSymbols(
+            {{m_interner(symbol), llvm::JITEvaluatedSymbol::fromPointer(data, llvm::JITSymbolFlags::Exported)}})));
+    }
 };
 } // namespace jllvm
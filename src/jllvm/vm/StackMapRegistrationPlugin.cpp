@@ -72,7 +72,7 @@ void jllvm::StackMapRegistrationPlugin::parseInterpreterEntry(JavaMethodMetadata
                                                               StackMapParser::RecordAccessor& record,
                                                               StackMapParser& parser)
 {
-    assert(record.getLocation(2).getSmallConstant() == 7 && "interpreter frames must have 6 deopt values");
+    assert(record.getLocation(2).getSmallConstant() == 8 && "interpreter frames must have 8 deopt values");
 
     constexpr std::size_t deoptValuesStart = 3;
 
@@ -84,6 +84,7 @@ void jllvm::StackMapRegistrationPlugin::parseInterpreterEntry(JavaMethodMetadata
     interpreterData.localVariables = toFrameValue<std::uint64_t*>(record.getLocation(deoptValuesStart + 5), parser);
     interpreterData.localVariablesGCMask =
         toFrameValue<std::uint64_t*>(record.getLocation(deoptValuesStart + 6), parser);
+    interpreterData.stacklessFrames = toFrameValue<StacklessFrame**>(record.getLocation(deoptValuesStart + 7), parser);
 }
 
 void jllvm::StackMapRegistrationPlugin::parseJITEntry(JavaMethodMetadata::JITData& jitData,
@@ -94,41 +95,66 @@ void jllvm::StackMapRegistrationPlugin::parseJITEntry(JavaMethodMetadata::JITDat
     {
         DeoptCountPos = 2,
         BytecodeDeoptPos = 3,
-        NumLocalsPos = 4,
-        LocalsStartPos = 5,
     };
 
     std::uint32_t deoptCount = record.getLocation(DeoptCountPos).getSmallConstant();
     assert(deoptCount != 0 && "jit frame must have deopt values");
 
     std::uint64_t addr = functionAddress + record.getInstructionOffset();
-    std::uint16_t byteCodeOffset = record.getLocation(BytecodeDeoptPos).getSmallConstant();
-    std::uint16_t numLocals = record.getLocation(NumLocalsPos).getSmallConstant();
 
-    auto range = llvm::seq<std::uint32_t>(LocalsStartPos, LocalsStartPos + deoptCount);
-    auto indexIter = range.begin();
-
-    std::vector<FrameValue<std::uint64_t>> locals(numLocals);
-    for (FrameValue<std::uint64_t>& iter : locals)
-    {
-        iter = toFrameValue<std::uint64_t>(record.getLocation(*indexIter++), parser);
-    }
-
-    std::vector<std::uint64_t> localsGCMask(llvm::divideCeil(numLocals, 64));
-    for (std::uint64_t& iter : localsGCMask)
+    std::uint32_t index = BytecodeDeoptPos;
+    auto readConstant = [&]() -> std::uint64_t
     {
-        StackMapParser::LocationAccessor location = record.getLocation(*indexIter++);
+        StackMapParser::LocationAccessor location = record.getLocation(index++);
         if (location.getKind() == StackMapParser::LocationKind::Constant)
         {
-            iter = location.getSmallConstant();
+            return location.getSmallConstant();
+        }
+        return parser.getConstant(location.getConstantIndex()).getValue();
+    };
+    auto readValues = [&](std::uint16_t count)
+    {
+        std::vector<FrameValue<std::uint64_t>> values(count);
+        for (FrameValue<std::uint64_t>& iter : values)
+        {
+            iter = toFrameValue<std::uint64_t>(record.getLocation(index++), parser);
         }
-        else
+        return values;
+    };
+    auto readGCMask = [&](std::uint16_t count)
+    {
+        std::vector<std::uint64_t> gcMask(llvm::divideCeil(count, 64));
+        for (std::uint64_t& iter : gcMask)
+        {
+            iter = readConstant();
+        }
+        return gcMask;
+    };
+
+    // Calls within inlined Java methods have the deopt values of the inlined frames appended after the ones of the
+    // outermost frame. The deopt values of every inlined frame are prefixed by its method.
+    JavaMethodMetadata::JITData::PerPCData pcData;
+    const Method* method = jitData.getMethod();
+    while (true)
+    {
+        JavaMethodMetadata::JITData::FrameState& state = pcData.frames.emplace_back();
+        state.method = method;
+        state.byteCodeOffset = readConstant();
+        std::uint16_t numLocals = readConstant();
+        state.locals = readValues(numLocals);
+        state.localsGCMask = readGCMask(numLocals);
+        std::uint16_t numOperands = readConstant();
+        state.operandStack = readValues(numOperands);
+        state.operandStackGCMask = readGCMask(numOperands);
+
+        if (index == BytecodeDeoptPos + deoptCount)
         {
-            iter = parser.getConstant(location.getConstantIndex()).getValue();
+            break;
         }
+        method = reinterpret_cast<const Method*>(readConstant());
     }
 
-    jitData.insert(addr, {byteCodeOffset, std::move(locals), std::move(localsGCMask)});
+    jitData.insert(addr, std::move(pcData));
 }
 
 void jllvm::StackMapRegistrationPlugin::modifyPassConfig(llvm::orc::MaterializationResponsibility& mr,
@@ -16,11 +16,13 @@
 #include <llvm/ADT/DepthFirstIterator.h>
 #include <llvm/ADT/SCCIterator.h>
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/Format.h>
 #include <llvm/Support/TargetSelect.h>
 
 #include <jllvm/compiler/ClassObjectStubMangling.hpp>
 #include <jllvm/unwind/Unwinder.hpp>
 
+#include "FaultMapRegistrationPlugin.hpp"
 #include "NativeImplementation.hpp"
 
 #define DEBUG_TYPE "jvm"
@@ -30,9 +32,22 @@ jllvm::VirtualMachine::VirtualMachine(BootOptions&& bootOptions)
         m_stringInterner, std::move(bootOptions.classPath),
         [this, bootOptions](ClassObject& classObject) { m_runtime.add(&classObject, getDefaultExecutor()); },
         [&] { return reinterpret_cast<void**>(m_gc.allocateStatic().data()); }),
-      m_runtime(*this, {&m_jit, &m_interpreter, &m_jni}),
-      m_jit(*this),
-      m_interpreter(*this, /*backEdgeThreshold=*/bootOptions.backEdgeThreshold),
+      m_runtime(*this, {&m_jit, &m_interpreter, &m_jni}, /*compileThreads=*/bootOptions.compileThreads,
+                /*codeCacheDirectory=*/bootOptions.codeCacheDirectory,
+                /*aotLibraryPath=*/
+                bootOptions.executionMode == ExecutionMode::Interpreter ? "" : bootOptions.aotLibrary,
+                /*inliningOptions=*/
+                InliningOptions{/*maxInlineSize=*/bootOptions.maxInlineSize,
+                                /*hotMaxInlineSize=*/bootOptions.hotMaxInlineSize},
+                /*printCompilation=*/bootOptions.printCompilation),
+      m_jit(*this, /*tierUpThreshold=*/bootOptions.tierUpThreshold),
+      m_interpreter(*this, /*backEdgeThreshold=*/bootOptions.backEdgeThreshold,
+                    /*invocationThreshold=*/bootOptions.invocationThreshold,
+                    /*profilingEnabled=*/bootOptions.executionMode == ExecutionMode::Mixed,
+                    /*zeroFrames=*/bootOptions.zeroInterpreterFrames,
+                    /*dumpByteCodePairs=*/bootOptions.dumpByteCodePairs,
+                    /*byteCodePairHistogram=*/bootOptions.byteCodePairHistogram,
+                    /*stacklessCalls=*/bootOptions.stacklessCalls),
       m_jni(*this, m_jniEnv.get()),
       m_gc(/*random value for now*/ 1 << 20),
       // Seed from the C++ implementations entropy source.
@@ -40,7 +55,9 @@ jllvm::VirtualMachine::VirtualMachine(BootOptions&& bootOptions)
       // Exclude 0 from the output as that is our sentinel value for "not yet calculated".
       m_hashIntDistrib(1, std::numeric_limits<std::uint32_t>::max()),
       m_javaHome(bootOptions.javaHome),
-      m_executionMode(bootOptions.executionMode)
+      m_executionMode(bootOptions.executionMode),
+      m_fastThrowThreshold(bootOptions.fastThrowThreshold),
+      m_dumpImplicitExceptionSites(bootOptions.dumpImplicitExceptionSites)
 {
     registerJavaClasses(*this);
 
@@ -56,7 +73,7 @@ jllvm::VirtualMachine::VirtualMachine(BootOptions&& bootOptions)
         [this](GarbageCollector::RootProvider::RelocateObjectFn relocateObjectFn)
         {
             unwindJavaStack(
-                [=](JavaFrame javaFrame)
+                [=, this](JavaFrame javaFrame)
                 {
                     std::optional interpreterFrame = llvm::dyn_cast<InterpreterFrame>(javaFrame);
                     if (!interpreterFrame)
@@ -82,6 +99,7 @@ jllvm::VirtualMachine::VirtualMachine(BootOptions&& bootOptions)
                         }
                     };
 
+                    m_interpreter.materializeGCMasks(*interpreterFrame);
                     addRoots(interpreterFrame->getLocals(), interpreterFrame->getLocalsGCMask());
                     addRoots(interpreterFrame->getOperandStack(), interpreterFrame->getOperandStackGCMask());
                 });
@@ -123,7 +141,13 @@ jllvm::VirtualMachine::VirtualMachine(BootOptions&& bootOptions)
     executeStaticMethod("java/lang/System", "initPhase1", "()V");
 }
 
-jllvm::VirtualMachine::~VirtualMachine() = default;
+jllvm::VirtualMachine::~VirtualMachine()
+{
+    if (m_dumpImplicitExceptionSites)
+    {
+        dumpImplicitExceptionSites(llvm::errs());
+    }
+}
 
 int jllvm::VirtualMachine::executeMain(llvm::StringRef path, llvm::ArrayRef<llvm::StringRef> args)
 {
@@ -259,6 +283,31 @@ void jllvm::VirtualMachine::throwJavaException(Throwable* exception)
                 return;
             }
 
+            // JITted code branches to its exception handlers by itself, making it possible to continue execution of
+            // the frame. This is only possible for the innermost method executing within the native frame, as the
+            // pending exception is dispatched by the code following the call it is executing.
+            if (frame.isJIT() && !frame.hasInlinedFrames())
+            {
+                m_jit.resumeAtExceptionHandler(frame, *handlerPc, exception);
+            }
+
+            // Stackless frames and their callers within the same native frame are continued by the interpreter loop
+            // executing them.
+            if (std::optional interpreterFrame = llvm::dyn_cast<InterpreterFrame>(frame);
+                interpreterFrame && (interpreterFrame->isStackless() || *interpreterFrame->getStacklessFrameChain()))
+            {
+                m_interpreter.resumeAtExceptionHandler(*interpreterFrame, *handlerPc, exception);
+            }
+
+            // The handler of a method inlined into one of its callees is executed by deoptimizing the native frame
+            // into the interpreter.
+            if (frame.isInlined())
+            {
+                m_runtime.doOnStackReplacement(
+                    frame.getOutermostFrame(),
+                    m_interpreter.createOSRStateForExceptionHandler(frame, *handlerPc, exception));
+            }
+
             m_runtime.doOnStackReplacement(
                 frame, getDefaultOSRTarget().createOSRStateForExceptionHandler(frame, *handlerPc, exception));
         });
@@ -268,8 +317,95 @@ void jllvm::VirtualMachine::throwJavaException(Throwable* exception)
     throw *exception;
 }
 
+jllvm::GCRootRef<jllvm::Throwable> jllvm::VirtualMachine::countImplicitException(FieldType exceptionType)
+{
+    // Sites are neither needed for fast throws nor for dumping them.
+    if (m_fastThrowThreshold == 0 && !m_dumpImplicitExceptionSites)
+    {
+        return nullptr;
+    }
+
+    const Method* method = nullptr;
+    std::uint16_t byteCodeOffset = 0;
+    unwindJavaStack(
+        [&](JavaFrame frame)
+        {
+            if (std::optional<std::uint16_t> offset = frame.getByteCodeOffset())
+            {
+                method = frame.getMethod();
+                byteCodeOffset = *offset;
+            }
+            return UnwindAction::StopUnwinding;
+        });
+    // Native methods do not have a bytecode offset to attribute the exception to.
+    if (!method)
+    {
+        return nullptr;
+    }
+
+    ClassObject& classObject = m_classLoader.forName(exceptionType);
+    std::tuple key{method, byteCodeOffset, static_cast<const ClassObject*>(&classObject)};
+    ImplicitExceptionSite& site = m_implicitExceptionSites[key];
+    site.count++;
+    if (m_fastThrowThreshold == 0 || site.count <= m_fastThrowThreshold)
+    {
+        return nullptr;
+    }
+    if (site.preallocated)
+    {
+        return site.preallocated;
+    }
+
+    LLVM_DEBUG({
+        llvm::dbgs() << "Preallocating " << exceptionType.pretty() << " for "
+                     << method->getClassObject()->getClassName() << '.' << method->getName()
+                     << method->getType().textual() << " at offset " << byteCodeOffset << " after " << site.count
+                     << " throws\n";
+    });
+
+    // The exception is shared by all later throws at the site, making a message describing the specific failure or a
+    // backtrace of the specific throw meaningless.
+    GCUniqueRoot exception = m_gc.root(m_gc.allocate<Throwable>(&classObject));
+    executeObjectConstructor(exception, "()V");
+
+    // The constructor may have thrown implicit exceptions itself, invalidating 'site'.
+    ImplicitExceptionSite& updatedSite = m_implicitExceptionSites[key];
+    updatedSite.preallocated = static_cast<GCRootRef<Throwable>>(m_gc.allocateStatic());
+    updatedSite.preallocated.assign(exception);
+    return updatedSite.preallocated;
+}
+
+void jllvm::VirtualMachine::dumpImplicitExceptionSites(llvm::raw_ostream& os) const
+{
+    std::vector<std::pair<std::uint64_t, decltype(m_implicitExceptionSites)::key_type>> sites;
+    for (auto&& [key, site] : m_implicitExceptionSites)
+    {
+        sites.emplace_back(site.count, key);
+    }
+    llvm::sort(sites, [](const auto& lhs, const auto& rhs) { return lhs.first > rhs.first; });
+
+    os << "Implicit exception sites:\n";
+    for (auto&& [count, key] : sites)
+    {
+        auto [method, byteCodeOffset, classObject] = key;
+        os << llvm::format_decimal(count, 12) << ' ' << method->getClassObject()->getClassName() << '.'
+           << method->getName() << method->getType().textual() << " at offset " << byteCodeOffset << ": "
+           << classObject->getDescriptor().pretty();
+        if (m_fastThrowThreshold != 0 && count > m_fastThrowThreshold)
+        {
+            os << " (fast throw)";
+        }
+        os << '\n';
+    }
+}
+
 void jllvm::VirtualMachine::throwArrayIndexOutOfBoundsException(std::int32_t indexAccessed, std::int32_t arrayLength)
 {
+    if (GCRootRef<Throwable> exception = countImplicitException("Ljava/lang/ArrayIndexOutOfBoundsException;"))
+    {
+        throwJavaException(exception);
+    }
+
     String* string = m_stringInterner.intern(
         llvm::formatv("Index {0} out of bounds for length {1}", indexAccessed, arrayLength).str());
     throwException("Ljava/lang/ArrayIndexOutOfBoundsException;", "(Ljava/lang/String;)V", string);
@@ -277,6 +413,11 @@ void jllvm::VirtualMachine::throwArrayIndexOutOfBoundsException(std::int32_t ind
 
 void jllvm::VirtualMachine::throwClassCastException(ObjectInterface* object, ClassObject* classObject)
 {
+    if (GCRootRef<Throwable> exception = countImplicitException("Ljava/lang/ClassCastException;"))
+    {
+        throwJavaException(exception);
+    }
+
     std::string className = object->getClass()->getDescriptor().pretty();
     std::string name = classObject->getDescriptor().pretty();
     llvm::StringRef prefix = classObject->isClass() || classObject->isInterface() ? "class " : "";
@@ -294,9 +435,36 @@ void jllvm::VirtualMachine::throwNegativeArraySizeException(std::int32_t arrayLe
 
 void jllvm::VirtualMachine::throwNullPointerException()
 {
+    if (GCRootRef<Throwable> exception = countImplicitException("Ljava/lang/NullPointerException;"))
+    {
+        throwJavaException(exception);
+    }
+
     throwException("Ljava/lang/NullPointerException;", "()V");
 }
 
+void jllvm::VirtualMachine::deoptimize(JavaFrame frame, DeoptimizationReason reason)
+{
+    const Method& method = *frame.getMethod();
+    LLVM_DEBUG({
+        llvm::dbgs() << "Deoptimizing " << method.getClassObject()->getClassName() << '.' << method.getName()
+                     << method.getType().textual() << " at offset " << *frame.getByteCodeOffset() << " for reason "
+                     << static_cast<unsigned>(reason) << '\n';
+    });
+
+    // The code deoptimizing is part of the code compiled for the outermost method, even if 'frame' is an inlined
+    // frame. Recompiled code takes the number of deoptimizations into account to stop emitting uncommon traps.
+    JavaFrame outermostFrame = frame.getOutermostFrame();
+    const Method& compiledMethod = *outermostFrame.getMethod();
+    if (MethodProfile* profile = compiledMethod.getProfile())
+    {
+        profile->incrementDeoptimizationCount();
+    }
+    m_runtime.recompile(compiledMethod);
+
+    m_runtime.doOnStackReplacement(outermostFrame, m_interpreter.createOSRStateForDeoptimization(frame));
+}
+
 jllvm::VirtualMachine jllvm::VirtualMachine::create(BootOptions&& options)
 {
     // Disable OSR into the JIT if the JIT is disabled.
@@ -317,6 +485,12 @@ jllvm::VirtualMachine jllvm::VirtualMachine::create(BootOptions&& options)
     // Deopt values are read-only and can be read from CSR registers by libunwind.
     llvmArgs.push_back("-use-registers-for-deopt-values=1");
 
+#if JLLVM_IMPLICIT_NULL_CHECKS
+    // Null checks marked with 'make.implicit' are folded into memory accesses. Faults caused by these are handled by
+    // the signal handler installed by 'FaultMapRegistrationPlugin'.
+    llvmArgs.push_back("-enable-implicit-null-checks=1");
+#endif
+
 #ifndef NDEBUG
     std::string temp = "-debug-only=" + options.debugLogging;
     llvmArgs.push_back("-jllvm-gc-every-alloc=1");
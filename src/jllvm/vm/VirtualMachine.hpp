@@ -13,6 +13,7 @@
 
 #pragma once
 
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/Support/Allocator.h>
 #include <llvm/Support/MemoryBuffer.h>
 
@@ -55,11 +56,49 @@ struct BootOptions
     bool systemInitialization = true;
     ExecutionMode executionMode = ExecutionMode::Mixed;
     std::string debugLogging;
+    /// Whether the operand stack and local variables of interpreter frames should be zero-initialized on entry.
+    /// This is not required for correctness and only useful for debugging.
+    bool zeroInterpreterFrames = false;
+    /// Whether a histogram of all pairs of bytecode instructions executed in sequence by the interpreter should be
+    /// printed to stderr on exit. Used to determine new candidates for super instructions in the interpreter.
+    bool dumpByteCodePairs = false;
+    /// Path to a histogram printed by 'dumpByteCodePairs' used to select the super instructions of the interpreter.
+    /// All super instructions are used if empty.
+    std::string byteCodePairHistogram;
+    /// Whether calls from interpreted methods to interpreted methods are executed as stackless frames within the
+    /// interpreter loop of the caller rather than through a new native frame.
+    bool stacklessCalls = false;
+    /// Whether the number of implicit exceptions thrown at every bytecode offset should be printed to stderr on exit.
+    bool dumpImplicitExceptionSites = false;
+    /// Whether a line should be printed to stderr whenever newly compiled code of a method is installed.
+    bool printCompilation = false;
+    /// Directory used to cache JIT compiled methods across processes. Caching is disabled if empty.
+    std::string codeCacheDirectory;
+    /// Path to a library of methods compiled ahead-of-time by 'jllvm-jvmc --aot'. Methods contained in the library
+    /// are executed by the JIT right away. Unused in interpreter-only mode.
+    std::string aotLibrary;
 
     // Runtime tuning parameters.
 
     /// Number of backedges before the Interpreter performs OSR into the JIT.
     std::uint64_t backEdgeThreshold = 50000;
+    /// Number of invocations of a method in the Interpreter before it is compiled by the JIT.
+    std::uint64_t invocationThreshold = 10000;
+    /// Number of invocations and loop iterations of baseline JIT code before it is recompiled with full optimizations.
+    /// If 0, the JIT always compiles with full optimizations.
+    std::uint64_t tierUpThreshold = 10000;
+    /// Maximum bytecode size in bytes of a method for it to be inlined into fully optimized JIT code. Inlining is
+    /// disabled if 0.
+    std::uint16_t maxInlineSize = 35;
+    /// Maximum bytecode size in bytes of a method for it to be inlined at a call site that has been frequently executed
+    /// by the interpreter.
+    std::uint16_t hotMaxInlineSize = 325;
+    /// Number of threads used to compile methods in the background. Methods continue to be interpreted until their
+    /// compilation has finished. If 0, methods are compiled synchronously.
+    unsigned compileThreads = 1;
+    /// Number of implicit exceptions of one type thrown at the same bytecode offset after which a preallocated
+    /// exception without a message is thrown instead of constructing a new one. Disabled if 0.
+    std::uint64_t fastThrowThreshold = 1000;
 };
 
 struct ModelState;
@@ -88,6 +127,29 @@ class VirtualMachine
     // Instances of 'Model::State', subtypes of ModelState.
     std::vector<std::unique_ptr<ModelState>> m_modelState;
 
+    /// Implicit exceptions thrown by the VM at a bytecode offset of a method.
+    struct ImplicitExceptionSite
+    {
+        /// Number of exceptions thrown.
+        std::uint64_t count = 0;
+        /// Exception thrown instead of a new exception once 'count' exceeds the fast throw threshold.
+        GCRootRef<Throwable> preallocated;
+    };
+
+    /// Implicit exception sites indexed by method, bytecode offset and class object of the exception.
+    llvm::DenseMap<std::tuple<const Method*, std::uint16_t, const ClassObject*>, ImplicitExceptionSite>
+        m_implicitExceptionSites;
+    std::uint64_t m_fastThrowThreshold;
+    bool m_dumpImplicitExceptionSites;
+
+    /// Counts an implicit exception of type 'exceptionType' being thrown at the current bytecode offset of the
+    /// innermost Java frame. Returns a preallocated exception without a message to throw instead of a new exception if
+    /// more than the fast throw threshold of these exceptions have been thrown at that offset. Returns null otherwise.
+    GCRootRef<Throwable> countImplicitException(FieldType exceptionType);
+
+    /// Prints all implicit exception sites to 'os', sorted by the number of exceptions thrown.
+    void dumpImplicitExceptionSites(llvm::raw_ostream& os) const;
+
     /// Returns the executor that should be used by default when first executing a method.
     Executor& getDefaultExecutor()
     {
@@ -226,6 +288,11 @@ public:
 
     /// Construct and throws an 'ArrayIndexOutOfBoundsException' with a message created from the index that was accessed
     /// and the length of the array.
+    ///
+    /// This and the other methods throwing implicit exceptions, with the exception of
+    /// 'throwNegativeArraySizeException', throw a preallocated exception without a message instead once the innermost
+    /// Java frame has thrown more than 'BootOptions::fastThrowThreshold' of these exceptions at its current bytecode
+    /// offset.
     [[noreturn]] void throwArrayIndexOutOfBoundsException(std::int32_t indexAccessed, std::int32_t arrayLength);
 
     /// Construct and throws an 'ClassCastException' with a message created from the object being cast and the class
@@ -239,6 +306,14 @@ public:
     /// Construct and throws a 'NullPointerException' with the default constructor.
     [[noreturn]] void throwNullPointerException();
 
+    /// Deoptimizes the JITted 'frame' which is currently calling 'jllvm_deoptimize' due to 'reason'. The compiled code
+    /// of its method is discarded, making sure it is recompiled the next time it is called. The frame itself is then
+    /// replaced by an interpreter frame continuing execution at the current bytecode offset with the local variables
+    /// and operand stack of 'frame'.
+    /// If 'frame' is a method inlined into JITted code, the native frame it is executing in is deoptimized instead,
+    /// with every inlined method getting its own interpreter frame.
+    void deoptimize(JavaFrame frame, DeoptimizationReason reason);
+
     /// Performs stack unwinding, calling 'f' for every Java frame encountered.
     /// 'f' may optionally return a 'UnwindAction' to control whether unwinding should continue.
     /// Returns true if 'UnwindAction::UnwindAction' was ever returned.
@@ -254,16 +329,46 @@ public:
                     return UnwindAction::ContinueUnwinding;
                 }
 
-                using T = decltype(f(std::declval<JavaFrame>()));
-                if constexpr (std::is_void_v<T>)
+                auto callF = [&](JavaFrame javaFrame)
                 {
-                    f(JavaFrame(*metadata, frame));
-                    return UnwindAction::ContinueUnwinding;
+                    using T = decltype(f(std::declval<JavaFrame>()));
+                    if constexpr (std::is_void_v<T>)
+                    {
+                        f(javaFrame);
+                        return UnwindAction::ContinueUnwinding;
+                    }
+                    else
+                    {
+                        return f(javaFrame);
+                    }
+                };
+
+                // Stackless frames executed by the interpreter within this frame are its callees and therefore
+                // come first, innermost first.
+                if (metadata->isInterpreter())
+                {
+                    for (StacklessFrame* iter = *metadata->getInterpreterData().stacklessFrames.readScalar(frame); iter;
+                         iter = iter->caller)
+                    {
+                        if (callF(JavaFrame(*metadata, frame, iter)) == UnwindAction::StopUnwinding)
+                        {
+                            return UnwindAction::StopUnwinding;
+                        }
+                    }
                 }
-                else
+                // Similarly, methods inlined into JITted code are executing within this frame, innermost first.
+                else if (metadata->isJIT())
                 {
-                    return f(JavaFrame(*metadata, frame));
+                    for (std::size_t inlinedFrame = metadata->getJITData()[frame.getProgramCounter()].frames.size() - 1;
+                         inlinedFrame != 0; inlinedFrame--)
+                    {
+                        if (callF(JavaFrame(*metadata, frame, inlinedFrame)) == UnwindAction::StopUnwinding)
+                        {
+                            return UnwindAction::StopUnwinding;
+                        }
+                    }
                 }
+                return callF(JavaFrame(*metadata, frame));
             });
     }
 
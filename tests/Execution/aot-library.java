@@ -0,0 +1,69 @@
+// RUN: javac %s -d %t
+// RUN: jllvm-jvmc --aot -o %t/test.a %t
+// RUN: jllvm -Xaot-library=%t/test.a %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xaot-library=%t/test.a %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint -Xaot-library=%t/test.a %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+    public static native void print(String s);
+
+    private static int s_field = 3;
+
+    static class Base
+    {
+        int get()
+        {
+            return 1;
+        }
+    }
+
+    static class Derived extends Base
+    {
+        @Override
+        int get()
+        {
+            return 2;
+        }
+    }
+
+    private static int fib(int n)
+    {
+        return n < 2 ? n : fib(n - 1) + fib(n - 2);
+    }
+
+    private static int sum(Base[] array)
+    {
+        int sum = 0;
+        for (Base base : array)
+        {
+            sum += base.get();
+        }
+        return sum;
+    }
+
+    private static void thrower()
+    {
+        throw new IllegalStateException("thrown");
+    }
+
+    public static void main(String[] args)
+    {
+        // CHECK: 6765
+        print(fib(20));
+        // CHECK: 6
+        print(sum(new Base[]{new Base(), new Derived(), new Base(), new Derived()}));
+        // CHECK: 3
+        print(s_field);
+        try
+        {
+            thrower();
+        }
+        catch (IllegalStateException e)
+        {
+            // CHECK: thrown
+            print(e.getMessage());
+        }
+    }
+}
@@ -0,0 +1,89 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xjit %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    public static native void print(double d);
+
+    public static native void print(String s);
+
+    // Bounds checks are provably redundant.
+    static int sum(int[] array)
+    {
+        int sum = 0;
+        for (int i = 0; i < array.length; i++)
+        {
+            sum += array[i];
+        }
+        return sum;
+    }
+
+    // Bounds checks are only redundant if 'n' is at most the length of both arrays.
+    static void axpy(double a, double[] x, double[] y, int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            y[i] += a * x[i];
+        }
+    }
+
+    // Bounds checks are only redundant for indices that are not negative.
+    static int sumFrom(int[] array, int start)
+    {
+        int sum = 0;
+        for (int i = start; i < array.length; i++)
+        {
+            sum += array[i];
+        }
+        return sum;
+    }
+
+    public static void main(String[] args)
+    {
+        int[] ints = new int[100];
+        for (int i = 0; i < ints.length; i++)
+        {
+            ints[i] = i;
+        }
+        // CHECK: 4950
+        print(sum(ints));
+
+        double[] x = new double[64];
+        double[] y = new double[64];
+        for (int i = 0; i < x.length; i++)
+        {
+            x[i] = i;
+            y[i] = 1;
+        }
+        axpy(2, x, y, 64);
+        // CHECK-NEXT: 127
+        print(y[63]);
+
+        try
+        {
+            axpy(2, x, new double[32], 64);
+        }
+        catch (ArrayIndexOutOfBoundsException e)
+        {
+            // CHECK-NEXT: Index 32 out of bounds for length 32
+            print(e.getMessage());
+        }
+
+        // CHECK-NEXT: 4905
+        print(sumFrom(ints, 10));
+
+        try
+        {
+            sumFrom(ints, -3);
+        }
+        catch (ArrayIndexOutOfBoundsException e)
+        {
+            // CHECK-NEXT: Index -3 out of bounds for length 100
+            print(e.getMessage());
+        }
+    }
+}
@@ -0,0 +1,43 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xinvocation-threshold=1 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=1 -Xcompile-threads=1 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=10 -Xcompile-threads=4 %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    private static int square(int i)
+    {
+        return i * i;
+    }
+
+    private int m_counter;
+
+    private void increment()
+    {
+        m_counter++;
+    }
+
+    private static int call(int i)
+    {
+        // Called from the interpreter, while the calls within are executed by whichever executor is installed in the
+        // stubs at the time.
+        return square(i) - square(i - 1);
+    }
+
+    public static void main(String[] args)
+    {
+        Test test = new Test();
+        int sum = 0;
+        for (int i = 0; i < 2000; i++)
+        {
+            sum += call(i);
+            test.increment();
+        }
+        // CHECK: 3996000
+        print(sum);
+        // CHECK: 2000
+        print(test.m_counter);
+    }
+}
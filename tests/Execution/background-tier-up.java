@@ -0,0 +1,40 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=2 -Xprint-compilation %t/Test.class 2> %t/background.txt \
+// RUN:   | FileCheck %s
+// RUN: FileCheck %s --check-prefix=INSTALLED < %t/background.txt
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=0 -Xprint-compilation %t/Test.class 2> %t/sync.txt \
+// RUN:   | FileCheck %s
+// RUN: FileCheck %s --check-prefix=INSTALLED < %t/sync.txt
+
+// Only JIT code is executed, making the runtime calls of baseline code the only opportunity to install the optimized
+// code compiled in the background.
+// INSTALLED: Installed Test.sum:(I)I from <javaJIT>
+// INSTALLED: Installed Test.sum:(I)I from <javaJITOptimized>
+
+class Test
+{
+    public static native void print(long l);
+
+    private static int sum(int n)
+    {
+        int result = 0;
+        for (int i = 0; i < n; i++)
+        {
+            result += i;
+        }
+        return result;
+    }
+
+    public static void main(String[] args)
+    {
+        // Executes long enough in baseline code for the background compilation to finish. Once the optimized code is
+        // installed, the remaining iterations finish quickly.
+        long total = 0;
+        for (int i = 0; i < 200000; i++)
+        {
+            total += sum(1000);
+        }
+        // CHECK: 99900000000
+        print(total);
+    }
+}
@@ -0,0 +1,81 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xjit %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=2 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=5 %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    static class Base
+    {
+        int get()
+        {
+            return 1;
+        }
+    }
+
+    // Only loaded once 'createOverride' is first executed, invalidating the single implementation of 'Base.get'.
+    static class Override extends Base
+    {
+        @Override
+        int get()
+        {
+            return 2;
+        }
+    }
+
+    static class Inherit extends Base
+    {
+    }
+
+    private static Base createOverride()
+    {
+        return new Override();
+    }
+
+    private static int call(Base base)
+    {
+        return base.get();
+    }
+
+    private static int loop(Base base, int n)
+    {
+        int sum = 0;
+        for (int i = 0; i < n; i++)
+        {
+            sum += base.get();
+            // Loads 'Override' while this frame is active.
+            if (i == n / 2)
+            {
+                base = createOverride();
+            }
+        }
+        return sum;
+    }
+
+    public static void main(String[] args)
+    {
+        Base base = new Base();
+        int sum = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            sum += call(base);
+        }
+        // CHECK: 100
+        print(sum);
+
+        // Subclasses not overriding the method keep the assumption intact.
+        // CHECK-NEXT: 1
+        print(call(new Inherit()));
+
+        // CHECK-NEXT: 149
+        print(loop(base, 100));
+
+        // CHECK-NEXT: 2
+        print(call(createOverride()));
+        // CHECK-NEXT: 1
+        print(call(base));
+    }
+}
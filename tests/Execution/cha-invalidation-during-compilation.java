@@ -0,0 +1,66 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=2 -Xprint-compilation %t/Test.class 2> %t/background.txt \
+// RUN:   | FileCheck %s
+// RUN: FileCheck %s --check-prefix=INSTALLED < %t/background.txt
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=0 -Xprint-compilation %t/Test.class 2> %t/sync.txt \
+// RUN:   | FileCheck %s
+// RUN: FileCheck %s --check-prefix=INSTALLED < %t/sync.txt
+
+// The optimized code of 'call' devirtualizing 'Base.get' is installed and then discarded in favour of new baseline
+// code, even if 'Override' was loaded while the optimized code was still being compiled in the background.
+// INSTALLED: Installed Test.call:(LTest$Base;)I from <javaJITOptimized>
+// INSTALLED: Installed Test.call:(LTest$Base;)I from <javaJIT>
+
+class Test
+{
+    public static native void print(int i);
+
+    static class Base
+    {
+        int get()
+        {
+            return 1;
+        }
+    }
+
+    // Only loaded once 'createOverride' is first executed, invalidating the single implementation of 'Base.get'.
+    static class Override extends Base
+    {
+        @Override
+        int get()
+        {
+            return 2;
+        }
+    }
+
+    private static Base createOverride()
+    {
+        return new Override();
+    }
+
+    private static int call(Base base)
+    {
+        return base.get();
+    }
+
+    public static void main(String[] args)
+    {
+        Base base = new Base();
+        int sum = 0;
+        // The last invocation requests the optimized code of 'call'.
+        for (int i = 0; i < 10; i++)
+        {
+            sum += call(base);
+        }
+        // Loads 'Override' right away, most likely while the optimized code is still being compiled.
+        Base override = createOverride();
+
+        // Executes long enough for the background compilation to finish and be installed.
+        for (int i = 0; i < 100000; i++)
+        {
+            sum += call(override) + call(base);
+        }
+        // CHECK: 300010
+        print(sum);
+    }
+}
@@ -0,0 +1,44 @@
+// RUN: javac %s -d %t
+// RUN: rm -rf %t/cache
+// RUN: jllvm -Xjit -Xtier-up-threshold=0 -Xcode-cache=%t/cache %t/Test.class | FileCheck %s
+// RUN: ls %t/cache | FileCheck %s --check-prefix=EMPTY --allow-empty
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=2 -Xcode-cache=%t/cache %t/Test.class | FileCheck %s
+// RUN: ls %t/cache | FileCheck %s --check-prefix=CACHE
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=2 -Xcode-cache=%t/cache %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=0 -Xcode-cache=%t/cache %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=0 -Xcode-cache=%t/cache %t/Test.class | FileCheck %s
+
+// Optimized code relies on the classes loaded by the process and is never cached.
+// EMPTY-NOT: .o
+
+// CACHE: {{^[0-9a-f]+}}.o
+// CACHE-NOT: .tmp
+
+class Test
+{
+    public static native void print(int i);
+    public static native void print(String s);
+
+    private static int s_field = 5;
+
+    private int m_value;
+
+    private static int fib(int n)
+    {
+        return n < 2 ? n : fib(n - 1) + fib(n - 2);
+    }
+
+    public static void main(String[] args)
+    {
+        // CHECK: 6765
+        print(fib(20));
+
+        // Field accesses and class objects must be resolved at link time rather than be part of the cached code.
+        Test test = new Test();
+        test.m_value = s_field * 2;
+        // CHECK: 10
+        print(test.m_value);
+        // CHECK: cached
+        print("cached");
+    }
+}
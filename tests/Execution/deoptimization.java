@@ -0,0 +1,83 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xinvocation-threshold=5 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=5 -Xtier-up-threshold=0 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    public static native void print(long l);
+
+    interface Shape
+    {
+        int area();
+    }
+
+    static class Square implements Shape
+    {
+        public int area()
+        {
+            return 4;
+        }
+    }
+
+    static class Rectangle implements Shape
+    {
+        public int area()
+        {
+            return 6;
+        }
+    }
+
+    static class Triangle implements Shape
+    {
+        public int area()
+        {
+            return 3;
+        }
+    }
+
+    // The operand stack contains a long and a double below the receiver when calling 'area'.
+    static long scaled(long base, Shape shape, double scale)
+    {
+        return base + (long)(scale * shape.area());
+    }
+
+    // The operand stack contains an array reference and two ints below the receiver when calling 'area'.
+    static void accumulate(int[] counts, Shape shape)
+    {
+        counts[0] += shape.area();
+    }
+
+    public static void main(String[] args)
+    {
+        Shape[] shapes = new Shape[]{new Square(), new Rectangle(), new Triangle()};
+
+        // Only ever call with two distinct receivers while the methods are being profiled.
+        long total = 0;
+        int[] counts = new int[1];
+        for (int i = 0; i < 10; i++)
+        {
+            total += scaled(i, shapes[i % 2], 1.5);
+            accumulate(counts, shapes[i % 2]);
+        }
+        // CHECK: 120
+        print(total);
+        // CHECK: 50
+        print(counts[0]);
+
+        // Fail the guards often enough for the frames to be deoptimized in the middle of evaluating the expressions.
+        total = 0;
+        counts[0] = 0;
+        for (int i = 0; i < 3000; i++)
+        {
+            total += scaled(i, shapes[i % 3], 1.5);
+            accumulate(counts, shapes[i % 3]);
+        }
+        // CHECK: 4517500
+        print(total);
+        // CHECK: 13000
+        print(counts[0]);
+    }
+}
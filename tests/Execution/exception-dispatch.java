@@ -0,0 +1,208 @@
+// RUN: javac %s -d %t
+// RUN: rm '%t/Test$Missing.class'
+// RUN: jllvm -Xjit %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=5 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    static class Base extends RuntimeException
+    {
+    }
+
+    static class Derived extends Base
+    {
+    }
+
+    // Its class file is deleted. Catch types are never loaded when dispatching exceptions.
+    static class Missing extends RuntimeException
+    {
+    }
+
+    static int counter;
+
+    static void thrower(int i)
+    {
+        if (i % 3 == 0)
+        {
+            throw new IllegalStateException();
+        }
+        if (i % 3 == 1)
+        {
+            throw new Derived();
+        }
+    }
+
+    // Thrown and caught within the same method.
+    static int local(int i)
+    {
+        try
+        {
+            if (i % 2 == 0)
+            {
+                throw new Derived();
+            }
+            throw new IllegalArgumentException();
+        }
+        catch (Base e)
+        {
+            return 1;
+        }
+        catch (RuntimeException e)
+        {
+            return 2;
+        }
+    }
+
+    // Thrown by a callee, with 'result' being live in the exception handlers.
+    static int callee(int i)
+    {
+        int result = i;
+        try
+        {
+            thrower(i);
+            result += 100;
+        }
+        catch (Base e)
+        {
+            result += 10;
+        }
+        catch (IllegalStateException e)
+        {
+            result += 20;
+        }
+        return result;
+    }
+
+    // Exceptions not caught by the handler are propagated to the caller.
+    static int mismatch(int i)
+    {
+        try
+        {
+            thrower(i);
+            return 0;
+        }
+        catch (Base e)
+        {
+            return 1;
+        }
+    }
+
+    static void withFinally(int i)
+    {
+        try
+        {
+            thrower(i);
+        }
+        finally
+        {
+            counter++;
+        }
+    }
+
+    static int notLoaded(int i)
+    {
+        try
+        {
+            if (i % 2 == 0)
+            {
+                throw new Derived();
+            }
+            return 0;
+        }
+        catch (Missing e)
+        {
+            return 2;
+        }
+        catch (Base e)
+        {
+            return 1;
+        }
+    }
+
+    static int nullPointer(int[] array)
+    {
+        try
+        {
+            return array[0];
+        }
+        catch (NullPointerException e)
+        {
+            return -1;
+        }
+    }
+
+    public static void main(String[] args)
+    {
+        int sum = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            sum += local(i);
+        }
+        // CHECK: 150
+        print(sum);
+
+        sum = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            sum += callee(i);
+        }
+        // CHECK: 9260
+        print(sum);
+
+        sum = 0;
+        int propagated = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            try
+            {
+                sum += mismatch(i);
+            }
+            catch (IllegalStateException e)
+            {
+                propagated++;
+            }
+        }
+        // CHECK: 33
+        print(sum);
+        // CHECK: 34
+        print(propagated);
+
+        int caught = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            try
+            {
+                withFinally(i);
+            }
+            catch (RuntimeException e)
+            {
+                caught++;
+            }
+        }
+        // CHECK: 100
+        print(counter);
+        // CHECK: 67
+        print(caught);
+
+        int[] array = new int[]{5};
+        sum = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            sum += nullPointer(i % 2 == 0 ? array : null);
+        }
+        // CHECK: 200
+        print(sum);
+
+        sum = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            sum += notLoaded(i);
+        }
+        // CHECK: 50
+        print(sum);
+    }
+}
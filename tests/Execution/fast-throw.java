@@ -0,0 +1,109 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xfast-throw-threshold=10 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xfast-throw-threshold=10 -Xjit %t/Test.class | FileCheck %s
+// RUN: jllvm -Xfast-throw-threshold=10 -Xint %t/Test.class | FileCheck %s
+// RUN: jllvm -Xfast-throw-threshold=0 %t/Test.class | FileCheck %s --check-prefix=DISABLED
+
+class Test
+{
+    public static native void print(boolean b);
+
+    public static native void print(String s);
+
+    static int load(int[] array, int index)
+    {
+        return array[index];
+    }
+
+    static int hash(Object o)
+    {
+        return o.hashCode();
+    }
+
+    static String cast(Object o)
+    {
+        return (String)o;
+    }
+
+    public static void main(String[] args)
+    {
+        int[] array = new int[1];
+        RuntimeException first = null;
+        RuntimeException previous = null;
+        RuntimeException last = null;
+        for (int i = 0; i < 40; i++)
+        {
+            try
+            {
+                load(array, 5);
+            }
+            catch (ArrayIndexOutOfBoundsException e)
+            {
+                if (first == null)
+                {
+                    first = e;
+                }
+                previous = last;
+                last = e;
+            }
+        }
+        // The first exceptions thrown at a site are constructed as usual.
+        // CHECK: Index 5 out of bounds for length 1
+        // DISABLED: Index 5 out of bounds for length 1
+        print(first.getMessage());
+        // Once the threshold has been exceeded, the same preallocated exception without a message is thrown.
+        // CHECK-NEXT: 1
+        // DISABLED-NEXT: 0
+        print(previous == last);
+        // CHECK-NEXT: 1
+        // DISABLED-NEXT: 0
+        print(last.getMessage() == null);
+
+        previous = null;
+        last = null;
+        for (int i = 0; i < 40; i++)
+        {
+            try
+            {
+                hash(null);
+            }
+            catch (NullPointerException e)
+            {
+                previous = last;
+                last = e;
+            }
+        }
+        // CHECK-NEXT: 1
+        // DISABLED-NEXT: 0
+        print(previous == last);
+
+        first = null;
+        previous = null;
+        last = null;
+        for (int i = 0; i < 40; i++)
+        {
+            try
+            {
+                cast(array);
+            }
+            catch (ClassCastException e)
+            {
+                if (first == null)
+                {
+                    first = e;
+                }
+                previous = last;
+                last = e;
+            }
+        }
+        // CHECK-NEXT: 1
+        // DISABLED-NEXT: 1
+        print(first.getMessage() != null);
+        // CHECK-NEXT: 1
+        // DISABLED-NEXT: 0
+        print(previous == last);
+        // CHECK-NEXT: 1
+        // DISABLED-NEXT: 0
+        print(last.getMessage() == null);
+    }
+}
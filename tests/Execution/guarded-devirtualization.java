@@ -0,0 +1,104 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xinvocation-threshold=5 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=5 -Xtier-up-threshold=0 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    interface Shape
+    {
+        int area();
+    }
+
+    static class Square implements Shape
+    {
+        public int area()
+        {
+            return 4;
+        }
+    }
+
+    static class Rectangle implements Shape
+    {
+        public int area()
+        {
+            return 6;
+        }
+    }
+
+    static class Triangle implements Shape
+    {
+        public int area()
+        {
+            return 3;
+        }
+    }
+
+    static abstract class Animal
+    {
+        abstract int legs();
+    }
+
+    static class Dog extends Animal
+    {
+        int legs()
+        {
+            return 4;
+        }
+    }
+
+    static class Bird extends Animal
+    {
+        int legs()
+        {
+            return 2;
+        }
+    }
+
+    static class Fish extends Animal
+    {
+        int legs()
+        {
+            return 0;
+        }
+    }
+
+    static int area(Shape shape)
+    {
+        return shape.area();
+    }
+
+    static int legs(Animal animal)
+    {
+        return animal.legs();
+    }
+
+    public static void main(String[] args)
+    {
+        Shape[] shapes = new Shape[]{new Square(), new Rectangle(), new Triangle()};
+        Animal[] animals = new Animal[]{new Dog(), new Bird(), new Fish()};
+
+        // Only ever call with two distinct receivers while the methods are being profiled.
+        int sum = 0;
+        for (int i = 0; i < 10; i++)
+        {
+            sum += area(shapes[i % 2]);
+            sum += legs(animals[i % 2]);
+        }
+        // CHECK: 80
+        print(sum);
+
+        // Fail the guards often enough for the methods to be recompiled.
+        sum = 0;
+        for (int i = 0; i < 3000; i++)
+        {
+            sum += area(shapes[i % 3]);
+            sum += legs(animals[i % 3]);
+        }
+        // CHECK: 19000
+        print(sum);
+    }
+}
@@ -0,0 +1,104 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xjit %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    public static native void print(String s);
+
+    int value;
+
+    int get()
+    {
+        return value;
+    }
+
+    static int readField(Test test)
+    {
+        return test.value;
+    }
+
+    static void writeField(Test test)
+    {
+        test.value = 5;
+    }
+
+    static int arrayLength(int[] array)
+    {
+        return array.length;
+    }
+
+    static int arrayLoad(int[] array, int index)
+    {
+        return array[index];
+    }
+
+    static int invoke(Test test)
+    {
+        return test.get();
+    }
+
+    public static void main(String[] args)
+    {
+        Test test = new Test();
+        test.value = 3;
+        int[] array = new int[]{1, 2, 3};
+
+        int caught = 0;
+        int sum = 0;
+        // Alternate between null and non-null objects to make sure execution continues correctly in both cases.
+        for (int i = 0; i < 100; i++)
+        {
+            Test maybeTest = i % 2 == 0 ? test : null;
+            int[] maybeArray = i % 2 == 0 ? array : null;
+            try
+            {
+                sum += readField(maybeTest);
+            }
+            catch (NullPointerException e)
+            {
+                caught++;
+            }
+            try
+            {
+                writeField(maybeTest);
+                test.value = 3;
+            }
+            catch (NullPointerException e)
+            {
+                caught++;
+            }
+            try
+            {
+                sum += arrayLength(maybeArray);
+            }
+            catch (NullPointerException e)
+            {
+                caught++;
+            }
+            try
+            {
+                sum += arrayLoad(maybeArray, 1);
+            }
+            catch (NullPointerException e)
+            {
+                caught++;
+            }
+            try
+            {
+                sum += invoke(maybeTest);
+            }
+            catch (NullPointerException e)
+            {
+                caught++;
+            }
+        }
+        // CHECK: 250
+        print(caught);
+        // CHECK: 550
+        print(sum);
+    }
+}
@@ -0,0 +1,123 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xjit %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    interface A
+    {
+        int a0();
+
+        int a1();
+
+        default int a2()
+        {
+            return 3;
+        }
+    }
+
+    interface B
+    {
+        int b0();
+
+        int b1();
+
+        int b2();
+    }
+
+    interface C extends A
+    {
+        int c0();
+
+        default int a1()
+        {
+            return 20;
+        }
+    }
+
+    interface D extends B, C
+    {
+        int d0();
+
+        int d1();
+    }
+
+    static class X implements D
+    {
+        public int a0() { return 1; }
+        public int b0() { return 4; }
+        public int b1() { return 5; }
+        public int b2() { return 6; }
+        public int c0() { return 7; }
+        public int d0() { return 8; }
+        public int d1() { return 9; }
+    }
+
+    static class Y extends X
+    {
+        public int a2() { return 30; }
+        public int b1() { return 50; }
+        public int d1() { return 90; }
+    }
+
+    static class Z implements A, B
+    {
+        public int a0() { return 100; }
+        public int a1() { return 200; }
+        public int b0() { return 400; }
+        public int b1() { return 500; }
+        public int b2() { return 600; }
+    }
+
+    static int callA(A a)
+    {
+        return a.a0() + a.a1() + a.a2();
+    }
+
+    static int callB(B b)
+    {
+        return b.b0() + b.b1() + b.b2();
+    }
+
+    static int callD(D d)
+    {
+        return d.c0() + d.d0() + d.d1();
+    }
+
+    public static void main(String[] args)
+    {
+        X x = new X();
+        Y y = new Y();
+        Z z = new Z();
+
+        // CHECK: 24
+        print(callA(x));
+        // CHECK: 51
+        print(callA(y));
+        // CHECK: 303
+        print(callA(z));
+        // CHECK: 15
+        print(callB(x));
+        // CHECK: 60
+        print(callB(y));
+        // CHECK: 1500
+        print(callB(z));
+        // CHECK: 24
+        print(callD(x));
+        // CHECK: 105
+        print(callD(y));
+
+        // Call sites seeing several receiver classes.
+        A[] as = {x, y, z};
+        B[] bs = {x, y, z};
+        int sum = 0;
+        for (int i = 0; i < 300; i++)
+        {
+            sum += callA(as[i % 3]) + callB(bs[i % 3]);
+        }
+        // CHECK: 195300
+        print(sum);
+    }
+}
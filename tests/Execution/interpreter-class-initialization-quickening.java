@@ -0,0 +1,52 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Other
+{
+    public static int counter;
+
+    public static long wide;
+
+    static
+    {
+        Test.print("Other.<clinit>");
+        // Executed while 'Other' is still under initialization.
+        for (int i = 0; i < 3; i++)
+        {
+            counter = increment(counter);
+        }
+    }
+
+    public static int increment(int i)
+    {
+        return i + 1;
+    }
+
+    public int value = 7;
+}
+
+class Test
+{
+    public static native void print(int i);
+
+    public static native void print(String s);
+
+    public static void main(String[] args)
+    {
+        int sum = 0;
+        for (int i = 0; i < 3; i++)
+        {
+            // CHECK: Other.<clinit>
+            // CHECK-NOT: Other.<clinit>
+            Other.counter = Other.increment(Other.counter);
+            Other.wide += 1L << 33;
+            sum += new Other().value;
+        }
+        // CHECK: 6
+        print(Other.counter);
+        // CHECK: 6
+        print((int)(Other.wide >> 32));
+        // CHECK: 21
+        print(sum);
+    }
+}
@@ -0,0 +1,39 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    public static native void print(String s);
+
+    private static String constant()
+    {
+        return "constant";
+    }
+
+    private static Class<?> literal()
+    {
+        return Test.class;
+    }
+
+    public static void main(String[] args)
+    {
+        String first = constant();
+        Class<?> firstClass = literal();
+        int same = 0;
+        for (int i = 0; i < 1000; i++)
+        {
+            // Allocate to trigger garbage collections in between executions of 'ldc'.
+            Object[] garbage = new Object[100];
+            if (constant() == first && literal() == firstClass)
+            {
+                same++;
+            }
+        }
+        // CHECK: 1000
+        print(same);
+        // CHECK: constant
+        print(constant());
+    }
+}
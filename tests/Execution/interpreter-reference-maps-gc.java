@@ -0,0 +1,55 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    private static int[] garbage(int size)
+    {
+        // Allocates enough to trigger garbage collections while the callers hold references in their frames.
+        int[] last = null;
+        for (int i = 0; i < 1000; i++)
+        {
+            last = new int[size];
+        }
+        return last;
+    }
+
+    private static int sum(int[] lhs, int[] rhs, int[] ignored)
+    {
+        return lhs[0] + rhs[0] + ignored.length;
+    }
+
+    // Every frame of the recursion is suspended at a different call with references in different local variables and
+    // operand stack slots, all of which must be found by the garbage collector.
+    private static int recurse(int depth)
+    {
+        int[] local = new int[]{depth};
+        if (depth == 0)
+        {
+            garbage(64);
+            return local[0];
+        }
+
+        Object other = new int[]{depth * 10};
+        int result = recurse(depth - 1);
+        if (depth % 2 == 0)
+        {
+            // 'local' and 'other' are on the operand stack during the call to 'garbage'.
+            result += sum(local, (int[])other, garbage(depth));
+        }
+        else
+        {
+            long wide = depth;
+            result += sum((int[])other, local, garbage((int)wide)) + local[0];
+        }
+        return result;
+    }
+
+    public static void main(String[] args)
+    {
+        // CHECK: 685
+        print(recurse(10));
+    }
+}
@@ -0,0 +1,111 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit %t/Test.class | FileCheck %s
+
+// Quickening is disabled while gathering the histogram, executing every instruction individually.
+// RUN: jllvm -Xint -Xdump-bytecode-pairs %t/Test.class 2> %t/pairs.txt | FileCheck %s
+// RUN: FileCheck %s --check-prefix=HISTOGRAM < %t/pairs.txt
+
+// Super instructions selected by the histogram of this very program and by an empty histogram selecting none.
+// RUN: jllvm -Xint -Xbytecode-pair-histogram=%t/pairs.txt %t/Test.class | FileCheck %s
+// RUN: echo "" > %t/empty.txt
+// RUN: jllvm -Xint -Xbytecode-pair-histogram=%t/empty.txt %t/Test.class | FileCheck %s
+
+// HISTOGRAM: Bytecode pair histogram:
+// HISTOGRAM-DAG: {{[0-9]+}} ILoad{{[0-3]?}} ILoad{{[0-3]?}}
+// HISTOGRAM-DAG: {{[0-9]+}} ILoad{{[0-3]?}} IAdd
+// HISTOGRAM-DAG: {{[0-9]+}} IAdd IStore{{[0-3]?}}
+// HISTOGRAM-DAG: {{[0-9]+}} IInc Goto
+// HISTOGRAM-DAG: {{[0-9]+}} ALoad0 GetField
+// HISTOGRAM-DAG: {{[0-9]+}} ILoad{{[0-3]?}} IfICmp{{Ge|Lt|Le|Gt|Eq|Ne}}
+
+class Test
+{
+    public static native void print(int i);
+
+    public static native void print(String s);
+
+    private int field;
+
+    private long wideField;
+
+    private static int sum(int n)
+    {
+        int result = 0;
+        for (int i = 0; i < n; i++)
+        {
+            int next = result + i;
+            result = next;
+        }
+        return result;
+    }
+
+    private static int getField(Test test)
+    {
+        return test.field;
+    }
+
+    // Every comparison fused with its two loads. Each taken comparison sets a different bit of the result.
+    private static int compare(int a, int b)
+    {
+        int result = 0;
+        if (a == b)
+        {
+            result |= 1;
+        }
+        if (a != b)
+        {
+            result |= 2;
+        }
+        if (a < b)
+        {
+            result |= 4;
+        }
+        if (a >= b)
+        {
+            result |= 8;
+        }
+        if (a > b)
+        {
+            result |= 16;
+        }
+        if (a <= b)
+        {
+            result |= 32;
+        }
+        return result;
+    }
+
+    public static void main(String[] args)
+    {
+        // CHECK: 4950
+        print(sum(100));
+
+        // CHECK-NEXT: 41
+        print(compare(3, 3));
+        // CHECK-NEXT: 38
+        print(compare(-5, 3));
+        // CHECK-NEXT: 26
+        print(compare(3, -5));
+        // CHECK-NEXT: 38
+        print(compare(Integer.MIN_VALUE, Integer.MAX_VALUE));
+
+        Test test = new Test();
+        test.field = 5;
+        test.wideField = 1L << 40;
+        // CHECK-NEXT: 5
+        print(getField(test));
+        // CHECK-NEXT: 256
+        print((int)(test.wideField >> 32));
+
+        try
+        {
+            getField(null);
+        }
+        catch (NullPointerException e)
+        {
+            // CHECK-NEXT: NPE
+            print("NPE");
+        }
+    }
+}
@@ -0,0 +1,164 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xinvocation-threshold=5 -Xtier-up-threshold=0 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=5 -Xtier-up-threshold=0 -Xcompile-threads=0 -Xstackless-calls %t/Test.class \
+// RUN:   | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=5 -Xtier-up-threshold=0 -Xcompile-threads=0 -Xmax-inline-size=0 %t/Test.class \
+// RUN:   | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    public static native void print(long l);
+
+    interface Shape
+    {
+        int area();
+    }
+
+    static class Square implements Shape
+    {
+        public int area()
+        {
+            return 4;
+        }
+    }
+
+    static class Rectangle implements Shape
+    {
+        public int area()
+        {
+            return 6;
+        }
+    }
+
+    static class Triangle implements Shape
+    {
+        public int area()
+        {
+            return 3;
+        }
+    }
+
+    // Inlined method handling exceptions by itself.
+    static int safeDivide(int a, int b)
+    {
+        try
+        {
+            return a / b;
+        }
+        catch (ArithmeticException e)
+        {
+            return -1;
+        }
+    }
+
+    static int callSafeDivide(int a, int b)
+    {
+        return safeDivide(a, b) + 1;
+    }
+
+    static int divide(int a, int b)
+    {
+        return a / b;
+    }
+
+    // Catches the exception thrown by the inlined 'divide' while being inlined into 'outer' itself.
+    static int middle(int a, int b)
+    {
+        try
+        {
+            return divide(a, b) + 1;
+        }
+        catch (ArithmeticException e)
+        {
+            return 0;
+        }
+    }
+
+    static int outer(int a, int b)
+    {
+        return middle(a, b) * 2;
+    }
+
+    // Only the outermost call to 'thrower' is inlined. Exceptions are therefore either thrown by the inlined code or by
+    // a frame called from within the inlined code.
+    static int thrower(int depth)
+    {
+        if (depth == 0)
+        {
+            throw new IllegalStateException();
+        }
+        return thrower(depth - 1) + 1;
+    }
+
+    static int catchFromCallee(int depth)
+    {
+        try
+        {
+            return thrower(depth);
+        }
+        catch (IllegalStateException e)
+        {
+            return -depth;
+        }
+    }
+
+    static int callCatchFromCallee(int depth)
+    {
+        return catchFromCallee(depth) + 1;
+    }
+
+    static int areaOf(Shape shape)
+    {
+        return shape.area();
+    }
+
+    // The operand stack contains a long while calling the inlined 'areaOf', whose speculation on the receiver of 'area'
+    // fails.
+    static long sumAreas(long base, Shape shape)
+    {
+        return base + areaOf(shape) * 2L;
+    }
+
+    public static void main(String[] args)
+    {
+        int safeDivided = 0;
+        int divided = 0;
+        int caught = 0;
+        for (int i = 0; i < 20; i++)
+        {
+            safeDivided += callSafeDivide(i, i % 2);
+            divided += outer(i, i % 2);
+            caught += callCatchFromCallee(i % 3);
+        }
+        // CHECK: 110
+        print(safeDivided);
+        // CHECK: 220
+        print(divided);
+        // CHECK: 1
+        print(caught);
+
+        Shape[] shapes = new Shape[]{new Square(), new Rectangle(), new Triangle()};
+
+        // Only ever call with two distinct receivers while 'areaOf' is being profiled.
+        long total = 0;
+        for (int i = 0; i < 10; i++)
+        {
+            total += sumAreas(i, shapes[i % 2]);
+        }
+        // CHECK: 145
+        print(total);
+
+        // Fail the guard within the inlined 'areaOf' often enough for the frames to be deoptimized.
+        total = 0;
+        for (int i = 0; i < 3000; i++)
+        {
+            total += sumAreas(i, shapes[i % 3]);
+        }
+        // CHECK: 4524500
+        print(total);
+    }
+}
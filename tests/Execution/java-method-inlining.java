@@ -0,0 +1,98 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xjit %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=0 -Xmax-inline-size=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Point
+{
+    private int x;
+    private int y;
+
+    Point(int x, int y)
+    {
+        this.x = x;
+        this.y = y;
+    }
+
+    int getX()
+    {
+        return x;
+    }
+
+    int getY()
+    {
+        return y;
+    }
+
+    void setX(int x)
+    {
+        this.x = x;
+    }
+
+    final int sum()
+    {
+        return getX() + getY();
+    }
+}
+
+class Test
+{
+    public static native void print(int i);
+
+    static int square(int i)
+    {
+        return i * i;
+    }
+
+    static int add(int a, int b)
+    {
+        return square(a) + b;
+    }
+
+    static int recursive(int i)
+    {
+        return i == 0 ? 0 : i + recursive(i - 1);
+    }
+
+    static int getX(Point point)
+    {
+        return point.getX();
+    }
+
+    public static void main(String[] args)
+    {
+        Point point = new Point(3, 4);
+        int sum = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            point.setX(i);
+            sum += point.sum();
+            sum += add(i, point.getY());
+        }
+        // CHECK: 334100
+        print(sum);
+
+        // CHECK: 5050
+        print(recursive(100));
+
+        // CHECK: 5
+        print("hello".length());
+
+        // Exceptions thrown within inlined methods must be caught by the handlers of the caller.
+        int caught = 0;
+        for (int i = 0; i < 10; i++)
+        {
+            try
+            {
+                sum += getX(i % 2 == 0 ? point : null);
+            }
+            catch (NullPointerException e)
+            {
+                caught++;
+            }
+        }
+        // CHECK: 5
+        print(caught);
+    }
+}
@@ -0,0 +1,143 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xint -Xstackless-calls %t/Test.class | FileCheck %s
+// RUN: jllvm -Xstackless-calls -Xinvocation-threshold=0 -Xback-edge-threshold=10 %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    interface Shape
+    {
+        int area();
+    }
+
+    static class Square implements Shape
+    {
+        protected final int side;
+
+        Square(int side)
+        {
+            this.side = side;
+        }
+
+        public int area()
+        {
+            return side * side;
+        }
+    }
+
+    static class Rectangle extends Square
+    {
+        private final int other;
+
+        Rectangle(int side, int other)
+        {
+            super(side);
+            this.other = other;
+        }
+
+        public int area()
+        {
+            return super.area() / side * other;
+        }
+    }
+
+    // Deep enough to overflow the native stack if every call used a native frame.
+    private static long sum(int n)
+    {
+        if (n == 0)
+        {
+            return 0;
+        }
+        return n + sum(n - 1);
+    }
+
+    private static int throwAt(int depth)
+    {
+        if (depth == 0)
+        {
+            throw new IllegalStateException();
+        }
+        return throwAt(depth - 1) + 1;
+    }
+
+    // Exception thrown by a callee and handled within a stackless frame of a caller.
+    private static int catchAt(int depth)
+    {
+        try
+        {
+            return throwAt(depth);
+        }
+        catch (IllegalStateException e)
+        {
+            return depth;
+        }
+    }
+
+    private static int[] garbage(int size)
+    {
+        int[] last = null;
+        for (int i = 0; i < 1000; i++)
+        {
+            last = new int[size];
+        }
+        return last;
+    }
+
+    // References held by stackless frames must be found by the garbage collector.
+    private static int gcRecurse(int depth)
+    {
+        int[] local = new int[]{depth};
+        if (depth == 0)
+        {
+            garbage(16);
+            return local[0];
+        }
+        return gcRecurse(depth - 1) + local[0];
+    }
+
+    // Loops long enough to be replaced by the JIT using OSR while executed as a stackless frame.
+    private static int loop(int n)
+    {
+        int result = 0;
+        for (int i = 0; i < n; i++)
+        {
+            result += i;
+        }
+        return result;
+    }
+
+    public static void main(String[] args)
+    {
+        // CHECK: 1250025000
+        print((int)sum(50000));
+
+        // CHECK: 5
+        print(catchAt(5));
+
+        try
+        {
+            throwAt(3);
+        }
+        catch (IllegalStateException e)
+        {
+            // CHECK: 42
+            print(42);
+        }
+
+        // CHECK: 55
+        print(gcRecurse(10));
+
+        Shape[] shapes = new Shape[]{new Square(3), new Rectangle(2, 5)};
+        int area = 0;
+        for (Shape shape : shapes)
+        {
+            area += shape.area();
+        }
+        // CHECK: 19
+        print(area);
+
+        // CHECK: 4950
+        print(loop(100));
+    }
+}
@@ -0,0 +1,93 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xjit %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(boolean b);
+
+    public static native void print(String s);
+
+    interface I {}
+
+    interface J extends I {}
+
+    static class L1 {}
+    static class L2 extends L1 {}
+    static class L3 extends L2 {}
+    static class L4 extends L3 {}
+    static class L5 extends L4 {}
+    static class L6 extends L5 {}
+    static class L7 extends L6 {}
+    static class L8 extends L7 {}
+    static class L9 extends L8 implements J {}
+    static class L10 extends L9 {}
+
+    static boolean isL1(Object o)
+    {
+        return o instanceof L1;
+    }
+
+    static boolean isL9(Object o)
+    {
+        return o instanceof L9;
+    }
+
+    static boolean isI(Object o)
+    {
+        return o instanceof I;
+    }
+
+    public static void main(String[] args)
+    {
+        Object l10 = new L10();
+        Object l7 = new L7();
+
+        // CHECK: 1
+        print(isL1(l10));
+        // CHECK-NEXT: 1
+        print(isL9(l10));
+        // CHECK-NEXT: 0
+        print(isL9(l7));
+        // CHECK-NEXT: 1
+        print(isI(l10));
+        // Same check again, now hitting the cache of the last secondary super.
+        // CHECK-NEXT: 1
+        print(isI(l10));
+        // CHECK-NEXT: 0
+        print(isI(l7));
+        // CHECK-NEXT: 1
+        print(l10 instanceof L10);
+        // CHECK-NEXT: 0
+        print(isL1("text"));
+
+        Object js = new J[1];
+        // CHECK-NEXT: 1
+        print(js instanceof I[]);
+        // CHECK-NEXT: 1
+        print(js instanceof Object[]);
+        // CHECK-NEXT: 0
+        print(js instanceof L1[]);
+        // CHECK-NEXT: 1
+        print(new L10[1][1] instanceof J[][]);
+        // CHECK-NEXT: 1
+        print(new L10[1][1] instanceof Cloneable[]);
+        // CHECK-NEXT: 0
+        print(new L7[1] instanceof I[]);
+
+        L1 l1 = (L1)l10;
+        J j = (J)l1;
+        // CHECK-NEXT: 1
+        print(j == l10);
+
+        try
+        {
+            L9 l9 = (L9)l7;
+        }
+        catch (ClassCastException e)
+        {
+            // CHECK-NEXT: ClassCastException
+            print("ClassCastException");
+        }
+    }
+}
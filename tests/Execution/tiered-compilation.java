@@ -0,0 +1,35 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xjit -Xtier-up-threshold=10 -Xcompile-threads=2 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=5 -Xtier-up-threshold=10 %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    private static int fib(int n)
+    {
+        return n < 2 ? n : fib(n - 1) + fib(n - 2);
+    }
+
+    private static int sum(int n)
+    {
+        int result = 0;
+        for (int i = 0; i < n; i++)
+        {
+            result += i;
+        }
+        return result;
+    }
+
+    public static void main(String[] args)
+    {
+        // CHECK: 6765
+        print(fib(20));
+        // Enough loop iterations to tier up while executing the loop.
+        // CHECK: 499500
+        print(sum(1000));
+        // CHECK: 499500
+        print(sum(1000));
+    }
+}
@@ -0,0 +1,74 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xinvocation-threshold=5 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xinvocation-threshold=5 -Xtier-up-threshold=0 -Xcompile-threads=0 %t/Test.class | FileCheck %s
+// RUN: jllvm -Xint %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    public static native void print(long l);
+
+    static int classify(int i)
+    {
+        if (i < 0)
+        {
+            return -1;
+        }
+        return i % 2;
+    }
+
+    static int select(int i)
+    {
+        switch (i)
+        {
+            case 0: return 10;
+            case 1: return 20;
+            case 2: return 30;
+            default: return 0;
+        }
+    }
+
+    // The operand stack contains a long when branching.
+    static long adjust(long base, int i)
+    {
+        return base + (i < 0 ? -1 : 1);
+    }
+
+    public static void main(String[] args)
+    {
+        // Never take some branches and switch cases while the methods are being profiled.
+        int classified = 0;
+        int selected = 0;
+        long adjusted = 0;
+        for (int i = 0; i < 10; i++)
+        {
+            classified += classify(i);
+            selected += select(i % 2);
+            adjusted += adjust(100, i);
+        }
+        // CHECK: 5
+        print(classified);
+        // CHECK: 150
+        print(selected);
+        // CHECK: 1010
+        print(adjusted);
+
+        // Reach the pruned branch targets, deoptimizing the compiled code.
+        classified = 0;
+        selected = 0;
+        adjusted = 0;
+        for (int i = 0; i < 100; i++)
+        {
+            classified += classify(i - 50);
+            selected += select(i % 3);
+            adjusted += adjust(100, i - 50);
+        }
+        // CHECK: -25
+        print(classified);
+        // CHECK: 1990
+        print(selected);
+        // CHECK: 10000
+        print(adjusted);
+    }
+}
@@ -0,0 +1,18 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xint -Xzero-interpreter-frames %t/Test.class | FileCheck %s
+
+class Test
+{
+    public static native void print(int i);
+
+    private static int fib(int n)
+    {
+        return n < 2 ? n : fib(n - 1) + fib(n - 2);
+    }
+
+    public static void main(String[] args)
+    {
+        // CHECK: 55
+        print(fib(10));
+    }
+}
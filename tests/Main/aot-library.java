@@ -0,0 +1,8 @@
+// RUN: not --crash jllvm -Xaot-library=%s Test.class 2>&1 | FileCheck %s
+// RUN: not --crash jllvm -Xaot-library=%t/does-not-exist.a Test.class 2>&1 | FileCheck %s --check-prefix=MISSING
+// RUN: rm -rf %t && mkdir -p %t && echo "JLLVM other" > %t/jllvm.target && llvm-ar rc %t/other.a %t/jllvm.target
+// RUN: not --crash jllvm -Xaot-library=%t/other.a Test.class 2>&1 | FileCheck %s --check-prefix=MISMATCH
+
+// CHECK: LLVM ERROR: {{.*}}aot-library.java
+// MISSING: LLVM ERROR: {{.*}}does-not-exist.a
+// MISMATCH: LLVM ERROR: {{.*}}other.a{{.*}}different target or JLLVM build
@@ -0,0 +1,7 @@
+// RUN: not --crash jllvm -Xcompile-threads=-1 Test.class 2>&1 | FileCheck %s --check-prefix=THREADS
+// RUN: not --crash jllvm -Xcompile-threads=aba Test.class 2>&1 | FileCheck %s --check-prefix=THREADS
+// RUN: not --crash jllvm -Xinvocation-threshold=0x1 Test.class 2>&1 | FileCheck %s --check-prefix=INVOCATION
+// RUN: not --crash jllvm -Xinvocation-threshold=10a Test.class 2>&1 | FileCheck %s --check-prefix=INVOCATION
+
+// THREADS: Invalid command line argument '-Xcompile-threads=
+// INVOCATION: Invalid command line argument '-Xinvocation-threshold=
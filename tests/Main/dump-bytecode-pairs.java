@@ -0,0 +1,26 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xno-system-init -Xint -Xdump-bytecode-pairs %t/Test.class 2>&1 | FileCheck %s
+
+// CHECK: Bytecode pair histogram:
+// CHECK-DAG: {{[0-9]+}} IInc Goto
+// CHECK-DAG: {{[0-9]+}} ALoad0 GetField
+
+class Test
+{
+    private int field = 1;
+
+    public static void main(String[] args)
+    {
+        Test test = new Test();
+        int result = 0;
+        for (int i = 0; i < 10; i++)
+        {
+            result += test.getField();
+        }
+    }
+
+    private int getField()
+    {
+        return field;
+    }
+}
@@ -0,0 +1,44 @@
+// RUN: javac %s -d %t
+// RUN: jllvm -Xint -Xfast-throw-threshold=10 -Xdump-implicit-exception-sites %t/Test.class 2>&1 | FileCheck %s
+
+// CHECK: Implicit exception sites:
+// CHECK-DAG: {{ +}}20 Test.load([II)I at offset 2: {{.*}}ArrayIndexOutOfBoundsException (fast throw)
+// CHECK-DAG: {{ +}}5 Test.hash(Ljava/lang/Object;)I at offset 1: {{.*}}NullPointerException{{$}}
+
+class Test
+{
+    static int load(int[] array, int index)
+    {
+        return array[index];
+    }
+
+    static int hash(Object o)
+    {
+        return o.hashCode();
+    }
+
+    public static void main(String[] args)
+    {
+        int[] array = new int[1];
+        for (int i = 0; i < 20; i++)
+        {
+            try
+            {
+                load(array, 5);
+            }
+            catch (ArrayIndexOutOfBoundsException e)
+            {
+            }
+        }
+        for (int i = 0; i < 5; i++)
+        {
+            try
+            {
+                hash(null);
+            }
+            catch (NullPointerException e)
+            {
+            }
+        }
+    }
+}
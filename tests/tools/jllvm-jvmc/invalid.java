@@ -6,6 +6,9 @@
 // RUN: not jllvm-jvmc --method "foo:()V" %t/Bar.class 2>&1 | FileCheck %s --check-prefix=INVAL_INPUT
 // RUN: not jllvm-jvmc --method "bar:()V" %t/Test.class 2>&1 | FileCheck %s --check-prefix=NO_METHOD
 // RUN: not jllvm-jvmc --method "foo:()V" --osr t %t/Test.class 2>&1 | FileCheck %s --check-prefix=OSR_NUMBER
+// RUN: not jllvm-jvmc --aot %t/Test.class 2>&1 | FileCheck %s --check-prefix=AOT_OUTPUT
+// RUN: not jllvm-jvmc --aot -o %t/test.a 2>&1 | FileCheck %s --check-prefix=AOT_INPUT
+// RUN: not jllvm-jvmc --aot --method "foo:()V" -o %t/test.a %t/Test.class 2>&1 | FileCheck %s --check-prefix=AOT_METHOD
 
 // TWO_METHOD: expected exactly one occurrence of '--method'
 // INVAL_METHOD: expected method in format '<name>:<descriptor>'
@@ -15,6 +18,9 @@
 // INVAL_INPUT-SAME: {{(/|\\\\)}}Bar.class{{[[:space:]]}}
 // NO_METHOD: failed to find method 'bar:()V' in 'Test'
 // OSR_NUMBER: invalid integer 't' as argument to '--osr'
+// AOT_OUTPUT: expected output file when using '--aot'
+// AOT_INPUT: expected at least one input class file or directory
+// AOT_METHOD: '--aot' cannot be combined with '--method'
 
 class Test
 {
@@ -11,17 +11,27 @@
 // You should have received a copy of the GNU General Public License along with JLLVM; see the file LICENSE.txt.  If not
 // see <http://www.gnu.org/licenses/>.
 
+#include <llvm/ADT/SetVector.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Verifier.h>
+#include <llvm/Object/ArchiveWriter.h>
 #include <llvm/Option/ArgList.h>
 #include <llvm/Option/Option.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Support/TargetSelect.h>
 
+#include <jllvm/compiler/ByteCodeCompileUtils.hpp>
+#include <jllvm/compiler/ClassObjectStubMangling.hpp>
 #include <jllvm/compiler/Compiler.hpp>
+#include <jllvm/llvm/CompilationPipeline.hpp>
+#include <jllvm/materialization/AOTLibrary.hpp>
 #include <jllvm/object/ClassLoader.hpp>
+#include <jllvm/object/MethodProfile.hpp>
 
 #include <iterator>
+#include <optional>
 
 enum ID
 {
@@ -53,6 +63,211 @@ class OptTable : public llvm::opt::GenericOptTable
 public:
     OptTable(llvm::ArrayRef<Info> optionInfos) : GenericOptTable(optionInfos) {}
 };
+
+/// Appends to 'classFiles' the class file at 'path' or, if 'path' is a directory, all class files within it.
+/// Returns false if any file could not be read.
+bool readClassFiles(llvm::StringRef path, std::vector<std::unique_ptr<llvm::MemoryBuffer>>& classFiles)
+{
+    if (!llvm::sys::fs::is_directory(path))
+    {
+        auto buffer = llvm::MemoryBuffer::getFile(path);
+        if (!buffer)
+        {
+            llvm::errs() << "failed to open " << path << '\n';
+            return false;
+        }
+        classFiles.push_back(std::move(*buffer));
+        return true;
+    }
+
+    std::error_code ec;
+    for (llvm::sys::fs::recursive_directory_iterator iter(path, ec), end; iter != end && !ec; iter.increment(ec))
+    {
+        if (llvm::sys::path::extension(iter->path()) != ".class")
+        {
+            continue;
+        }
+        if (!readClassFiles(iter->path(), classFiles))
+        {
+            return false;
+        }
+    }
+    if (ec)
+    {
+        llvm::errs() << "failed to read directory " << path << ": " << ec.message() << '\n';
+        return false;
+    }
+    return true;
+}
+
+/// Reads the profile in the textual format described by the '--profile' option from 'path' into 'profile'.
+/// Returns false if the file could not be read or is malformed.
+bool readProfile(llvm::StringRef path, jllvm::MethodProfile& profile, jllvm::ClassLoader& loader,
+                 llvm::StringSaver& stringSaver)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(path);
+    if (!buffer)
+    {
+        llvm::errs() << "failed to open " << path << '\n';
+        return false;
+    }
+
+    llvm::SmallVector<llvm::StringRef> lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, /*KeepEmpty=*/false);
+    for (llvm::StringRef line : lines)
+    {
+        llvm::SmallVector<llvm::StringRef> tokens;
+        line.split(tokens, ' ', -1, /*KeepEmpty=*/false);
+        if (tokens.empty())
+        {
+            continue;
+        }
+
+        std::uint16_t offset;
+        if (tokens.size() < 2 || tokens[1].getAsInteger(0, offset))
+        {
+            llvm::errs() << "expected byte code offset in profile line '" << line << "'\n";
+            return false;
+        }
+
+        // Parses the token at 'index' as a count.
+        auto getCount = [&](std::size_t index) -> std::optional<std::uint64_t>
+        {
+            std::uint64_t count;
+            if (index >= tokens.size() || tokens[index].getAsInteger(0, count))
+            {
+                llvm::errs() << "expected count in profile line '" << line << "'\n";
+                return std::nullopt;
+            }
+            return count;
+        };
+
+        if (tokens[0] == "branch")
+        {
+            std::optional<std::uint64_t> taken = getCount(2);
+            std::optional<std::uint64_t> notTaken = getCount(3);
+            if (!taken || !notTaken)
+            {
+                return false;
+            }
+            for (std::uint64_t i = 0; i < *taken; i++)
+            {
+                profile.recordBranch(offset, /*taken=*/true);
+            }
+            for (std::uint64_t i = 0; i < *notTaken; i++)
+            {
+                profile.recordBranch(offset, /*taken=*/false);
+            }
+        }
+        else if (tokens[0] == "switch")
+        {
+            std::size_t numCases = tokens.size() - 3;
+            for (std::size_t index = 2; index < tokens.size(); index++)
+            {
+                std::optional<std::uint64_t> count = getCount(index);
+                if (!count)
+                {
+                    return false;
+                }
+                std::optional<std::size_t> caseIndex;
+                if (index != 2)
+                {
+                    caseIndex = index - 3;
+                }
+                for (std::uint64_t i = 0; i < *count; i++)
+                {
+                    profile.recordSwitch(offset, caseIndex, numCases);
+                }
+            }
+        }
+        else if (tokens[0] == "receiver")
+        {
+            for (std::size_t index = 2; index < tokens.size(); index += 2)
+            {
+                llvm::StringRef descriptor = stringSaver.save(tokens[index]);
+                if (!jllvm::FieldType::verify(descriptor))
+                {
+                    llvm::errs() << "invalid descriptor '" << descriptor << "' in profile line '" << line << "'\n";
+                    return false;
+                }
+                std::optional<std::uint64_t> count = getCount(index + 1);
+                if (!count)
+                {
+                    return false;
+                }
+                const jllvm::ClassObject* classObject = &loader.forName(jllvm::FieldType(descriptor));
+                for (std::uint64_t i = 0; i < *count; i++)
+                {
+                    profile.recordReceiverType(offset, classObject);
+                }
+            }
+        }
+        else
+        {
+            llvm::errs() << "unknown profile entry '" << tokens[0] << "'\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Compiles all methods of 'classObjects' and writes them as an 'AOTLibrary' to 'outputFile'.
+int compileAheadOfTime(llvm::ArrayRef<jllvm::ClassObject*> classObjects, llvm::StringRef outputFile,
+                       llvm::StringSaver& stringSaver)
+{
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+
+    // Objects must be compiled exactly the same way as the JIT would for them to be linkable by the VM.
+    std::unique_ptr<llvm::TargetMachine> targetMachine =
+        llvm::cantFail(jllvm::createTargetMachineBuilder().createTargetMachine());
+    llvm::orc::SimpleCompiler compiler(*targetMachine);
+
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects;
+    std::vector<llvm::NewArchiveMember> members;
+    llvm::StringRef targetDescription = stringSaver.save(jllvm::AOTLibrary::getTargetDescription(*targetMachine));
+    members.emplace_back(llvm::MemoryBufferRef(targetDescription, jllvm::AOTLibrary::targetMemberName));
+    for (const jllvm::ClassObject* classObject : classObjects)
+    {
+        for (const jllvm::Method& method : classObject->getMethods())
+        {
+            if (method.isNative() || method.isAbstract())
+            {
+                continue;
+            }
+
+            llvm::LLVMContext context;
+            llvm::Module module(jllvm::mangleDirectMethodCall(&method), context);
+            module.setDataLayout(targetMachine->createDataLayout());
+            module.setTargetTriple(LLVM_HOST_TRIPLE);
+
+            jllvm::compileMethod(module, method);
+            jllvm::setCompilationTier(module, jllvm::CompilationTier::Optimized);
+            jllvm::optimizeModule(module, *targetMachine);
+
+            llvm::Expected<std::unique_ptr<llvm::MemoryBuffer>> object = compiler(module);
+            if (!object)
+            {
+                llvm::logAllUnhandledErrors(object.takeError(), llvm::errs(),
+                                            "failed to compile '" + module.getName() + "': ");
+                return -1;
+            }
+            members.emplace_back(llvm::MemoryBufferRef((*object)->getBuffer(),
+                                                       stringSaver.save(jllvm::AOTLibrary::getMemberName(method))));
+            objects.push_back(std::move(*object));
+        }
+    }
+
+    if (llvm::Error error = llvm::writeArchive(outputFile, members, /*WriteSymtab=*/true,
+                                               llvm::object::Archive::K_GNU, /*Deterministic=*/true,
+                                               /*Thin=*/false))
+    {
+        llvm::logAllUnhandledErrors(std::move(error), llvm::errs(), "failed to write " + outputFile + ": ");
+        return -1;
+    }
+    return 0;
+}
+
 } // namespace
 
 int main(int argc, char** argv)
@@ -75,34 +290,63 @@ int main(int argc, char** argv)
 
     if (args.hasArg(OPT_help))
     {
-        optTable.printHelp(llvm::outs(), "jllvm-jvmc [opts] --method <name>:<descriptor> class-file", "jllvm-jvmc");
+        optTable.printHelp(llvm::outs(),
+                           "jllvm-jvmc [opts] --method <name>:<descriptor> class-file\n"
+                           "       jllvm-jvmc --aot -o <output> <class-file|directory>...",
+                           "jllvm-jvmc");
         return 0;
     }
 
-    if (args.getAllArgValues(OPT_method).size() != 1)
+    bool aheadOfTime = args.hasArg(OPT_aot);
+    std::optional<jllvm::MethodType> methodType;
+    llvm::StringRef name;
+    if (aheadOfTime)
     {
-        llvm::errs() << "expected exactly one occurrence of '--method'\n";
-        return -1;
-    }
-
-    llvm::StringRef value = args.getLastArgValue(OPT_method);
-    auto [name, descriptor] = value.split(':');
-    if (descriptor.empty())
-    {
-        llvm::errs() << "expected method in format '<name>:<descriptor>'\n";
-        return -1;
+        if (args.hasArg(OPT_method, OPT_osr, OPT_tier_up_threshold, OPT_profile, OPT_optimize))
+        {
+            llvm::errs() << "'--aot' cannot be combined with '--method', '--osr', '--tier-up-threshold', '--profile' or "
+                            "'--optimize'\n";
+            return -1;
+        }
+        if (!args.hasArg(OPT_output))
+        {
+            llvm::errs() << "expected output file when using '--aot'\n";
+            return -1;
+        }
+        if (!args.hasArg(OPT_INPUT))
+        {
+            llvm::errs() << "expected at least one input class file or directory\n";
+            return -1;
+        }
     }
-    if (!jllvm::MethodType::verify(descriptor))
+    else
     {
-        llvm::errs() << "invalid method descriptor '" << descriptor << "'\n";
-        return -1;
-    }
-    jllvm::MethodType methodType(descriptor);
+        if (args.getAllArgValues(OPT_method).size() != 1)
+        {
+            llvm::errs() << "expected exactly one occurrence of '--method'\n";
+            return -1;
+        }
 
-    if (args.getAllArgValues(OPT_INPUT).size() != 1)
-    {
-        llvm::errs() << "expected exactly one input class file\n";
-        return -1;
+        llvm::StringRef value = args.getLastArgValue(OPT_method);
+        llvm::StringRef descriptor;
+        std::tie(name, descriptor) = value.split(':');
+        if (descriptor.empty())
+        {
+            llvm::errs() << "expected method in format '<name>:<descriptor>'\n";
+            return -1;
+        }
+        if (!jllvm::MethodType::verify(descriptor))
+        {
+            llvm::errs() << "invalid method descriptor '" << descriptor << "'\n";
+            return -1;
+        }
+        methodType.emplace(descriptor);
+
+        if (args.getAllArgValues(OPT_INPUT).size() != 1)
+        {
+            llvm::errs() << "expected exactly one input class file\n";
+            return -1;
+        }
     }
 
     // Add to the class path the development class files extracted by the cmake build from the found JDK.
@@ -117,10 +361,23 @@ int main(int argc, char** argv)
         classPath.push_back(iter->path());
     }
 
-    // Also add to the class path the directory of the input file to be able to load any classes in the same directory.
-    llvm::SmallString<32> inputFile(args.getLastArgValue(OPT_INPUT));
-    llvm::sys::fs::make_absolute(inputFile);
-    classPath.emplace_back(llvm::sys::path::parent_path(inputFile));
+    // Also add to the class path the input directories and the directories of the input files to be able to load any
+    // classes in the same directory.
+    std::vector<std::string> inputs;
+    for (llvm::StringRef input : args.getAllArgValues(OPT_INPUT))
+    {
+        llvm::SmallString<32> absolute(input);
+        llvm::sys::fs::make_absolute(absolute);
+        if (llvm::sys::fs::is_directory(absolute))
+        {
+            classPath.emplace_back(absolute);
+        }
+        else
+        {
+            classPath.emplace_back(llvm::sys::path::parent_path(absolute));
+        }
+        inputs.emplace_back(absolute);
+    }
 
     jllvm::StringInterner stringInterner;
 
@@ -132,23 +389,46 @@ int main(int argc, char** argv)
 
     stringInterner.initialize([&](jllvm::FieldType fieldType) { return &loader.forName(fieldType); });
 
-    auto buffer = llvm::MemoryBuffer::getFile(inputFile);
-    if (!buffer)
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> classFiles;
+    for (llvm::StringRef input : inputs)
     {
-        llvm::errs() << "failed to open " << inputFile << '\n';
-        return -1;
+        if (!readClassFiles(input, classFiles))
+        {
+            return -1;
+        }
     }
 
-    jllvm::ClassObject& classObject = loader.add(std::move(*buffer));
+    // Class files may have already been loaded as dependency of a previous class file.
+    llvm::SetVector<jllvm::ClassObject*> classObjects;
+    for (std::unique_ptr<llvm::MemoryBuffer>& buffer : classFiles)
+    {
+        classObjects.insert(&loader.add(std::move(buffer)));
+    }
 
-    const jllvm::Method* method = classObject.getMethod(name, methodType);
+    if (aheadOfTime)
+    {
+        return compileAheadOfTime(classObjects.getArrayRef(), args.getLastArgValue(OPT_output), stringSaver);
+    }
+
+    jllvm::ClassObject& classObject = *classObjects.front();
+    const jllvm::Method* method = classObject.getMethod(name, *methodType);
     if (!method)
     {
-        llvm::errs() << "failed to find method '" << name << ":" << methodType.textual() << "' in '"
+        llvm::errs() << "failed to find method '" << name << ":" << methodType->textual() << "' in '"
                      << classObject.getClassName() << "'\n";
         return -1;
     }
 
+    jllvm::MethodProfile profile;
+    if (llvm::opt::Arg* arg = args.getLastArg(OPT_profile))
+    {
+        if (!readProfile(arg->getValue(), profile, loader, stringSaver))
+        {
+            return -1;
+        }
+        method->setProfile(&profile);
+    }
+
     llvm::LLVMContext context;
     llvm::Module module(name, context);
 
@@ -165,12 +445,35 @@ int main(int argc, char** argv)
     }
     else
     {
-        compileMethod(module, *method);
+        std::uint64_t tierUpThreshold = 0;
+        if (llvm::opt::Arg* arg = args.getLastArg(OPT_tier_up_threshold))
+        {
+            llvm::StringRef ref = arg->getValue();
+            if (ref.consumeInteger(0, tierUpThreshold))
+            {
+                llvm::errs() << "invalid integer '" << ref << "' as argument to '--tier-up-threshold'\n";
+                return -1;
+            }
+        }
+        compileMethod(module, *method, tierUpThreshold);
     }
     if (llvm::verifyModule(module, &llvm::dbgs()))
     {
         std::abort();
     }
 
+    if (args.hasArg(OPT_optimize))
+    {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+
+        std::unique_ptr<llvm::TargetMachine> targetMachine =
+            llvm::cantFail(jllvm::createTargetMachineBuilder().createTargetMachine());
+        module.setDataLayout(targetMachine->createDataLayout());
+        module.setTargetTriple(LLVM_HOST_TRIPLE);
+        jllvm::setCompilationTier(module, jllvm::CompilationTier::Optimized);
+        jllvm::optimizeModule(module, *targetMachine);
+    }
+
     module.print(llvm::outs(), nullptr);
 }